@@ -0,0 +1,224 @@
+#include "thread_pool.hpp"
+
+using namespace ccl::sys::concurrent;
+
+namespace
+{
+    // The pool and index of the worker running on the current thread, if any
+    thread_local ThreadPool* tl_pool  = nullptr;
+    thread_local size_t      tl_index = 0;
+
+    // Per-thread xorshift state used to pick random victims
+    thread_local uint32_t tl_seed = 0x9E3779B9u;
+
+    uint32_t next_random()
+    {
+        tl_seed ^= tl_seed << 13;
+        tl_seed ^= tl_seed >> 17;
+        tl_seed ^= tl_seed << 5;
+        return tl_seed;
+    }
+}
+
+/**
+ * The worker Thread just runs the worker loop of the pool. The cancellation
+ * policy is DEFERRED, since the loop exits by itself once the pool stops.
+ */
+class ThreadPool::Worker : public Thread
+{
+private:
+    ThreadPool* m_pool;
+    size_t      m_index;
+
+    void run() override
+    {
+        m_pool->workerLoop( m_index );
+    }
+
+public:
+    Worker( ThreadPool* pool, size_t index )
+        : Thread( "PoolWorker-" + std::to_string(index), false, CancellationPolicy::DEFERRED ),
+          m_pool( pool ), m_index( index )
+    {}
+};
+
+ThreadPool::ThreadPool(size_t nof_threads, bool pin_threads)
+    : m_injection( INJECTION_CAPACITY )
+{
+    if ( nof_threads == 0 ) nof_threads = 1;
+
+    // All the deques must exist before any worker starts stealing
+    for ( size_t idx = 0; idx < nof_threads; ++idx )
+    {
+        m_deques.push_back( std::make_unique<deque_t>() );
+    }
+
+    size_t nof_cpus = std::max( 1u, std::thread::hardware_concurrency() );
+
+    for ( size_t idx = 0; idx < nof_threads; ++idx )
+    {
+        m_workers.push_back( std::make_unique<Worker>( this, idx ) );
+        m_workers.back()->start();
+
+        if ( pin_threads ) m_workers.back()->setAffinity( idx % nof_cpus );
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    m_stop.store( true );
+    m_epoch.fetch_add( 1 );
+    m_epoch.notify_all();
+
+    // Join before destroying the workers: the Thread destructor would join
+    // only once the Worker part is gone, and a worker that did not enter
+    // run() yet would end up calling a pure virtual function.
+    for ( auto& worker: m_workers ) worker->join();
+    m_workers.clear();
+
+    // Nothing should be left, but never leak tasks
+    task_ptr task;
+    while ( m_injection.tryPop( task ) ) runTask( task );
+}
+
+size_t ThreadPool::size() const
+{
+    return m_workers.size();
+}
+
+void ThreadPool::enqueue(task_ptr task)
+{
+    if ( tl_pool == this )
+    {
+        m_deques[tl_index]->push( task );
+    }
+    else
+    {
+        m_injection.push( task );
+    }
+
+    wakeUp();
+}
+
+void ThreadPool::wakeUp()
+{
+    // Pairs with the fence in the worker loop: either the worker sees the
+    // new task when it checks again, or we see it idle and wake it up.
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    if ( m_idle.load( std::memory_order_relaxed ) == 0 ) return;
+
+    m_epoch.fetch_add( 1, std::memory_order_release );
+    m_epoch.notify_one();
+}
+
+ThreadPool::task_ptr ThreadPool::findTask(size_t index)
+{
+    task_ptr task = nullptr;
+
+    if ( m_deques[index]->pop( task ) ) return task;
+    if ( m_injection.tryPop( task ) ) return task;
+    return stealTask( index );
+}
+
+ThreadPool::task_ptr ThreadPool::stealTask(size_t self)
+{
+    size_t nof_deques = m_deques.size();
+    size_t first = next_random() % nof_deques;
+    task_ptr task = nullptr;
+
+    for ( size_t offset = 0; offset < nof_deques; ++offset )
+    {
+        size_t victim = (first + offset) % nof_deques;
+        if ( victim == self ) continue;
+        if ( m_deques[victim]->steal( task ) ) return task;
+    }
+
+    return nullptr;
+}
+
+bool ThreadPool::hasWork() const
+{
+    if ( !m_injection.empty() ) return true;
+
+    for ( const auto& deque: m_deques )
+    {
+        if ( !deque->empty() ) return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::runTask(task_ptr task)
+{
+    std::unique_ptr<Task> owner( task );
+    (*owner)();
+}
+
+bool ThreadPool::runPendingTask()
+{
+    task_ptr task = nullptr;
+
+    if ( tl_pool == this )
+    {
+        task = findTask( tl_index );
+    }
+    else if ( !m_injection.tryPop( task ) )
+    {
+        task = stealTask( m_deques.size() );
+    }
+
+    if ( task == nullptr ) return false;
+
+    runTask( task );
+    return true;
+}
+
+void ThreadPool::workerLoop(size_t index)
+{
+    tl_pool  = this;
+    tl_index = index;
+    tl_seed ^= static_cast<uint32_t>( (index + 1) * 0x85EBCA6Bu );
+
+    size_t attempts = 0;
+
+    while ( true )
+    {
+        if ( task_ptr task = findTask( index ) )
+        {
+            runTask( task );
+            attempts = 0;
+            continue;
+        }
+
+        if ( ++attempts < IDLE_SPIN_BUDGET )
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Announce that we are going to sleep, then check again for work
+        m_idle.fetch_add( 1, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        uint32_t epoch = m_epoch.load( std::memory_order_acquire );
+
+        if ( hasWork() )
+        {
+            m_idle.fetch_sub( 1, std::memory_order_relaxed );
+            attempts = 0;
+            continue;
+        }
+
+        // Pending tasks are always drained before stopping
+        if ( m_stop.load() )
+        {
+            m_idle.fetch_sub( 1, std::memory_order_relaxed );
+            break;
+        }
+
+        m_epoch.wait( epoch, std::memory_order_acquire );
+        m_idle.fetch_sub( 1, std::memory_order_relaxed );
+        attempts = 0;
+    }
+
+    tl_pool = nullptr;
+}
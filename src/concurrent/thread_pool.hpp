@@ -0,0 +1,165 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <type_traits>
+#include <concurrent/thread.hpp>
+#include <data_structures/queue/mpmc_queue.hpp>
+#include <data_structures/queue/work_stealing_deque.hpp>
+
+namespace ccl::sys::concurrent
+{
+    /**
+     * @class ThreadPool
+     *
+     * @brief Fixed-size pool of worker threads with work stealing. Each worker
+     * is a Thread owning a Chase-Lev deque: tasks submitted from inside a worker
+     * are pushed into its own deque, while tasks submitted from any other thread
+     * go through a shared lock-free injection queue. An idle worker first pops
+     * from its own deque, then from the injection queue, and finally tries to
+     * steal from the other workers, starting from a random victim.
+     *
+     * Workers that find nothing to do spin for a while and then sleep. Producers
+     * wake them up only if at least one of them is sleeping.
+     *
+     * On destruction all the pending tasks are executed before joining.
+     */
+    class ThreadPool
+    {
+    public:
+        using Task = std::function<void()>;
+
+        static constexpr size_t INJECTION_CAPACITY = 4096;
+        static constexpr size_t IDLE_SPIN_BUDGET   = 64;
+
+    private:
+        class Worker; // The Thread running the worker loop
+
+        using task_ptr = Task*;
+        using deque_t  = ds::queue::WorkStealingDeque<task_ptr>;
+
+        std::vector<std::unique_ptr<deque_t>> m_deques;  // One per worker
+        std::vector<std::unique_ptr<Worker>>  m_workers; // The worker threads
+        ds::queue::MpmcQueue<task_ptr>        m_injection; // External submissions
+
+        std::atomic<bool>     m_stop  = false;
+        std::atomic<size_t>   m_idle  = 0; // Number of sleeping (or about to) workers
+        std::atomic<uint32_t> m_epoch = 0; // Bumped to wake up sleeping workers
+
+        void enqueue( task_ptr task );       // Push into the local deque or injection queue
+        void wakeUp();                       // Wake up one worker if any is sleeping
+        task_ptr findTask( size_t index );   // Find a task for the given worker index
+        task_ptr stealTask( size_t self );   // Try to steal from all workers but self
+        bool hasWork() const;                // If any task is queued anywhere
+        void workerLoop( size_t index );     // Main loop of each worker
+        static void runTask( task_ptr task );
+
+        /**
+         * Execute one pending task on the calling thread, if any. It is used to
+         * make progress while waiting, instead of blocking a worker.
+         */
+        bool runPendingTask();
+
+    public:
+        /**
+         * @param nof_threads The number of workers (at least one)
+         * @param pin_threads If true, worker i is pinned to CPU (i % nof_cpus)
+         */
+        explicit ThreadPool( size_t nof_threads = std::thread::hardware_concurrency(),
+                             bool pin_threads = false );
+
+        ThreadPool( const ThreadPool& ) = delete;
+        ThreadPool& operator=( const ThreadPool& ) = delete;
+
+        virtual ~ThreadPool();
+
+        /* Returns the number of workers */
+        size_t size() const;
+
+        /**
+         * @brief Submit a callable with its arguments to the pool
+         * @return A future holding the result (or the exception) of the call
+         */
+        template <typename _Callable, typename ..._Args>
+        auto submit( _Callable&& fun, _Args&& ...args )
+            -> std::future<std::invoke_result_t<_Callable, _Args...>>;
+
+        /**
+         * @brief Run body(i) for each i in [begin, end) splitting the range into
+         * chunks of grain size. If grain is zero, the range is split into four
+         * chunks per worker. The calling thread takes part in the execution
+         * and returns once all the chunks are completed. The first exception
+         * raised by the body, if any, is rethrown.
+         */
+        template <typename _Body>
+        void parallelFor( size_t begin, size_t end, _Body&& body, size_t grain = 0 );
+    };
+
+    template <typename _Callable, typename ..._Args>
+    inline auto ThreadPool::submit( _Callable&& fun, _Args&& ...args )
+        -> std::future<std::invoke_result_t<_Callable, _Args...>>
+    {
+        using result_t = std::invoke_result_t<_Callable, _Args...>;
+
+        // packaged_task is move-only, while std::function must be copyable
+        auto task = std::make_shared<std::packaged_task<result_t()>>(
+            [fun = std::forward<_Callable>(fun),
+             args = std::make_tuple( std::forward<_Args>(args)... )]() mutable
+            {
+                return std::apply( std::move(fun), std::move(args) );
+            }
+        );
+
+        std::future<result_t> result = task->get_future();
+        enqueue( new Task( [task](){ (*task)(); } ) );
+        return result;
+    }
+
+    template <typename _Body>
+    inline void ThreadPool::parallelFor( size_t begin, size_t end, _Body&& body, size_t grain )
+    {
+        if ( begin >= end ) return;
+        if ( grain == 0 ) grain = std::max<size_t>( 1, (end - begin) / (size() * 4) );
+
+        struct SharedState
+        {
+            std::atomic<size_t> m_remaining;
+            std::exception_ptr  m_error;
+            std::mutex          m_mutex;
+        } state;
+
+        size_t nof_chunks = (end - begin + grain - 1) / grain;
+        state.m_remaining.store( nof_chunks, std::memory_order_relaxed );
+
+        for ( size_t start = begin; start < end; start += grain )
+        {
+            size_t stop = std::min( end, start + grain );
+
+            enqueue( new Task( [&state, &body, start, stop]()
+            {
+                try {
+                    for ( size_t idx = start; idx < stop; ++idx ) body( idx );
+                } catch ( ... ) {
+                    std::lock_guard<std::mutex> _l( state.m_mutex );
+                    if ( !state.m_error ) state.m_error = std::current_exception();
+                }
+
+                state.m_remaining.fetch_sub( 1, std::memory_order_acq_rel );
+            }));
+        }
+
+        // Help the workers instead of just waiting
+        while ( state.m_remaining.load( std::memory_order_acquire ) > 0 )
+        {
+            if ( !runPendingTask() ) std::this_thread::yield();
+        }
+
+        if ( state.m_error ) std::rethrow_exception( state.m_error );
+    }
+}
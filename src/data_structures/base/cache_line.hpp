@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+namespace ccl::ds::base
+{
+    /**
+     * Size in bytes of a cache line on the target architectures (x86-64 and
+     * most ARMv8 cores). It is used to pad atomics that are written by different
+     * threads, so that they do not end up on the same line (false sharing).
+     *
+     * Note: std::hardware_destructive_interference_size is not used since GCC
+     * warns about its value not being stable across compiler flags.
+     */
+    inline constexpr std::size_t CACHE_LINE_SIZE = 64;
+}
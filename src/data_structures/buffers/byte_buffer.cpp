@@ -204,6 +204,12 @@ void ByteBuffer::clear()
     m_size = 0;
 }
 
+void ByteBuffer::reset()
+{
+    m_position = 0;
+    m_size = 0;
+}
+
 void ByteBuffer::put(const unsigned char data)
 {
     checkForOutOfBound(position() + BYTE_SIZE, false);
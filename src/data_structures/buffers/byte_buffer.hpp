@@ -46,6 +46,7 @@ namespace ccl::ds::buffers
 
         bool isEmpty() const; // If the buffer is empty or not
         void clear();         // Clear the entire buffer
+        void reset();         // Reset position and size without zeroing the content
 
         void put(const unsigned char data);               // Put a single byte into the buffer
         void putUnsignedShort(const unsigned short data); // Put a single short into the buffer
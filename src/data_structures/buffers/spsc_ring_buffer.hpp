@@ -0,0 +1,331 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <data_structures/base/cache_line.hpp>
+
+namespace ccl::ds::buffers
+{
+    /**
+     * Lock-free Single-Producer Single-Consumer ring buffer. Differently from the
+     * ConcurrentRingBuffer, no mutex is involved: the producer only writes the
+     * tail index and the consumer only writes the head index, both published
+     * with release semantic and read with acquire semantic. Each side also keeps
+     * a cached copy of the opposite index, so that the shared cache line is
+     * touched only when the buffer looks full (producer) or empty (consumer).
+     *
+     * The capacity is always rounded up to the next power of two, so that the
+     * position in the storage is computed with a mask instead of a modulo.
+     * Indexes grow monotonically and never wrap in practice (64 bit).
+     *
+     * Differently from the RingBuffer, pushing into a full buffer never overwrites
+     * the oldest value, since it would require the producer to move the head.
+     *
+     * IMPORTANT: at most one thread can push and at most one thread can pop
+     * at the same time. Any other usage is undefined behavior.
+     *
+     * @tparam T The type of values inside the container
+     */
+    template <typename T>
+    class SpscRingBuffer
+    {
+    private:
+        using index_t = std::atomic<size_t>;
+
+        // Number of failed attempts before a blocking call yields the CPU, and
+        // before it definitely sleeps on the opposite index.
+        static constexpr size_t SPIN_BUDGET  = 64;
+        static constexpr size_t YIELD_BUDGET = 16;
+
+        std::vector<T> m_buffer;
+        size_t         m_capacity = 0;
+        size_t         m_mask     = 0;
+
+        // Consumer side: the read index and the last seen write index
+        alignas(base::CACHE_LINE_SIZE) index_t m_head = 0;
+        size_t m_cached_tail = 0;
+
+        // Producer side: the write index and the last seen read index
+        alignas(base::CACHE_LINE_SIZE) index_t m_tail = 0;
+        size_t m_cached_head = 0;
+
+        // Set by a blocking call before sleeping on the opposite index, so
+        // that the other side issues a futex wake-up only when needed.
+        alignas(base::CACHE_LINE_SIZE) std::atomic<bool> m_producer_waiting = false;
+        std::atomic<bool> m_consumer_waiting = false;
+
+        static constexpr size_t roundCapacity( size_t );
+
+        // Free (used) slots as seen by the producer (consumer). The opposite
+        // index is reloaded only if the cached one gives less than wanted.
+        size_t writable( size_t tail, size_t wanted = 1 );
+        size_t readable( size_t head, size_t wanted = 1 );
+
+        void wakeProducer(); // Wake up the producer if it is sleeping
+        void wakeConsumer(); // Wake up the consumer if it is sleeping
+
+    public:
+        explicit SpscRingBuffer( size_t capacity );
+
+        SpscRingBuffer( const SpscRingBuffer& ) = delete;
+        SpscRingBuffer( SpscRingBuffer&& ) = delete;
+        SpscRingBuffer& operator=( const SpscRingBuffer& ) = delete;
+        SpscRingBuffer& operator=( SpscRingBuffer&& ) = delete;
+
+        // Observers are only approximated when called concurrently
+        bool   empty   () const;
+        bool   full    () const;
+        size_t size    () const;
+        size_t capacity() const;
+
+        /**
+         * Push a single value. Returns false if the buffer is full.
+         * Can be called only by the producer thread.
+         */
+        template <typename U> bool tryPush( U&& value );
+
+        /**
+         * Push a single value, waiting for a free slot if the buffer is full.
+         * It spins for a while, then yields and finally sleeps until the
+         * consumer pops.
+         */
+        template <typename U> void push( U&& value );
+
+        /**
+         * Copy up to nelem values from the source array with a single index
+         * publication. Returns the number of values actually pushed.
+         *
+         * @param src The source array
+         * @param nelem The number of elements in the source array
+         * @return The number of pushed elements
+         */
+        size_t tryPushN( const T* src, size_t nelem );
+
+        /**
+         * Pop a single value into the destination. Returns false if the buffer
+         * is empty. Can be called only by the consumer thread.
+         */
+        bool tryPop( T& dst );
+
+        /**
+         * Pop a single value, waiting for the producer if the buffer is empty.
+         * It spins for a while, then yields and finally sleeps until the
+         * producer pushes.
+         */
+        T pop();
+
+        /**
+         * Move up to nelem values into the destination array with a single
+         * index publication. Returns the number of values actually popped.
+         *
+         * @param dst The destination array
+         * @param nelem The maximum number of elements to pop
+         * @return The number of popped elements
+         */
+        size_t tryPopN( T* dst, size_t nelem );
+    };
+
+    template <typename T>
+    inline constexpr size_t SpscRingBuffer<T>::roundCapacity(size_t capacity)
+    {
+        size_t result = 1;
+        while ( result < capacity ) result <<= 1;
+        return result;
+    }
+
+    template <typename T>
+    inline SpscRingBuffer<T>::SpscRingBuffer(size_t capacity)
+    {
+        if ( capacity == 0 )
+        {
+            throw std::invalid_argument( "SpscRingBuffer capacity must be greater than zero" );
+        }
+
+        m_capacity = roundCapacity( capacity );
+        m_mask = m_capacity - 1;
+        m_buffer.resize( m_capacity );
+    }
+
+    template <typename T>
+    inline size_t SpscRingBuffer<T>::writable(size_t tail, size_t wanted)
+    {
+        size_t free_slots = m_capacity - ( tail - m_cached_head );
+        if ( free_slots >= wanted ) return free_slots;
+
+        // Only when the buffer looks full we refresh the head
+        m_cached_head = m_head.load( std::memory_order_acquire );
+        return m_capacity - ( tail - m_cached_head );
+    }
+
+    template <typename T>
+    inline size_t SpscRingBuffer<T>::readable(size_t head, size_t wanted)
+    {
+        size_t used_slots = m_cached_tail - head;
+        if ( used_slots >= wanted ) return used_slots;
+
+        // Only when the buffer looks empty we refresh the tail
+        m_cached_tail = m_tail.load( std::memory_order_acquire );
+        return m_cached_tail - head;
+    }
+
+    template <typename T>
+    inline void SpscRingBuffer<T>::wakeProducer()
+    {
+        // The fence orders the head store before the flag load, pairing
+        // with the one in push(). Without it the wake-up could be lost.
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        if ( m_producer_waiting.load( std::memory_order_relaxed ) ) m_head.notify_one();
+    }
+
+    template <typename T>
+    inline void SpscRingBuffer<T>::wakeConsumer()
+    {
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        if ( m_consumer_waiting.load( std::memory_order_relaxed ) ) m_tail.notify_one();
+    }
+
+    template <typename T>
+    inline bool SpscRingBuffer<T>::empty() const
+    {
+        return size() == 0;
+    }
+
+    template <typename T>
+    inline bool SpscRingBuffer<T>::full() const
+    {
+        return size() >= m_capacity;
+    }
+
+    template <typename T>
+    inline size_t SpscRingBuffer<T>::size() const
+    {
+        size_t head = m_head.load( std::memory_order_acquire );
+        size_t tail = m_tail.load( std::memory_order_acquire );
+        return tail >= head ? tail - head : 0;
+    }
+
+    template <typename T>
+    inline size_t SpscRingBuffer<T>::capacity() const
+    {
+        return m_capacity;
+    }
+
+    template <typename T>
+    template <typename U>
+    inline bool SpscRingBuffer<T>::tryPush(U &&value)
+    {
+        size_t tail = m_tail.load( std::memory_order_relaxed );
+        if ( writable( tail ) == 0 ) return false;
+
+        m_buffer[tail & m_mask] = std::forward<U>(value);
+        m_tail.store( tail + 1, std::memory_order_release );
+        wakeConsumer();
+        return true;
+    }
+
+    template <typename T>
+    template <typename U>
+    inline void SpscRingBuffer<T>::push(U &&value)
+    {
+        size_t tail = m_tail.load( std::memory_order_relaxed );
+        size_t attempts = 0;
+
+        while ( writable( tail ) == 0 )
+        {
+            if ( ++attempts < SPIN_BUDGET ) continue;
+            if ( attempts < SPIN_BUDGET + YIELD_BUDGET )
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // Sleep until the consumer moves the head forward. The head is
+            // checked again after raising the flag to not miss any wake-up.
+            m_producer_waiting.store( true, std::memory_order_relaxed );
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+            if ( writable( tail ) == 0 ) m_head.wait( m_cached_head, std::memory_order_acquire );
+            m_producer_waiting.store( false, std::memory_order_relaxed );
+        }
+
+        m_buffer[tail & m_mask] = std::forward<U>(value);
+        m_tail.store( tail + 1, std::memory_order_release );
+        wakeConsumer();
+    }
+
+    template <typename T>
+    inline size_t SpscRingBuffer<T>::tryPushN(const T *src, size_t nelem)
+    {
+        size_t tail = m_tail.load( std::memory_order_relaxed );
+        size_t count = std::min( nelem, writable( tail, nelem ) );
+        if ( count == 0 ) return 0;
+
+        for ( size_t idx = 0; idx < count; ++idx )
+        {
+            m_buffer[(tail + idx) & m_mask] = src[idx];
+        }
+
+        m_tail.store( tail + count, std::memory_order_release );
+        wakeConsumer();
+        return count;
+    }
+
+    template <typename T>
+    inline bool SpscRingBuffer<T>::tryPop(T &dst)
+    {
+        size_t head = m_head.load( std::memory_order_relaxed );
+        if ( readable( head ) == 0 ) return false;
+
+        dst = std::move( m_buffer[head & m_mask] );
+        m_head.store( head + 1, std::memory_order_release );
+        wakeProducer();
+        return true;
+    }
+
+    template <typename T>
+    inline T SpscRingBuffer<T>::pop()
+    {
+        size_t head = m_head.load( std::memory_order_relaxed );
+        size_t attempts = 0;
+
+        while ( readable( head ) == 0 )
+        {
+            if ( ++attempts < SPIN_BUDGET ) continue;
+            if ( attempts < SPIN_BUDGET + YIELD_BUDGET )
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // Sleep until the producer moves the tail forward
+            m_consumer_waiting.store( true, std::memory_order_relaxed );
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+            if ( readable( head ) == 0 ) m_tail.wait( m_cached_tail, std::memory_order_acquire );
+            m_consumer_waiting.store( false, std::memory_order_relaxed );
+        }
+
+        T value = std::move( m_buffer[head & m_mask] );
+        m_head.store( head + 1, std::memory_order_release );
+        wakeProducer();
+        return value;
+    }
+
+    template <typename T>
+    inline size_t SpscRingBuffer<T>::tryPopN(T *dst, size_t nelem)
+    {
+        size_t head = m_head.load( std::memory_order_relaxed );
+        size_t count = std::min( nelem, readable( head, nelem ) );
+        if ( count == 0 ) return 0;
+
+        for ( size_t idx = 0; idx < count; ++idx )
+        {
+            dst[idx] = std::move( m_buffer[(head + idx) & m_mask] );
+        }
+
+        m_head.store( head + count, std::memory_order_release );
+        wakeProducer();
+        return count;
+    }
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <queue>
 #include <stdexcept>
 #include <iostream>
@@ -17,6 +18,7 @@ namespace ccl::ds::queue
      * - push() waits if the queue is full (if bounded).
      * - pop() waits if the queue is empty.
      * - tryPush()/tryPop() are non-blocking.
+     * - popN()/tryPopN() move up to N elements out with a single lock.
      */
     template <typename T>
     class ConcurrentQueue : public QueueInterface<T>
@@ -62,6 +64,19 @@ namespace ccl::ds::queue
         void pop(T&)           override;
         bool tryPop(T&)        override;
         bool peek(T&)    const override;
+
+        /**
+         * Move up to nelem elements into dst, waiting until there is at
+         * least one. All of them are taken with a single lock.
+         * @return The number of elements moved
+         */
+        size_t popN(T* dst, size_t nelem);
+
+        /* Move up to nelem elements into dst without waiting, returns how many */
+        size_t tryPopN(T* dst, size_t nelem);
+
+    private:
+        size_t moveOut(T* dst, size_t nelem); // Requires the mutex to be held
     };
 
     template <typename T>
@@ -227,4 +242,46 @@ namespace ccl::ds::queue
         dest = m_queue.front();
         return true;
     }
+
+    template <typename T>
+    inline size_t ConcurrentQueue<T>::moveOut(T *dst, size_t nelem)
+    {
+        size_t count = std::min(nelem, m_queue.size());
+        for (size_t idx = 0; idx < count; ++idx)
+        {
+            dst[idx] = std::move(m_queue.front());
+            m_queue.pop();
+        }
+
+        m_size.fetch_sub(count, std::memory_order_relaxed);
+        return count;
+    }
+
+    template <typename T>
+    inline size_t ConcurrentQueue<T>::popN(T *dst, size_t nelem)
+    {
+        if (nelem == 0) return 0;
+
+        std::unique_lock lock(m_mutex);
+        m_notEmpty.wait(lock, [this] {
+            return !m_queue.empty();
+        });
+
+        size_t count = moveOut(dst, nelem);
+
+        lock.unlock();
+        m_notFull.notify_all();
+        return count;
+    }
+
+    template <typename T>
+    inline size_t ConcurrentQueue<T>::tryPopN(T *dst, size_t nelem)
+    {
+        std::unique_lock lock(m_mutex);
+        size_t count = moveOut(dst, nelem);
+
+        lock.unlock();
+        if (count > 0) m_notFull.notify_all();
+        return count;
+    }
 }
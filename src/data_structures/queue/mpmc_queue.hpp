@@ -0,0 +1,386 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include <data_structures/base/cache_line.hpp>
+#include "queue_interface.hpp"
+
+namespace ccl::ds::queue
+{
+    /**
+     * @class MpmcQueue
+     *
+     * @brief Bounded Multi-Producer Multi-Consumer lock-free queue, based on the
+     * Dmitry Vyukov's algorithm. Each slot of the queue stores a sequence number
+     * next to the value, which tells producers and consumers whether the slot
+     * is free or ready for the current lap. Producers and consumers only contend
+     * on a single CAS of the enqueue or the dequeue position respectively, and
+     * never on the same cache line.
+     *
+     * It follows the same contract of the ConcurrentQueue, so it can be used as
+     * a drop-in replacement of it:
+     * - push() waits if the queue is full.
+     * - pop() waits if the queue is empty.
+     * - tryPush()/tryPop() are non-blocking and never lock.
+     *
+     * Blocking calls first retry the lock-free path up to a configurable spin
+     * budget, and only then sleep on a condition variable. The mutex is taken
+     * by the other side only when there is at least one sleeping thread.
+     *
+     * Differently from the ConcurrentQueue the queue is always bounded. The
+     * capacity is rounded up to the next power of two, and it is at least two
+     * since with a single cell a full slot and a free one of the next lap
+     * would have the same sequence number.
+     *
+     * @tparam T The type of data belonging to the queue
+     */
+    template <typename T>
+    class MpmcQueue : public QueueInterface<T>
+    {
+    public:
+        static constexpr size_t DEFAULT_CAPACITY    = 1024;
+        static constexpr size_t DEFAULT_SPIN_BUDGET = 128;
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> m_sequence; // Lap in which the cell is usable
+            T                   m_data;     // The stored value
+        };
+
+        std::unique_ptr<Cell[]> m_cells;
+        size_t                  m_capacity = 0;
+        size_t                  m_mask     = 0;
+        std::atomic<size_t>     m_spin_budget = DEFAULT_SPIN_BUDGET;
+
+        alignas(base::CACHE_LINE_SIZE) std::atomic<size_t> m_enqueue_pos = 0;
+        alignas(base::CACHE_LINE_SIZE) std::atomic<size_t> m_dequeue_pos = 0;
+
+        // Slow path: only used once the spin budget is exhausted
+        alignas(base::CACHE_LINE_SIZE) std::atomic<size_t> m_push_waiters = 0;
+        std::atomic<size_t>     m_pop_waiters = 0;
+        mutable std::mutex      m_mutex;
+        std::condition_variable m_notEmpty;
+        std::condition_variable m_notFull;
+
+        template <typename U> bool enqueue( U&& value );
+        bool dequeue( T& dest );
+
+        void notifyNotEmpty();
+        void notifyNotFull();
+
+        template <typename U> void blockingPush( U&& value );
+
+    public:
+        MpmcQueue();
+        explicit MpmcQueue( size_t capacity, size_t spin_budget = DEFAULT_SPIN_BUDGET );
+
+        MpmcQueue( const MpmcQueue& ) = delete;
+        MpmcQueue( MpmcQueue&& ) = delete;
+        MpmcQueue& operator=( const MpmcQueue& ) = delete;
+        MpmcQueue& operator=( MpmcQueue&& ) = delete;
+
+        virtual ~MpmcQueue() = default;
+
+        // Observers are only approximated when called concurrently
+        size_t size    () const override;
+        bool   empty   () const override;
+        bool   full    () const override;
+        size_t capacity() const override;
+
+        /**
+         * Sets the number of lock-free attempts a blocking push or pop
+         * performs before sleeping. Zero means sleeping immediately.
+         */
+        void   setSpinBudget( size_t budget );
+        size_t getSpinBudget() const;
+
+        void push(const T&)    override;
+        void push(T&&)         override;
+        bool tryPush(const T&) override;
+        bool tryPush(T&&)      override;
+
+        T    pop()             override;
+        void pop(T&)           override;
+        bool tryPop(T&)        override;
+
+        /**
+         * Copy the front element without removing it. Notice that with more
+         * than one consumer the element could be popped in the meanwhile,
+         * therefore it is reliable only when a single thread pops.
+         */
+        bool peek(T&)    const override;
+    };
+
+    template <typename T>
+    inline MpmcQueue<T>::MpmcQueue()
+        : MpmcQueue( DEFAULT_CAPACITY )
+    {}
+
+    template <typename T>
+    inline MpmcQueue<T>::MpmcQueue(size_t capacity, size_t spin_budget)
+        : m_spin_budget( spin_budget )
+    {
+        if ( capacity == 0 )
+        {
+            throw std::invalid_argument( "MpmcQueue capacity must be greater than zero" );
+        }
+
+        m_capacity = 2;
+        while ( m_capacity < capacity ) m_capacity <<= 1;
+        m_mask = m_capacity - 1;
+
+        // Each cell starts usable by the producer of the first lap
+        m_cells = std::make_unique<Cell[]>( m_capacity );
+        for ( size_t idx = 0; idx < m_capacity; ++idx )
+        {
+            m_cells[idx].m_sequence.store( idx, std::memory_order_relaxed );
+        }
+    }
+
+    template <typename T>
+    template <typename U>
+    inline bool MpmcQueue<T>::enqueue(U &&value)
+    {
+        Cell* cell;
+        size_t pos = m_enqueue_pos.load( std::memory_order_relaxed );
+
+        while ( true )
+        {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->m_sequence.load( std::memory_order_acquire );
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+            if ( diff == 0 )
+            {
+                // The cell is free for this lap, try to claim the position
+                if ( m_enqueue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed ) ) break;
+            }
+            else if ( diff < 0 )
+            {
+                return false; // The cell still holds the previous lap value
+            }
+            else
+            {
+                pos = m_enqueue_pos.load( std::memory_order_relaxed );
+            }
+        }
+
+        cell->m_data = std::forward<U>(value);
+        cell->m_sequence.store( pos + 1, std::memory_order_release );
+        return true;
+    }
+
+    template <typename T>
+    inline bool MpmcQueue<T>::dequeue(T &dest)
+    {
+        Cell* cell;
+        size_t pos = m_dequeue_pos.load( std::memory_order_relaxed );
+
+        while ( true )
+        {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->m_sequence.load( std::memory_order_acquire );
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+
+            if ( diff == 0 )
+            {
+                // The cell has been written for this lap, try to claim it
+                if ( m_dequeue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed ) ) break;
+            }
+            else if ( diff < 0 )
+            {
+                return false; // No producer has written the cell yet
+            }
+            else
+            {
+                pos = m_dequeue_pos.load( std::memory_order_relaxed );
+            }
+        }
+
+        dest = std::move( cell->m_data );
+
+        // Make the cell available to the producer of the next lap
+        cell->m_sequence.store( pos + m_mask + 1, std::memory_order_release );
+        return true;
+    }
+
+    template <typename T>
+    inline void MpmcQueue<T>::notifyNotEmpty()
+    {
+        // The fence pairs with the one taken by sleeping consumers: either
+        // they see the new value, or we see them waiting.
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        if ( m_pop_waiters.load( std::memory_order_relaxed ) == 0 ) return;
+
+        std::lock_guard<std::mutex> _l( m_mutex );
+        m_notEmpty.notify_one();
+    }
+
+    template <typename T>
+    inline void MpmcQueue<T>::notifyNotFull()
+    {
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        if ( m_push_waiters.load( std::memory_order_relaxed ) == 0 ) return;
+
+        std::lock_guard<std::mutex> _l( m_mutex );
+        m_notFull.notify_one();
+    }
+
+    template <typename T>
+    inline size_t MpmcQueue<T>::size() const
+    {
+        size_t head = m_dequeue_pos.load( std::memory_order_acquire );
+        size_t tail = m_enqueue_pos.load( std::memory_order_acquire );
+        if ( tail <= head ) return 0;
+        return std::min( tail - head, m_capacity );
+    }
+
+    template <typename T>
+    inline bool MpmcQueue<T>::empty() const
+    {
+        return size() == 0;
+    }
+
+    template <typename T>
+    inline bool MpmcQueue<T>::full() const
+    {
+        return size() >= m_capacity;
+    }
+
+    template <typename T>
+    inline size_t MpmcQueue<T>::capacity() const
+    {
+        return m_capacity;
+    }
+
+    template <typename T>
+    inline void MpmcQueue<T>::setSpinBudget(size_t budget)
+    {
+        m_spin_budget.store( budget, std::memory_order_relaxed );
+    }
+
+    template <typename T>
+    inline size_t MpmcQueue<T>::getSpinBudget() const
+    {
+        return m_spin_budget.load( std::memory_order_relaxed );
+    }
+
+    template <typename T>
+    template <typename U>
+    inline void MpmcQueue<T>::blockingPush(U &&value)
+    {
+        size_t budget = getSpinBudget();
+
+        for ( size_t attempt = 0; attempt < budget; ++attempt )
+        {
+            if ( enqueue( std::forward<U>(value) ) )
+            {
+                notifyNotEmpty();
+                return;
+            }
+
+            std::this_thread::yield();
+        }
+
+        std::unique_lock _l( m_mutex );
+        m_push_waiters.fetch_add( 1, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+
+        m_notFull.wait( _l, [this, &value](){ return enqueue( std::forward<U>(value) ); } );
+        m_push_waiters.fetch_sub( 1, std::memory_order_relaxed );
+        _l.unlock();
+
+        notifyNotEmpty();
+    }
+
+    template <typename T>
+    inline void MpmcQueue<T>::push(const T &value)
+    {
+        blockingPush( value );
+    }
+
+    template <typename T>
+    inline void MpmcQueue<T>::push(T &&value)
+    {
+        blockingPush( std::move(value) );
+    }
+
+    template <typename T>
+    inline bool MpmcQueue<T>::tryPush(const T &value)
+    {
+        if ( !enqueue( value ) ) return false;
+        notifyNotEmpty();
+        return true;
+    }
+
+    template <typename T>
+    inline bool MpmcQueue<T>::tryPush(T &&value)
+    {
+        if ( !enqueue( std::move(value) ) ) return false;
+        notifyNotEmpty();
+        return true;
+    }
+
+    template <typename T>
+    inline T MpmcQueue<T>::pop()
+    {
+        T element;
+        pop(element);
+        return element;
+    }
+
+    template <typename T>
+    inline void MpmcQueue<T>::pop(T &dest)
+    {
+        size_t budget = getSpinBudget();
+
+        for ( size_t attempt = 0; attempt < budget; ++attempt )
+        {
+            if ( dequeue( dest ) )
+            {
+                notifyNotFull();
+                return;
+            }
+
+            std::this_thread::yield();
+        }
+
+        std::unique_lock _l( m_mutex );
+        m_pop_waiters.fetch_add( 1, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+
+        m_notEmpty.wait( _l, [this, &dest](){ return dequeue( dest ); } );
+        m_pop_waiters.fetch_sub( 1, std::memory_order_relaxed );
+        _l.unlock();
+
+        notifyNotFull();
+    }
+
+    template <typename T>
+    inline bool MpmcQueue<T>::tryPop(T &dest)
+    {
+        if ( !dequeue( dest ) ) return false;
+        notifyNotFull();
+        return true;
+    }
+
+    template <typename T>
+    inline bool MpmcQueue<T>::peek(T &dest) const
+    {
+        size_t pos = m_dequeue_pos.load( std::memory_order_relaxed );
+        const Cell& cell = m_cells[pos & m_mask];
+
+        if ( cell.m_sequence.load( std::memory_order_acquire ) != pos + 1 ) return false;
+        dest = cell.m_data;
+        return true;
+    }
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+#include <data_structures/base/cache_line.hpp>
+
+namespace ccl::ds::queue
+{
+    /**
+     * @class WorkStealingDeque
+     *
+     * @brief Chase-Lev work-stealing deque, in the formulation for weak memory
+     * models of Lê et al. (PPoPP 2013). The owner thread pushes and pops at the
+     * bottom of the deque (LIFO), while any other thread can steal from the top
+     * (FIFO). The owner never takes a lock and only pays a CAS when it competes
+     * with a thief for the last element.
+     *
+     * The storage is a circular array that grows when full. Retired arrays are
+     * kept alive until the deque is destroyed, since a thief could be still
+     * reading from them.
+     *
+     * IMPORTANT: push() and pop() can only be called by the owner thread.
+     *
+     * @tparam T The type of the values. It must be trivially copyable (usually
+     * a pointer to the actual item), since it is stored into atomics.
+     */
+    template <typename T>
+    class WorkStealingDeque
+    {
+        static_assert( std::is_trivially_copyable_v<T>, "WorkStealingDeque values must be trivially copyable" );
+
+    private:
+        struct Array
+        {
+            int64_t                           m_capacity;
+            int64_t                           m_mask;
+            std::unique_ptr<std::atomic<T>[]> m_data;
+
+            explicit Array( int64_t capacity )
+                : m_capacity( capacity ), m_mask( capacity - 1 ),
+                  m_data( std::make_unique<std::atomic<T>[]>( capacity ) )
+            {}
+
+            T get( int64_t idx ) const
+            {
+                return m_data[idx & m_mask].load( std::memory_order_relaxed );
+            }
+
+            void put( int64_t idx, T value )
+            {
+                m_data[idx & m_mask].store( value, std::memory_order_relaxed );
+            }
+        };
+
+        alignas(base::CACHE_LINE_SIZE) std::atomic<int64_t> m_top    = 0;
+        alignas(base::CACHE_LINE_SIZE) std::atomic<int64_t> m_bottom = 0;
+        alignas(base::CACHE_LINE_SIZE) std::atomic<Array*>  m_array;
+
+        std::vector<std::unique_ptr<Array>> m_arrays; // Current and retired arrays
+
+        Array* grow( Array* array, int64_t bottom, int64_t top );
+
+    public:
+        explicit WorkStealingDeque( size_t capacity = 256 );
+
+        WorkStealingDeque( const WorkStealingDeque& ) = delete;
+        WorkStealingDeque& operator=( const WorkStealingDeque& ) = delete;
+
+        // Observers are only approximated when called concurrently
+        size_t size () const;
+        bool   empty() const;
+
+        /* Push a value at the bottom. Only the owner can call it. */
+        void push( T value );
+
+        /* Pop a value from the bottom. Only the owner can call it. */
+        bool pop( T& dst );
+
+        /* Steal a value from the top. Any thread can call it. */
+        bool steal( T& dst );
+    };
+
+    template <typename T>
+    inline WorkStealingDeque<T>::WorkStealingDeque(size_t capacity)
+    {
+        int64_t rounded = 2;
+        while ( rounded < static_cast<int64_t>(capacity) ) rounded <<= 1;
+
+        m_arrays.push_back( std::make_unique<Array>( rounded ) );
+        m_array.store( m_arrays.back().get(), std::memory_order_relaxed );
+    }
+
+    template <typename T>
+    inline typename WorkStealingDeque<T>::Array* WorkStealingDeque<T>::grow(
+        Array* array, int64_t bottom, int64_t top
+    ) {
+        auto bigger = std::make_unique<Array>( array->m_capacity * 2 );
+        for ( int64_t idx = top; idx < bottom; ++idx )
+        {
+            bigger->put( idx, array->get( idx ) );
+        }
+
+        Array* result = bigger.get();
+        m_arrays.push_back( std::move(bigger) );
+        m_array.store( result, std::memory_order_release );
+        return result;
+    }
+
+    template <typename T>
+    inline size_t WorkStealingDeque<T>::size() const
+    {
+        int64_t bottom = m_bottom.load( std::memory_order_relaxed );
+        int64_t top = m_top.load( std::memory_order_relaxed );
+        return bottom > top ? static_cast<size_t>( bottom - top ) : 0;
+    }
+
+    template <typename T>
+    inline bool WorkStealingDeque<T>::empty() const
+    {
+        return size() == 0;
+    }
+
+    template <typename T>
+    inline void WorkStealingDeque<T>::push(T value)
+    {
+        int64_t bottom = m_bottom.load( std::memory_order_relaxed );
+        int64_t top = m_top.load( std::memory_order_acquire );
+        Array* array = m_array.load( std::memory_order_relaxed );
+
+        if ( bottom - top > array->m_capacity - 1 )
+        {
+            array = grow( array, bottom, top );
+        }
+
+        array->put( bottom, value );
+        std::atomic_thread_fence( std::memory_order_release );
+        m_bottom.store( bottom + 1, std::memory_order_relaxed );
+    }
+
+    template <typename T>
+    inline bool WorkStealingDeque<T>::pop(T &dst)
+    {
+        int64_t bottom = m_bottom.load( std::memory_order_relaxed ) - 1;
+        Array* array = m_array.load( std::memory_order_relaxed );
+        m_bottom.store( bottom, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        int64_t top = m_top.load( std::memory_order_relaxed );
+
+        if ( top > bottom )
+        {
+            // The deque was already empty, restore the bottom
+            m_bottom.store( bottom + 1, std::memory_order_relaxed );
+            return false;
+        }
+
+        dst = array->get( bottom );
+        if ( top < bottom ) return true;
+
+        // Last element: race against thieves for it
+        bool won = m_top.compare_exchange_strong( top, top + 1,
+            std::memory_order_seq_cst, std::memory_order_relaxed );
+
+        m_bottom.store( bottom + 1, std::memory_order_relaxed );
+        return won;
+    }
+
+    template <typename T>
+    inline bool WorkStealingDeque<T>::steal(T &dst)
+    {
+        int64_t top = m_top.load( std::memory_order_acquire );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        int64_t bottom = m_bottom.load( std::memory_order_acquire );
+
+        if ( top >= bottom ) return false;
+
+        Array* array = m_array.load( std::memory_order_acquire );
+        T value = array->get( top );
+
+        // Another thief, or the owner, could have taken it in the meanwhile
+        if ( !m_top.compare_exchange_strong( top, top + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed ) )
+        {
+            return false;
+        }
+
+        dst = value;
+        return true;
+    }
+}
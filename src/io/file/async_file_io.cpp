@@ -0,0 +1,578 @@
+#include "async_file_io.hpp"
+#include <algorithm>
+#include <cstring>
+#include <concurrent/thread.hpp>
+#include <concurrent/thread_pool.hpp>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+using namespace ccl::sys::io;
+
+namespace
+{
+    // Worker threads of the fallback backend. Blocking calls are
+    // mostly waiting, so more threads than CPUs pay off.
+    constexpr size_t FALLBACK_THREADS = 4;
+}
+
+#ifdef __linux__
+
+/**
+ * A minimal io_uring instance: the submission and completion rings shared
+ * with the kernel, plus a thread reaping the completions. The submission
+ * side is used under the AsyncFileIO mutex, the completion side only by
+ * the reaper thread, so each ring has a single producer and consumer.
+ */
+class AsyncFileIO::Ring
+{
+private:
+    // The user data of the request stopping the reaper thread
+    static constexpr __u64 STOP_TOKEN = 0;
+
+    class Reaper : public concurrent::Thread
+    {
+    private:
+        Ring*        m_ring;
+        AsyncFileIO* m_owner;
+
+        void run() override { m_ring->reap( *m_owner ); }
+
+    public:
+        Reaper( Ring* ring, AsyncFileIO* owner )
+            : Thread( "AsyncFileIO-Reaper", false, concurrent::CancellationPolicy::DEFERRED ),
+              m_ring( ring ), m_owner( owner )
+        {}
+    };
+
+    int             m_fd = -1;
+    io_uring_params m_params;
+
+    void*  m_sqRing = nullptr;
+    void*  m_cqRing = nullptr;
+    size_t m_sqRingSize = 0;
+    size_t m_cqRingSize = 0;
+
+    io_uring_sqe* m_sqes = nullptr;
+    size_t        m_sqesSize = 0;
+
+    unsigned* m_sqHead;
+    unsigned* m_sqTail;
+    unsigned* m_sqMask;
+    unsigned* m_sqArray;
+    unsigned* m_cqHead;
+    unsigned* m_cqTail;
+    unsigned* m_cqMask;
+    io_uring_cqe* m_cqes;
+
+    unsigned m_localTail = 0; // Tail including the not yet published entries
+    unsigned m_toSubmit  = 0; // Entries not yet consumed by the kernel
+
+    bool m_filesRegistered   = false;
+    bool m_buffersRegistered = false;
+
+    std::unique_ptr<Reaper> m_reaper;
+
+    int enter( unsigned to_submit, unsigned min_complete, unsigned flags )
+    {
+        int r = static_cast<int>( syscall( __NR_io_uring_enter, m_fd, to_submit,
+                                           min_complete, flags, nullptr, 0 ) );
+        return r < 0 ? -errno : r;
+    }
+
+    template <typename T>
+    T* at( void* base, __u32 offset )
+    {
+        return reinterpret_cast<T*>( static_cast<char*>( base ) + offset );
+    }
+
+    void release()
+    {
+        if ( m_sqes != nullptr ) munmap( m_sqes, m_sqesSize );
+        if ( m_cqRing != nullptr && m_cqRing != m_sqRing ) munmap( m_cqRing, m_cqRingSize );
+        if ( m_sqRing != nullptr ) munmap( m_sqRing, m_sqRingSize );
+        if ( m_fd >= 0 ) ::close( m_fd );
+    }
+
+    [[noreturn]] void fail( const std::string& what )
+    {
+        std::stringstream ss;
+        ss << "io_uring " << what << " [Error]: " << get_last_error_string() << std::endl;
+        release();
+        throw std::runtime_error( ss.str() );
+    }
+
+    /* Consume the completions until the stop token is found */
+    void reap( AsyncFileIO& owner )
+    {
+        bool stop = false;
+
+        while ( !stop )
+        {
+            int r = enter( 0, 1, IORING_ENTER_GETEVENTS );
+            if ( r < 0 && r != -EINTR && r != -EAGAIN && r != -EBUSY )
+            {
+                std::cerr << "io_uring wait failed [Error]: " << std::strerror(-r) << std::endl;
+            }
+
+            unsigned head = *m_cqHead;
+            unsigned tail = std::atomic_ref<unsigned>( *m_cqTail ).load( std::memory_order_acquire );
+
+            while ( head != tail )
+            {
+                const io_uring_cqe& cqe = m_cqes[head & *m_cqMask];
+                head++;
+
+                if ( cqe.user_data == STOP_TOKEN )
+                {
+                    stop = true;
+                    continue;
+                }
+
+                std::unique_ptr<Request> request( reinterpret_cast<Request*>( cqe.user_data ) );
+                owner.complete( *request, cqe.res );
+            }
+
+            std::atomic_ref<unsigned>( *m_cqHead ).store( head, std::memory_order_release );
+        }
+    }
+
+public:
+    Ring( unsigned entries, AsyncFileIO* owner )
+    {
+        std::memset( &m_params, 0, sizeof(m_params) );
+
+        m_fd = static_cast<int>( syscall( __NR_io_uring_setup, entries, &m_params ) );
+        if ( m_fd < 0 ) fail( "setup failed" );
+
+        // Plain read and write opcodes are available since the same release
+        if ( !( m_params.features & IORING_FEAT_RW_CUR_POS ) )
+        {
+            errno = ENOTSUP;
+            fail( "read and write operations not supported" );
+        }
+
+        m_sqRingSize = m_params.sq_off.array + m_params.sq_entries * sizeof(unsigned);
+        m_cqRingSize = m_params.cq_off.cqes + m_params.cq_entries * sizeof(io_uring_cqe);
+
+        bool single_mmap = m_params.features & IORING_FEAT_SINGLE_MMAP;
+        if ( single_mmap ) m_sqRingSize = m_cqRingSize = std::max( m_sqRingSize, m_cqRingSize );
+
+        m_sqRing = ::mmap( nullptr, m_sqRingSize, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING );
+        if ( m_sqRing == MAP_FAILED ) { m_sqRing = nullptr; fail( "ring mapping failed" ); }
+
+        m_cqRing = m_sqRing;
+        if ( !single_mmap )
+        {
+            m_cqRing = ::mmap( nullptr, m_cqRingSize, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING );
+            if ( m_cqRing == MAP_FAILED ) { m_cqRing = nullptr; fail( "ring mapping failed" ); }
+        }
+
+        m_sqesSize = m_params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = ::mmap( nullptr, m_sqesSize, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES );
+        if ( sqes == MAP_FAILED ) fail( "entries mapping failed" );
+        m_sqes = static_cast<io_uring_sqe*>( sqes );
+
+        m_sqHead  = at<unsigned>( m_sqRing, m_params.sq_off.head );
+        m_sqTail  = at<unsigned>( m_sqRing, m_params.sq_off.tail );
+        m_sqMask  = at<unsigned>( m_sqRing, m_params.sq_off.ring_mask );
+        m_sqArray = at<unsigned>( m_sqRing, m_params.sq_off.array );
+        m_cqHead  = at<unsigned>( m_cqRing, m_params.cq_off.head );
+        m_cqTail  = at<unsigned>( m_cqRing, m_params.cq_off.tail );
+        m_cqMask  = at<unsigned>( m_cqRing, m_params.cq_off.ring_mask );
+        m_cqes    = at<io_uring_cqe>( m_cqRing, m_params.cq_off.cqes );
+
+        m_localTail = *m_sqTail;
+
+        m_reaper = std::make_unique<Reaper>( this, owner );
+        m_reaper->start();
+    }
+
+    ~Ring()
+    {
+        release();
+    }
+
+    /* Returns a free submission entry, or nullptr if the ring is full */
+    io_uring_sqe* getSqe()
+    {
+        unsigned head = std::atomic_ref<unsigned>( *m_sqHead ).load( std::memory_order_acquire );
+        if ( m_localTail - head >= m_params.sq_entries ) return nullptr;
+
+        unsigned idx = m_localTail & *m_sqMask;
+        io_uring_sqe* sqe = &m_sqes[idx];
+        std::memset( sqe, 0, sizeof(*sqe) );
+
+        m_sqArray[idx] = idx;
+        m_localTail++;
+        m_toSubmit++;
+        return sqe;
+    }
+
+    unsigned pending() const { return m_toSubmit; }
+
+    /* Publish the new entries and submit them. Returns -errno on error. */
+    int submit()
+    {
+        std::atomic_ref<unsigned>( *m_sqTail ).store( m_localTail, std::memory_order_release );
+
+        int r;
+        do { r = enter( m_toSubmit, 0, 0 ); } while ( r == -EINTR );
+
+        if ( r > 0 ) m_toSubmit -= r;
+        return r;
+    }
+
+    /* Submit the stop token and join the reaper */
+    void stop()
+    {
+        io_uring_sqe* sqe = getSqe();
+        while ( sqe == nullptr )
+        {
+            submit();
+            sqe = getSqe();
+        }
+
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = STOP_TOKEN;
+        submit();
+
+        m_reaper->join();
+    }
+
+    void registerFile( int slot, int fd )
+    {
+        if ( !m_filesRegistered )
+        {
+            // A sparse table, slots are then updated one at a time
+            std::vector<int> fds( MAX_FIXED_FILES, -1 );
+            if ( syscall( __NR_io_uring_register, m_fd, IORING_REGISTER_FILES,
+                          fds.data(), fds.size() ) < 0 )
+            {
+                throw std::runtime_error( "io_uring files registration failed [Error]: "
+                                          + get_last_error_string() );
+            }
+
+            m_filesRegistered = true;
+        }
+
+        io_uring_files_update update;
+        std::memset( &update, 0, sizeof(update) );
+        update.offset = slot;
+        update.fds = reinterpret_cast<__u64>( &fd );
+
+        if ( syscall( __NR_io_uring_register, m_fd, IORING_REGISTER_FILES_UPDATE, &update, 1 ) < 0 )
+        {
+            throw std::runtime_error( "io_uring file update failed [Error]: "
+                                      + get_last_error_string() );
+        }
+    }
+
+    void registerBuffers( const std::vector<std::span<char>>& buffers )
+    {
+        if ( m_buffersRegistered )
+        {
+            syscall( __NR_io_uring_register, m_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0 );
+            m_buffersRegistered = false;
+        }
+
+        if ( buffers.empty() ) return;
+
+        std::vector<struct iovec> iov( buffers.size() );
+        for ( size_t idx = 0; idx < buffers.size(); ++idx )
+        {
+            iov[idx].iov_base = buffers[idx].data();
+            iov[idx].iov_len  = buffers[idx].size();
+        }
+
+        if ( syscall( __NR_io_uring_register, m_fd, IORING_REGISTER_BUFFERS,
+                      iov.data(), iov.size() ) < 0 )
+        {
+            throw std::runtime_error( "io_uring buffers registration failed [Error]: "
+                                      + get_last_error_string() );
+        }
+
+        m_buffersRegistered = true;
+    }
+};
+
+#else
+
+// Placeholder: the fallback backend is always used
+class AsyncFileIO::Ring {};
+
+#endif
+
+AsyncFileIO::AsyncFileIO(size_t queue_depth, bool force_fallback)
+    : m_backend( Backend::ThreadPool ), m_files( MAX_FIXED_FILES, -1 )
+{
+#ifdef __linux__
+    if ( !force_fallback )
+    {
+        try
+        {
+            m_ring = std::make_unique<Ring>( static_cast<unsigned>( queue_depth ), this );
+            m_backend = Backend::IoUring;
+        }
+        catch ( const std::runtime_error& )
+        {
+            m_ring.reset(); // Not available, use the fallback
+        }
+    }
+#endif
+
+    if ( m_backend == Backend::ThreadPool )
+    {
+        m_pool = std::make_unique<concurrent::ThreadPool>( FALLBACK_THREADS );
+    }
+}
+
+AsyncFileIO::~AsyncFileIO()
+{
+    submit();
+    wait();
+
+#ifdef __linux__
+    if ( m_ring != nullptr )
+    {
+        std::lock_guard<std::mutex> _l( m_mutex );
+        m_ring->stop();
+    }
+#endif
+}
+
+AsyncFileIO::Backend AsyncFileIO::getBackend() const
+{
+    return m_backend;
+}
+
+int AsyncFileIO::registerFile(const StreamHandler<NativeHandleType> &handler)
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+
+    auto it = std::find( m_files.begin(), m_files.end(), -1 );
+    if ( it == m_files.end() )
+    {
+        throw std::runtime_error( "No free slot in the fixed file table" );
+    }
+
+    int slot = static_cast<int>( it - m_files.begin() );
+
+#ifdef __linux__
+    if ( m_ring != nullptr ) m_ring->registerFile( slot, handler.get() );
+#endif
+
+    m_files[slot] = handler.get();
+    return slot;
+}
+
+void AsyncFileIO::unregisterFile(int slot)
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+
+    if ( slot < 0 || static_cast<size_t>(slot) >= m_files.size() || m_files[slot] == -1 ) return;
+
+#ifdef __linux__
+    if ( m_ring != nullptr ) m_ring->registerFile( slot, -1 );
+#endif
+
+    m_files[slot] = -1;
+}
+
+void AsyncFileIO::registerBuffers(std::span<const std::span<char>> buffers)
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+    m_buffers.assign( buffers.begin(), buffers.end() );
+
+#ifdef __linux__
+    if ( m_ring != nullptr ) m_ring->registerBuffers( m_buffers );
+#endif
+}
+
+void AsyncFileIO::unregisterBuffers()
+{
+    registerBuffers( std::span<const std::span<char>>() );
+}
+
+std::future<ssize_t> AsyncFileIO::bindFuture(Callback &callback)
+{
+    auto promise = std::make_shared<std::promise<ssize_t>>();
+    callback = [promise]( ssize_t result ){ promise->set_value( result ); };
+    return promise->get_future();
+}
+
+void AsyncFileIO::read(AsyncTarget file, char *dst, size_t size, OFF_T offset,
+    Callback callback, int buffer
+) {
+    enqueue( std::unique_ptr<Request>( new Request{
+        Op::Read, file, dst, size, offset, buffer, std::move(callback) } ) );
+}
+
+std::future<ssize_t> AsyncFileIO::read(AsyncTarget file, char *dst, size_t size,
+    OFF_T offset, int buffer
+) {
+    Callback callback;
+    std::future<ssize_t> result = bindFuture( callback );
+    read( file, dst, size, offset, std::move(callback), buffer );
+    return result;
+}
+
+void AsyncFileIO::write(AsyncTarget file, const char *src, size_t size, OFF_T offset,
+    Callback callback, int buffer
+) {
+    // The source is never written, the cast only allows a single request type
+    enqueue( std::unique_ptr<Request>( new Request{
+        Op::Write, file, const_cast<char*>(src), size, offset, buffer, std::move(callback) } ) );
+}
+
+std::future<ssize_t> AsyncFileIO::write(AsyncTarget file, const char *src, size_t size,
+    OFF_T offset, int buffer
+) {
+    Callback callback;
+    std::future<ssize_t> result = bindFuture( callback );
+    write( file, src, size, offset, std::move(callback), buffer );
+    return result;
+}
+
+void AsyncFileIO::enqueue(std::unique_ptr<Request> request)
+{
+    std::unique_lock<std::mutex> _l( m_mutex );
+
+#ifdef __linux__
+    if ( m_ring != nullptr )
+    {
+        io_uring_sqe* sqe = m_ring->getSqe();
+        if ( sqe == nullptr )
+        {
+            // The ring is full: implicitly submit what is queued
+            _l.unlock();
+            submit();
+            _l.lock();
+
+            while ( ( sqe = m_ring->getSqe() ) == nullptr )
+            {
+                _l.unlock();
+                std::this_thread::yield();
+                submit();
+                _l.lock();
+            }
+        }
+
+        bool registered = request->m_buffer != NO_BUFFER;
+        if ( request->m_target.isFixed() ) sqe->flags |= IOSQE_FIXED_FILE;
+
+        if ( request->m_op == Op::Read )
+        {
+            sqe->opcode = registered ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        }
+        else
+        {
+            sqe->opcode = registered ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        }
+
+        sqe->fd        = request->m_target.handle();
+        sqe->addr      = reinterpret_cast<__u64>( request->m_data );
+        sqe->len       = static_cast<__u32>( request->m_size );
+        sqe->off       = static_cast<__u64>( request->m_offset );
+        sqe->buf_index = registered ? static_cast<__u16>( request->m_buffer ) : 0;
+        sqe->user_data = reinterpret_cast<__u64>( request.release() );
+        return;
+    }
+#endif
+
+    m_pending.push_back( std::move(request) );
+}
+
+size_t AsyncFileIO::submit()
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+
+#ifdef __linux__
+    if ( m_ring != nullptr )
+    {
+        size_t pending = m_ring->pending();
+        if ( pending == 0 ) return 0;
+
+        // Counted before entering, a completion could arrive in the meanwhile
+        m_inflight.fetch_add( pending );
+        int submitted = m_ring->submit();
+
+        if ( submitted < 0 )
+        {
+            if ( m_inflight.fetch_sub( pending ) == pending ) m_inflight.notify_all();
+            throw std::runtime_error( std::string( "io_uring submission failed [Error]: " )
+                                      + std::strerror( -submitted ) );
+        }
+
+        // Entries not consumed are left for the next submission. The earlier
+        // completions may be over: wake up the waiters as complete would.
+        size_t unsubmitted = pending - submitted;
+        if ( unsubmitted > 0 && m_inflight.fetch_sub( unsubmitted ) == unsubmitted ) m_inflight.notify_all();
+        return submitted;
+    }
+#endif
+
+    size_t submitted = m_pending.size();
+    m_inflight.fetch_add( submitted );
+
+    for ( auto& request: m_pending )
+    {
+        Request* raw = request.release();
+        m_pool->submit( [this, raw]()
+        {
+            std::unique_ptr<Request> owner( raw );
+            complete( *owner, execute( *owner ) );
+        });
+    }
+
+    m_pending.clear();
+    return submitted;
+}
+
+ssize_t AsyncFileIO::execute(const Request &request) const
+{
+    NativeHandleType fd = request.m_target.handle();
+    if ( request.m_target.isFixed() )
+    {
+        std::lock_guard<std::mutex> _l( m_mutex );
+        fd = m_files.at( fd );
+    }
+
+    ssize_t result = ( request.m_op == Op::Read )
+        ? ::pread ( fd, request.m_data, request.m_size, request.m_offset )
+        : ::pwrite( fd, request.m_data, request.m_size, request.m_offset );
+
+    return result < 0 ? -errno : result;
+}
+
+void AsyncFileIO::complete(Request &request, ssize_t result)
+{
+    try
+    {
+        if ( request.m_callback ) request.m_callback( result );
+    }
+    catch ( const std::exception& e )
+    {
+        std::cerr << "AsyncFileIO callback raised an exception: " << e.what() << std::endl;
+    }
+
+    if ( m_inflight.fetch_sub( 1 ) == 1 ) m_inflight.notify_all();
+}
+
+void AsyncFileIO::wait()
+{
+    size_t inflight;
+    while ( ( inflight = m_inflight.load() ) != 0 ) m_inflight.wait( inflight );
+}
+
+size_t AsyncFileIO::getInflight() const
+{
+    return m_inflight.load();
+}
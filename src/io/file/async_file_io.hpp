@@ -0,0 +1,197 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+#include <io/base/stream_io.hpp>
+#include "file_io.hpp"
+
+namespace ccl::sys::concurrent
+{
+    class ThreadPool; // Used by the fallback backend
+}
+
+namespace ccl::sys::io
+{
+    /**
+     * @brief The file an asynchronous operation works on. It is either a plain
+     * descriptor, taken from a StreamHandler or from a StreamIO, or the slot of
+     * a file registered into the AsyncFileIO (fixed file).
+     */
+    class AsyncTarget
+    {
+    private:
+        NativeHandleType m_handle; // The descriptor or the fixed slot
+        bool             m_fixed;  // If the handle is a fixed slot
+
+        AsyncTarget( NativeHandleType handle, bool fixed )
+            : m_handle( handle ), m_fixed( fixed )
+        {}
+
+    public:
+        AsyncTarget( const StreamHandler<NativeHandleType>& handler )
+            : AsyncTarget( handler.get(), false )
+        {}
+
+        AsyncTarget( const StreamIO& stream )
+            : AsyncTarget( stream.getNativeHandle(), false )
+        {}
+
+        /* A file previously registered with AsyncFileIO::registerFile */
+        static AsyncTarget fixed( int slot ) { return AsyncTarget( slot, true ); }
+
+        NativeHandleType handle () const { return m_handle; }
+        bool             isFixed() const { return m_fixed; }
+    };
+
+    /**
+     * @brief Asynchronous positional reads and writes on files.
+     *
+     * Operations are only queued by read() and write(): nothing starts until
+     * submit() is called, which hands the whole batch to the kernel with a
+     * single syscall. The result of each operation, that is the number of
+     * transferred bytes or -errno, is delivered either to a callback or to a
+     * future. Callbacks run on an internal thread, hence they must be short
+     * and must not throw.
+     *
+     * On Linux the engine is io_uring, driven directly through the kernel
+     * interface (no liburing is needed). It supports:
+     * - Registered buffers: operations whose memory lies in a buffer passed
+     *   to registerBuffers() can use its index, saving the page pinning.
+     * - Fixed files: registerFile() returns a slot usable in place of the
+     *   descriptor, saving the file reference counting on each operation.
+     *
+     * If io_uring is not available (old kernels, seccomp filters, other OS)
+     * the same interface is implemented with pread/pwrite on a ThreadPool.
+     * Registered buffers and fixed files are then only bookkeeping.
+     *
+     * The class is thread-safe: operations can be queued and submitted by
+     * more threads at the same time.
+     */
+    class AsyncFileIO
+    {
+    public:
+        using Callback = std::function<void( ssize_t )>;
+
+        enum class Backend
+        {
+            IoUring,   // Linux io_uring
+            ThreadPool // pread/pwrite on worker threads
+        };
+
+        static constexpr size_t DEFAULT_QUEUE_DEPTH = 256;
+        static constexpr size_t MAX_FIXED_FILES     = 64;
+        static constexpr int    NO_BUFFER           = -1;
+
+    private:
+        class Ring; // The io_uring instance, when available
+
+        enum class Op { Read, Write };
+
+        struct Request
+        {
+            Op               m_op;
+            AsyncTarget      m_target;
+            char*            m_data;
+            size_t           m_size;
+            OFF_T            m_offset;
+            int              m_buffer; // Registered buffer index or NO_BUFFER
+            Callback         m_callback;
+        };
+
+        Backend                                    m_backend;
+        std::unique_ptr<Ring>                      m_ring;    // io_uring backend
+        std::unique_ptr<concurrent::ThreadPool>    m_pool;    // Fallback backend
+        std::vector<std::unique_ptr<Request>>      m_pending; // Fallback queued requests
+        std::vector<NativeHandleType>              m_files;   // Fixed file table
+        std::vector<std::span<char>>               m_buffers; // Registered buffers
+
+        mutable std::mutex  m_mutex;        // Protects the submission side
+        std::atomic<size_t> m_inflight = 0; // Submitted but not completed
+
+        void enqueue( std::unique_ptr<Request> request );
+        void complete( Request& request, ssize_t result );
+
+        // Fallback execution of a single request
+        ssize_t execute( const Request& request ) const;
+
+        static std::future<ssize_t> bindFuture( Callback& callback );
+
+    public:
+        /**
+         * @param queue_depth The number of operations that can be queued
+         *                    before submit() is implicitly called
+         * @param force_fallback If true io_uring is never used
+         */
+        explicit AsyncFileIO( size_t queue_depth = DEFAULT_QUEUE_DEPTH,
+                              bool force_fallback = false );
+
+        AsyncFileIO( const AsyncFileIO& ) = delete;
+        AsyncFileIO& operator=( const AsyncFileIO& ) = delete;
+
+        /* Waits for all the submitted operations before returning */
+        virtual ~AsyncFileIO();
+
+        /* Returns the backend in use */
+        Backend getBackend() const;
+
+        /**
+         * Register a file into the fixed file table.
+         * @param handler The open file
+         * @return The slot to use with AsyncTarget::fixed
+         */
+        int registerFile( const StreamHandler<NativeHandleType>& handler );
+
+        /**
+         * Remove a file from the fixed file table. There must not be
+         * pending operations on that slot.
+         */
+        void unregisterFile( int slot );
+
+        /**
+         * Register a set of buffers, replacing the previous ones. Their
+         * index is the position in the input. There must not be pending
+         * operations on the replaced buffers.
+         */
+        void registerBuffers( std::span<const std::span<char>> buffers );
+        void unregisterBuffers();
+
+        /**
+         * Queue a read of size bytes at the given offset into dst. If the
+         * buffer index is given, dst must be inside that registered buffer.
+         */
+        void read( AsyncTarget file, char* dst, size_t size, OFF_T offset,
+                   Callback callback, int buffer = NO_BUFFER );
+
+        std::future<ssize_t> read( AsyncTarget file, char* dst, size_t size,
+                                   OFF_T offset, int buffer = NO_BUFFER );
+
+        /**
+         * Queue a write of size bytes from src at the given offset. If the
+         * buffer index is given, src must be inside that registered buffer.
+         */
+        void write( AsyncTarget file, const char* src, size_t size, OFF_T offset,
+                    Callback callback, int buffer = NO_BUFFER );
+
+        std::future<ssize_t> write( AsyncTarget file, const char* src, size_t size,
+                                    OFF_T offset, int buffer = NO_BUFFER );
+
+        /**
+         * Start all the queued operations with a single syscall.
+         * @return The number of submitted operations
+         */
+        size_t submit();
+
+        /**
+         * Wait for all the submitted operations to complete
+         */
+        void wait();
+
+        /* Returns the number of submitted but not completed operations */
+        size_t getInflight() const;
+    };
+}
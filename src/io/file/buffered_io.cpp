@@ -1,7 +1,50 @@
 #include "buffered_io.hpp"
+#include <concurrent/thread.hpp>
 
 using namespace ccl::sys::io;
 
+/**
+ * Background thread flushing the buffer once its content is older than the
+ * max age of the policy. It checks twice per max age, so the actual latency
+ * is bounded by 1.5 times the max age.
+ */
+class BufferedFileIO::Flusher : public ccl::sys::concurrent::Thread
+{
+private:
+    BufferedFileIO* m_owner;
+
+    void run() override
+    {
+        std::unique_lock<std::mutex> _l( m_owner->m_mutex );
+
+        while ( !isCancelled() )
+        {
+            auto period = std::max<std::chrono::milliseconds>(
+                std::chrono::milliseconds(1), m_owner->m_policy.max_age / 2 );
+
+            m_owner->m_flusherCv.wait_for( _l, period );
+            if ( isCancelled() ) break;
+
+            if ( m_owner->isStaleLocked( clock::now() ) ) m_owner->flushLocked();
+        }
+    }
+
+public:
+    explicit Flusher( BufferedFileIO* owner )
+        : Thread( "BufferedFileIO-Flusher", false,
+                  ccl::sys::concurrent::CancellationPolicy::AT_CONDITION_CHECK ),
+          m_owner( owner )
+    {}
+};
+
+BufferedFileIO::BufferedFileIO(const std::string &path)
+    : FileIO( path )
+{}
+
+BufferedFileIO::BufferedFileIO(const std::string &path, iom mode)
+    : FileIO( path, mode )
+{}
+
 BufferedFileIO::BufferedFileIO(const std::string &path, iom mode, size_t buff_size)
     : FileIO( path, mode ), m_buffer( buff_size )
 {
@@ -9,59 +52,196 @@ BufferedFileIO::BufferedFileIO(const std::string &path, iom mode, size_t buff_si
     m_buffer.clear();
 }
 
+BufferedFileIO::BufferedFileIO(const std::string &path, iom mode, size_t buff_size,
+    const FlushPolicy& policy
+) : BufferedFileIO( path, mode, buff_size )
+{
+    setFlushPolicy( policy );
+}
+
+BufferedFileIO::~BufferedFileIO()
+{
+    stopFlusher();
+
+    std::lock_guard<std::mutex> _l( m_mutex );
+    flushLocked();
+}
+
 BufferedFileIO::BufferedFileIO(BufferedFileIO &&other)
-    : FileIO( std::move(other) )
+    : FileIO( ( other.stopFlusher(), std::move(other) ) )
 {
+    std::lock_guard<std::mutex> _l( other.m_mutex );
     m_buffer = std::move( other.m_buffer );
+    m_policy = other.m_policy;
+    m_oldest = other.m_oldest;
+
+    if ( m_policy.max_age.count() > 0 ) startFlusher();
 }
 
 BufferedFileIO &BufferedFileIO::operator=(BufferedFileIO &&other)
 {
-    FileIO::operator=( std::move(other) );
-
     if ( this != &other )
     {
+        stopFlusher();
+        other.stopFlusher();
+
+        // Do not lose what has been written into the current file
+        {
+            std::lock_guard<std::mutex> _l( m_mutex );
+            flushLocked();
+        }
+
+        FileIO::operator=( std::move(other) );
+
+        std::scoped_lock _l( m_mutex, other.m_mutex );
         m_buffer = std::move( other.m_buffer );
+        m_policy = other.m_policy;
+        m_oldest = other.m_oldest;
     }
 
+    if ( m_policy.max_age.count() > 0 ) startFlusher();
     return *this;
 }
 
+void BufferedFileIO::startFlusher()
+{
+    if ( m_flusher != nullptr ) return;
+
+    m_flusher = std::make_unique<Flusher>( this );
+    m_flusher->start();
+}
+
+void BufferedFileIO::stopFlusher()
+{
+    if ( m_flusher == nullptr ) return;
+
+    // Cancel with the lock held, so the flusher cannot miss the notification
+    {
+        std::lock_guard<std::mutex> _l( m_mutex );
+        m_flusher->cancel();
+    }
+
+    m_flusherCv.notify_all();
+    m_flusher->join();
+    m_flusher.reset();
+}
+
 void BufferedFileIO::setBufferCapacity(size_t capacity)
 {
+    std::lock_guard<std::mutex> _l( m_mutex );
     m_buffer.allocate( capacity );
 }
 
+void BufferedFileIO::setFlushPolicy(const FlushPolicy &policy)
+{
+    stopFlusher();
+
+    {
+        std::lock_guard<std::mutex> _l( m_mutex );
+        m_policy = policy;
+    }
+
+    if ( policy.max_age.count() > 0 ) startFlusher();
+}
+
+FlushPolicy BufferedFileIO::getFlushPolicy() const
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+    return m_policy;
+}
+
+size_t BufferedFileIO::getBufferedBytes() const
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+    return m_buffer.getBufferSize();
+}
+
+void BufferedFileIO::append(const char *buff, size_t nbytes)
+{
+    if ( nbytes == 0 ) return;
+    if ( m_buffer.isEmpty() ) m_oldest = clock::now();
+
+    m_buffer.putBuffer( reinterpret_cast<const unsigned char*>(buff), nbytes );
+
+    size_t buffered = m_buffer.getBufferSize();
+    if ( m_buffer.getRemainingCapacity() == 0 ||
+        ( m_policy.max_bytes > 0 && buffered >= m_policy.max_bytes ) )
+    {
+        flushLocked();
+    }
+}
+
+ssize_t BufferedFileIO::writeThrough(std::span<const ConstBuffer> buffers)
+{
+    // Gather the buffered content and the input into a single writev
+    size_t buffered = m_buffer.getBufferSize();
+
+    m_scatter.clear();
+    if ( buffered > 0 )
+    {
+        m_scatter.emplace_back( reinterpret_cast<const char*>(m_buffer.getBuffer()), buffered );
+    }
+
+    m_scatter.insert( m_scatter.end(), buffers.begin(), buffers.end() );
+
+    ssize_t r = FileIO::writev( m_scatter );
+    m_buffer.reset();
+
+    if ( r < 0 ) return -1;
+    return std::max<ssize_t>( 0, r - static_cast<ssize_t>(buffered) );
+}
+
 ssize_t BufferedFileIO::write(const char *buff, size_t nbytes)
 {
-    size_t total_written_bytes = 0;
+    std::lock_guard<std::mutex> _l( m_mutex );
 
-    while ( total_written_bytes < nbytes )
+    if ( nbytes <= m_buffer.getRemainingCapacity() )
     {
-        size_t rem_bytes = nbytes - total_written_bytes;
-        size_t n_bytes_to_write = std::min( rem_bytes, m_buffer.getRemainingCapacity() );
-        const char* next_data = buff + total_written_bytes;
-        
-        m_buffer.putBuffer( 
-            reinterpret_cast<const unsigned char*>(next_data), 
-            n_bytes_to_write );
-
-        if ( m_buffer.getRemainingCapacity() == 0 )
-        {
-            flush();
-        }
+        append( buff, nbytes );
+        return nbytes;
+    }
+
+    // Larger than the free space: no intermediate copy
+    ConstBuffer input( buff, nbytes );
+    return writeThrough( std::span<const ConstBuffer>( &input, 1 ) );
+}
+
+ssize_t BufferedFileIO::writev(std::span<const ConstBuffer> buffers)
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
 
-        total_written_bytes += n_bytes_to_write;
+    size_t total_bytes = 0;
+    for ( const auto& buffer: buffers ) total_bytes += buffer.size();
+
+    if ( total_bytes > m_buffer.getRemainingCapacity() )
+    {
+        return writeThrough( buffers );
     }
 
-    return total_written_bytes;
+    // Coalesce the small writes into the buffer
+    for ( const auto& buffer: buffers ) append( buffer.data(), buffer.size() );
+    return total_bytes;
 }
 
 ssize_t BufferedFileIO::flush()
 {
+    std::lock_guard<std::mutex> _l( m_mutex );
+    return flushLocked();
+}
+
+ssize_t BufferedFileIO::flushLocked()
+{
+    if ( m_buffer.isEmpty() ) return 0;
+
     // Write the entire buffer into the file
     const char* buff = (const char*)m_buffer.getBuffer();
     ssize_t r = FileIO::write( buff, m_buffer.getBufferSize() );
-    m_buffer.clear();
+    m_buffer.reset();
     return r;
 }
+
+bool BufferedFileIO::isStaleLocked(clock::time_point now) const
+{
+    if ( m_buffer.isEmpty() || m_policy.max_age.count() <= 0 ) return false;
+    return now - m_oldest >= m_policy.max_age;
+}
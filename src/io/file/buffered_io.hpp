@@ -1,31 +1,86 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <condition_variable>
 #include "file_io.hpp"
 #include <data_structures/buffers/byte_buffer.hpp>
 
 namespace ccl::sys::io
 {
+    /**
+     * @brief When the content of a BufferedFileIO is flushed, besides
+     * when the buffer is full or flush() is explicitly called.
+     */
+    struct FlushPolicy
+    {
+        // Flush as soon as at least this number of bytes is buffered.
+        // Zero means only when the buffer is full.
+        size_t max_bytes = 0;
+
+        // Flush once the oldest buffered byte is older than this. The check
+        // is performed by a background thread, so that the latency is bounded
+        // even if no more writes arrive. Zero disables the background flush.
+        std::chrono::milliseconds max_age{0};
+    };
+
     /**
      * @brief Buffered version of the File IO Stream
-     * 
+     *
      * It has an internal buffer to fill with content before being flushed
-     * out into the actual file stream. The buffer has a user-defined 
+     * out into the actual file stream. The buffer has a user-defined
      * capacity, which every time it is exceeded it automatically flushes
      * its content into the file.
+     *
+     * Writes that do not fit into the remaining capacity are not copied:
+     * the buffered content and the new data are gathered into a single
+     * writev call. Therefore, large payloads go straight to the file.
+     *
+     * All the operations on the buffer are protected by a mutex, since
+     * a background thread flushes it when the FlushPolicy has a max age.
+     * The content still buffered is flushed on destruction.
      */
     class BufferedFileIO : public FileIO
     {
     private:
+        class Flusher; // The background thread enforcing the max age
+
+        using clock = std::chrono::steady_clock;
+
         ds::buffers::ByteBuffer m_buffer; // The buffer before flushing
-    
+        FlushPolicy             m_policy; // When to flush besides full buffer
+
+        mutable std::mutex       m_mutex;      // Protects the buffer
+        clock::time_point        m_oldest;     // When the buffer became non empty
+        std::vector<ConstBuffer> m_scatter;    // Reused scatter list for writev
+        std::condition_variable  m_flusherCv;  // Wakes up the flusher on stop
+        std::unique_ptr<Flusher> m_flusher;    // Only if the policy has a max age
+
+        void startFlusher();
+        void stopFlusher();
+
+        // All the following functions require the mutex to be held
+        void    append( const char* buff, size_t nbytes );
+        ssize_t writeThrough( std::span<const ConstBuffer> buffers );
+        ssize_t flushLocked();
+        bool    isStaleLocked( clock::time_point now ) const;
+
     public:
-        using FileIO::FileIO; // Use the constructor of the super class
+        // Same as the constructors of the super class. They cannot be just
+        // inherited, since the flusher is an incomplete type in here.
+        explicit BufferedFileIO( const std::string& path );
+        BufferedFileIO( const std::string& path, iom mode );
         BufferedFileIO( const std::string& path, iom mode, size_t buff_size );
-        virtual ~BufferedFileIO() = default;
+        BufferedFileIO( const std::string& path, iom mode, size_t buff_size,
+                        const FlushPolicy& policy );
+
+        virtual ~BufferedFileIO();
 
         BufferedFileIO( BufferedFileIO&& other );
         BufferedFileIO& operator=( BufferedFileIO&& other );
-        
+
         // Delete the copy constructor, no double ownership of the
         // file handler and buffer ( data consistency ).
         BufferedFileIO( const BufferedFileIO& other ) = delete;
@@ -37,21 +92,47 @@ namespace ccl::sys::io
          */
         void setBufferCapacity( size_t capacity );
 
+        /**
+         * Set the flush policy. The background flusher is started or
+         * stopped depending on the max age of the new policy.
+         * @param policy The new flush policy
+         */
+        void setFlushPolicy( const FlushPolicy& policy );
+        FlushPolicy getFlushPolicy() const;
+
+        /**
+         * Returns the number of bytes currently buffered
+         */
+        size_t getBufferedBytes() const;
+
         /**
          * Write the content of the input buffer into the internal buffer.
-         * If the size of the input buffer exceeds the max capacity of the
-         * internale buffer, it would be flushed out and then filled with
-         * the remaining data.
-         * 
+         * If it does not fit into the remaining capacity, the buffered
+         * content and the input are written together with a single
+         * writev, without copying the input.
+         *
          * @param buff The buffer to be written
          * @param nbyts The size of the input buffer
          * @return The total number of bytes written
          */
         ssize_t write( const char* buff, size_t nbytes ) override;
 
+        /**
+         * Write all the buffers of the scatter list. If all of them fit into
+         * the remaining capacity they are coalesced into the internal buffer,
+         * otherwise they are written along with the buffered content with
+         * writev, without any intermediate copy.
+         *
+         * @param buffers The scatter list of buffers to write
+         * @return The total number of bytes written, -1 on error
+         */
+        ssize_t writev( std::span<const ConstBuffer> buffers ) override;
+
+        using FileIO::write;
+
         /**
          * Flush the content of the buffer into the file.
          */
         ssize_t flush();
     };
-};
\ No newline at end of file
+};
@@ -14,6 +14,10 @@ FileIOBase::FileIOBase(FileIOBase &&other) : StreamIO( std::move(other) )
     m_readIdx  = other.m_readIdx;
     m_writeIdx = other.m_writeIdx;
 
+    m_readAhead   = std::move( other.m_readAhead );
+    m_aheadOffset = other.m_aheadOffset;
+    m_aheadSize   = std::exchange( other.m_aheadSize, 0 );
+
     other.m_readIdx = -1;
     other.m_writeIdx = -1;
 }
@@ -29,6 +33,10 @@ FileIOBase &ccl::sys::io::FileIOBase::operator=(FileIOBase &&other)
         m_readIdx  = other.m_readIdx;
         m_writeIdx = other.m_writeIdx;
 
+        m_readAhead   = std::move( other.m_readAhead );
+        m_aheadOffset = other.m_aheadOffset;
+        m_aheadSize   = std::exchange( other.m_aheadSize, 0 );
+
         other.m_readIdx = -1;
         other.m_writeIdx = -1;
     }
@@ -46,51 +54,131 @@ bool FileIOBase::isOpen() const
     return m_handler.isValid();
 }
 
+void FileIOBase::invalidateReadAhead()
+{
+    m_aheadSize = 0;
+}
+
+ssize_t FileIOBase::fillReadAhead()
+{
+    if ( m_readAhead.empty() ) m_readAhead.resize( READ_AHEAD_SIZE );
+    if ( m_aheadSize == m_readAhead.size() ) m_readAhead.resize( 2 * m_readAhead.size() );
+
+    // Read right after the cached range, then restore the read pointer
+    OFF_T prev_read_idx = m_readIdx;
+    m_readIdx = m_aheadOffset + static_cast<OFF_T>( m_aheadSize );
+
+    ssize_t nbytes = read( m_readAhead.data() + m_aheadSize,
+                           m_readAhead.size() - m_aheadSize );
+
+    m_readIdx = prev_read_idx;
+    if ( nbytes > 0 ) m_aheadSize += nbytes;
+    return nbytes;
+}
+
 size_t FileIOBase::getNofLines()
 {
-    // Compute the total number of lines
+    // Compute the total number of lines. The read-ahead buffer is
+    // used as scratch memory, so it must be dropped afterwards.
     OFF_T prev_read_idx = m_readIdx;
+    if ( m_readAhead.empty() ) m_readAhead.resize( READ_AHEAD_SIZE );
 
-    std::string line;
+    char* chunk = m_readAhead.data();
     size_t nof_lines = 0;
-    while ( readLine(line) != 0 ) { nof_lines++; }
-    
+    bool partial_line = false; // If the last line has no terminator
+
+    ssize_t nbytes;
+    while ( ( nbytes = read( chunk, m_readAhead.size() ) ) > 0 )
+    {
+        const char* curr = chunk;
+        const char* last = chunk + nbytes;
+
+        while ( ( curr = static_cast<const char*>( 
+            std::memchr( curr, '\n', last - curr ) ) ) != nullptr )
+        {
+            nof_lines++;
+            curr++;
+        }
+
+        partial_line = chunk[nbytes - 1] != '\n';
+    }
+
+    if ( partial_line ) nof_lines++;
+
+    invalidateReadAhead();
     m_readIdx = prev_read_idx;
     return nof_lines;
 }
 
-ssize_t FileIOBase::readLine(std::string &line)
+ssize_t FileIOBase::readLine(std::string_view &line)
 {
-    if ( m_handler.isValid() )
+    line = std::string_view();
+    if ( !m_handler.isValid() ) return -1;
+
+    // The cached bytes are useless if the read pointer moved out of them
+    OFF_T cached_end = m_aheadOffset + static_cast<OFF_T>( m_aheadSize );
+    if ( m_readIdx < m_aheadOffset || m_readIdx > cached_end )
     {
-        ssize_t total_bytes = 0; // Initialize the total bytes result
-        ssize_t curr_bytes; // The current number of bytes read
-        char curr_ch; // Current char
-        line.clear(); // Clear the destination before reading
+        m_aheadOffset = m_readIdx;
+        m_aheadSize = 0;
+    }
+
+    size_t start   = static_cast<size_t>( m_readIdx - m_aheadOffset );
+    size_t scanned = start; // Bytes already searched for the terminator
+    size_t stop;            // One past the last byte of the line
 
-        do
+    while ( true )
+    {
+        const char* data = m_readAhead.data();
+        const void* found = ( m_aheadSize > scanned ) 
+            ? std::memchr( data + scanned, '\n', m_aheadSize - scanned )
+            : nullptr;
+
+        if ( found != nullptr )
         {
-            // Read a single character from the current position and
-            // check for any potential error (-1 is returned).
-            if ( ( curr_bytes = read( &curr_ch, (size_t)1 ) ) < 0 )
-            {
-                line.clear();
-                return -1;
-            }
-
-            // Check for EOF (End Of File)
-            if ( curr_bytes == 0 ) break;
-            
-            // Updates the line and the total count
-            line += curr_ch;
-            total_bytes++;
+            stop = static_cast<const char*>( found ) - data + 1;
+            break;
+        }
 
-        } while (curr_ch != '\n');
+        scanned = m_aheadSize;
+
+        // Move the beginning of the line at the front before reading more
+        if ( start > 0 )
+        {
+            std::memmove( m_readAhead.data(), data + start, m_aheadSize - start );
+            m_aheadOffset += start;
+            m_aheadSize   -= start;
+            scanned       -= start;
+            start          = 0;
+        }
 
-        return total_bytes;
+        ssize_t nbytes = fillReadAhead();
+        if ( nbytes < 0 ) return -1;
+        if ( nbytes == 0 )
+        {
+            stop = m_aheadSize; // End of file, the last line has no terminator
+            break;
+        }
     }
 
-    return -1;
+    line = std::string_view( m_readAhead.data() + start, stop - start );
+    m_readIdx = m_aheadOffset + static_cast<OFF_T>( stop );
+    return static_cast<ssize_t>( stop - start );
+}
+
+ssize_t FileIOBase::readLine(std::string &line)
+{
+    std::string_view view;
+    ssize_t total_bytes = readLine( view );
+
+    if ( total_bytes < 0 )
+    {
+        line.clear();
+        return -1;
+    }
+
+    line.assign( view.data(), view.size() );
+    return total_bytes;
 }
 
 void FileIOBase::read(std::string &dest)
@@ -175,23 +263,47 @@ std::string &ccl::sys::io::operator>>(FileIOBase &stream, std::string &dest)
     return dest;
 }
 
-file_iterator::file_iterator(FileIOBase *file_io, size_t size)
-    : Base( file_io, size ), m_fileSize( size )
+file_iterator::file_iterator(FileIOBase *file_io, size_t pos)
+    : Base( file_io, pos )
+{
+    if ( m_pos != npos ) readNext();
+}
+
+void file_iterator::readNext()
 {
+    // Both the end of file and any error end the iteration
+    if ( m_iterable->readLine( m_currLine ) <= 0 ) m_pos = npos;
 }
 
 file_iterator::reference file_iterator::operator*() const
 {
-    m_iterable->readLine( m_currLine );
     return m_currLine;
 }
 
 file_iterator::pointer file_iterator::operator->() const
 {
-    m_iterable->readLine( m_currLine );
     return &m_currLine;
 }
 
+file_iterator &file_iterator::operator++()
+{
+    if ( m_pos == npos ) return *this;
+
+    ++m_pos;
+    readNext();
+    return *this;
+}
+
+bool file_iterator::operator==(const file_iterator &other) const
+{
+    return m_iterable == other.m_iterable && m_pos == other.m_pos;
+}
+
+bool file_iterator::operator!=(const file_iterator &other) const
+{
+    return !( *this == other );
+}
+
 FileIOIterable::iterator FileIOIterable::begin()
 {
     return iterator( this, 0 );
@@ -199,7 +311,7 @@ FileIOIterable::iterator FileIOIterable::begin()
 
 FileIOIterable::iterator FileIOIterable::end()
 {
-    return iterator( this, getNofLines() );
+    return iterator( this, iterator::npos );
 }
 
 #ifndef _WIN32
@@ -300,6 +412,7 @@ ssize_t FileIO::write(const char *src, size_t nbytes)
 {
     if ( m_handler.isValid() )
     {
+        invalidateReadAhead();
         lseek( m_handler.get(), m_writeIdx, static_cast<int>(iop::Beg) );
 
         ssize_t nw_bytes;
@@ -319,6 +432,65 @@ ssize_t FileIO::write(const char *src, size_t nbytes)
     return -1;
 }
 
+ssize_t FileIO::writev(std::span<const ConstBuffer> buffers)
+{
+    if ( !m_handler.isValid() ) return -1;
+
+    invalidateReadAhead();
+    lseek( m_handler.get(), m_writeIdx, static_cast<int>(iop::Beg) );
+
+    struct iovec iov[WRITEV_BATCH];
+    size_t total_written_bytes = 0;
+    size_t next = 0;   // The next buffer to put into the batch
+    size_t offset = 0; // Bytes of the next buffer already written
+
+    while ( next < buffers.size() )
+    {
+        // Fill the batch skipping empty buffers
+        int iovcnt = 0;
+        for ( size_t idx = next; idx < buffers.size() && iovcnt < (int)WRITEV_BATCH; ++idx )
+        {
+            size_t skip = ( idx == next ) ? offset : 0;
+            if ( buffers[idx].size() <= skip ) continue;
+
+            iov[iovcnt].iov_base = const_cast<char*>( buffers[idx].data() + skip );
+            iov[iovcnt].iov_len  = buffers[idx].size() - skip;
+            iovcnt++;
+        }
+
+        if ( iovcnt == 0 ) break;
+
+        ssize_t nw_bytes;
+        if ( ( nw_bytes = ::writev( m_handler.get(), iov, iovcnt ) ) < 0 )
+        {
+            if ( errno == EINTR ) continue;
+
+            std::cerr << "Unable to write bytes into " << m_filePath
+                      << " [Error]: " << std::strerror(errno)
+                      << std::endl;
+
+            return -1;
+        }
+
+        m_writeIdx += nw_bytes;
+        total_written_bytes += nw_bytes;
+
+        // Move forward of the written bytes, the remaining part of a
+        // partially written buffer is resumed by the next call.
+        size_t consumed = static_cast<size_t>( nw_bytes );
+        while ( next < buffers.size() && consumed >= buffers[next].size() - offset )
+        {
+            consumed -= buffers[next].size() - offset;
+            offset = 0;
+            next++;
+        }
+
+        offset += consumed;
+    }
+
+    return total_written_bytes;
+}
+
 #else
 
 // TODO: Do something for windows version
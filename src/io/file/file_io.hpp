@@ -3,7 +3,10 @@
 #include <type_traits>
 #include <fstream>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <cstring>
+#include <span>
 #include <io/base/stream_io.hpp>
 #include <data_structures/base/iterators.hpp>
 
@@ -13,6 +16,7 @@
 #ifndef _WIN32
 
 #include <sys/stat.h>
+#include <sys/uio.h>
 #define FLAG_T int
 #define OFF_T  off_t
 
@@ -110,12 +114,35 @@ namespace ccl::sys::io
     public:
         using T = typename std::string;
 
+        // Initial size of the read-ahead buffer used to read lines
+        static constexpr size_t READ_AHEAD_SIZE = 64 * 1024;
+
     protected:
         std::string m_filePath; // The path of the current file
         iom         m_openMode; // The open mode of the current file
 
         OFF_T m_readIdx  = 0; // The position of the read pointer
         OFF_T m_writeIdx = 0; // The position of the write pointer
+
+        // Read-ahead buffer for line reading. It caches the file content
+        // starting at m_aheadOffset, and it is used as long as the read
+        // pointer falls inside the cached range.
+        std::vector<char> m_readAhead;
+        OFF_T             m_aheadOffset = 0; // File offset of the first cached byte
+        size_t            m_aheadSize   = 0; // Number of valid cached bytes
+
+        /**
+         * Drop the content of the read-ahead buffer. It must be called
+         * by each write, since the cached bytes could be overwritten.
+         */
+        void invalidateReadAhead();
+
+        /**
+         * Read more bytes from the file at the end of the cached range,
+         * growing the read-ahead buffer if it is full. The read pointer
+         * is not modified. Returns the number of read bytes, -1 on error.
+         */
+        ssize_t fillReadAhead();
     
     public:
         FileIOBase( const std::string& path, iom flags )
@@ -164,11 +191,13 @@ namespace ccl::sys::io
         OFF_T tellg() const;
 
         /**
-         * Returns the total number of lines
+         * Returns the total number of lines from the read pointer up to
+         * the end of the file. The file is scanned in a single pass, large
+         * chunks at a time, and the read pointer is left untouched.
          */
         size_t getNofLines();
 
-                /**
+        /**
          * Reads a single line from the file and returns the total number
          * of bytes read. Returns -1 if any error, >= 0 otherwise.
          * 
@@ -177,6 +206,21 @@ namespace ccl::sys::io
          */
         ssize_t readLine( std::string& line );
 
+        /**
+         * Same as readLine with a string destination, but no copy is made:
+         * the line (terminator included, if any) is a view on the internal
+         * read-ahead buffer. The file is read in chunks of READ_AHEAD_SIZE
+         * bytes and scanned with memchr, so reading a line costs no syscall
+         * at all most of the times.
+         *
+         * IMPORTANT: the view is valid only until the next read or write
+         * operation on the file.
+         *
+         * @param line The view on the read line
+         * @return Total number of bytes read
+         */
+        ssize_t readLine( std::string_view& line );
+
         /**
          * Read the entire file content into the input string.
          * @param dest The destination string for file content
@@ -194,7 +238,10 @@ namespace ccl::sys::io
 
     /**
      * @brief Simple iterator class for File streams.
-     * This iterator iterates over the rows of the file.
+     * This iterator iterates over the rows of the file. Each increment
+     * reads the next line, and once the end of the file is reached the
+     * iterator becomes equal to the end one (position npos). Therefore,
+     * it is meant to be used as a forward, single pass, iterator.
      */
     class file_iterator : 
         public ds::base::abstract_iterator<FileIOBase::T,
@@ -211,13 +258,24 @@ namespace ccl::sys::io
         using typename Base::pointer;
 
         mutable FileIOBase::T m_currLine; // The current line read from the file
-        size_t                m_fileSize; // The current size of the file
+
+        void readNext(); // Read the next line or move to the end
 
     public:
-        file_iterator( FileIOBase* file_io, size_t size );
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        /**
+         * If the position is not npos, the first line is read immediately.
+         */
+        file_iterator( FileIOBase* file_io, size_t pos );
 
         reference operator* () const override;
         pointer   operator->() const override;
+
+        file_iterator& operator++() override;
+
+        bool operator==( const file_iterator& other ) const;
+        bool operator!=( const file_iterator& other ) const;
     };
 
     /**
@@ -227,10 +285,11 @@ namespace ccl::sys::io
      * and `end` method. As already said, it iterates for each
      * row in the input file.
      * 
-     * Note on thread-safety: It is not thread safe. Once the
-     * iterator is created the total number of lines set is fixed.
-     * Which means that, if another thread removes a line from the
-     * file, the object will continue iterates returning empty lines.
+     * The iteration starts from the current read pointer and stops
+     * at the end of the file, which is not known in advance: end()
+     * does not need to count the lines.
+     *
+     * Note on thread-safety: It is not thread safe.
      */
     class FileIOIterable : public FileIOBase
     {
@@ -277,6 +336,11 @@ namespace ccl::sys::io
         static const iom DEFAULT_OPEN_FLAGS;
 
     public:
+        using ConstBuffer = std::span<const char>; // A single entry of a scatter list
+
+        // Maximum number of entries handed to a single writev call
+        static constexpr size_t WRITEV_BATCH = 64;
+
         FileIO( const std::string& path, iom flags = DEFAULT_OPEN_FLAGS );
         virtual ~FileIO() = default;
 
@@ -332,6 +396,18 @@ namespace ccl::sys::io
          */
         virtual ssize_t write( const char* src, size_t nbytes ) override;
 
+        /**
+         * Gathers all the input buffers, in order, and writes them into the
+         * file with the least number of writev calls (one for each batch of
+         * WRITEV_BATCH buffers), without any intermediate copy. Short writes
+         * are resumed until all the bytes are written. It returns -1 on
+         * error, otherwise the total number of written bytes.
+         *
+         * @param buffers The scatter list of buffers to write
+         * @return The total number of written bytes
+         */
+        virtual ssize_t writev( std::span<const ConstBuffer> buffers );
+
         using StreamIO::write; // Take the write with string input
     };
 }
\ No newline at end of file
@@ -121,6 +121,9 @@ void MappedFileIO::remap( OFF_T size, bool keep_size )
     unsigned char* data = static_cast<unsigned char*>( addr );
 
     m_mapBuffer.setBuffer( data, size, keep_size );
+
+    // The advices belong to the previous mapping
+    if ( m_advice != advf::Normal ) advise( m_advice );
 }
 
 OFF_T MappedFileIO::compute_position(OFF_T offset, iop position) const
@@ -141,7 +144,12 @@ void MappedFileIO::set_position(OFF_T position)
 {
     size_t n_position = static_cast<size_t>(position);
 
-    if ( n_position >= m_mapBuffer.getBufferCapacity() )
+    // A read-only mapping cannot grow, stop at the end of the file
+    if ( !is_writable() )
+    {
+        n_position = std::min( n_position, m_mapBuffer.getBufferCapacity() );
+    }
+    else if ( n_position >= m_mapBuffer.getBufferCapacity() )
     {
         // This means that we would like to access data outside the current capacity
         size_t size = m_growFactor * static_cast<size_t>(getSize());
@@ -155,6 +163,32 @@ void MappedFileIO::set_position(OFF_T position)
     m_mapBuffer.position( n_position );
 }
 
+bool MappedFileIO::is_writable() const
+{
+    return to_bool( m_protFlags & protf::Write );
+}
+
+bool MappedFileIO::page_range(OFF_T offset, size_t length, void *&addr, size_t &size) const
+{
+    size_t capacity = m_mapBuffer.getBufferCapacity();
+    if ( offset < 0 || static_cast<size_t>(offset) >= capacity || length == 0 ) return false;
+
+    size_t start = static_cast<size_t>( offset );
+    size_t stop  = std::min( capacity, start + length );
+
+#ifndef _WIN32
+    size_t page_size = static_cast<size_t>( sysconf( _SC_PAGESIZE ) );
+#else
+    size_t page_size = 4096;
+#endif
+
+    // The mapping itself is page aligned, so aligning the offset is enough
+    size_t aligned = start & ~( page_size - 1 );
+    addr = m_mapBuffer.getBuffer() + aligned;
+    size = stop - aligned;
+    return true;
+}
+
 void MappedFileIO::free()
 {
 #ifndef _WIN32
@@ -199,26 +233,35 @@ MappedFileIO::MappedFileIO(const std::string &filePath, iom mode, protf pfl, map
     seekp( 0, pos );
 }
 
-MappedFileIO::~MappedFileIO()
+MappedFileIO::MappedFileIO(const std::string &filePath, advf advice)
+    : MappedFileIO( filePath, iom::Read, protf::Read, mapf::Shared )
 {
-    free();
+    advise( advice );
+}
 
-    if ( m_policy == MSyncPolicy::SYNC_ON_CLOSE )
+MappedFileIO::~MappedFileIO()
+{
+    // The pages must be synchronized before unmapping them
+    if ( m_policy == MSyncPolicy::SYNC_ON_CLOSE && is_writable() )
     {
-        msync( m_mapBuffer.getBuffer(), m_mapBuffer.getBufferCapacity(), MS_SYNC );
+        msync( 0, m_mapBuffer.getBufferCapacity() );
     }
+
+    free();
 }
 
 void MappedFileIO::seekg( OFF_T offset, iop position )
 {
     m_readIdx = compute_position( offset, position );
     set_position( m_readIdx );
+    m_readIdx = m_mapBuffer.position(); // Clamped on read-only mappings
 }
 
 void MappedFileIO::seekp( OFF_T offset, iop position )
 {
     m_writeIdx = compute_position( offset, position );
     set_position( m_writeIdx );
+    m_writeIdx = m_mapBuffer.position(); // Clamped on read-only mappings
 }
 
 ssize_t MappedFileIO::read(char *dst, size_t rsize)
@@ -242,6 +285,8 @@ ssize_t MappedFileIO::write(const char *src, size_t nbytes)
     // Check if we can even write into the buffer
     if ( !to_bool( m_protFlags & protf::Write ) ) return 0;
 
+    invalidateReadAhead();
+
     // Check the total number of remaining bytes
     if ( m_writeIdx + nbytes > m_mapBuffer.getBufferCapacity() )
     {
@@ -249,19 +294,13 @@ ssize_t MappedFileIO::write(const char *src, size_t nbytes)
         remap( nsize, true );
     }
 
+    OFF_T start = m_writeIdx;
     m_mapBuffer.position( m_writeIdx );
     m_mapBuffer.putBuffer( reinterpret_cast<const unsigned char*>(src), nbytes );
     m_writeIdx = m_mapBuffer.position();
 
-    if ( m_policy == MSyncPolicy::SYNC_ON_WRITE )
-    {
-#ifndef _WIN32
-        int res = msync( m_mapBuffer.getBuffer(), m_mapBuffer.getBufferSize(), MS_SYNC );
-        std::cout << res << std::endl;
-#else
-        // Do something for Windows
-#endif
-    }
+    // Only the pages touched by this write need to be synchronized
+    if ( m_policy == MSyncPolicy::SYNC_ON_WRITE ) msync( start, nbytes );
 
     return nbytes;
 }
@@ -275,3 +314,91 @@ void MappedFileIO::setSyncPolicy(MSyncPolicy policy)
 {
     m_policy = policy;
 }
+
+bool MappedFileIO::advise(advf advice)
+{
+    if ( to_bool( advice & advf::Sequential ) && to_bool( advice & advf::Random ) )
+    {
+        throw std::runtime_error( "Cannot advise SEQUENTIAL and RANDOM together" );
+    }
+
+    m_advice = advice;
+    bool accepted = true;
+
+#ifndef _WIN32
+
+    void* addr = m_mapBuffer.getBuffer();
+    size_t size = m_mapBuffer.getBufferCapacity();
+    if ( addr == nullptr || size == 0 ) return false;
+
+    auto apply = [addr, size, &accepted]( int flag )
+    {
+        if ( ::madvise( addr, size, flag ) != 0 ) accepted = false;
+    };
+
+    if ( advice == advf::Normal ) apply( MADV_NORMAL );
+    if ( to_bool( advice & advf::Sequential ) ) apply( MADV_SEQUENTIAL );
+    if ( to_bool( advice & advf::Random     ) ) apply( MADV_RANDOM );
+    if ( to_bool( advice & advf::WillNeed   ) ) apply( MADV_WILLNEED );
+
+#ifdef MADV_HUGEPAGE
+    if ( to_bool( advice & advf::HugePage ) ) apply( MADV_HUGEPAGE );
+#else
+    if ( to_bool( advice & advf::HugePage ) ) accepted = false;
+#endif
+
+#else
+
+    // TODO: PrefetchVirtualMemory for the Windows version
+    accepted = advice == advf::Normal;
+
+#endif
+
+    return accepted;
+}
+
+void MappedFileIO::prefetch(OFF_T offset, size_t length)
+{
+    void* addr;
+    size_t size;
+    if ( !page_range( offset, length, addr, size ) ) return;
+
+#ifndef _WIN32
+    ::madvise( addr, size, MADV_WILLNEED );
+#endif
+}
+
+void MappedFileIO::evict(OFF_T offset, size_t length)
+{
+    void* addr;
+    size_t size;
+    if ( !page_range( offset, length, addr, size ) ) return;
+
+#ifndef _WIN32
+    // Drop the pages from the mapping, then from the page cache
+    ::madvise( addr, size, MADV_DONTNEED );
+    ::posix_fadvise( m_handler.get(), offset, static_cast<OFF_T>( length ), POSIX_FADV_DONTNEED );
+#endif
+}
+
+bool MappedFileIO::msync(OFF_T offset, size_t length, bool async)
+{
+    void* addr;
+    size_t size;
+    if ( !page_range( offset, length, addr, size ) ) return true;
+
+#ifndef _WIN32
+    if ( ::msync( addr, size, async ? MS_ASYNC : MS_SYNC ) != 0 )
+    {
+        std::cerr << "Unable to synchronize " << m_filePath << " [Error]: "
+                  << get_last_error_string()
+                  << std::endl;
+
+        return false;
+    }
+#else
+    // TODO: FlushViewOfFile for the Windows version
+#endif
+
+    return true;
+}
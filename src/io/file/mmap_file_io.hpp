@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <type_traits>
 #include <data_structures/buffers/byte_buffer.hpp>
 
@@ -77,6 +78,23 @@ namespace ccl::sys::io
 
     template<> struct enable_bitmask_operator<mapf> : std::true_type {};
 
+    /**
+     * @brief Advice flags
+     *
+     * These describe the expected access pattern (see madvise). Sequential
+     * and Random are mutually exclusive.
+     */
+    enum class advf : unsigned
+    {
+        Normal     = 0,      // No special treatment
+        Sequential = 1 << 0, // Aggressive read-ahead, pages freed soon after access
+        Random     = 1 << 1, // No read-ahead
+        WillNeed   = 1 << 2, // Start reading the pages in background
+        HugePage   = 1 << 3  // Back the mapping with transparent huge pages
+    };
+
+    template<> struct enable_bitmask_operator<advf> : std::true_type {};
+
     FLAG_T __make_flags( protf flags );
     FLAG_T __make_flags( mapf flags );
 
@@ -87,7 +105,13 @@ namespace ccl::sys::io
     };
 
     /**
-     * @brief
+     * @brief File stream on a memory mapping of the whole file.
+     *
+     * Reads and writes are plain copies from and to the mapping, which grows
+     * (remapping the file) when a write goes beyond its capacity. A read-only
+     * mapping never grows. The expected access pattern can be passed to the
+     * kernel with advise(), and single ranges can be prefetched, evicted or
+     * synchronized with the file.
      */
     class MappedFileIO : public FileIOBase
     {
@@ -95,6 +119,7 @@ namespace ccl::sys::io
         ds::buffers::ByteBuffer m_mapBuffer; // The buffer with the file content
         protf                   m_protFlags; // Input protection flags
         mapf                    m_mapFlags;  // Input map flags
+        advf                    m_advice = advf::Normal; // Re-applied on remap
 
         size_t m_growFactor  = 2; // The capacity grow factor
         MSyncPolicy m_policy = MSyncPolicy::SYNC_ON_WRITE;
@@ -110,10 +135,28 @@ namespace ccl::sys::io
         OFF_T compute_position( OFF_T offset, iop position ) const;
         void  set_position    ( OFF_T position );
 
+        bool is_writable() const;
+
+        /**
+         * Clamp the range to the mapping and align its start to the page
+         * size. Returns false if the range is empty.
+         */
+        bool page_range( OFF_T offset, size_t length, void*& addr, size_t& size ) const;
+
         void free();
 
     public:
         MappedFileIO( const std::string& filePath, iom mode, protf pfl, mapf mfl );
+
+        /**
+         * Read-only mapping of the file with the given access pattern. Writes
+         * are ignored and the mapping never grows.
+         *
+         * @param filePath The file to map
+         * @param advice The expected access pattern
+         */
+        MappedFileIO( const std::string& filePath, advf advice = advf::Sequential );
+
         virtual ~MappedFileIO();
 
         /**
@@ -171,5 +214,46 @@ namespace ccl::sys::io
          * Set the synchronization policy.
          */
         void setSyncPolicy( MSyncPolicy policy );
+
+        /**
+         * Give the kernel the expected access pattern of the whole mapping.
+         * The advice is kept and applied again when the file is remapped.
+         * Advices are only hints: it returns false if any of them has been
+         * rejected (e.g., HugePage on file systems not supporting it).
+         *
+         * @param advice The access pattern flags
+         * @return True if all the advices have been accepted
+         */
+        bool advise( advf advice );
+
+        /**
+         * Start reading the given range of the file in background, so that
+         * later accesses do not page-fault on the disk.
+         *
+         * @param offset The start of the range
+         * @param length The length of the range in bytes
+         */
+        void prefetch( OFF_T offset, size_t length );
+
+        /**
+         * Release the pages of the given range, both from the mapping and
+         * from the page cache (only clean pages). Useful to scan files way
+         * larger than the memory. Notice that on a private writable mapping
+         * the modifications of the range are lost.
+         *
+         * @param offset The start of the range
+         * @param length The length of the range in bytes
+         */
+        void evict( OFF_T offset, size_t length );
+
+        /**
+         * Write back the modified pages of the given range into the file.
+         *
+         * @param offset The start of the range
+         * @param length The length of the range in bytes
+         * @param async If true, schedule the write back without waiting
+         * @return True on success
+         */
+        bool msync( OFF_T offset, size_t length, bool async = false );
     };
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "segmented_mmap_io.hpp"
+
+using namespace ccl::sys::io;
+
+SegmentedMappedFileIO::SegmentedMappedFileIO(const std::string &filePath, iom mode,
+    size_t window_size, size_t max_windows
+) : FileIOBase( filePath, mode ), m_maxWindows( std::max<size_t>( 1, max_windows ) )
+{
+    m_handler.reset( __open_file( filePath, mode ) );
+
+#ifndef _WIN32
+    size_t page_size = static_cast<size_t>( sysconf( _SC_PAGESIZE ) );
+    m_protFlags = PROT_READ | ( iom2bool( mode & iom::Write ) ? PROT_WRITE : 0 );
+#else
+    size_t page_size = 4096;
+    m_protFlags = 0; // TODO: Windows version
+#endif
+
+    // Windows are mapped at multiples of their size, which must be page aligned
+    m_windowSize = std::max( page_size, window_size );
+    m_windowSize = ( m_windowSize + page_size - 1 ) / page_size * page_size;
+
+    m_length = getSize();
+    m_capacity = m_length;
+
+    seekg( 0, iop::Beg );
+
+    iop pos = iom2bool( mode & iom::App ) ? iop::End : iop::Beg;
+    seekp( 0, pos );
+}
+
+SegmentedMappedFileIO::~SegmentedMappedFileIO()
+{
+    for ( const auto& win: m_windows ) unmap( win );
+
+    // Remove the padding of the last segment
+    if ( is_writable() && m_capacity != m_length )
+    {
+#ifndef _WIN32
+        if ( ftruncate( m_handler.get(), m_length ) < 0 )
+        {
+            std::cerr << "Unable to resize the file " << m_filePath << " [Error]: "
+                      << get_last_error_string()
+                      << std::endl;
+        }
+#endif
+    }
+}
+
+bool SegmentedMappedFileIO::is_writable() const
+{
+    return iom2bool( m_openMode & iom::Write );
+}
+
+SegmentedMappedFileIO::Window &SegmentedMappedFileIO::window(size_t index)
+{
+    // Fast path: sequential accesses keep hitting the same window
+    if ( !m_windows.empty() && m_windows.front().m_index == index )
+    {
+        return m_windows.front();
+    }
+
+    auto it = m_lookup.find( index );
+    if ( it != m_lookup.end() )
+    {
+        m_windows.splice( m_windows.begin(), m_windows, it->second );
+        return m_windows.front();
+    }
+
+    // Make room for the new window evicting the least recently used one
+    if ( m_windows.size() >= m_maxWindows )
+    {
+        unmap( m_windows.back() );
+        m_lookup.erase( m_windows.back().m_index );
+        m_windows.pop_back();
+    }
+
+    void* addr = nullptr;
+
+#ifndef _WIN32
+    OFF_T offset = static_cast<OFF_T>( index * m_windowSize );
+    addr = ::mmap( nullptr, m_windowSize, m_protFlags, MAP_SHARED, m_handler.get(), offset );
+    if ( addr == MAP_FAILED ) addr = nullptr;
+#else
+    // TODO: MapViewOfFile for the Windows version
+#endif
+
+    if ( addr == nullptr )
+    {
+        std::stringstream ss;
+        ss << "Unable to Memory map window " << index << " of file " << m_filePath
+           << " [Error]: "
+           << get_last_error_string()
+           << std::endl;
+
+        throw std::runtime_error( ss.str() );
+    }
+
+    m_windows.push_front( Window{ index, static_cast<char*>( addr ), m_windowSize } );
+    m_lookup[index] = m_windows.begin();
+    return m_windows.front();
+}
+
+void SegmentedMappedFileIO::unmap(const Window &window)
+{
+#ifndef _WIN32
+    munmap( static_cast<void*>( window.m_data ), window.m_size );
+#else
+    UnmapViewOfFile( static_cast<void*>( window.m_data ) );
+#endif
+}
+
+void SegmentedMappedFileIO::grow(OFF_T size)
+{
+    // Append whole segments, the live windows are still valid
+    OFF_T segment = static_cast<OFF_T>( m_windowSize );
+    OFF_T capacity = ( size + segment - 1 ) / segment * segment;
+
+    int result = 0;
+
+#ifndef _WIN32
+    result = ftruncate( m_handler.get(), capacity );
+#else
+    // TODO: SetFileInformationByHandle for the Windows version
+#endif
+
+    if ( result < 0 )
+    {
+        std::stringstream ss;
+        ss << "Unable to resize the file " << m_filePath << " [Error]: "
+           << get_last_error_string()
+           << std::endl;
+
+        throw std::runtime_error( ss.str() );
+    }
+
+    m_capacity = capacity;
+}
+
+OFF_T SegmentedMappedFileIO::compute_position(OFF_T offset, iop position, OFF_T current) const
+{
+    OFF_T result = 0;
+
+    switch ( position )
+    {
+        case iop::Beg: result = offset; break;
+        case iop::Cur: result = current + offset; break;
+        case iop::End: result = m_length + offset; break;
+    }
+
+    return result;
+}
+
+void SegmentedMappedFileIO::seekg(OFF_T offset, iop position)
+{
+    OFF_T result = compute_position( offset, position, m_readIdx );
+
+    m_readIdx = std::clamp<OFF_T>( result, 0, m_length );
+}
+
+void SegmentedMappedFileIO::seekp(OFF_T offset, iop position)
+{
+    OFF_T result = compute_position( offset, position, m_writeIdx );
+
+    m_writeIdx = std::max<OFF_T>( result, 0 );
+    if ( !is_writable() ) m_writeIdx = std::min( m_writeIdx, m_length );
+}
+
+ssize_t SegmentedMappedFileIO::read(char *dst, size_t rsize)
+{
+    if ( m_readIdx >= m_length ) return 0;
+
+    rsize = std::min( rsize, static_cast<size_t>( m_length - m_readIdx ) );
+    size_t total_bytes = 0;
+
+    while ( total_bytes < rsize )
+    {
+        size_t position = static_cast<size_t>( m_readIdx );
+        Window& win = window( position / m_windowSize );
+
+        size_t start = position % m_windowSize;
+        size_t nbytes = std::min( rsize - total_bytes, win.m_size - start );
+
+        std::memcpy( dst + total_bytes, win.m_data + start, nbytes );
+        total_bytes += nbytes;
+        m_readIdx += nbytes;
+    }
+
+    return total_bytes;
+}
+
+ssize_t SegmentedMappedFileIO::write(const char *src, size_t nbytes)
+{
+    if ( !is_writable() ) return 0;
+
+    invalidateReadAhead();
+
+    OFF_T end = m_writeIdx + static_cast<OFF_T>( nbytes );
+    if ( end > m_capacity ) grow( end );
+
+    size_t total_bytes = 0;
+
+    while ( total_bytes < nbytes )
+    {
+        size_t position = static_cast<size_t>( m_writeIdx );
+        Window& win = window( position / m_windowSize );
+
+        size_t start = position % m_windowSize;
+        size_t chunk = std::min( nbytes - total_bytes, win.m_size - start );
+
+        std::memcpy( win.m_data + start, src + total_bytes, chunk );
+        total_bytes += chunk;
+        m_writeIdx += chunk;
+    }
+
+    m_length = std::max( m_length, end );
+    return total_bytes;
+}
+
+bool SegmentedMappedFileIO::sync(bool async)
+{
+    bool result = true;
+
+#ifndef _WIN32
+    for ( const auto& win: m_windows )
+    {
+        if ( ::msync( win.m_data, win.m_size, async ? MS_ASYNC : MS_SYNC ) != 0 )
+        {
+            result = false;
+        }
+    }
+#endif
+
+    return result;
+}
+
+OFF_T SegmentedMappedFileIO::getLength() const
+{
+    return m_length;
+}
+
+size_t SegmentedMappedFileIO::getWindowSize() const
+{
+    return m_windowSize;
+}
+
+size_t SegmentedMappedFileIO::getNofLiveWindows() const
+{
+    return m_windows.size();
+}
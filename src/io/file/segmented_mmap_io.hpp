@@ -0,0 +1,123 @@
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include "mmap_file_io.hpp"
+
+namespace ccl::sys::io
+{
+    /**
+     * @brief File stream on memory mapped windows of the file.
+     *
+     * Unlike MappedFileIO, the file is never mapped as a whole: it is split
+     * into fixed-size windows (segments) that are mapped on demand, when the
+     * read or write pointer enters them. At most a given number of windows
+     * is kept alive, the least recently used one is unmapped to make room
+     * for a new one. Hence, the virtual memory used is bounded regardless of
+     * the file size.
+     *
+     * When a write goes beyond the end of the file, the file grows by whole
+     * segments: the windows already mapped are left untouched, since there is
+     * no remapping at all. On destruction the file is truncated back to the
+     * last written byte. Meanwhile, getSize() returns the size on disk, that
+     * is rounded up to the segment size, while getLength() returns the
+     * number of bytes actually written.
+     *
+     * Note on thread-safety: It is not thread safe.
+     */
+    class SegmentedMappedFileIO : public FileIOBase
+    {
+    public:
+        static constexpr size_t DEFAULT_WINDOW_SIZE = 64 * 1024 * 1024;
+        static constexpr size_t DEFAULT_MAX_WINDOWS = 8;
+
+    private:
+        struct Window
+        {
+            size_t m_index; // Window number, i.e. file offset / window size
+            char*  m_data;  // Start of the mapping
+            size_t m_size;  // Length of the mapping
+        };
+
+        using WindowList = std::list<Window>;
+
+        size_t m_windowSize; // Size of a window, multiple of the page size
+        size_t m_maxWindows; // Maximum number of live windows
+        OFF_T  m_length;     // Logical size of the file (written bytes)
+        OFF_T  m_capacity;   // Size of the file on disk
+        FLAG_T m_protFlags;  // Native protection flags of the windows
+
+        WindowList                                       m_windows; // Most recent first
+        std::unordered_map<size_t, WindowList::iterator> m_lookup;  // Index to window
+
+        bool is_writable() const;
+
+        /**
+         * Returns the window with the given index, mapping it if needed
+         * and marking it as the most recently used one.
+         */
+        Window& window( size_t index );
+
+        void unmap( const Window& window );
+
+        /* Grow the file on disk by whole segments to hold size bytes */
+        void grow( OFF_T size );
+
+        OFF_T compute_position( OFF_T offset, iop position, OFF_T current ) const;
+
+    public:
+        /**
+         * @param filePath The file to map
+         * @param mode The open mode. The file is writable only with iom::Write
+         * @param window_size The size of each window, rounded up to the page size
+         * @param max_windows The maximum number of windows mapped at once
+         */
+        SegmentedMappedFileIO( const std::string& filePath, iom mode,
+                               size_t window_size = DEFAULT_WINDOW_SIZE,
+                               size_t max_windows = DEFAULT_MAX_WINDOWS );
+
+        SegmentedMappedFileIO( const SegmentedMappedFileIO& ) = delete;
+        SegmentedMappedFileIO& operator=( const SegmentedMappedFileIO& ) = delete;
+
+        virtual ~SegmentedMappedFileIO();
+
+        /**
+         * Move the read pointer. It cannot go beyond the last written byte.
+         */
+        void seekg( OFF_T offset, iop position ) override;
+
+        /**
+         * Move the write pointer. Going beyond the end leaves a hole that
+         * is filled with zeros.
+         */
+        void seekp( OFF_T offset, iop position ) override;
+
+        /**
+         * Read at most rsize bytes into dst, crossing windows if needed.
+         * @return The total number of bytes read
+         */
+        ssize_t read( char* dst, size_t rsize ) override;
+
+        /**
+         * Write nbytes from src at the write pointer, crossing windows and
+         * growing the file by whole segments if needed. On read-only files
+         * nothing is written and it returns 0.
+         *
+         * @return The total number of written bytes
+         */
+        ssize_t write( const char* src, size_t nbytes ) override;
+
+        /**
+         * Write back the modified pages of all the live windows.
+         * @param async If true, schedule the write back without waiting
+         * @return True on success
+         */
+        bool sync( bool async = false );
+
+        /* Returns the number of bytes of the file, padding excluded */
+        OFF_T getLength() const;
+
+        size_t getWindowSize() const;
+        size_t getNofLiveWindows() const;
+    };
+}
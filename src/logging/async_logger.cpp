@@ -0,0 +1,275 @@
+#include "async_logger.hpp"
+#include <concurrent/thread.hpp>
+#include <cstring>
+
+using namespace ccl::logging;
+
+/**
+ * Staging queue of a single thread. The thread is the only producer, the
+ * writer (or whoever holds the mutex of the logger) the only consumer.
+ */
+struct AsyncLogger::Staging
+{
+    ds::buffers::SpscRingBuffer<Record> m_queue;
+
+    std::atomic<size_t> m_dropped  = 0;     // Messages lost with a full queue
+    std::atomic<bool>   m_orphan   = false; // The owner thread has exited
+    std::atomic<bool>   m_detached = false; // The logger has been destroyed
+
+    explicit Staging( size_t capacity ) : m_queue( capacity ) {}
+};
+
+/**
+ * The staging queues of a thread, one for each logger it has used. The
+ * queues are shared with the loggers, so that neither the thread nor the
+ * logger has to outlive the other.
+ */
+struct AsyncLogger::LocalRegistry
+{
+    struct Entry
+    {
+        uint64_t                 m_logger;
+        std::shared_ptr<Staging> m_staging;
+    };
+
+    std::vector<Entry> m_entries;
+    uint64_t           m_lastLogger  = 0;       // Cache of the last lookup
+    Staging*           m_lastStaging = nullptr;
+
+    ~LocalRegistry()
+    {
+        // The writer removes the queue once it is empty
+        for ( auto& entry: m_entries )
+        {
+            entry.m_staging->m_orphan.store( true, std::memory_order_release );
+        }
+    }
+};
+
+/**
+ * Background thread draining the staging queues. It sleeps for the flush
+ * interval once they are all empty, or until a blocked producer wakes it.
+ */
+class AsyncLogger::Writer : public ccl::sys::concurrent::Thread
+{
+private:
+    AsyncLogger* m_owner;
+
+    void run() override
+    {
+        std::unique_lock<std::mutex> _l( m_owner->m_mutex );
+
+        while ( !isCancelled() )
+        {
+            if ( m_owner->drain() > 0 ) continue;
+
+            m_owner->m_file.flush();
+            m_owner->m_writerCv.wait_for( _l, m_owner->m_config.flush_interval );
+        }
+    }
+
+public:
+    explicit Writer( AsyncLogger* owner )
+        : Thread( "AsyncLogger-Writer", false,
+                  ccl::sys::concurrent::CancellationPolicy::AT_CONDITION_CHECK ),
+          m_owner( owner )
+    {}
+};
+
+static uint64_t next_logger_id()
+{
+    static std::atomic<uint64_t> counter = 0;
+    return counter.fetch_add( 1, std::memory_order_relaxed ) + 1;
+}
+
+std::string_view AsyncLogger::Record::text() const
+{
+    return m_overflow != nullptr ? std::string_view( m_overflow, m_size )
+                                 : std::string_view( m_text, m_size );
+}
+
+AsyncLogger::AsyncLogger(const std::string &path, const AsyncLoggerConfig &config)
+    : LoggingInterface( config.level ), m_id( next_logger_id() ), m_config( config ),
+      m_file( path, sys::io::iom::Write | sys::io::iom::Create | sys::io::iom::App,
+              config.buffer_size )
+{
+    if ( config.loss_policy == ds::LossPolicy::OVERWRITE_OLDEST )
+    {
+        throw std::invalid_argument( "OVERWRITE_OLDEST Loss policy is not available for AsyncLogger" );
+    }
+
+    m_batch.resize( BATCH_SIZE );
+
+    m_writer = std::make_unique<Writer>( this );
+    m_writer->start();
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    // Cancel with the lock held, so the writer cannot miss the notification
+    {
+        std::lock_guard<std::mutex> _l( m_mutex );
+        m_writer->cancel();
+    }
+
+    m_writerCv.notify_all();
+    m_writer->join();
+    m_writer.reset();
+
+    std::lock_guard<std::mutex> _l( m_mutex );
+    drain();
+    m_file.flush();
+
+    for ( auto& staging: m_stagings )
+    {
+        staging->m_detached.store( true, std::memory_order_release );
+    }
+}
+
+AsyncLogger::Staging &AsyncLogger::staging()
+{
+    static thread_local LocalRegistry registry;
+
+    if ( registry.m_lastLogger == m_id ) return *registry.m_lastStaging;
+
+    for ( auto& entry: registry.m_entries )
+    {
+        if ( entry.m_logger != m_id ) continue;
+
+        registry.m_lastLogger = m_id;
+        registry.m_lastStaging = entry.m_staging.get();
+        return *registry.m_lastStaging;
+    }
+
+    // First message of this thread: drop the queues of destroyed loggers
+    std::erase_if( registry.m_entries, []( const LocalRegistry::Entry& entry ) {
+        return entry.m_staging->m_detached.load( std::memory_order_acquire );
+    });
+
+    auto queue = std::make_shared<Staging>( m_config.queue_capacity );
+
+    {
+        std::lock_guard<std::mutex> _l( m_mutex );
+        m_stagings.push_back( queue );
+    }
+
+    registry.m_entries.push_back( { m_id, queue } );
+    registry.m_lastLogger = m_id;
+    registry.m_lastStaging = queue.get();
+    return *queue;
+}
+
+void AsyncLogger::write(LoggingLevel lvl, std::string_view msg)
+{
+    Staging& queue = staging();
+
+    Record record;
+    record.m_timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch() ).count();
+
+    record.m_level = lvl;
+    record.m_size = static_cast<uint32_t>( msg.size() );
+    record.m_overflow = nullptr;
+
+    if ( msg.size() <= INLINE_SIZE )
+    {
+        std::memcpy( record.m_text, msg.data(), msg.size() );
+    }
+    else
+    {
+        record.m_overflow = new char[msg.size()];
+        std::memcpy( record.m_overflow, msg.data(), msg.size() );
+    }
+
+    if ( queue.m_queue.tryPush( record ) ) return;
+
+    if ( m_config.loss_policy == ds::LossPolicy::BLOCK )
+    {
+        m_writerCv.notify_one();
+        queue.m_queue.push( record );
+        return;
+    }
+
+    delete[] record.m_overflow;
+    queue.m_dropped.fetch_add( 1, std::memory_order_relaxed );
+}
+
+size_t AsyncLogger::drain()
+{
+    size_t total = 0;
+
+    for ( auto it = m_stagings.begin(); it != m_stagings.end(); )
+    {
+        Staging& queue = **it;
+
+        // Read the flag first: once set, no more pushes can happen
+        bool orphan = queue.m_orphan.load( std::memory_order_acquire );
+
+        // Bounded to the capacity, so a single thread cannot starve the others
+        size_t popped = 0, nelem = 0;
+        while ( popped < queue.m_queue.capacity() &&
+                ( nelem = queue.m_queue.tryPopN( m_batch.data(), BATCH_SIZE ) ) > 0 )
+        {
+            m_line.clear();
+            for ( size_t idx = 0; idx < nelem; ++idx )
+            {
+                format( m_batch[idx] );
+                delete[] m_batch[idx].m_overflow;
+            }
+
+            m_file.write( m_line.data(), m_line.size() );
+            popped += nelem;
+        }
+
+        total += popped;
+
+        if ( orphan && queue.m_queue.empty() )
+        {
+            m_dropped.fetch_add( queue.m_dropped.load( std::memory_order_relaxed ),
+                                 std::memory_order_relaxed );
+
+            it = m_stagings.erase( it );
+            continue;
+        }
+
+        ++it;
+    }
+
+    return total;
+}
+
+void AsyncLogger::format(const Record &record)
+{
+    m_line += '[';
+    m_line += m_timestamp.render( record.m_timestamp / 1'000'000'000 );
+    m_line += "] [";
+    m_line += levelName( record.m_level );
+    m_line += "] ";
+    m_line += record.text();
+    m_line += '\n';
+}
+
+void AsyncLogger::flush()
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+    drain();
+    m_file.flush();
+}
+
+size_t AsyncLogger::getDropped() const
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+
+    size_t dropped = m_dropped.load( std::memory_order_relaxed );
+    for ( const auto& queue: m_stagings )
+    {
+        dropped += queue->m_dropped.load( std::memory_order_relaxed );
+    }
+
+    return dropped;
+}
+
+const AsyncLoggerConfig &AsyncLogger::getConfig() const
+{
+    return m_config;
+}
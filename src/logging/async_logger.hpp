@@ -0,0 +1,129 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <data_structures/base/enum.hpp>
+#include <data_structures/buffers/spsc_ring_buffer.hpp>
+#include <io/file/buffered_io.hpp>
+#include "formatting.hpp"
+#include "logger_base.hpp"
+
+namespace ccl::logging
+{
+    /**
+     * @brief Configuration of an AsyncLogger
+     */
+    struct AsyncLoggerConfig
+    {
+        // Number of messages each thread can stage before the loss policy
+        // kicks in. It is rounded up to the next power of two.
+        size_t queue_capacity = 1024;
+
+        // What to do when the staging queue of a thread is full: ERROR drops
+        // the message (counted by getDropped), BLOCK waits for the writer.
+        // OVERWRITE_OLDEST is not supported.
+        ds::LossPolicy loss_policy = ds::LossPolicy::ERROR;
+
+        LoggingLevel level = LoggingLevel::INFO;
+
+        // How long the writer sleeps when there is nothing to write. It is
+        // also the maximum delay before a message reaches the file.
+        std::chrono::milliseconds flush_interval{ 10 };
+
+        // Capacity of the file buffer used by the writer
+        size_t buffer_size = 64 * 1024;
+    };
+
+    /**
+     * @brief Logger deferring the formatting and the IO to a background thread.
+     *
+     * A log call only takes the timestamp and copies the message into a
+     * staging queue owned by the calling thread: a lock-free single producer
+     * single consumer ring, so threads never contend with each other. Short
+     * messages are copied inline, longer ones are the only case requiring a
+     * heap allocation on the caller side.
+     *
+     * The writer thread periodically drains all the staging queues in
+     * batches, formats the messages as the DefaultStringFormatter does
+     * ([<date-time>] [<level>] <message>) using the timestamp of the call,
+     * and writes them into a BufferedFileIO. Messages of the same thread
+     * keep their order, while there is no ordering across threads.
+     *
+     * All the pending messages are written on flush() and on destruction.
+     */
+    class AsyncLogger : public LoggingInterface
+    {
+    public:
+        // Bytes of a message stored inline in the staging queue
+        static constexpr size_t INLINE_SIZE = 224;
+
+        // Maximum number of records moved out of a queue at once
+        static constexpr size_t BATCH_SIZE = 64;
+
+    private:
+        class Writer;         // The background thread
+        struct Staging;       // The staging queue of a single thread
+        struct LocalRegistry; // The staging queues of the calling thread
+
+        struct Record
+        {
+            int64_t      m_timestamp; // Nanoseconds since the epoch (system clock)
+            LoggingLevel m_level;
+            uint32_t     m_size;      // Size of the message
+            char*        m_overflow;  // Heap copy of the message if not inline
+            char         m_text[INLINE_SIZE];
+
+            std::string_view text() const;
+        };
+
+        const uint64_t    m_id;     // Identifies the logger in the thread-local registry
+        AsyncLoggerConfig m_config;
+
+        sys::io::BufferedFileIO m_file;
+
+        mutable std::mutex                    m_mutex;    // Protects stagings and draining
+        std::vector<std::shared_ptr<Staging>> m_stagings; // One per logging thread
+        std::vector<Record>                   m_batch;    // Reused by drain
+        std::string                           m_line;     // Reused by format
+
+        TimestampCache m_timestamp; // The date-time changes once per second
+
+        std::atomic<size_t>     m_dropped = 0;   // From stagings already removed
+        std::condition_variable m_writerCv;      // Wakes up the writer
+        std::unique_ptr<Writer> m_writer;
+
+        Staging& staging(); // The staging queue of the calling thread
+
+        // All the following functions require the mutex to be held
+        size_t drain();
+        void   format( const Record& record );
+
+    protected:
+        void write( LoggingLevel lvl, std::string_view msg ) override;
+
+    public:
+        /**
+         * @param path The log file, created if missing and opened for appending
+         * @param config The logger configuration
+         */
+        explicit AsyncLogger( const std::string& path, const AsyncLoggerConfig& config = {} );
+
+        AsyncLogger( const AsyncLogger& ) = delete;
+        AsyncLogger& operator=( const AsyncLogger& ) = delete;
+
+        /* Stops the writer and writes all the pending messages */
+        virtual ~AsyncLogger();
+
+        void flush() override;
+
+        /* Returns the number of messages dropped because of a full queue */
+        size_t getDropped() const;
+
+        const AsyncLoggerConfig& getConfig() const;
+    };
+}
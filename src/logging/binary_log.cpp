@@ -0,0 +1,583 @@
+#include "binary_log.hpp"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+using namespace ccl::logging;
+using ccl::ds::buffers::ByteBuffer;
+
+// Format string of the messages already formatted by the caller
+static constexpr std::string_view TEXT_FORMAT = "{}";
+
+static constexpr size_t SEGMENT_HEADER_SIZE = sizeof( binlog::MAGIC ) + 1;
+
+// Bound of the fixed fields of a message: id, level, timestamp, nargs, nelements
+static constexpr size_t MESSAGE_FIXED_SIZE = 4 * binlog::MAX_VARINT + 1;
+
+// Space reserved before the payload for the type and the payload length
+static constexpr size_t RECORD_HEADER_SIZE = 1 + binlog::MAX_VARINT;
+
+// ------------------------------------------------------------------------
+// ENCODING
+// ------------------------------------------------------------------------
+
+/* Write the varint into dst, returning the number of bytes */
+static size_t varint_bytes( unsigned char* dst, uint64_t value )
+{
+    size_t nbytes = 0;
+    while ( value >= 0x80 )
+    {
+        dst[nbytes++] = static_cast<unsigned char>( value | 0x80 );
+        value >>= 7;
+    }
+
+    dst[nbytes++] = static_cast<unsigned char>( value );
+    return nbytes;
+}
+
+/* Tag and varint are put with a single call, it is the hot path */
+static void put_tagged_varint( ByteBuffer& buffer, binlog::ArgType type, uint64_t value )
+{
+    unsigned char bytes[1 + binlog::MAX_VARINT];
+    bytes[0] = static_cast<unsigned char>( type );
+    buffer.putBuffer( bytes, 1 + varint_bytes( bytes + 1, value ) );
+}
+
+void binlog::putVarint(ByteBuffer &buffer, uint64_t value)
+{
+    unsigned char bytes[MAX_VARINT];
+    buffer.putBuffer( bytes, varint_bytes( bytes, value ) );
+}
+
+uint64_t binlog::getVarint(ByteBuffer &buffer)
+{
+    uint64_t value = 0;
+
+    for ( unsigned shift = 0; shift < 64; shift += 7 )
+    {
+        if ( buffer.getRemainingSize() == 0 )
+        {
+            throw std::out_of_range( "[binlog] Truncated varint" );
+        }
+
+        unsigned char byte = buffer.get();
+        value |= static_cast<uint64_t>( byte & 0x7F ) << shift;
+        if ( ( byte & 0x80 ) == 0 ) return value;
+    }
+
+    throw std::out_of_range( "[binlog] Varint longer than 64 bits" );
+}
+
+void binlog::putString(ByteBuffer &buffer, std::string_view value)
+{
+    putVarint( buffer, value.size() );
+    if ( !value.empty() )
+    {
+        buffer.putBuffer( reinterpret_cast<const unsigned char*>( value.data() ), value.size() );
+    }
+}
+
+void binlog::encodeArg(ByteBuffer &buffer, std::string_view value)
+{
+    buffer.put( static_cast<unsigned char>( ArgType::String ) );
+    putString( buffer, value );
+}
+
+void binlog::encodeArg(ByteBuffer &buffer, const char *value)
+{
+    // Same text of formatArg for null strings
+    encodeArg( buffer, std::string_view( value != nullptr ? value : "(null)" ) );
+}
+
+void binlog::encodeArg(ByteBuffer &buffer, const std::string &value)
+{
+    encodeArg( buffer, std::string_view( value ) );
+}
+
+void binlog::encodeInt(ByteBuffer &buffer, int64_t value)
+{
+    put_tagged_varint( buffer, ArgType::Int, zigzag( value ) );
+}
+
+void binlog::encodeUInt(ByteBuffer &buffer, uint64_t value)
+{
+    put_tagged_varint( buffer, ArgType::UInt, value );
+}
+
+void binlog::encodeArg(ByteBuffer &buffer, char value)
+{
+    buffer.put( static_cast<unsigned char>( ArgType::Char ) );
+    buffer.put( static_cast<unsigned char>( value ) );
+}
+
+void binlog::encodeArg(ByteBuffer &buffer, bool value)
+{
+    buffer.put( static_cast<unsigned char>( ArgType::Bool ) );
+    buffer.put( value ? 1 : 0 );
+}
+
+void binlog::encodeArg(ByteBuffer &buffer, float value)
+{
+    buffer.put( static_cast<unsigned char>( ArgType::Float ) );
+    buffer.putUnsignedInt( std::bit_cast<uint32_t>( value ) );
+}
+
+void binlog::encodeArg(ByteBuffer &buffer, double value)
+{
+    uint64_t bits = htole64( std::bit_cast<uint64_t>( value ) );
+
+    unsigned char bytes[1 + sizeof( bits )];
+    bytes[0] = static_cast<unsigned char>( ArgType::Double );
+    std::memcpy( bytes + 1, &bits, sizeof( bits ) );
+    buffer.putBuffer( bytes, sizeof( bytes ) );
+}
+
+void binlog::encodeArg(ByteBuffer &buffer, const void *value)
+{
+    put_tagged_varint( buffer, ArgType::Pointer, reinterpret_cast<uintptr_t>( value ) );
+}
+
+void binlog::encodeValue(ByteBuffer &buffer, const SD_Element::SD_Value &value)
+{
+    std::visit( [&buffer]( const auto& typed ) { encodeArg( buffer, typed ); }, value );
+}
+
+void binlog::encodeElement(ByteBuffer &buffer, const SD_Element &element)
+{
+    putString( buffer, element.getId() );
+    putVarint( buffer, element.getParameters().size() );
+
+    for ( const auto& [key, value]: element.getParameters() )
+    {
+        putString( buffer, key );
+        encodeValue( buffer, value );
+    }
+}
+
+size_t binlog::maxElementSize(const SD_Element &element)
+{
+    size_t size = 2 * MAX_VARINT + element.getId().size();
+
+    for ( const auto& [key, value]: element.getParameters() )
+    {
+        size += MAX_VARINT + key.size();
+        size += std::visit( []( const auto& typed ) { return maxArgSize( typed ); }, value );
+    }
+
+    return size;
+}
+
+// ------------------------------------------------------------------------
+// BINARY LOGGER
+// ------------------------------------------------------------------------
+
+BinaryLogger::BinaryLogger(const std::string &path, const BinaryLogConfig &config)
+    : LoggingInterface( config.level ), m_path( path ), m_config( config ),
+      m_header( RECORD_HEADER_SIZE )
+{
+    // Never overwrite the segments of a previous run
+    while ( std::filesystem::exists( segmentPath( m_path, m_segment ) ) ) ++m_segment;
+
+    openSegment();
+}
+
+std::string BinaryLogger::segmentPath(const std::string &path, size_t index)
+{
+    return path + "." + std::to_string( index );
+}
+
+std::string BinaryLogger::getSegmentPath() const
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+    return segmentPath( m_path, m_segment );
+}
+
+void BinaryLogger::openSegment()
+{
+    if ( m_file )
+    {
+        // Unmaps and truncates the padding of the previous one
+        m_file.reset();
+        while ( std::filesystem::exists( segmentPath( m_path, ++m_segment ) ) );
+    }
+
+    m_file = std::make_unique<sys::io::SegmentedMappedFileIO>(
+        segmentPath( m_path, m_segment ),
+        sys::io::iom::Read | sys::io::iom::Write | sys::io::iom::Create,
+        m_config.window_size, 2 );
+
+    m_file->write( binlog::MAGIC, sizeof( binlog::MAGIC ) );
+    m_file->write( reinterpret_cast<const char*>( &binlog::VERSION ), 1 );
+
+    // Each segment is decoded on its own
+    std::fill( m_defined.begin(), m_defined.end(), false );
+    m_lastTimestamp = 0;
+}
+
+uint32_t BinaryLogger::intern(std::string_view fmt)
+{
+    auto it = m_ids.find( fmt.data() );
+    if ( it != m_ids.end() && m_formats[it->second].size() == fmt.size() ) return it->second;
+
+    uint32_t id = static_cast<uint32_t>( m_formats.size() );
+    m_ids.insert_or_assign( fmt.data(), id );
+    m_formats.push_back( fmt );
+    m_defined.push_back( false );
+    return id;
+}
+
+void BinaryLogger::beginMessage(uint32_t id, LoggingLevel lvl, size_t nargs, size_t bound)
+{
+    bound += MESSAGE_FIXED_SIZE;
+
+    OFF_T length = m_file->getLength();
+    if ( m_config.segment_size > 0 && length > static_cast<OFF_T>( SEGMENT_HEADER_SIZE ) &&
+         static_cast<size_t>( length ) + bound > m_config.segment_size )
+    {
+        openSegment();
+    }
+
+    if ( !m_defined[id] )
+    {
+        std::string_view fmt = m_formats[id];
+
+        beginRecord( 2 * binlog::MAX_VARINT + fmt.size() );
+        binlog::putVarint( m_payload, id );
+        binlog::putString( m_payload, fmt );
+        appendRecord( binlog::RecordType::Format );
+
+        m_defined[id] = true;
+    }
+
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch() ).count();
+
+    // The fixed fields are put with a single call
+    unsigned char fields[MESSAGE_FIXED_SIZE];
+    size_t nbytes = varint_bytes( fields, id );
+    fields[nbytes++] = static_cast<unsigned char>( lvl );
+    nbytes += varint_bytes( fields + nbytes, binlog::zigzag( now - m_lastTimestamp ) );
+    nbytes += varint_bytes( fields + nbytes, nargs );
+
+    beginRecord( bound );
+    m_payload.putBuffer( fields, nbytes );
+
+    m_lastTimestamp = now;
+}
+
+void BinaryLogger::endMessage(std::span<const SD_Element> elements)
+{
+    binlog::putVarint( m_payload, elements.size() );
+    for ( const auto& element: elements ) binlog::encodeElement( m_payload, element );
+
+    appendRecord( binlog::RecordType::Message );
+}
+
+void BinaryLogger::beginRecord(size_t bound)
+{
+    static constexpr unsigned char reserved[RECORD_HEADER_SIZE] = {};
+
+    m_payload.allocate( RECORD_HEADER_SIZE + bound );
+    m_payload.reset();
+    m_payload.putBuffer( reserved, RECORD_HEADER_SIZE );
+}
+
+void BinaryLogger::appendRecord(binlog::RecordType type)
+{
+    size_t size = m_payload.getBufferSize() - RECORD_HEADER_SIZE;
+
+    m_header.reset();
+    m_header.put( static_cast<unsigned char>( type ) );
+    binlog::putVarint( m_header, size );
+
+    // Place the header right before the payload, so a single write is needed
+    size_t start = RECORD_HEADER_SIZE - m_header.getBufferSize();
+    unsigned char* record = m_payload.getBuffer() + start;
+    std::memcpy( record, m_header.getBuffer(), m_header.getBufferSize() );
+
+    m_file->write( reinterpret_cast<const char*>( record ), m_header.getBufferSize() + size );
+}
+
+void BinaryLogger::write(LoggingLevel lvl, std::string_view msg)
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+
+    uint32_t id = intern( TEXT_FORMAT );
+    beginMessage( id, lvl, 1, binlog::maxArgSize( msg ) );
+    binlog::encodeArg( m_payload, msg );
+    endMessage( {} );
+}
+
+void BinaryLogger::flush()
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+    m_file->sync();
+}
+
+// ------------------------------------------------------------------------
+// BINARY LOG READER
+// ------------------------------------------------------------------------
+
+static std::string get_string( ByteBuffer& buffer )
+{
+    size_t size = binlog::getVarint( buffer );
+    if ( size > buffer.getRemainingSize() )
+    {
+        throw std::out_of_range( "[binlog] Truncated string" );
+    }
+
+    std::string value( reinterpret_cast<const char*>( buffer.getBuffer() + buffer.position() ), size );
+    buffer.position( buffer.position() + size );
+    return value;
+}
+
+static unsigned char get_byte( ByteBuffer& buffer )
+{
+    if ( buffer.getRemainingSize() < 1 ) throw std::out_of_range( "[binlog] Truncated record" );
+    return buffer.get();
+}
+
+/* Decode a tagged value into its SD_Value, characters and pointers excluded */
+static SD_Element::SD_Value decode_value( ByteBuffer& buffer, binlog::ArgType type )
+{
+    switch ( type )
+    {
+        case binlog::ArgType::Int:    return binlog::unzigzag( binlog::getVarint( buffer ) );
+        case binlog::ArgType::UInt:   return binlog::getVarint( buffer );
+        case binlog::ArgType::Bool:   return get_byte( buffer ) != 0;
+        case binlog::ArgType::String: return get_string( buffer );
+        case binlog::ArgType::Double:
+            if ( buffer.getRemainingSize() < ByteBuffer::INT_SIZE_64 )
+            {
+                throw std::out_of_range( "[binlog] Truncated record" );
+            }
+
+            return std::bit_cast<double>( static_cast<uint64_t>( buffer.getUnsignedLong() ) );
+
+        default: throw std::out_of_range( "[binlog] Unknown value type" );
+    }
+}
+
+/* Decode a tagged argument and append its text */
+static void decode_arg( ByteBuffer& buffer, std::string& text )
+{
+    auto type = static_cast<binlog::ArgType>( get_byte( buffer ) );
+    StaticFormatBuffer<64> out;
+
+    switch ( type )
+    {
+        case binlog::ArgType::Char:
+            text += static_cast<char>( get_byte( buffer ) );
+            return;
+
+        case binlog::ArgType::Pointer:
+            formatArg( out, reinterpret_cast<const void*>( binlog::getVarint( buffer ) ) );
+            break;
+
+        case binlog::ArgType::String:
+            text += get_string( buffer );
+            return;
+
+        case binlog::ArgType::Float:
+            if ( buffer.getRemainingSize() < ByteBuffer::INT_SIZE )
+            {
+                throw std::out_of_range( "[binlog] Truncated record" );
+            }
+
+            formatArg( out, std::bit_cast<float>( buffer.getUnsignedInt() ) );
+            break;
+
+        default:
+        {
+            auto value = decode_value( buffer, type );
+            std::visit( [&out]( const auto& typed ) { formatArg( out, typed ); }, value );
+            break;
+        }
+    }
+
+    text += out.view();
+}
+
+BinaryLogReader::BinaryLogReader(const std::string &path)
+    : m_file( path, sys::io::advf::Sequential )
+{
+    char header[SEGMENT_HEADER_SIZE];
+    ssize_t nbytes = m_file.read( header, SEGMENT_HEADER_SIZE );
+
+    if ( nbytes != static_cast<ssize_t>( SEGMENT_HEADER_SIZE ) ||
+         std::memcmp( header, binlog::MAGIC, sizeof( binlog::MAGIC ) ) != 0 ||
+         static_cast<uint8_t>( header[sizeof( binlog::MAGIC )] ) != binlog::VERSION )
+    {
+        std::stringstream ss;
+        ss << "[BinaryLogReader] File " << path
+           << " is not a binary log segment of version "
+           << static_cast<int>( binlog::VERSION );
+
+        throw std::runtime_error( ss.str() );
+    }
+}
+
+bool BinaryLogReader::readRecord(binlog::RecordType &type, ByteBuffer &payload)
+{
+    char byte;
+    if ( m_file.read( &byte, 1 ) != 1 ) return false;
+    type = static_cast<binlog::RecordType>( byte );
+
+    uint64_t size = 0;
+    for ( unsigned shift = 0; ; shift += 7 )
+    {
+        if ( shift >= 64 || m_file.read( &byte, 1 ) != 1 ) return false;
+
+        size |= static_cast<uint64_t>( byte & 0x7F ) << shift;
+        if ( ( byte & 0x80 ) == 0 ) break;
+    }
+
+    if ( size == 0 ) return false;
+
+    m_record.resize( size );
+    if ( m_file.read( reinterpret_cast<char*>( m_record.data() ), size ) != static_cast<ssize_t>( size ) )
+    {
+        return false;
+    }
+
+    payload.setBuffer( m_record.data(), size, false );
+    payload.position( 0 );
+    return true;
+}
+
+bool BinaryLogReader::next(DecodedMessage &message)
+{
+    binlog::RecordType type;
+    ByteBuffer payload;
+
+    try
+    {
+        while ( readRecord( type, payload ) )
+        {
+            if ( type == binlog::RecordType::Format )
+            {
+                size_t id = binlog::getVarint( payload );
+                if ( id >= m_formats.size() ) m_formats.resize( id + 1 );
+                m_formats[id] = get_string( payload );
+                continue;
+            }
+
+            if ( type != binlog::RecordType::Message ) continue;
+
+            size_t id = binlog::getVarint( payload );
+            if ( id >= m_formats.size() ) throw std::out_of_range( "[binlog] Undefined format" );
+
+            message.level = static_cast<LoggingLevel>( get_byte( payload ) );
+            m_lastTimestamp += binlog::unzigzag( binlog::getVarint( payload ) );
+            message.timestamp = m_lastTimestamp;
+
+            // Replace each field with the next argument, and {{ }} with braces
+            std::string_view fmt = m_formats[id];
+            size_t nargs = binlog::getVarint( payload );
+            message.text.clear();
+
+            for ( size_t idx = 0; idx < fmt.size(); ++idx )
+            {
+                char c = fmt[idx];
+                bool pair = idx + 1 < fmt.size() && ( c == '{' || c == '}' );
+
+                if ( pair && c == '{' && fmt[idx + 1] == '}' )
+                {
+                    if ( nargs > 0 )
+                    {
+                        decode_arg( payload, message.text );
+                        --nargs;
+                    }
+
+                    ++idx;
+                    continue;
+                }
+
+                if ( pair && fmt[idx + 1] == c ) ++idx;
+                message.text += c;
+            }
+
+            // Skip the arguments without a field, if any
+            std::string discarded;
+            for ( ; nargs > 0; --nargs ) decode_arg( payload, discarded );
+
+            message.elements.clear();
+            for ( size_t nelements = binlog::getVarint( payload ); nelements > 0; --nelements )
+            {
+                SD_Element element( get_string( payload ) );
+                for ( size_t nparams = binlog::getVarint( payload ); nparams > 0; --nparams )
+                {
+                    std::string key = get_string( payload );
+                    auto value_type = static_cast<binlog::ArgType>( get_byte( payload ) );
+                    element.addParameter( key, decode_value( payload, value_type ) );
+                }
+
+                message.elements.push_back( std::move( element ) );
+            }
+
+            return true;
+        }
+    }
+    catch ( const std::out_of_range& )
+    {
+        // Corrupted record, the rest of the segment cannot be trusted
+    }
+
+    return false;
+}
+
+size_t BinaryLogReader::render(std::ostream &out)
+{
+    TimestampCache timestamp;
+    DecodedMessage message;
+    size_t count = 0;
+
+    while ( next( message ) )
+    {
+        out << '[' << timestamp.render( message.timestamp / 1'000'000'000 ) << "] ["
+            << levelName( message.level ) << "] " << message.text;
+
+        for ( const auto& element: message.elements ) out << ' ' << element.format();
+
+        out << '\n';
+        ++count;
+    }
+
+    return count;
+}
+
+std::vector<std::string> BinaryLogReader::segments(const std::string &path)
+{
+    namespace fs = std::filesystem;
+
+    fs::path prefix( path );
+    fs::path directory = prefix.has_parent_path() ? prefix.parent_path() : fs::path( "." );
+    std::string stem = prefix.filename().string() + ".";
+
+    std::vector<std::pair<size_t, std::string>> found;
+    std::error_code ec;
+
+    for ( const auto& entry: fs::directory_iterator( directory, ec ) )
+    {
+        std::string name = entry.path().filename().string();
+        if ( name.size() <= stem.size() || name.compare( 0, stem.size(), stem ) != 0 ) continue;
+
+        size_t index = 0;
+        const char* first = name.data() + stem.size();
+        const char* last = name.data() + name.size();
+        auto [ptr, err] = std::from_chars( first, last, index );
+        if ( err != std::errc() || ptr != last ) continue;
+
+        found.emplace_back( index, entry.path().string() );
+    }
+
+    std::sort( found.begin(), found.end() );
+
+    std::vector<std::string> result;
+    for ( auto& [index, file]: found ) result.push_back( std::move( file ) );
+    return result;
+}
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <data_structures/buffers/byte_buffer.hpp>
+#include <io/file/mmap_file_io.hpp>
+#include <io/file/segmented_mmap_io.hpp>
+#include "formatting.hpp"
+#include "logger_base.hpp"
+
+namespace ccl::logging
+{
+    /**
+     * Encoding of the binary log segments.
+     *
+     * A segment starts with the magic "CCLB" and the version byte, followed
+     * by records made of a type byte, the payload length and the payload.
+     * All integers are LEB128 varints, signed ones zig-zag encoded first,
+     * while floating point values are stored as little endian bits.
+     *
+     * - Format record:  id, length, format string bytes. It is written the
+     *   first time an id is used in the segment, so each segment can be
+     *   decoded on its own.
+     * - Message record: format id, level byte, timestamp delta in ns from the
+     *   previous message (signed), the number of arguments and each of them
+     *   as a type tag plus value, the number of SD elements and each of them
+     *   as id, number of parameters and (key, type tag, value) triples.
+     */
+    namespace binlog
+    {
+        using ds::buffers::ByteBuffer;
+
+        static constexpr char    MAGIC[4]   = { 'C', 'C', 'L', 'B' };
+        static constexpr uint8_t VERSION    = 1;
+        static constexpr size_t  MAX_VARINT = 10;
+
+        enum class RecordType : uint8_t
+        {
+            Format  = 1,
+            Message = 2
+        };
+
+        enum class ArgType : uint8_t
+        {
+            Int     = 1, // Zig-zag varint
+            UInt    = 2, // Varint
+            Double  = 3, // 8 bytes
+            Bool    = 4, // 1 byte
+            Char    = 5, // 1 byte
+            String  = 6, // Varint length and bytes
+            Pointer = 7, // Varint
+            Float   = 8  // 4 bytes
+        };
+
+        void     putVarint( ByteBuffer& buffer, uint64_t value );
+        uint64_t getVarint( ByteBuffer& buffer );
+
+        inline uint64_t zigzag  ( int64_t value )  { return ( static_cast<uint64_t>( value ) << 1 ) ^ static_cast<uint64_t>( value >> 63 ); }
+        inline int64_t  unzigzag( uint64_t value ) { return static_cast<int64_t>( value >> 1 ) ^ -static_cast<int64_t>( value & 1 ); }
+
+        void putString( ByteBuffer& buffer, std::string_view value );
+
+        // Encoding of the single argument: the type tag and the value
+        void encodeArg( ByteBuffer& buffer, std::string_view value );
+        void encodeArg( ByteBuffer& buffer, const char* value );
+        void encodeArg( ByteBuffer& buffer, const std::string& value );
+        void encodeArg( ByteBuffer& buffer, char value );
+        void encodeArg( ByteBuffer& buffer, bool value );
+        void encodeArg( ByteBuffer& buffer, float value );
+        void encodeArg( ByteBuffer& buffer, double value );
+        void encodeArg( ByteBuffer& buffer, const void* value );
+
+        void encodeInt ( ByteBuffer& buffer, int64_t value );
+        void encodeUInt( ByteBuffer& buffer, uint64_t value );
+
+        template <typename T>
+            requires ( std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char> )
+        inline void encodeArg( ByteBuffer& buffer, T value )
+        {
+            if constexpr ( std::is_signed_v<T> ) encodeInt( buffer, static_cast<int64_t>( value ) );
+            else encodeUInt( buffer, static_cast<uint64_t>( value ) );
+        }
+
+        void encodeValue  ( ByteBuffer& buffer, const SD_Element::SD_Value& value );
+        void encodeElement( ByteBuffer& buffer, const SD_Element& element );
+
+        // Upper bounds of the encoded sizes, used to size the buffer upfront
+        inline size_t maxArgSize( std::string_view value ) { return 1 + MAX_VARINT + value.size(); }
+        inline size_t maxArgSize( const char* value ) { return maxArgSize( std::string_view( value != nullptr ? value : "" ) ); }
+        inline size_t maxArgSize( const std::string& value ) { return maxArgSize( std::string_view( value ) ); }
+
+        template <typename T>
+            requires ( !std::is_convertible_v<const T&, std::string_view> )
+        inline size_t maxArgSize( const T& ) { return 1 + MAX_VARINT; }
+
+        size_t maxElementSize( const SD_Element& element );
+    }
+
+    /**
+     * @brief Configuration of a BinaryLogger
+     */
+    struct BinaryLogConfig
+    {
+        // A new segment is started once the current one exceeds this size
+        size_t segment_size = 256 * 1024 * 1024;
+
+        // Size of the memory mapped windows of the segment
+        size_t window_size = 4 * 1024 * 1024;
+
+        LoggingLevel level = LoggingLevel::INFO;
+    };
+
+    /**
+     * @brief Logger writing binary records instead of text.
+     *
+     * Formatting is deferred to the decoder: a log call only writes the id of
+     * the format string and the raw arguments, hence no number is converted
+     * into text and the records are several times smaller than the lines.
+     * Format strings are interned by address, so they are expected to be
+     * string literals.
+     *
+     * Records are appended to memory mapped segments named <path>.<N>, with
+     * N increasing from the first one not already present. The text can be
+     * rendered later with BinaryLogReader, or with the ccl_LogDecoder tool.
+     *
+     * Calls are serialized by a mutex.
+     */
+    class BinaryLogger : public LoggingInterface
+    {
+    private:
+        std::string     m_path;
+        BinaryLogConfig m_config;
+        size_t          m_segment = 0; // Index of the current segment
+
+        std::unique_ptr<sys::io::SegmentedMappedFileIO> m_file;
+
+        mutable std::mutex                       m_mutex;
+        ds::buffers::ByteBuffer                  m_payload;  // Reused record, header space included
+        ds::buffers::ByteBuffer                  m_header;   // Reused record header
+        std::unordered_map<const char*, uint32_t> m_ids;     // Format string to id
+        std::vector<std::string_view>            m_formats;  // Id to format string
+        std::vector<bool>                        m_defined;  // Id written in the segment
+        int64_t                                  m_lastTimestamp = 0;
+
+        // All the following functions require the mutex to be held
+        void     openSegment();
+        uint32_t intern( std::string_view fmt );
+        void     beginMessage( uint32_t id, LoggingLevel lvl, size_t nargs, size_t bound );
+        void     endMessage( std::span<const SD_Element> elements );
+        void     beginRecord( size_t bound );
+        void     appendRecord( binlog::RecordType type );
+
+    protected:
+        void write( LoggingLevel lvl, std::string_view msg ) override;
+
+    public:
+        /**
+         * @param path The prefix of the segment files
+         * @param config The logger configuration
+         */
+        explicit BinaryLogger( const std::string& path, const BinaryLogConfig& config = {} );
+
+        BinaryLogger( const BinaryLogger& ) = delete;
+        BinaryLogger& operator=( const BinaryLogger& ) = delete;
+
+        virtual ~BinaryLogger() = default;
+
+        using LoggingInterface::log;
+        using LoggingInterface::info;
+        using LoggingInterface::warning;
+        using LoggingInterface::error;
+
+        /**
+         * Log the format string id and the raw arguments. Same interface of
+         * LoggingInterface::log, without any formatting.
+         */
+        template <typename Arg, typename... Args>
+        void log( LoggingLevel lvl, FormatString<Arg, Args...> fmt, Arg&& arg, Args&&... args );
+
+        template <typename Arg, typename... Args>
+        void info( FormatString<Arg, Args...> fmt, Arg&& arg, Args&&... args )
+        {
+            log<Arg, Args...>( LoggingLevel::INFO, fmt, std::forward<Arg>( arg ), std::forward<Args>( args )... );
+        }
+
+        template <typename Arg, typename... Args>
+        void warning( FormatString<Arg, Args...> fmt, Arg&& arg, Args&&... args )
+        {
+            log<Arg, Args...>( LoggingLevel::WARNING, fmt, std::forward<Arg>( arg ), std::forward<Args>( args )... );
+        }
+
+        template <typename Arg, typename... Args>
+        void error( FormatString<Arg, Args...> fmt, Arg&& arg, Args&&... args )
+        {
+            log<Arg, Args...>( LoggingLevel::ERROR, fmt, std::forward<Arg>( arg ), std::forward<Args>( args )... );
+        }
+
+        /**
+         * Same as log, with structured data elements attached to the message.
+         */
+        template <typename... Args>
+        void log( LoggingLevel lvl, std::span<const SD_Element> elements,
+                  FormatString<Args...> fmt, Args&&... args );
+
+        /* Synchronize the mapped segment with the file */
+        void flush() override;
+
+        /* Returns the path of the segment currently written */
+        std::string getSegmentPath() const;
+
+        /* Returns the path of the N-th segment with the given prefix */
+        static std::string segmentPath( const std::string& path, size_t index );
+    };
+
+    template <typename Arg, typename... Args>
+    inline void BinaryLogger::log(
+        LoggingLevel lvl, FormatString<Arg, Args...> fmt, Arg&& arg, Args&&... args
+    ) {
+        log<Arg, Args...>( lvl, std::span<const SD_Element>(), fmt,
+                           std::forward<Arg>( arg ), std::forward<Args>( args )... );
+    }
+
+    template <typename... Args>
+    inline void BinaryLogger::log(
+        LoggingLevel lvl, std::span<const SD_Element> elements, FormatString<Args...> fmt, Args&&... args
+    ) {
+        if ( !isEnabled( lvl ) ) return;
+
+        size_t bound = ( size_t( 0 ) + ... + binlog::maxArgSize( args ) );
+        for ( const auto& element: elements ) bound += binlog::maxElementSize( element );
+
+        std::lock_guard<std::mutex> _l( m_mutex );
+
+        uint32_t id = intern( fmt.get() );
+        beginMessage( id, lvl, sizeof...(Args), bound );
+        ( binlog::encodeArg( m_payload, args ), ... );
+        endMessage( elements );
+    }
+
+    /**
+     * @brief A message decoded from a binary log segment.
+     */
+    struct DecodedMessage
+    {
+        int64_t                 timestamp; // Nanoseconds since the epoch
+        LoggingLevel            level;
+        std::string             text;      // The formatted message
+        std::vector<SD_Element> elements;
+    };
+
+    /**
+     * @brief Reader of a single binary log segment.
+     *
+     * The segment is mapped read-only with a sequential access advice and
+     * decoded record by record. A record cut by a crash of the writer ends
+     * the segment.
+     */
+    class BinaryLogReader
+    {
+    private:
+        sys::io::MappedFileIO    m_file;
+        std::vector<std::string> m_formats; // Id to format string
+        std::vector<unsigned char> m_record; // Payload of the current record
+        int64_t                  m_lastTimestamp = 0;
+
+        bool readRecord( binlog::RecordType& type, ds::buffers::ByteBuffer& payload );
+
+    public:
+        explicit BinaryLogReader( const std::string& path );
+
+        /**
+         * Decode the next message.
+         * @return False at the end of the segment
+         */
+        bool next( DecodedMessage& message );
+
+        /**
+         * Render all the remaining messages as text lines, in the same layout
+         * of the DefaultStringFormatter followed by the SD elements.
+         *
+         * @return The number of rendered messages
+         */
+        size_t render( std::ostream& out );
+
+        /* Returns the existing segments with the given prefix, in order */
+        static std::vector<std::string> segments( const std::string& path );
+    };
+}
@@ -0,0 +1,129 @@
+#include "format_string.hpp"
+#include <ctime>
+
+using namespace ccl::logging;
+
+void FormatBuffer::append(std::string_view str)
+{
+    if ( m_truncated ) return;
+
+    size_t nchars = str.size();
+    if ( nchars > remaining() )
+    {
+        nchars = remaining();
+        m_truncated = true;
+    }
+
+    std::memcpy( m_data + m_size, str.data(), nchars );
+    m_size += nchars;
+}
+
+void FormatBuffer::append(char c)
+{
+    if ( m_truncated || m_size == m_capacity )
+    {
+        m_truncated = true;
+        return;
+    }
+
+    m_data[m_size++] = c;
+}
+
+void FormatBuffer::clear()
+{
+    m_size = 0;
+    m_truncated = false;
+}
+
+FormatBuffer &ccl::logging::threadBuffer()
+{
+    static thread_local StaticFormatBuffer<THREAD_BUFFER_SIZE> buffer;
+    buffer.clear();
+    return buffer;
+}
+
+std::string_view TimestampCache::render(int64_t seconds)
+{
+    if ( seconds != m_second )
+    {
+        std::time_t now_c = static_cast<std::time_t>( seconds );
+        std::tm tm {};
+
+#ifdef _WIN32
+        if ( m_utc ) gmtime_s( &tm, &now_c ); else localtime_s( &tm, &now_c );
+#else
+        if ( m_utc ) gmtime_r( &now_c, &tm ); else localtime_r( &now_c, &tm );
+#endif
+
+        m_size = std::strftime( m_text, sizeof(m_text), m_format, &tm );
+        m_second = seconds;
+    }
+
+    return std::string_view( m_text, m_size );
+}
+
+std::string_view TimestampCache::render(std::chrono::system_clock::time_point tp)
+{
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>( tp.time_since_epoch() );
+    return render( static_cast<int64_t>( seconds.count() ) );
+}
+
+void ccl::logging::formatArg(FormatBuffer &out, std::string_view value)
+{
+    out.append( value );
+}
+
+void ccl::logging::formatArg(FormatBuffer &out, const char *value)
+{
+    out.append( value != nullptr ? std::string_view( value ) : std::string_view( "(null)" ) );
+}
+
+void ccl::logging::formatArg(FormatBuffer &out, const std::string &value)
+{
+    out.append( std::string_view( value ) );
+}
+
+void ccl::logging::formatArg(FormatBuffer &out, char value)
+{
+    out.append( value );
+}
+
+void ccl::logging::formatArg(FormatBuffer &out, bool value)
+{
+    out.append( value ? std::string_view( "true" ) : std::string_view( "false" ) );
+}
+
+void ccl::logging::formatArg(FormatBuffer &out, const void *value)
+{
+    out.append( std::string_view( "0x" ) );
+
+    auto [ptr, ec] = std::to_chars( out.end(), out.end() + out.remaining(),
+                                    reinterpret_cast<uintptr_t>( value ), 16 );
+    if ( ec != std::errc() )
+    {
+        out.truncate();
+        return;
+    }
+
+    out.commit( static_cast<size_t>( ptr - out.end() ) );
+}
+
+void ccl::logging::formatLiteral(FormatBuffer &out, std::string_view text, bool escapes)
+{
+    if ( !escapes )
+    {
+        out.append( text );
+        return;
+    }
+
+    // Each doubled brace is written once
+    for ( size_t idx = 0; idx < text.size(); ++idx )
+    {
+        out.append( text[idx] );
+        if ( ( text[idx] == '{' || text[idx] == '}' ) && idx + 1 < text.size()
+            && text[idx + 1] == text[idx] )
+        {
+            ++idx;
+        }
+    }
+}
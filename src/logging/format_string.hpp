@@ -0,0 +1,224 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace ccl::logging
+{
+    /**
+     * @brief Fixed-capacity character buffer used as formatting destination.
+     *
+     * It does not own the memory: it writes into a caller-provided span, so
+     * formatting never allocates. Whatever does not fit is discarded and the
+     * buffer is marked as truncated: from then on, appends are ignored until
+     * the buffer is cleared.
+     */
+    class FormatBuffer
+    {
+    private:
+        char*  m_data;
+        size_t m_capacity;
+        size_t m_size      = 0;
+        bool   m_truncated = false;
+
+    public:
+        explicit FormatBuffer( std::span<char> storage )
+            : m_data( storage.data() ), m_capacity( storage.size() )
+        {}
+
+        void append( std::string_view str );
+        void append( char c );
+
+        void clear();
+
+        // Returns the free space, to be filled directly, e.g., with to_chars.
+        // Then commit the number of characters actually written.
+        char*  end      () { return m_data + m_size; }
+        size_t remaining() const { return m_capacity - m_size; }
+        void   commit   ( size_t nchars ) { m_size += nchars; }
+        void   truncate () { m_truncated = true; }
+
+        size_t           size       () const { return m_size; }
+        size_t           capacity   () const { return m_capacity; }
+        bool             isTruncated() const { return m_truncated; }
+        std::string_view view       () const { return std::string_view( m_data, m_size ); }
+    };
+
+    /**
+     * @brief FormatBuffer with its own storage.
+     */
+    template <size_t N>
+    class StaticFormatBuffer : public FormatBuffer
+    {
+    private:
+        std::array<char, N> m_storage;
+
+    public:
+        StaticFormatBuffer() : FormatBuffer( std::span<char>( m_storage ) ) {}
+
+        StaticFormatBuffer( const StaticFormatBuffer& ) = delete;
+        StaticFormatBuffer& operator=( const StaticFormatBuffer& ) = delete;
+    };
+
+    static constexpr size_t THREAD_BUFFER_SIZE = 4096;
+
+    /**
+     * Returns the formatting buffer of the calling thread, already cleared.
+     * Its content is valid until the next call from the same thread.
+     */
+    FormatBuffer& threadBuffer();
+
+    /**
+     * @brief Renders a time point with a strftime format, at most once per
+     * second: the text is cached and only rebuilt when the second changes.
+     */
+    class TimestampCache
+    {
+    private:
+        const char* m_format;
+        bool        m_utc;
+        int64_t     m_second = INT64_MIN;
+        char        m_text[64];
+        size_t      m_size = 0;
+
+    public:
+        explicit TimestampCache( const char* format = "%Y-%m-%d %H:%M:%S", bool utc = false )
+            : m_format( format ), m_utc( utc )
+        {}
+
+        /* Returns the text for the given number of seconds since the epoch */
+        std::string_view render( int64_t seconds );
+        std::string_view render( std::chrono::system_clock::time_point tp );
+    };
+
+    /**
+     * @brief Format string checked and parsed at compile time.
+     *
+     * The only replacement field is "{}", while "{{" and "}}" stand for the
+     * literal braces. The number of fields must match the number of arguments,
+     * otherwise the program does not compile. The positions of the fields are
+     * computed at compile time as well, so formatting is just a sequence of
+     * copies.
+     *
+     * @tparam Args The types of the arguments
+     */
+    template <typename... Args>
+    class BasicFormatString
+    {
+    private:
+        static constexpr size_t NARGS = sizeof...(Args);
+
+        std::string_view              m_str;
+        std::array<size_t, NARGS + 1> m_fields {}; // Start of each field, the last is the end
+        bool                          m_escapes = false; // If the literal text has {{ or }}
+
+    public:
+        template <typename S>
+            requires std::is_convertible_v<const S&, std::string_view>
+        consteval BasicFormatString( const S& str ) : m_str( str )
+        {
+            size_t nfields = 0;
+
+            for ( size_t idx = 0; idx < m_str.size(); ++idx )
+            {
+                char c = m_str[idx];
+                if ( c != '{' && c != '}' ) continue;
+
+                bool doubled = idx + 1 < m_str.size() && m_str[idx + 1] == c;
+                if ( doubled )
+                {
+                    m_escapes = true;
+                    ++idx;
+                    continue;
+                }
+
+                if ( c == '}' || idx + 1 >= m_str.size() || m_str[idx + 1] != '}' )
+                {
+                    throw "Invalid format string: unmatched brace";
+                }
+
+                if ( nfields == NARGS ) throw "Invalid format string: too many fields";
+                m_fields[nfields++] = idx++;
+            }
+
+            if ( nfields != NARGS ) throw "Invalid format string: too few fields";
+            m_fields[NARGS] = m_str.size();
+        }
+
+        constexpr std::string_view get() const { return m_str; }
+        constexpr size_t field( size_t idx ) const { return m_fields[idx]; }
+        constexpr bool hasEscapes() const { return m_escapes; }
+    };
+
+    // Prevent the deduction of the argument types from the format string
+    template <typename... Args>
+    using FormatString = BasicFormatString<std::type_identity_t<Args>...>;
+
+    /**
+     * Append the textual representation of the argument. Other types can
+     * be formatted by providing an overload found by ADL.
+     */
+    void formatArg( FormatBuffer& out, std::string_view value );
+    void formatArg( FormatBuffer& out, const char* value );
+    void formatArg( FormatBuffer& out, const std::string& value );
+    void formatArg( FormatBuffer& out, char value );
+    void formatArg( FormatBuffer& out, bool value );
+    void formatArg( FormatBuffer& out, const void* value );
+
+    template <typename T>
+        requires ( std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char> )
+    void formatArg( FormatBuffer& out, T value );
+
+    /* Append the literal text, replacing {{ and }} if needed */
+    void formatLiteral( FormatBuffer& out, std::string_view text, bool escapes );
+
+    /**
+     * Format the arguments into the buffer. No allocation is made.
+     *
+     * @param out The destination buffer
+     * @param fmt The compile-time checked format string
+     * @param args The arguments, one for each field
+     */
+    template <typename... Args>
+    void formatTo( FormatBuffer& out, FormatString<Args...> fmt, Args&&... args );
+
+    template <typename T>
+        requires ( std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char> )
+    inline void formatArg( FormatBuffer& out, T value )
+    {
+        if ( out.isTruncated() ) return;
+
+        auto [ptr, ec] = std::to_chars( out.end(), out.end() + out.remaining(), value );
+        if ( ec != std::errc() )
+        {
+            out.truncate();
+            return;
+        }
+
+        out.commit( static_cast<size_t>( ptr - out.end() ) );
+    }
+
+    template <typename... Args>
+    inline void formatTo( FormatBuffer& out, FormatString<Args...> fmt, Args&&... args )
+    {
+        std::string_view str = fmt.get();
+        size_t position = 0, idx = 0;
+
+        [[maybe_unused]] auto next = [&]( auto&& arg )
+        {
+            formatLiteral( out, str.substr( position, fmt.field( idx ) - position ), fmt.hasEscapes() );
+            formatArg( out, arg );
+            position = fmt.field( idx++ ) + 2;
+        };
+
+        ( next( std::forward<Args>( args ) ), ... );
+        formatLiteral( out, str.substr( position ), fmt.hasEscapes() );
+    }
+}
@@ -1,34 +1,57 @@
 #include "formatting.hpp"
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
 using namespace ccl::logging;
 
-std::string DefaultStringFormatter::format(LoggingLevel lvl, const std::string &msg)
+std::string_view ccl::logging::levelName(LoggingLevel lvl)
 {
-    auto now = std::chrono::system_clock::now();
-    std::time_t now_c = std::chrono::system_clock::to_time_t( now );
-    std::tm tm {};
+    switch (lvl)
+    {
+        case LoggingLevel::INFO: return "INFO";
+        case LoggingLevel::WARNING: return "WARNING";
+        case LoggingLevel::ERROR: return "ERROR";
+        default: return "";
+    }
+}
 
-#ifdef _WIN32
-    localtime_s( &tm, &now_c );
-#else
-    localtime_r( &now_c, &tm );
-#endif
+std::string DefaultStringFormatter::format(LoggingLevel lvl, const std::string &msg)
+{
+    FormatBuffer& out = threadBuffer();
+    formatTo( out, lvl, msg );
 
-    std::string logging_lvl;
-    switch (lvl)
+    // Too long for the thread buffer, fall back to a local one
+    if ( out.isTruncated() )
     {
-        case LoggingLevel::INFO: logging_lvl = "INFO"; break;
-        case LoggingLevel::WARNING: logging_lvl = "WARNING"; break;
-        case LoggingLevel::ERROR: logging_lvl = "ERROR"; break;
-        default: break;
+        std::string line( out.size() + msg.size() + 64, '\0' );
+        FormatBuffer big( line );
+        formatTo( big, lvl, msg );
+        line.resize( big.size() );
+        return line;
     }
 
-    std::ostringstream oss;
-    oss << "[" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "] "
-        << "[" << logging_lvl << "] " << msg
-        << std::endl;
+    return std::string( out.view() );
+}
+
+void DefaultStringFormatter::formatTo(
+    FormatBuffer &out, LoggingLevel lvl, std::string_view msg, clock::time_point tp
+) {
+    formatPrefix( out, lvl, tp );
+    out.append( msg );
+    out.append( '\n' );
+}
+
+void DefaultStringFormatter::formatPrefix(FormatBuffer &out, LoggingLevel lvl, clock::time_point tp)
+{
+    static thread_local TimestampCache timestamp;
 
-    return oss.str();
+    out.append( '[' );
+    out.append( timestamp.render( tp ) );
+    out.append( "] [" );
+    out.append( levelName( lvl ) );
+    out.append( "] " );
 }
 
 // ------------------------------------------------------------------------
@@ -40,7 +63,7 @@ SD_Element::SD_Element(const std::string &sdid)
 {}
 
 SD_Element::SD_Element(const SD_Element &other)
-: m_sdid( other.m_sdid ), m_sd_params( other.m_sd_params )
+: std::enable_shared_from_this<SD_Element>(), m_sdid( other.m_sdid ), m_sd_params( other.m_sd_params )
 {}
 
 SD_Element::SD_Element(SD_Element &&other)
@@ -71,7 +94,7 @@ bool SD_Element::isEmpty() const
     return m_sd_params.empty();
 }
 
-void SD_Element::addParameter(const std::string &k, const std::string &v)
+void SD_Element::addParameter(const std::string &k, SD_Value v)
 {
     // Here, we should check for known SD Parameters and SD Elements
     if ( 
@@ -83,18 +106,43 @@ void SD_Element::addParameter(const std::string &k, const std::string &v)
         throw std::runtime_error( "[Error] Known SD_ELEMENTS should have known SD_PARAM" );
     }
 
-    m_sd_params.insert_or_assign( k, v );
+    m_sd_params.insert_or_assign( k, std::move( v ) );
+}
+
+const std::string &SD_Element::getId() const
+{
+    return m_sdid;
+}
+
+const std::unordered_map<std::string, SD_Element::SD_Value> &SD_Element::getParameters() const
+{
+    return m_sd_params;
 }
 
 int ccl::logging::SD_Element::getValue(const std::string &k, std::string &out) const
 {
-    if ( m_sd_params.find( k ) != m_sd_params.end() )
+    auto it = m_sd_params.find( k );
+    if ( it == m_sd_params.end() ) return -1;
+
+    if ( auto str = std::get_if<std::string>( &it->second ) )
     {
-        out = m_sd_params.at( k );
+        out = *str;
         return 0;
     }
 
-    return -1;
+    StaticFormatBuffer<64> text;
+    std::visit( [&text]( const auto& value ) { formatArg( text, value ); }, it->second );
+    out.assign( text.view() );
+    return 0;
+}
+
+int ccl::logging::SD_Element::getValue(const std::string &k, SD_Value &out) const
+{
+    auto it = m_sd_params.find( k );
+    if ( it == m_sd_params.end() ) return -1;
+
+    out = it->second;
+    return 0;
 }
 
 std::string SD_Element::format() const
@@ -102,16 +150,53 @@ std::string SD_Element::format() const
     // Returns an empty string if the SD Element has no parameters
     if ( isEmpty() ) return "";
 
-    std::stringstream sd_elements_str;
-    sd_elements_str << "[" << m_sdid;
+    std::string result( THREAD_BUFFER_SIZE, '\0' );
+    FormatBuffer out( result );
+    formatTo( out );
+
+    // Parameters way too long, retry with larger buffers
+    while ( out.isTruncated() )
+    {
+        result.assign( 2 * result.size(), '\0' );
+        out = FormatBuffer( result );
+        formatTo( out );
+    }
+
+    result.resize( out.size() );
+    return result;
+}
+
+void SD_Element::formatTo(FormatBuffer &out) const
+{
+    if ( isEmpty() ) return;
+
+    out.append( '[' );
+    out.append( m_sdid );
 
     for ( const auto& [key,value]: m_sd_params )
     {
-        sd_elements_str << " " << key << "=\"" << value << "\"";
+        out.append( ' ' );
+        out.append( key );
+        out.append( "=\"" );
+
+        if ( auto str = std::get_if<std::string>( &value ) )
+        {
+            // Characters to escape inside a PARAM-VALUE (RFC 5424, 6.3.3)
+            for ( char c: *str )
+            {
+                if ( c == '"' || c == '\\' || c == ']' ) out.append( '\\' );
+                out.append( c );
+            }
+        }
+        else
+        {
+            std::visit( [&out]( const auto& typed ) { formatArg( out, typed ); }, value );
+        }
+
+        out.append( '"' );
     }
 
-    sd_elements_str << "]";
-    return sd_elements_str.str();
+    out.append( ']' );
 }
 
 SD_Element::cs_ptr SD_Element::toShared() const
@@ -141,14 +226,14 @@ SD_Element::w_ptr SysLogFormatter::getElement(const std::string &sdid) const
 }
 
 int SysLogFormatter::addParameter(
-    const std::string &sdid, const std::string &k, const std::string &v
+    const std::string &sdid, const std::string &k, SD_Element::SD_Value v
 ) {
     auto w_elem = getElement( sdid );
     if ( auto elem = w_elem.lock() )
     {
         try
         {
-            elem->addParameter( k, v );
+            elem->addParameter( k, std::move( v ) );
             return 0;
         }
         catch(const std::runtime_error& e)
@@ -166,5 +251,71 @@ int SysLogFormatter::addParameter(
 
 std::string SysLogFormatter::format(SysLogFacility f, SysLogSeverity s, const std::string &msg)
 {
-    return std::string();
+    FormatBuffer& out = threadBuffer();
+    formatTo( out, f, s, msg );
+
+    // Too long for the thread buffer, fall back to a local one. The
+    // structured data has no bound either, hence grow until it fits.
+    if ( out.isTruncated() )
+    {
+        std::string line( out.size() + msg.size() + 64, '\0' );
+        FormatBuffer big( line );
+        formatTo( big, f, s, msg );
+
+        while ( big.isTruncated() )
+        {
+            line.assign( 2 * line.size(), '\0' );
+            big = FormatBuffer( line );
+            formatTo( big, f, s, msg );
+        }
+
+        line.resize( big.size() );
+        return line;
+    }
+
+    return std::string( out.view() );
+}
+
+void SysLogFormatter::formatTo(FormatBuffer &out, SysLogFacility f, SysLogSeverity s, std::string_view msg)
+{
+    static thread_local TimestampCache timestamp( "%Y-%m-%dT%H:%M:%S", true );
+    static const std::string hostname = []() {
+        char name[256] = {};
+#ifndef _WIN32
+        if ( gethostname( name, sizeof(name) - 1 ) != 0 ) return std::string( "-" );
+#endif
+        return name[0] != '\0' ? std::string( name ) : std::string( "-" );
+    }();
+
+    auto now = std::chrono::system_clock::now();
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+        now.time_since_epoch() ).count() % 1'000'000;
+
+    // <PRI>VERSION TIMESTAMP HOSTNAME APP-NAME PROCID MSGID
+    int priority = static_cast<int>( f ) * 8 + static_cast<int>( s );
+    ccl::logging::formatTo( out, "<{}>{} {}.", priority, m_version, timestamp.render( now ) );
+
+    // Microseconds are zero padded to six digits
+    char digits[6];
+    for ( int idx = 5; idx >= 0; --idx, micros /= 10 ) digits[idx] = static_cast<char>( '0' + micros % 10 );
+    out.append( std::string_view( digits, sizeof(digits) ) );
+
+#ifndef _WIN32
+    long pid = static_cast<long>( ::getpid() );
+#else
+    long pid = static_cast<long>( GetCurrentProcessId() );
+#endif
+
+    ccl::logging::formatTo( out, "Z {} - {} - ", std::string_view( hostname ), pid );
+
+    // STRUCTURED-DATA, nil if there are no elements with parameters
+    size_t before = out.size();
+    for ( const auto& [sdid, element]: m_sd_elements ) element->formatTo( out );
+    if ( out.size() == before ) out.append( '-' );
+
+    if ( !msg.empty() )
+    {
+        out.append( ' ' );
+        out.append( msg );
+    }
 }
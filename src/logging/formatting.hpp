@@ -7,13 +7,18 @@
 #include <iomanip>
 #include <vector>
 #include <unordered_map>
+#include <variant>
 #include <stdexcept>
 #include <memory>
 #include <iostream>
 #include "enum.hpp"
+#include "format_string.hpp"
 
 namespace ccl::logging
 {
+    /* Returns the name of the level as written in the log */
+    std::string_view levelName( LoggingLevel lvl );
+
     class StringFormatterInterface
     {
     public:
@@ -24,13 +29,46 @@ namespace ccl::logging
      * @brief The default string formatter
      * 
      * Format the logging string as: [<date-time>][<level>] <message>
+     *
+     * The formatTo functions write into the given buffer, hence they do not
+     * allocate: the date-time is rendered at most once per second per thread
+     * and the arguments are formatted with a compile-time format string.
      */
     class DefaultStringFormatter : public StringFormatterInterface
     {
     public:
+        using clock = std::chrono::system_clock;
+
         std::string format( LoggingLevel lvl, const std::string& msg );
+
+        /**
+         * Format the message into the buffer.
+         * @param tp The time of the message
+         */
+        void formatTo( FormatBuffer& out, LoggingLevel lvl, std::string_view msg,
+                       clock::time_point tp = clock::now() );
+
+        /**
+         * Format the message, built from a format string and its arguments,
+         * into the buffer.
+         */
+        template <typename Arg, typename... Args>
+        void formatTo( FormatBuffer& out, LoggingLevel lvl, FormatString<Arg, Args...> fmt,
+                       Arg&& arg, Args&&... args );
+
+        /* Write the [<date-time>] [<level>] prefix of the line */
+        static void formatPrefix( FormatBuffer& out, LoggingLevel lvl, clock::time_point tp );
     };
 
+    template <typename Arg, typename... Args>
+    inline void DefaultStringFormatter::formatTo(
+        FormatBuffer& out, LoggingLevel lvl, FormatString<Arg, Args...> fmt, Arg&& arg, Args&&... args
+    ) {
+        formatPrefix( out, lvl, clock::now() );
+        ccl::logging::formatTo<Arg, Args...>( out, fmt, std::forward<Arg>( arg ), std::forward<Args>( args )... );
+        out.append( '\n' );
+    }
+
     // ------------------------------------------------------------------------
     // SYS LOG FORMAT CLASS
     // ------------------------------------------------------------------------
@@ -45,13 +83,20 @@ namespace ccl::logging
      * and interpretable data format. SD_Element is a single element in the
      * STRUCTURED-DATA field of the SysLog Logging message.
      * 
+     * Values keep their type (string, signed or unsigned integer, floating
+     * point or boolean), so that binary encodings do not need to parse them
+     * back. In the SysLog format they are all rendered as text.
+     *
      * Reference: [The SysLog Protocol](https://datatracker.ietf.org/doc/html/rfc5424)
      */
     class SD_Element : public std::enable_shared_from_this<SD_Element>
     {
+    public:
+        using SD_Value = std::variant<std::string, int64_t, uint64_t, double, bool>;
+
     private:
         std::string m_sdid;
-        std::unordered_map<std::string, std::string> m_sd_params;
+        std::unordered_map<std::string, SD_Value> m_sd_params;
 
     public:
         using s_ptr  = typename std::shared_ptr<SD_Element>;
@@ -68,19 +113,26 @@ namespace ccl::logging
         cs_ptr toShared() const;
 
         bool isEmpty() const;
-        void addParameter( const std::string& k, const std::string& v );
+        void addParameter( const std::string& k, SD_Value v );
+
+        const std::string& getId() const;
+        const std::unordered_map<std::string, SD_Value>& getParameters() const;
 
         /**
-         * Get the corresponding value of the input key if it exists.
-         * Returns 0 on success, and -1 on failure.
+         * Get the corresponding value of the input key if it exists, as
+         * text or with its type. Returns 0 on success, and -1 on failure.
          */
         int getValue( const std::string& k, std::string& out ) const;
+        int getValue( const std::string& k, SD_Value& out ) const;
         
         /**
          * Format the SD Element into the suitable format for SysLog.
          * Returns a string.
          */
         std::string format() const;
+
+        /* Same as format, writing into the buffer */
+        void formatTo( FormatBuffer& out ) const;
     };
 
     class SysLogFormatter
@@ -98,8 +150,16 @@ namespace ccl::logging
          * Adds the corresponding SD Parameter (k, v) in the given SD elements if
          * it exists in the formatter. On success, 0 is returned, otherwise -1.
          */
-        int addParameter( const std::string& sdid, const std::string& k, const std::string& v );
+        int addParameter( const std::string& sdid, const std::string& k, SD_Element::SD_Value v );
 
+        /**
+         * Format the message as a RFC 5424 line: the timestamp is in UTC with
+         * microseconds, the hostname and the process id are filled in, while
+         * the APP-NAME and the MSGID are nil.
+         */
         std::string format( SysLogFacility f, SysLogSeverity s, const std::string& msg );
+
+        /* Same as format, writing into the buffer */
+        void formatTo( FormatBuffer& out, SysLogFacility f, SysLogSeverity s, std::string_view msg );
     };
 }
\ No newline at end of file
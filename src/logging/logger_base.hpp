@@ -1,10 +1,99 @@
 #pragma once
 
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "enum.hpp"
+#include "format_string.hpp"
+
 namespace ccl::logging
 {
+    /**
+     * @brief Base class of all the loggers.
+     *
+     * It owns the minimum level: messages below it are discarded as the very
+     * first thing, before the message is even built. Hence, the lazy overload
+     * of log, taking a callable that returns the message, costs a single
+     * atomic load when the level is disabled. The same holds for the
+     * overloads taking a format string and its arguments, which format the
+     * message into the thread buffer without any allocation.
+     */
     class LoggingInterface
     {
+    private:
+        std::atomic<LoggingLevel> m_level;
+
+    protected:
+        /* Actually log the message, the level has already been checked */
+        virtual void write( LoggingLevel lvl, std::string_view msg ) = 0;
+
     public:
-        
+        explicit LoggingInterface( LoggingLevel lvl = LoggingLevel::INFO )
+            : m_level( lvl )
+        {}
+
+        virtual ~LoggingInterface() = default;
+
+        void         setLevel( LoggingLevel lvl ) { m_level.store( lvl, std::memory_order_relaxed ); }
+        LoggingLevel getLevel() const { return m_level.load( std::memory_order_relaxed ); }
+
+        /* Returns true if the messages with the given level are logged */
+        bool isEnabled( LoggingLevel lvl ) const { return lvl >= getLevel(); }
+
+        void log( LoggingLevel lvl, std::string_view msg )
+        {
+            if ( isEnabled( lvl ) ) write( lvl, msg );
+        }
+
+        /**
+         * Log the message returned by the builder, which is called only
+         * if the level is enabled.
+         */
+        template <typename Builder>
+        std::enable_if_t<std::is_invocable_v<Builder>> log( LoggingLevel lvl, Builder&& builder )
+        {
+            if ( isEnabled( lvl ) ) write( lvl, std::string_view( builder() ) );
+        }
+
+        /**
+         * Log the message formatted from the format string and the arguments,
+         * which is done only if the level is enabled. Messages longer than
+         * THREAD_BUFFER_SIZE are truncated.
+         */
+        template <typename Arg, typename... Args>
+        void log( LoggingLevel lvl, FormatString<Arg, Args...> fmt, Arg&& arg, Args&&... args )
+        {
+            if ( !isEnabled( lvl ) ) return;
+
+            FormatBuffer& out = threadBuffer();
+            formatTo<Arg, Args...>( out, fmt, std::forward<Arg>( arg ), std::forward<Args>( args )... );
+            write( lvl, out.view() );
+        }
+
+        void info   ( std::string_view msg ) { log( LoggingLevel::INFO,    msg ); }
+        void warning( std::string_view msg ) { log( LoggingLevel::WARNING, msg ); }
+        void error  ( std::string_view msg ) { log( LoggingLevel::ERROR,   msg ); }
+
+        template <typename Arg, typename... Args>
+        void info( FormatString<Arg, Args...> fmt, Arg&& arg, Args&&... args )
+        {
+            log<Arg, Args...>( LoggingLevel::INFO, fmt, std::forward<Arg>( arg ), std::forward<Args>( args )... );
+        }
+
+        template <typename Arg, typename... Args>
+        void warning( FormatString<Arg, Args...> fmt, Arg&& arg, Args&&... args )
+        {
+            log<Arg, Args...>( LoggingLevel::WARNING, fmt, std::forward<Arg>( arg ), std::forward<Args>( args )... );
+        }
+
+        template <typename Arg, typename... Args>
+        void error( FormatString<Arg, Args...> fmt, Arg&& arg, Args&&... args )
+        {
+            log<Arg, Args...>( LoggingLevel::ERROR, fmt, std::forward<Arg>( arg ), std::forward<Args>( args )... );
+        }
+
+        /* Wait until all the messages logged so far are written */
+        virtual void flush() = 0;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,51 @@
+#include <filesystem>
+#include <iostream>
+#include <logging/binary_log.hpp>
+
+using namespace ccl::logging;
+
+/**
+ * Print the messages of binary log segments as text lines. Each argument is
+ * either a segment file, or the path given to the BinaryLogger, whose
+ * segments are decoded in order.
+ */
+int main( int argc, char** argv )
+{
+    if ( argc < 2 )
+    {
+        std::cerr << "Usage: " << argv[0] << " <segment | prefix>..." << std::endl;
+        return 1;
+    }
+
+    int status = 0;
+
+    for ( int idx = 1; idx < argc; ++idx )
+    {
+        std::vector<std::string> files;
+        if ( std::filesystem::is_regular_file( argv[idx] ) ) files.push_back( argv[idx] );
+        else files = BinaryLogReader::segments( argv[idx] );
+
+        if ( files.empty() )
+        {
+            std::cerr << "[LogDecoder] No segment found for " << argv[idx] << std::endl;
+            status = 1;
+        }
+
+        for ( const auto& file: files )
+        {
+            try
+            {
+                BinaryLogReader reader( file );
+                reader.render( std::cout );
+            }
+            catch ( const std::runtime_error& e )
+            {
+                std::cerr << e.what() << std::endl;
+                status = 1;
+            }
+        }
+    }
+
+    std::cout.flush();
+    return status;
+}
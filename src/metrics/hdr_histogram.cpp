@@ -0,0 +1,162 @@
+#include "hdr_histogram.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+using namespace ccl::metrics;
+
+HdrHistogram::HdrHistogram(uint64_t highest, int digits)
+    : m_highest( highest ), m_digits( digits )
+{
+    if ( digits < 1 || digits > 5 || highest < 2 )
+    {
+        std::stringstream ss;
+        ss << "[HdrHistogram] Invalid configuration: highest " << highest
+           << " and " << digits << " significant digits";
+
+        throw std::invalid_argument( ss.str() );
+    }
+
+    // Sub-buckets enough to tell apart 1 unit in 10^digits
+    uint64_t largest_single_unit = 2 * static_cast<uint64_t>( std::pow( 10, digits ) );
+    m_subBucketMagnitude     = static_cast<int>( std::bit_width( largest_single_unit - 1 ) );
+    m_subBucketHalfMagnitude = m_subBucketMagnitude - 1;
+    m_subBucketCount         = uint64_t( 1 ) << m_subBucketMagnitude;
+    m_subBucketHalfCount     = m_subBucketCount / 2;
+    m_subBucketMask          = m_subBucketCount - 1;
+
+    // Power of two buckets needed to reach the highest value
+    size_t buckets = 1;
+    uint64_t smallest_untrackable = m_subBucketCount;
+    while ( smallest_untrackable <= highest && smallest_untrackable < ( UINT64_MAX >> 1 ) )
+    {
+        smallest_untrackable <<= 1;
+        ++buckets;
+    }
+
+    m_counts.assign( ( buckets + 1 ) * m_subBucketHalfCount, 0 );
+}
+
+size_t HdrHistogram::index_of(uint64_t value) const
+{
+    // The first bucket holds all the sub-buckets, the others only the upper half
+    int bucket = static_cast<int>( std::bit_width( value | m_subBucketMask ) ) - m_subBucketMagnitude;
+    uint64_t sub_bucket = value >> bucket;
+
+    return ( static_cast<size_t>( bucket + 1 ) << m_subBucketHalfMagnitude )
+         + static_cast<size_t>( sub_bucket - m_subBucketHalfCount );
+}
+
+uint64_t HdrHistogram::value_at(size_t index) const
+{
+    int bucket = static_cast<int>( index >> m_subBucketHalfMagnitude ) - 1;
+    uint64_t sub_bucket = ( index & ( m_subBucketHalfCount - 1 ) ) + m_subBucketHalfCount;
+
+    if ( bucket < 0 )
+    {
+        sub_bucket -= m_subBucketHalfCount;
+        bucket = 0;
+    }
+
+    return sub_bucket << bucket;
+}
+
+uint64_t HdrHistogram::highest_equivalent(uint64_t value) const
+{
+    int bucket = static_cast<int>( std::bit_width( value | m_subBucketMask ) ) - m_subBucketMagnitude;
+    uint64_t lowest = ( value >> bucket ) << bucket;
+    return lowest + ( uint64_t( 1 ) << bucket ) - 1;
+}
+
+void HdrHistogram::record(uint64_t value, uint64_t count)
+{
+    if ( count == 0 ) return;
+
+    size_t index = index_of( std::min( value, m_highest ) );
+    m_counts[std::min( index, m_counts.size() - 1 )] += count;
+
+    m_total += count;
+    m_sum   += value * count;
+    m_min    = std::min( m_min, value );
+    m_max    = std::max( m_max, value );
+}
+
+void HdrHistogram::merge(const HdrHistogram &other)
+{
+    if ( other.m_highest != m_highest || other.m_digits != m_digits )
+    {
+        throw std::invalid_argument( "[HdrHistogram] Cannot merge histograms with different configurations" );
+    }
+
+    for ( size_t idx = 0; idx < m_counts.size(); ++idx ) m_counts[idx] += other.m_counts[idx];
+
+    m_total += other.m_total;
+    m_sum   += other.m_sum;
+    m_min    = std::min( m_min, other.m_min );
+    m_max    = std::max( m_max, other.m_max );
+}
+
+void HdrHistogram::reset()
+{
+    std::fill( m_counts.begin(), m_counts.end(), 0 );
+    m_total = 0;
+    m_min   = UINT64_MAX;
+    m_max   = 0;
+    m_sum   = 0;
+}
+
+uint64_t HdrHistogram::getValueAtPercentile(double percentile) const
+{
+    if ( m_total == 0 ) return 0;
+
+    if ( percentile >= 100.0 ) return m_max;
+
+    percentile = std::max( percentile, 0.0 );
+    uint64_t target = static_cast<uint64_t>( percentile / 100.0 * static_cast<double>( m_total ) + 0.5 );
+    target = std::max<uint64_t>( target, 1 );
+
+    uint64_t seen = 0;
+    for ( size_t idx = 0; idx < m_counts.size(); ++idx )
+    {
+        seen += m_counts[idx];
+        if ( seen >= target )
+        {
+            // Never beyond the exact extremes
+            return std::clamp( highest_equivalent( value_at( idx ) ), m_min, m_max );
+        }
+    }
+
+    return m_max;
+}
+
+uint64_t HdrHistogram::getCount() const
+{
+    return m_total;
+}
+
+uint64_t HdrHistogram::getMin() const
+{
+    return m_total == 0 ? 0 : m_min;
+}
+
+uint64_t HdrHistogram::getMax() const
+{
+    return m_max;
+}
+
+uint64_t HdrHistogram::getSum() const
+{
+    return m_sum;
+}
+
+double HdrHistogram::getMean() const
+{
+    return m_total == 0 ? 0.0 : static_cast<double>( m_sum ) / static_cast<double>( m_total );
+}
+
+size_t HdrHistogram::getMemorySize() const
+{
+    return m_counts.size() * sizeof( uint64_t );
+}
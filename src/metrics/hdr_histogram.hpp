@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ccl::metrics
+{
+    /**
+     * @class HdrHistogram
+     *
+     * @brief High Dynamic Range histogram of non-negative integer values.
+     *
+     * Values are counted in log-linear buckets: each power of two range is
+     * split in the same number of sub-buckets, so that any recorded value is
+     * known with the given number of significant decimal digits, whatever
+     * its magnitude. Recording is a couple of shifts and an increment, the
+     * memory is fixed at construction. Values above the highest trackable
+     * one are counted in the last bucket, while the exact minimum, maximum
+     * and sum are kept aside.
+     *
+     * Reference: [HdrHistogram](https://hdrhistogram.github.io/HdrHistogram/)
+     */
+    class HdrHistogram
+    {
+    private:
+        uint64_t m_highest;           // Highest trackable value
+        int      m_digits;            // Significant decimal digits
+        int      m_subBucketMagnitude;
+        int      m_subBucketHalfMagnitude;
+        uint64_t m_subBucketCount;
+        uint64_t m_subBucketHalfCount;
+        uint64_t m_subBucketMask;
+
+        std::vector<uint64_t> m_counts;
+        uint64_t m_total = 0;
+        uint64_t m_min   = UINT64_MAX;
+        uint64_t m_max   = 0;
+        uint64_t m_sum   = 0;
+
+        size_t   index_of   ( uint64_t value ) const;
+        uint64_t value_at   ( size_t index ) const;
+        uint64_t highest_equivalent( uint64_t value ) const;
+
+    public:
+        static constexpr uint64_t DEFAULT_HIGHEST = 3'600'000'000; // An hour in us
+
+        /**
+         * @param highest The highest value to track with the given precision
+         * @param digits The number of significant decimal digits, from 1 to 5
+         */
+        explicit HdrHistogram( uint64_t highest = DEFAULT_HIGHEST, int digits = 2 );
+
+        /* Count the value the given number of times */
+        void record( uint64_t value, uint64_t count = 1 );
+
+        /**
+         * Add the counts of the other histogram, which must have the same
+         * highest value and precision.
+         */
+        void merge( const HdrHistogram& other );
+
+        void reset();
+
+        /**
+         * Returns the value below which the given percentage of values fall,
+         * within the precision of the histogram, or 0 if it is empty.
+         *
+         * @param percentile From 0 to 100
+         */
+        uint64_t getValueAtPercentile( double percentile ) const;
+
+        uint64_t getCount() const;
+        uint64_t getMin() const; // 0 if empty
+        uint64_t getMax() const;
+        uint64_t getSum() const;
+        double   getMean() const;
+        size_t   getMemorySize() const; // Bytes of the counts
+    };
+}
@@ -2,44 +2,81 @@
 
 using namespace ccl::metrics;
 
+MetricsBroker::MetricsBroker(const MetricsSinkConfig &config)
+    : m_sink( *this, config )
+{}
+
 std::shared_ptr<MetricsBroker> MetricsBroker::getInstance()
 {
     static auto ptr = std::make_shared<MetricsBroker>();
     return ptr;
 }
 
+MetricsBroker &MetricsBroker::instance()
+{
+    static MetricsBroker& ref = *getInstance();
+    return ref;
+}
+
+void MetricsBroker::setCollectionMode(CollectionMode mode)
+{
+    s_mode.store( mode, std::memory_order_relaxed );
+}
+
+CollectionMode MetricsBroker::getCollectionMode()
+{
+    return s_mode.load( std::memory_order_relaxed );
+}
+
+void MetricsBroker::setDelivery(MetricsDelivery delivery)
+{
+    s_delivery.store( delivery, std::memory_order_relaxed );
+}
+
+MetricsDelivery MetricsBroker::getDelivery()
+{
+    return s_delivery.load( std::memory_order_relaxed );
+}
+
+void MetricsBroker::setEnabled(bool enabled)
+{
+    s_enabled.store( enabled, std::memory_order_relaxed );
+}
+
+MetricsSink &MetricsBroker::getSink()
+{
+    return m_sink;
+}
+
 void MetricsBroker::addMetricsCollector(const collector_ptr &collector)
 {
-    auto& collectors_stack = getCollectorsByTid( collector->getThreadId() );
+    auto& collectors_stack = getCollectorsStack();
 
-    // The stack for the given thread is always accessed sequentially
-    // therefore, we do not need to lock something else here.
+    // The stack is owned by the calling thread, which is the one of the
+    // collector, therefore we do not need to lock anything here.
 
-    // First, we need to check if the last element of the stack, if not empty,
-    // is still accessible or not. If it is not, then we remove it.
-    if ( !collectors_stack.empty() && collectors_stack.back().expired() )
+    // First, we need to drop the collectors on top of the stack that are
+    // not accessible anymore, i.e., the functions that already returned.
+    while ( !collectors_stack.empty() && collectors_stack.back().expired() )
     {
         collectors_stack.pop_back();
     }
 
-    // If there are still elements in the stack, then take the last element and
-    // set the input collector as its child.
+    // If there are still elements in the stack, then the last one is the
+    // caller of the function: set it as the parent of the input collector.
     if ( !collectors_stack.empty() )
     {
-        // First get the last collector and see if it still accessible
-        collector_life_t prev_coll_ref = collectors_stack.back();
-
-        if ( auto prev_coll = prev_coll_ref.lock() )
+        if ( auto prev_coll = collectors_stack.back().lock() )
         {
-            prev_coll->setParent( collector->getFuncName() );
+            collector->setParent( prev_coll->getFuncName() );
         }
     }
 
     collectors_stack.push_back( collector );
 }
 
-std::vector<MetricsBroker::collector_life_t> &MetricsBroker::getCollectorsByTid(int tid)
+std::vector<MetricsBroker::collector_life_t> &MetricsBroker::getCollectorsStack()
 {
-    std::lock_guard<std::mutex> _l( m_mutex );
-    return m_metrics_map[ tid ];
+    static thread_local std::vector<collector_life_t> stack;
+    return stack;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <metrics/metrics_gather.hpp>
+#include <metrics/metrics_sink.hpp>
 #include <patterns/pub_sub/broker.hpp>
 #include <memory>
 #include <vector>
@@ -8,22 +9,37 @@
 #include <thread>
 #include <mutex>
 #include <iterator>
+#include <atomic>
 
 namespace ccl::metrics
 {
     /**
      * @class MetricsBroker
+     *
+     * @brief Broker of the MetricEvents, which also keeps the stack of the
+     * active collectors of each thread, to link them to their caller.
+     *
+     * With MetricsDelivery::Sink the collectors do not publish their events
+     * themselves: they stage them in the MetricsSink of the broker, which
+     * delivers them to the same subscribers from a background thread.
      */
     class MetricsBroker : public ccl::dp::pub_sub::PubSubBroker
     {
         friend class MetricsCollector;
+        friend class ScopeTimer;
 
     private:
         using collector_life_t = typename std::weak_ptr<MetricsCollector>;
         using collector_ptr = typename std::shared_ptr<MetricsCollector>;
         
-        std::unordered_map<int, std::vector<collector_life_t>> m_metrics_map;
-        std::mutex m_mutex;
+        MetricsSink m_sink; // Deferred delivery of the metrics
+
+        static inline std::atomic<CollectionMode>  s_mode     = CollectionMode::Proc;
+        static inline std::atomic<MetricsDelivery> s_delivery = MetricsDelivery::Direct;
+        static inline std::atomic<bool>            s_enabled  = true;
+
+        /* Returns the unique instance without touching its reference count */
+        static MetricsBroker& instance();
 
         /**
          * @brief Add a new metric collector on the stack
@@ -31,14 +47,13 @@ namespace ccl::metrics
         void addMetricsCollector( const collector_ptr& collector );
 
         /**
-         * @brief Returns the collectors stack given the Thread ID
-         * @param tid The current Thread ID
-         * @return The collectors Stack
+         * @brief Returns the collectors stack of the calling thread. Being
+         * thread-local, it is accessed without any lock.
          */
-        std::vector<collector_life_t>& getCollectorsByTid( int tid );
+        std::vector<collector_life_t>& getCollectorsStack();
 
     public:
-        MetricsBroker() = default;
+        explicit MetricsBroker( const MetricsSinkConfig& config = {} );
 
         MetricsBroker( const MetricsBroker& ) = delete;
         MetricsBroker& operator=( const MetricsBroker& ) = delete;
@@ -48,5 +63,34 @@ namespace ccl::metrics
          * and returns a reference to it.
          */
         static std::shared_ptr<MetricsBroker> getInstance();
+
+        /**
+         * @brief Set how the collectors created from now on gather metrics.
+         * The default is CollectionMode::Proc.
+         */
+        static void setCollectionMode( CollectionMode mode );
+        static CollectionMode getCollectionMode();
+
+        /**
+         * @brief Set how the collectors created from now on deliver their
+         * metrics. The default is MetricsDelivery::Direct.
+         */
+        static void setDelivery( MetricsDelivery delivery );
+        static MetricsDelivery getDelivery();
+
+        /**
+         * @brief Turn the collection on or off globally. While disabled,
+         * MetricsCollector::create costs a relaxed load and returns the
+         * inert collector. Enabled by default.
+         */
+        static void setEnabled( bool enabled );
+
+        static bool isEnabled()
+        {
+            return s_enabled.load( std::memory_order_relaxed );
+        }
+
+        /* Returns the sink used by MetricsDelivery::Sink */
+        MetricsSink& getSink();
     };
 }
\ No newline at end of file
@@ -0,0 +1,311 @@
+#include "metrics_exporter.hpp"
+#include <concurrent/thread.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace ccl::metrics;
+
+static constexpr std::string_view CONTENT_TYPE = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+// Largest request accepted, only the request line is used
+static constexpr size_t MAX_REQUEST = 8 * 1024;
+
+/**
+ * Background thread accepting the connections. It sleeps in poll until a
+ * client connects or the exporter writes into the wake-up pipe.
+ */
+class MetricsExporter::Server : public ccl::sys::concurrent::Thread
+{
+private:
+    MetricsExporter* m_owner;
+
+    void run() override
+    {
+#ifndef _WIN32
+
+        struct pollfd fds[2] = {
+            { m_owner->m_listenFd, POLLIN, 0 },
+            { m_owner->m_wakeFd[0], POLLIN, 0 }
+        };
+
+        while ( !isCancelled() )
+        {
+            if ( poll( fds, 2, -1 ) < 0 ) continue;
+            if ( isCancelled() || ( fds[1].revents & POLLIN ) ) break;
+            if ( !( fds[0].revents & POLLIN ) ) continue;
+
+            int client = accept4( m_owner->m_listenFd, nullptr, nullptr, SOCK_CLOEXEC );
+            if ( client < 0 ) continue;
+
+            m_owner->serve( client );
+            close( client );
+        }
+
+#endif
+    }
+
+public:
+    explicit Server( MetricsExporter* owner )
+        : Thread( "MetricsExporter-Server", false,
+                  ccl::sys::concurrent::CancellationPolicy::AT_CONDITION_CHECK ),
+          m_owner( owner )
+    {}
+};
+
+#ifndef _WIN32
+
+static void throw_errno( const std::string& what )
+{
+    std::stringstream ss;
+    ss << "[MetricsExporter] " << what << ": " << std::strerror( errno );
+    throw std::runtime_error( ss.str() );
+}
+
+static bool send_all( int fd, const void* data, size_t size )
+{
+    const char* bytes = static_cast<const char*>( data );
+
+    while ( size > 0 )
+    {
+        ssize_t sent = send( fd, bytes, size, MSG_NOSIGNAL );
+        if ( sent < 0 && errno == EINTR ) continue;
+        if ( sent <= 0 ) return false;
+
+        bytes += sent;
+        size -= static_cast<size_t>( sent );
+    }
+
+    return true;
+}
+
+#endif
+
+MetricsExporter::MetricsExporter(MetricsRegistry &registry, const MetricsExporterConfig &config)
+    : m_registry( registry ), m_config( config ), m_buffer( config.buffer_size ), m_renderer( registry )
+{
+#ifndef _WIN32
+
+    if ( !config.unix_path.empty() )
+    {
+        struct sockaddr_un address {};
+        if ( config.unix_path.size() >= sizeof( address.sun_path ) )
+        {
+            throw std::runtime_error( "[MetricsExporter] Unix socket path too long: " + config.unix_path );
+        }
+
+        address.sun_family = AF_UNIX;
+        std::memcpy( address.sun_path, config.unix_path.c_str(), config.unix_path.size() );
+
+        m_listenFd = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+        if ( m_listenFd < 0 ) throw_errno( "socket" );
+
+        unlink( config.unix_path.c_str() );
+        if ( bind( m_listenFd, reinterpret_cast<sockaddr*>( &address ), sizeof( address ) ) < 0 )
+        {
+            close( m_listenFd );
+            throw_errno( "bind " + config.unix_path );
+        }
+    }
+    else
+    {
+        struct sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons( config.port );
+        address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+        m_listenFd = socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+        if ( m_listenFd < 0 ) throw_errno( "socket" );
+
+        int reuse = 1;
+        setsockopt( m_listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof( reuse ) );
+
+        socklen_t length = sizeof( address );
+        if ( bind( m_listenFd, reinterpret_cast<sockaddr*>( &address ), sizeof( address ) ) < 0 ||
+             getsockname( m_listenFd, reinterpret_cast<sockaddr*>( &address ), &length ) < 0 )
+        {
+            close( m_listenFd );
+            throw_errno( "bind port " + std::to_string( config.port ) );
+        }
+
+        m_port = ntohs( address.sin_port );
+    }
+
+    const char* failed = nullptr;
+    if ( listen( m_listenFd, 16 ) < 0 ) failed = "listen";
+    else if ( pipe2( m_wakeFd, O_CLOEXEC ) < 0 ) failed = "pipe2";
+
+    if ( failed != nullptr )
+    {
+        int error = errno;
+        close( m_listenFd );
+
+        // Do not leave the bound socket file behind
+        if ( !config.unix_path.empty() ) unlink( config.unix_path.c_str() );
+
+        errno = error;
+        throw_errno( failed );
+    }
+
+    m_server = std::make_unique<Server>( this );
+    m_server->start();
+
+#else
+
+    // Windows Implementation
+    throw std::runtime_error( "[MetricsExporter] Not available on this platform" );
+
+#endif
+}
+
+MetricsExporter::~MetricsExporter()
+{
+#ifndef _WIN32
+
+    m_server->cancel();
+
+    char byte = 0;
+    while ( write( m_wakeFd[1], &byte, 1 ) < 0 && errno == EINTR );
+
+    m_server->join();
+    m_server.reset();
+
+    close( m_wakeFd[0] );
+    close( m_wakeFd[1] );
+    close( m_listenFd );
+
+    if ( !m_config.unix_path.empty() ) unlink( m_config.unix_path.c_str() );
+
+#endif
+}
+
+void MetricsExporter::serve(int client)
+{
+#ifndef _WIN32
+
+    // Never wait forever on a client
+    struct timeval timeout { 1, 0 };
+    setsockopt( client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof( timeout ) );
+    setsockopt( client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof( timeout ) );
+
+    // Read up to the end of the headers, the body (if any) is ignored
+    std::string request;
+    char chunk[1024];
+
+    while ( request.find( "\r\n\r\n" ) == std::string::npos && request.size() < MAX_REQUEST )
+    {
+        ssize_t nbytes = recv( client, chunk, sizeof( chunk ), 0 );
+        if ( nbytes < 0 && errno == EINTR ) continue;
+        if ( nbytes <= 0 ) return;
+        request.append( chunk, static_cast<size_t>( nbytes ) );
+    }
+
+    if ( request.compare( 0, 4, "GET " ) != 0 )
+    {
+        static constexpr std::string_view NOT_ALLOWED =
+            "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+        send_all( client, NOT_ALLOWED.data(), NOT_ALLOWED.size() );
+        return;
+    }
+
+    // A failing scrape must not take the server thread (and the process) down
+    bool answered = false; // The 200 header has been sent
+    try
+    {
+        m_renderer.begin();
+
+        bool done = false;
+        while ( !done )
+        {
+            m_buffer.reset();
+            done = renderChunk();
+
+            if ( !answered )
+            {
+                // No length: the end of the body is the end of the connection
+                std::string header = "HTTP/1.1 200 OK\r\nContent-Type: ";
+                header += CONTENT_TYPE;
+                header += "\r\nConnection: close\r\n\r\n";
+
+                if ( !send_all( client, header.data(), header.size() ) ) return;
+                answered = true;
+            }
+
+            if ( m_buffer.getBufferSize() > 0 &&
+                 !send_all( client, m_buffer.getBuffer(), m_buffer.getBufferSize() ) )
+            {
+                return;
+            }
+        }
+    }
+    catch ( const std::exception& e )
+    {
+        std::cerr << "[MetricsExporter] Scrape failed: " << e.what() << std::endl;
+
+        if ( !answered )
+        {
+            static constexpr std::string_view INTERNAL_ERROR =
+                "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+            send_all( client, INTERNAL_ERROR.data(), INTERNAL_ERROR.size() );
+            return;
+        }
+
+        // The body is incomplete: reset the connection instead of ending it
+        struct linger abort { 1, 0 };
+        setsockopt( client, SOL_SOCKET, SO_LINGER, &abort, sizeof( abort ) );
+        return;
+    }
+
+    // Counted before the client sees the end of the body
+    m_scrapes.fetch_add( 1, std::memory_order_relaxed );
+    shutdown( client, SHUT_WR );
+
+#else
+
+    // Windows Implementation
+    (void)client;
+
+#endif
+}
+
+bool MetricsExporter::renderChunk()
+{
+    while ( true )
+    {
+        try
+        {
+            return m_renderer.render( m_buffer );
+        }
+        catch ( const std::overflow_error& )
+        {
+            // A line longer than the whole buffer, kept pending by the
+            // renderer: grow the buffer until it fits, for the next scrapes too
+            m_buffer.allocate( std::max<size_t>( 2 * m_buffer.getBufferCapacity(), 1024 ) );
+        }
+    }
+}
+
+uint16_t MetricsExporter::getPort() const
+{
+    return m_port;
+}
+
+uint64_t MetricsExporter::getScrapes() const
+{
+    return m_scrapes.load( std::memory_order_relaxed );
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <metrics/open_metrics.hpp>
+#include <data_structures/buffers/byte_buffer.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace ccl::metrics
+{
+    /**
+     * @brief Configuration of a MetricsExporter
+     */
+    struct MetricsExporterConfig
+    {
+        // Serve on this Unix domain socket if not empty (replaced if it exists)
+        std::string unix_path;
+
+        // Otherwise serve on 127.0.0.1 at this port, 0 picks a free one
+        uint16_t port = 0;
+
+        // Capacity of the buffer the exposition is rendered into, a chunk
+        // at a time. It grows when a single line does not fit.
+        size_t buffer_size = 64 * 1024;
+    };
+
+    /**
+     * @class MetricsExporter
+     *
+     * @brief Serves the metrics of a registry in the OpenMetrics text format,
+     * over HTTP on a Unix domain socket or on the loopback interface.
+     *
+     * A background thread accepts one connection at a time, reads the
+     * request and answers any GET with the exposition (other methods get a
+     * 405), then closes the connection. The exposition is rendered into a
+     * ByteBuffer of fixed capacity and sent chunk by chunk, so its size is
+     * not bounded by the buffer, and the writers of the metrics are never
+     * blocked (see OpenMetricsRenderer). Slow clients are given up after
+     * a second without progress.
+     *
+     * Scraping with curl: curl --unix-socket <path> http://localhost/metrics
+     */
+    class MetricsExporter
+    {
+    private:
+        class Server; // The background thread
+
+        MetricsRegistry&      m_registry;
+        MetricsExporterConfig m_config;
+
+        int      m_listenFd  = -1;
+        int      m_wakeFd[2] = { -1, -1 }; // Pipe waking up the server on destruction
+        uint16_t m_port      = 0;
+
+        ds::buffers::ByteBuffer m_buffer;
+        OpenMetricsRenderer     m_renderer;
+        std::atomic<uint64_t>   m_scrapes = 0;
+
+        std::unique_ptr<Server> m_server;
+
+        void serve( int client ); // Answer a single connection
+        bool renderChunk();       // Render into the buffer, grown to fit the longest line
+
+    public:
+        /**
+         * @param registry The registry to expose, must outlive the exporter
+         * @param config Where to listen
+         * @throws std::runtime_error If the socket cannot be bound
+         */
+        explicit MetricsExporter( MetricsRegistry& registry, const MetricsExporterConfig& config = {} );
+
+        MetricsExporter( const MetricsExporter& ) = delete;
+        MetricsExporter& operator=( const MetricsExporter& ) = delete;
+
+        /* Stops serving, and removes the Unix socket if any */
+        ~MetricsExporter();
+
+        uint16_t getPort() const;    // The TCP port, 0 on Unix sockets
+        uint64_t getScrapes() const; // Number of expositions served
+    };
+}
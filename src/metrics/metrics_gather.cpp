@@ -5,30 +5,75 @@ using namespace ccl::metrics;
 
 namespace ps = ccl::dp::pub_sub;
 
-MetricsCollector::MetricsCollector(const std::string &func_name)
-    : m_function_name(func_name), m_thread_id( syscall(SYS_gettid) )
+MetricsCollector::MetricsCollector(const std::string &func_name, PerfEvent events)
+    : m_function_name(func_name), m_thread_id( get_thread_id() ),
+      m_mode( MetricsBroker::getCollectionMode() ),
+      m_delivery( MetricsBroker::getDelivery() )
 {
+    if ( events != PerfEvent::None )
+    {
+        m_perf = &PerfCounterGroup::forThread( events );
+    }
+
     m_metrics.m_start_time = std::chrono::high_resolution_clock::now();
     m_metrics.m_timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
         m_metrics.m_start_time.time_since_epoch()).count();
     
-    m_metrics.m_cpu_time = get_cpu_time();
-    m_metrics.m_stack_usage = get_stack_usage( m_thread_id );
-    m_metrics.m_heap_usage = get_heap_usage();
+    m_metrics.m_cpu_time = sampleCpuTime();
+    m_metrics.m_stack_usage = sampleStack();
+    m_metrics.m_heap_usage = sampleHeap();
     m_metrics.m_heap_res = m_metrics.m_heap_usage;
+
+    // Last, so that the other probes are not counted
+    if ( m_perf != nullptr ) m_perf->read( m_metrics.m_counters );
 }   
 
+MetricsCollector::MetricsCollector()
+    : m_thread_id( 0 ), m_metrics(), m_mode( CollectionMode::Fast ),
+      m_delivery( MetricsDelivery::Direct ), m_inert( true )
+{}
+
+std::shared_ptr<MetricsCollector> MetricsCollector::inert()
+{
+    // Never destroyed, so it can be used until the very end
+    static MetricsCollector* collector = new MetricsCollector();
+
+    // Aliasing an empty pointer: no control block, no reference counting
+    return std::shared_ptr<MetricsCollector>( std::shared_ptr<MetricsCollector>(), collector );
+}
+
+static uint64_t steady_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
 ccl::metrics::MetricsCollector::~MetricsCollector()
 {
-    long final_heap_res = get_heap_usage();
+    if ( m_inert ) return;
+
+    uint64_t start = m_sampler != nullptr ? steady_ns() : 0;
+
+    long final_heap_res = sampleHeap();
     m_metrics.m_heap_res = final_heap_res - m_metrics.m_heap_res;
 
-    // Now it has to publish the metrics event to the broker
-    auto metrics_ev = std::make_shared<const MetricEvent>(m_parent, m_function_name, 
-        m_metrics, m_thread_id);
+    // The collector is going away: its names can be moved into the record
+    if ( m_delivery == MetricsDelivery::Sink )
+    {
+        MetricsBroker::instance().getSink().push( {
+            std::move( m_parent ), std::move( m_function_name ), m_metrics, m_thread_id } );
+    }
+    else
+    {
+        // Now it has to publish the metrics event to the broker
+        auto metrics_ev = std::make_shared<const MetricEvent>(m_parent, m_function_name, 
+            m_metrics, m_thread_id);
+
+        std::shared_ptr<const ps::PubSubEvent> base_ref = metrics_ev;
+        publish( base_ref );
+    }
 
-    std::shared_ptr<const ps::PubSubEvent> base_ref = metrics_ev;
-    publish( base_ref );
+    if ( m_sampler != nullptr ) m_sampler->record( m_overhead + steady_ns() - start );
 }
 
 TID_t MetricsCollector::getThreadId() const
@@ -56,13 +101,35 @@ Metrics MetricsCollector::getCollectedMetrics() const
     return m_metrics;
 }
 
+long MetricsCollector::sampleCpuTime() const
+{
+    return m_mode == CollectionMode::Fast ? get_thread_cpu_time() : get_cpu_time();
+}
+
+long MetricsCollector::sampleStack() const
+{
+    return m_mode == CollectionMode::Fast ? get_stack_usage_fast() : get_stack_usage( m_thread_id );
+}
+
+long MetricsCollector::sampleHeap() const
+{
+    return m_mode == CollectionMode::Fast ? get_heap_bytes() / 1024 : get_heap_usage();
+}
+
 void MetricsCollector::collect()
 {
-    // Gather final metrics
+    if ( m_inert ) return;
+
+    uint64_t start = m_sampler != nullptr ? steady_ns() : 0;
+
+    // Gather final metrics, counters first
+    PerfCounters final_counters;
+    if ( m_perf != nullptr ) m_perf->read( final_counters );
+
     auto end_time = std::chrono::high_resolution_clock::now();
-    unsigned long final_cpu_time = get_cpu_time();
-    long final_stack_usage = get_stack_usage( m_thread_id );
-    long final_heap_usage = get_heap_usage();
+    unsigned long final_cpu_time = sampleCpuTime();
+    long final_stack_usage = sampleStack();
+    long final_heap_usage = sampleHeap();
 
     // Compute deltas for the current function
     m_metrics.m_duration = std::chrono::duration_cast<std::chrono::microseconds>
@@ -71,13 +138,45 @@ void MetricsCollector::collect()
     m_metrics.m_cpu_time = final_cpu_time - m_metrics.m_cpu_time;
     m_metrics.m_stack_usage = std::max(final_stack_usage, m_metrics.m_stack_usage) / 1024;
     m_metrics.m_heap_usage = final_heap_usage - m_metrics.m_heap_usage;
+    m_metrics.m_counters = final_counters - m_metrics.m_counters;
+
+    if ( m_sampler != nullptr ) m_overhead += steady_ns() - start;
 }
 
-std::shared_ptr<MetricsCollector> MetricsCollector::create(const std::string &f_name)
+bool MetricsCollector::isSampled() const
 {
-    auto collector = std::shared_ptr<MetricsCollector>( new MetricsCollector( f_name ) );
-    auto broker = MetricsBroker::getInstance();
-    broker->addMetricsCollector( collector );
-    collector->setBroker( broker ); // Set the broker
+    return !m_inert;
+}
+
+std::shared_ptr<MetricsCollector> MetricsCollector::create(const std::string &f_name, PerfEvent events)
+{
+    if ( !MetricsBroker::isEnabled() ) return inert();
+
+    auto collector = std::shared_ptr<MetricsCollector>( new MetricsCollector( f_name, events ) );
+    MetricsBroker::instance().addMetricsCollector( collector );
+
+    // Only needed to publish, the sink is reached through the instance
+    if ( collector->m_delivery == MetricsDelivery::Direct )
+    {
+        collector->setBroker( MetricsBroker::getInstance() ); // Set the broker
+    }
+
+    return collector;
+}
+
+std::shared_ptr<MetricsCollector> MetricsCollector::create(const std::string &f_name, Sampler &sampler,
+                                                           PerfEvent events)
+{
+    if ( !MetricsBroker::isEnabled() || !sampler.shouldSample() ) return inert();
+    if ( !sampler.needsCost() ) return create( f_name, events );
+
+    uint64_t start = steady_ns();
+    auto collector = create( f_name, events );
+
+    // Disabled meanwhile: the shared inert collector must stay untouched
+    if ( !collector->isSampled() ) return collector;
+
+    collector->m_sampler = &sampler;
+    collector->m_overhead = steady_ns() - start;
     return collector;
 }
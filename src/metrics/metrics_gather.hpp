@@ -1,6 +1,8 @@
 #pragma once
 
 #include <metrics/metrics_utils.hpp>
+#include <metrics/perf_counters.hpp>
+#include <metrics/sampling.hpp>
 #include <patterns/pub_sub/publisher.hpp>
 #include <patterns/pub_sub/event.hpp>
 #include <fstream>
@@ -18,6 +20,24 @@
 
 namespace ccl::metrics
 {
+    /**
+     * @brief How the MetricsCollector gathers CPU time, stack and heap usage.
+     */
+    enum class CollectionMode
+    {
+        Proc, // Process-wide values parsed from /proc files (milliseconds per scope)
+        Fast  // Per-thread values from clocks, cached stack bounds and heap counters
+    };
+
+    /**
+     * @brief How the MetricsCollector delivers its metrics to the subscribers.
+     */
+    enum class MetricsDelivery
+    {
+        Direct, // A MetricEvent published through the broker by the destructor
+        Sink    // A record staged in the queue of the thread (see MetricsSink)
+    };
+
     class MetricsBroker; // Forward declaration of MetricsBroker
     class AbstractMetricsLogger; // Forward declaration of MetricsLogger
 
@@ -39,6 +59,7 @@ namespace ccl::metrics
         long          m_stack_usage; // Usage of the Stack-allocated memory
         long          m_heap_usage;  // Usage of the Heap-allocated memory 
         long          m_heap_res;    // Heap residual memory
+        PerfCounters  m_counters;    // Performance counters, if requested
     };
 
     /**
@@ -77,6 +98,26 @@ namespace ccl::metrics
      * @brief Collect metrics for a single function call, where the object
      * is constructed. It follows the RAII principle, meaning that metrics
      * are collected once the function is entered and exited.
+     *
+     * The collection mode is the one of the MetricsBroker at construction.
+     * In Fast mode the CPU time, the stack usage and the heap usage refer
+     * to the calling thread only (see get_thread_cpu_time, get_stack_usage_fast
+     * and get_heap_bytes).
+     *
+     * With MetricsDelivery::Sink, the destructor moves the metrics into
+     * the queue of the thread in the MetricsSink of the broker, instead of
+     * publishing them: no lock is taken and no event is allocated there.
+     *
+     * When the collection is disabled or the call is not sampled, create
+     * returns an inert collector shared by everybody, without allocating
+     * nor touching any reference count: calling collect on it does nothing.
+     * The scopes nested in an inert one are attached to the closest sampled
+     * caller.
+     *
+     * Optionally, performance counters (cycles, instructions, cache and
+     * branch misses, context switches) are read at construction and at
+     * collect, through the PerfCounterGroup of the thread. The events that
+     * cannot be counted are just missing from Metrics::m_counters.
      */
     class MetricsCollector : public ccl::dp::pub_sub::Publisher
     {
@@ -89,20 +130,47 @@ namespace ccl::metrics
         TID_t       m_thread_id;     // The Thread ID of the metrics collector
         Metrics     m_metrics;       // Collected metrics
         std::string m_parent;        // The parent metrics collector
+        CollectionMode m_mode;       // How metrics are collected
+        MetricsDelivery m_delivery;  // How metrics are delivered
+        PerfCounterGroup* m_perf = nullptr; // Counters of the thread, if any
+
+        bool     m_inert    = false;   // Not sampled: collects and publishes nothing
+        Sampler* m_sampler  = nullptr; // Receives the cost of the scope, if needed
+        uint64_t m_overhead = 0;       // Time spent in the collector so far (ns)
 
-        explicit MetricsCollector( const std::string& func_name );
+        explicit MetricsCollector( const std::string& func_name, PerfEvent events );
+        MetricsCollector(); // The inert collector
+
+        // Returns a non-owning pointer to the shared inert collector
+        static std::shared_ptr<MetricsCollector> inert();
+
+        long sampleCpuTime() const; // CPU time in us
+        long sampleStack() const;   // Stack usage in bytes
+        long sampleHeap() const;    // Heap usage in KB
 
         void setParent( const std::string& name ); // Set the parent function name
 
     public:
         ~MetricsCollector();
 
-        // Creates a MetricsCollector and adds it to the MetricsLogger
-        static std::shared_ptr<MetricsCollector> create( const std::string& f_name );
+        // Creates a MetricsCollector and adds it to the MetricsLogger, also
+        // counting the given performance events. If the collection is
+        // disabled (see MetricsBroker::setEnabled), it returns an inert one.
+        static std::shared_ptr<MetricsCollector> create( const std::string& f_name,
+                                                         PerfEvent events = PerfEvent::None );
+
+        // As above, only if the sampler of the call site samples the call,
+        // otherwise it returns an inert collector
+        static std::shared_ptr<MetricsCollector> create( const std::string& f_name, Sampler& sampler,
+                                                         PerfEvent events = PerfEvent::None );
 
         // Collects all metrics up to the point the function is called
         void collect();
 
+        // Returns false for the inert collectors, which ignore collect and
+        // are never published
+        bool isSampled() const;
+
         Metrics     getCollectedMetrics() const; // Returns collected metrics
         TID_t       getThreadId() const; // Returns the Thread ID of the metrics collector
         std::string getFuncName() const; // Returns the function name
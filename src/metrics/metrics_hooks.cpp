@@ -0,0 +1,70 @@
+/**
+ * Replacement of the global allocation functions, counting the heap bytes
+ * allocated and freed, and the allocations made, by each thread (see
+ * get_heap_bytes and heap_hooks). It is built as
+ * the ccl_MetricsHooks object library: linking it installs the hooks for
+ * the whole program.
+ *
+ * The sizes are the usable ones of the allocator, the same on both sides,
+ * hence the counters do not drift. Aligned allocations are not counted.
+ */
+
+#include <metrics/metrics_utils.hpp>
+#include <cstdlib>
+#include <new>
+
+#ifndef _WIN32
+#include <malloc.h>
+#endif
+
+namespace hooks = ccl::metrics::heap_hooks;
+
+static void* allocate( size_t size )
+{
+    void* ptr = std::malloc( size == 0 ? 1 : size );
+    if ( ptr == nullptr ) return nullptr;
+
+    ++hooks::allocations;
+
+#ifndef _WIN32
+    hooks::live_bytes += static_cast<long>( malloc_usable_size( ptr ) );
+#endif
+
+    return ptr;
+}
+
+static void deallocate( void* ptr ) noexcept
+{
+    if ( ptr == nullptr ) return;
+
+#ifndef _WIN32
+    hooks::live_bytes -= static_cast<long>( malloc_usable_size( ptr ) );
+#endif
+
+    std::free( ptr );
+}
+
+// Mark the hooks as installed before main
+[[maybe_unused]] static const bool s_installed = ( hooks::installed.store( true ), true );
+
+void* operator new( size_t size )
+{
+    if ( void* ptr = allocate( size ) ) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[]( size_t size )
+{
+    if ( void* ptr = allocate( size ) ) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new( size_t size, const std::nothrow_t& ) noexcept { return allocate( size ); }
+void* operator new[]( size_t size, const std::nothrow_t& ) noexcept { return allocate( size ); }
+
+void operator delete( void* ptr ) noexcept { deallocate( ptr ); }
+void operator delete[]( void* ptr ) noexcept { deallocate( ptr ); }
+void operator delete( void* ptr, size_t ) noexcept { deallocate( ptr ); }
+void operator delete[]( void* ptr, size_t ) noexcept { deallocate( ptr ); }
+void operator delete( void* ptr, const std::nothrow_t& ) noexcept { deallocate( ptr ); }
+void operator delete[]( void* ptr, const std::nothrow_t& ) noexcept { deallocate( ptr ); }
@@ -1,25 +1,472 @@
 #include "metrics_logger.hpp"
+#include <io/file/file_io.hpp>
+#include <concurrent/thread.hpp>
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <sstream>
+#include <unistd.h>
 
 using namespace ccl::metrics;
 
 namespace ps = ccl::dp::pub_sub;
 
+/**
+ * Background thread rewriting the report file at each export interval.
+ */
+class TreeMetricsLogger::Exporter : public ccl::sys::concurrent::Thread
+{
+private:
+    TreeMetricsLogger* m_owner;
+
+    void run() override
+    {
+        std::unique_lock<std::mutex> _l( m_owner->m_exporterMutex );
+
+        while ( !isCancelled() )
+        {
+            m_owner->m_exporterCv.wait_for( _l, m_owner->m_config.export_interval,
+                [this] { return isCancelled(); } );
+
+            if ( isCancelled() ) break;
+
+            _l.unlock();
+            m_owner->exportTo( m_owner->m_config.path, m_owner->m_config.format );
+            _l.lock();
+        }
+    }
+
+public:
+    explicit Exporter( TreeMetricsLogger* owner )
+        : Thread( "TreeMetricsLogger-Exporter", false,
+                  ccl::sys::concurrent::CancellationPolicy::AT_CONDITION_CHECK ),
+          m_owner( owner )
+    {}
+};
+
 TreeMetricsLogger::TreeMetricsLogger()
-: AbstractMetricsLogger(__FUNCTION__)
+: TreeMetricsLogger( TreeMetricsLoggerConfig {} )
 {}
 
+TreeMetricsLogger::TreeMetricsLogger(const TreeMetricsLoggerConfig &config)
+: AbstractMetricsLogger( "TreeMetricsLogger" ), m_config( config )
+{
+    // Fail here on a wrong precision, not at the first event
+    HdrHistogram( config.highest_value, config.digits );
+
+    if ( !config.path.empty() )
+    {
+        m_exporter = std::make_unique<Exporter>( this );
+        m_exporter->start();
+    }
+}
+
+TreeMetricsLogger::~TreeMetricsLogger()
+{
+    // Consume the events left in the queue first
+    stop();
+
+    if ( m_exporter != nullptr )
+    {
+        // Cancel with the lock held, so the exporter cannot miss the notification
+        {
+            std::lock_guard<std::mutex> _l( m_exporterMutex );
+            m_exporter->cancel();
+        }
+
+        m_exporterCv.notify_all();
+        m_exporter->join();
+        m_exporter.reset();
+
+        exportTo( m_config.path, m_config.format );
+    }
+}
+
 void TreeMetricsLogger::consume(event_ptr event)
 {
     auto metric_ev = std::static_pointer_cast<const MetricEvent>(event);
-    
-    std::cout << "----------------------------------------------------" << std::endl;
-    std::cout << "( " << metric_ev->m_func_name << " ) "
-              << "Total Duration: " << metric_ev->m_metrics.m_duration    << " [us] "
-              << "CPU Time: "       << metric_ev->m_metrics.m_cpu_time    << " [us] "
-              << "Stack Usage: "    << metric_ev->m_metrics.m_stack_usage << " [KB] "
-              << "Heap Usage: "     << metric_ev->m_metrics.m_heap_usage  << " [KB] "
-              << "Residual Mem: "   << metric_ev->m_metrics.m_heap_res    << " [KB]"
-              << std::endl;
-
-    std::cout << "----------------------------------------------------" << std::endl;
-}
\ No newline at end of file
+    const Metrics& metrics = metric_ev->m_metrics;
+
+    std::lock_guard<std::mutex> _l( m_mutex );
+
+    children_t& children = m_trees[ metric_ev->m_thread_id ][ metric_ev->m_parent_func_name ];
+    auto it = children.find( metric_ev->m_func_name );
+    if ( it == children.end() )
+    {
+        it = children.try_emplace( metric_ev->m_func_name, m_config.highest_value, m_config.digits ).first;
+    }
+
+    it->second.m_duration.record( metrics.m_duration );
+    it->second.m_cpu_time.record( metrics.m_cpu_time );
+}
+
+void TreeMetricsLogger::writeNode(std::ostream &out, TID_t tid, const tree_t &tree, const std::string &name,
+                                  const MetricsNode &node, std::vector<std::string> &stack,
+                                  TreeReportFormat format) const
+{
+    stack.push_back( name );
+
+    auto children_it = tree.find( name );
+    uint64_t children_sum = 0;
+
+    if ( children_it != tree.end() )
+    {
+        for ( const auto& [ child, child_node ]: children_it->second )
+        {
+            children_sum += child_node.m_duration.getSum();
+        }
+    }
+
+    if ( format == TreeReportFormat::Folded )
+    {
+        // Time spent in the function itself, the children may overlap it
+        // when they are shared between several parents
+        uint64_t total = node.m_duration.getSum();
+        uint64_t self  = total > children_sum ? total - children_sum : 0;
+
+        out << tid;
+        for ( const auto& frame: stack ) out << ";" << frame;
+        out << " " << self << "\n";
+    }
+    else
+    {
+        const HdrHistogram& duration = node.m_duration;
+        const HdrHistogram& cpu_time = node.m_cpu_time;
+
+        out << std::string( 2 * stack.size(), ' ' ) << name
+            << " count=" << duration.getCount()
+            << " total=" << duration.getSum() << "us"
+            << " min="   << duration.getMin() << "us"
+            << " max="   << duration.getMax() << "us"
+            << " p50="   << duration.getValueAtPercentile( 50.0 ) << "us"
+            << " p90="   << duration.getValueAtPercentile( 90.0 ) << "us"
+            << " p99="   << duration.getValueAtPercentile( 99.0 ) << "us"
+            << " p999="  << duration.getValueAtPercentile( 99.9 ) << "us"
+            << " | cpu total=" << cpu_time.getSum() << "us"
+            << " p50="   << cpu_time.getValueAtPercentile( 50.0 ) << "us"
+            << " p99="   << cpu_time.getValueAtPercentile( 99.0 ) << "us"
+            << "\n";
+    }
+
+    if ( children_it != tree.end() )
+    {
+        for ( const auto& [ child, child_node ]: children_it->second )
+        {
+            // Recursive calls are already accounted by the outer call
+            if ( std::find( stack.begin(), stack.end(), child ) != stack.end() ) continue;
+            writeNode( out, tid, tree, child, child_node, stack, format );
+        }
+    }
+
+    stack.pop_back();
+}
+
+void TreeMetricsLogger::report(std::ostream &out, TreeReportFormat format) const
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+
+    // Threads in a stable order, from one report to the next
+    std::vector<TID_t> tids;
+    for ( const auto& [ tid, tree ]: m_trees ) tids.push_back( tid );
+    std::sort( tids.begin(), tids.end() );
+
+    std::vector<std::string> stack;
+
+    for ( TID_t tid: tids )
+    {
+        const tree_t& tree = m_trees.at( tid );
+        if ( format == TreeReportFormat::Tree ) out << "Thread " << tid << "\n";
+
+        auto roots = tree.find( "" );
+        if ( roots == tree.end() ) continue;
+
+        for ( const auto& [ name, node ]: roots->second )
+        {
+            writeNode( out, tid, tree, name, node, stack, format );
+        }
+    }
+}
+
+bool TreeMetricsLogger::exportTo(const std::string &path, TreeReportFormat format) const
+{
+    std::stringstream ss;
+    report( ss, format );
+    const std::string content = ss.str();
+
+    std::string tmp_path = path + ".tmp";
+
+    try
+    {
+        using ccl::sys::io::iom;
+        ccl::sys::io::FileIO file( tmp_path, iom::Write | iom::Create | iom::Trunc );
+        if ( file.write( content.data(), content.size() ) != static_cast<ssize_t>( content.size() ) )
+        {
+            return false;
+        }
+    }
+    catch ( const std::exception& )
+    {
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename( tmp_path, path, ec );
+    return !ec;
+}
+
+std::unique_ptr<MetricsNode> TreeMetricsLogger::getNode(TID_t tid, const std::string &parent,
+                                                        const std::string &function) const
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+
+    auto tree_it = m_trees.find( tid );
+    if ( tree_it == m_trees.end() ) return nullptr;
+
+    auto parent_it = tree_it->second.find( parent );
+    if ( parent_it == tree_it->second.end() ) return nullptr;
+
+    auto node_it = parent_it->second.find( function );
+    if ( node_it == parent_it->second.end() ) return nullptr;
+
+    return std::make_unique<MetricsNode>( node_it->second );
+}
+
+RegistryMetricsLogger::RegistryMetricsLogger(MetricsRegistry &registry, const std::vector<double> &bounds)
+: AbstractMetricsLogger( "RegistryMetricsLogger" ), m_registry( registry ), m_bounds( bounds )
+{}
+
+RegistryMetricsLogger::~RegistryMetricsLogger()
+{
+    // Consume the events left in the queue first
+    stop();
+}
+
+Histogram &RegistryMetricsLogger::duration(const std::string &name)
+{
+    return m_registry.histogram( "ccl_function_duration_seconds",
+        "Wall-clock duration of the instrumented functions", m_bounds, { { "function", name } } );
+}
+
+void RegistryMetricsLogger::consume(event_ptr event)
+{
+    if ( auto batch = std::dynamic_pointer_cast<const ScopeBatchEvent>( event ) )
+    {
+        for ( const ScopeRecord& record: batch->m_records )
+        {
+            auto it = m_siteDurations.find( record.m_site );
+            if ( it == m_siteDurations.end() )
+            {
+                const CallSite& site = CallSiteRegistry::get( record.m_site );
+                it = m_siteDurations.emplace( record.m_site, &duration( site.m_name ) ).first;
+            }
+
+            // The timestamps are in nanoseconds
+            it->second->observe( ( record.m_end - record.m_start ) / 1e9 );
+        }
+
+        return;
+    }
+
+    auto metric_ev = std::static_pointer_cast<const MetricEvent>(event);
+    const Metrics& metrics = metric_ev->m_metrics;
+    const std::string& name = metric_ev->m_func_name;
+
+    auto it = m_durations.find( name );
+    if ( it == m_durations.end() )
+    {
+        it = m_durations.emplace( name, &duration( name ) ).first;
+
+        m_cpuTimes.emplace( name, &m_registry.histogram( "ccl_function_cpu_seconds",
+            "CPU time of the instrumented functions", m_bounds, { { "function", name } } ) );
+    }
+
+    // The metrics are in microseconds
+    it->second->observe( metrics.m_duration / 1e6 );
+    m_cpuTimes[ name ]->observe( metrics.m_cpu_time / 1e6 );
+}
+
+// Append the string as the content of a JSON string
+static void append_json( std::string& out, std::string_view text )
+{
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    for ( char c: text )
+    {
+        if ( c == '"' || c == '\\' )
+        {
+            out += '\\';
+            out += c;
+        }
+        else if ( static_cast<unsigned char>( c ) < 0x20 )
+        {
+            out += "\\u00";
+            out += HEX[ ( c >> 4 ) & 0xf ];
+            out += HEX[ c & 0xf ];
+        }
+        else
+        {
+            out += c;
+        }
+    }
+}
+
+static void append_integer( std::string& out, int64_t value )
+{
+    char buffer[24];
+    auto result = std::to_chars( buffer, buffer + sizeof( buffer ), value );
+    out.append( buffer, result.ptr );
+}
+
+// Append nanoseconds as microseconds, the unit of the trace format
+static void append_micros( std::string& out, int64_t ns )
+{
+    if ( ns < 0 ) ns = 0;
+
+    append_integer( out, ns / 1000 );
+
+    int64_t fraction = ns % 1000;
+    if ( fraction == 0 ) return;
+
+    out += '.';
+    out += static_cast<char>( '0' + fraction / 100 );
+    out += static_cast<char>( '0' + fraction / 10 % 10 );
+    out += static_cast<char>( '0' + fraction % 10 );
+}
+
+ChromeTraceLogger::ChromeTraceLogger(const std::string &path, const ChromeTraceLoggerConfig &config)
+: AbstractMetricsLogger( "ChromeTraceLogger", config.batching ),
+  m_file( path, ccl::sys::io::iom::Write | ccl::sys::io::iom::Create | ccl::sys::io::iom::Trunc,
+          config.buffer_size, ccl::sys::io::FlushPolicy { 0, config.flush_interval } ),
+  m_pid( static_cast<int>( getpid() ) )
+{
+    using namespace std::chrono;
+
+    m_steadyOffset = duration_cast<nanoseconds>( system_clock::now().time_since_epoch() ).count()
+                   - duration_cast<nanoseconds>( steady_clock::now().time_since_epoch() ).count();
+
+    m_file.write( "[\n", 2 );
+}
+
+ChromeTraceLogger::~ChromeTraceLogger()
+{
+    // Consume the events left in the queue first
+    stop();
+
+    m_file.write( "\n]\n", 3 );
+    m_file.flush();
+}
+
+const std::string &ChromeTraceLogger::siteName(uint32_t site)
+{
+    auto it = m_siteNames.find( site );
+    if ( it == m_siteNames.end() )
+    {
+        std::string name;
+        append_json( name, CallSiteRegistry::get( site ).m_name );
+        it = m_siteNames.emplace( site, std::move( name ) ).first;
+    }
+
+    return it->second;
+}
+
+void ChromeTraceLogger::appendSpan(std::string_view name, TID_t tid, int64_t start, int64_t duration,
+                                   std::string_view parent, long cpu_time)
+{
+    m_line += m_first ? "{\"name\":\"" : ",\n{\"name\":\"";
+    m_first = false;
+
+    m_line += name;
+    m_line += "\",\"cat\":\"ccl\",\"ph\":\"X\",\"ts\":";
+    append_micros( m_line, start );
+    m_line += ",\"dur\":";
+    append_micros( m_line, duration );
+    m_line += ",\"pid\":";
+    append_integer( m_line, m_pid );
+    m_line += ",\"tid\":";
+    append_integer( m_line, tid );
+
+    if ( !parent.empty() || cpu_time >= 0 )
+    {
+        m_line += ",\"args\":{";
+
+        if ( !parent.empty() )
+        {
+            m_line += "\"parent\":\"";
+            m_line += parent;
+            m_line += '"';
+        }
+
+        if ( cpu_time >= 0 )
+        {
+            if ( !parent.empty() ) m_line += ',';
+            m_line += "\"cpu_us\":";
+            append_integer( m_line, cpu_time );
+        }
+
+        m_line += '}';
+    }
+
+    m_line += '}';
+}
+
+size_t ChromeTraceLogger::appendEvent(const event_ptr &event)
+{
+    if ( auto batch = std::dynamic_pointer_cast<const ScopeBatchEvent>( event ) )
+    {
+        for ( const ScopeRecord& record: batch->m_records )
+        {
+            std::string_view parent = record.m_parent != 0 ? siteName( record.m_parent ) : "";
+
+            appendSpan( siteName( record.m_site ), record.m_thread_id, record.m_start + m_steadyOffset,
+                        record.m_end - record.m_start, parent, -1 );
+        }
+
+        return batch->m_records.size();
+    }
+
+    auto metric_ev = std::static_pointer_cast<const MetricEvent>(event);
+    const Metrics& metrics = metric_ev->m_metrics;
+
+    std::string name, parent;
+    append_json( name, metric_ev->m_func_name );
+    append_json( parent, metric_ev->m_parent_func_name );
+
+    int64_t start = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        metrics.m_start_time.time_since_epoch() ).count();
+
+    appendSpan( name, metric_ev->m_thread_id, start, int64_t( metrics.m_duration ) * 1000,
+                parent, static_cast<long>( metrics.m_cpu_time ) );
+
+    return 1;
+}
+
+void ChromeTraceLogger::consume(event_ptr event)
+{
+    m_line.clear();
+    size_t spans = appendEvent( event );
+
+    m_file.write( m_line.data(), m_line.size() );
+    m_spans.fetch_add( spans, std::memory_order_relaxed );
+}
+
+void ChromeTraceLogger::consumeBatch(std::span<event_ptr> events)
+{
+    m_line.clear();
+    size_t spans = 0;
+
+    for ( const auto& event: events ) spans += appendEvent( event );
+
+    // The whole batch goes through the file buffer at once
+    m_file.write( m_line.data(), m_line.size() );
+    m_spans.fetch_add( spans, std::memory_order_relaxed );
+}
+
+void ChromeTraceLogger::flush()
+{
+    m_file.flush();
+}
+
+uint64_t ChromeTraceLogger::getSpans() const
+{
+    return m_spans.load( std::memory_order_relaxed );
+}
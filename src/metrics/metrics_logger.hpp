@@ -1,9 +1,24 @@
 #pragma once
 
 #include <metrics/metrics_broker.hpp>
+#include <metrics/hdr_histogram.hpp>
+#include <metrics/open_metrics.hpp>
+#include <metrics/scope_timer.hpp>
+#include <io/file/buffered_io.hpp>
 #include <patterns/pub_sub/event.hpp>
 #include <patterns/pub_sub/subscriber.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace ccl::metrics
 {
@@ -19,26 +34,234 @@ namespace ccl::metrics
     class AbstractMetricsLogger : public ccl::dp::pub_sub::AsyncSubscriber
     {
     public:
-        AbstractMetricsLogger( const std::string& name )
-        : AsyncSubscriber( name )
+        AbstractMetricsLogger( const std::string& name,
+                               const ccl::dp::pub_sub::AsyncSubscriberConfig& config = {} )
+        : AsyncSubscriber( name, config )
         {}
 
         virtual ~AbstractMetricsLogger() = default;
 
         virtual void consume(event_ptr event) = 0;
     };
-    
+
+    /**
+     * @brief Layout of the reports of the TreeMetricsLogger
+     */
+    enum class TreeReportFormat
+    {
+        Tree,  // Indented call tree with the statistics of each node
+        Folded // One "tid;root;...;function self_time_us" line per node, for flame graphs
+    };
+
+    /**
+     * @brief Configuration of the TreeMetricsLogger
+     */
+    struct TreeMetricsLoggerConfig
+    {
+        // The report file, rewritten at each export. No export if empty.
+        std::string path;
+
+        std::chrono::milliseconds export_interval = std::chrono::seconds( 10 );
+        TreeReportFormat          format          = TreeReportFormat::Tree;
+
+        // Precision of the percentiles (see HdrHistogram)
+        uint64_t highest_value = HdrHistogram::DEFAULT_HIGHEST;
+        int      digits        = 2;
+    };
+
+    /**
+     * @brief Aggregated metrics of a function called from a given parent.
+     */
+    struct MetricsNode
+    {
+        HdrHistogram m_duration; // Durations in us
+        HdrHistogram m_cpu_time; // CPU times in us
+
+        MetricsNode( uint64_t highest, int digits )
+            : m_duration( highest, digits ), m_cpu_time( highest, digits )
+        {}
+    };
+
+    /**
+     * @class TreeMetricsLogger
+     *
+     * @brief Aggregates the metric events into a call tree for each thread.
+     *
+     * Each node is a (parent function, function) edge, with count, sum,
+     * min and max of the duration and of the CPU time, and the percentiles
+     * from their HDR histograms. The children of a node are the edges whose
+     * parent is its function: since events only carry the direct parent, a
+     * function called from different parents shows the same children under
+     * each of them.
+     *
+     * With a path in the configuration, the whole report is rewritten
+     * periodically by a background thread (and once more at destruction),
+     * into a temporary file renamed over the report, so readers never see a
+     * partial one.
+     */
     class TreeMetricsLogger : public AbstractMetricsLogger
     {
     private:
-        // TODO: Add metrics tree
-        
+        class Exporter; // The periodic export thread
+
+        // Per thread: parent function -> function -> node
+        using children_t = std::map<std::string, MetricsNode>;
+        using tree_t     = std::map<std::string, children_t>;
+
+        TreeMetricsLoggerConfig m_config;
+
+        std::unordered_map<TID_t, tree_t> m_trees;
+        mutable std::mutex                m_mutex;
+        std::mutex                        m_exporterMutex;
+        std::condition_variable           m_exporterCv;
+        std::unique_ptr<Exporter>         m_exporter;
+
+        // Write the node and, recursively, its children. The stack holds the
+        // functions from the root, to stop at recursive calls.
+        void writeNode( std::ostream& out, TID_t tid, const tree_t& tree, const std::string& name,
+                        const MetricsNode& node, std::vector<std::string>& stack,
+                        TreeReportFormat format ) const;
+
     public:
         TreeMetricsLogger();
-        
-        virtual ~TreeMetricsLogger() 
-        { AsyncSubscriber::stop(); }
-        
+        explicit TreeMetricsLogger( const TreeMetricsLoggerConfig& config );
+
+        virtual ~TreeMetricsLogger();
+
         void consume(event_ptr event) override;
+
+        /* Write the report of all the trees collected so far */
+        void report( std::ostream& out, TreeReportFormat format ) const;
+
+        /**
+         * Write the report into the given file, through a temporary one.
+         * @return False if the file could not be written
+         */
+        bool exportTo( const std::string& path, TreeReportFormat format ) const;
+
+        /**
+         * Returns a copy of the node of the function called from the parent
+         * in the given thread, or nullptr if never seen. The parent of the
+         * outermost functions is the empty string.
+         */
+        std::unique_ptr<MetricsNode> getNode( TID_t tid, const std::string& parent,
+                                              const std::string& function ) const;
+    };
+
+    /**
+     * @class RegistryMetricsLogger
+     *
+     * @brief Feeds the collected metrics into a MetricsRegistry, to be
+     * scraped through a MetricsExporter.
+     *
+     * Each function gets a series of the ccl_function_duration_seconds and
+     * ccl_function_cpu_seconds histograms, labelled function="<name>".
+     * The ScopeBatchEvents of the timers only have a duration, observed in
+     * the same series as the collectors of the same name.
+     */
+    class RegistryMetricsLogger : public AbstractMetricsLogger
+    {
+    private:
+        MetricsRegistry&    m_registry;
+        std::vector<double> m_bounds;
+
+        // Histograms of each function, cached to lock the registry only once
+        std::unordered_map<std::string, Histogram*> m_durations;
+        std::unordered_map<std::string, Histogram*> m_cpuTimes;
+        std::unordered_map<uint32_t, Histogram*>    m_siteDurations; // By call site
+
+        Histogram& duration( const std::string& name ); // Of the given function
+
+    public:
+        /**
+         * @param registry Where the histograms are registered, must outlive the logger
+         * @param bounds Buckets in seconds, from 1us to about 4s by default
+         */
+        explicit RegistryMetricsLogger( MetricsRegistry& registry,
+                                        const std::vector<double>& bounds =
+                                            Histogram::exponentialBounds( 1e-6, 4.0, 12 ) );
+
+        virtual ~RegistryMetricsLogger();
+
+        void consume(event_ptr event) override;
+    };
+    /**
+     * @brief Configuration of the ChromeTraceLogger
+     */
+    struct ChromeTraceLoggerConfig
+    {
+        // Capacity of the file buffer
+        size_t buffer_size = 256 * 1024;
+
+        // Maximum age of a buffered span before it reaches the file
+        std::chrono::milliseconds flush_interval = std::chrono::seconds( 1 );
+
+        // How the events are taken from the queue, each batch is written at once
+        ccl::dp::pub_sub::AsyncSubscriberConfig batching;
+    };
+
+    /**
+     * @class ChromeTraceLogger
+     *
+     * @brief Streams the spans into a file in the Chrome Trace Event Format,
+     * which can be opened with chrome://tracing or ui.perfetto.dev.
+     *
+     * Each MetricEvent and each record of a ScopeBatchEvent becomes a
+     * complete ("X") event, with the parent and, for the collectors, the
+     * CPU time as arguments. The file uses the JSON array format, whose
+     * closing bracket is optional, so a trace cut short is still readable.
+     * The timestamps of the timers (steady clock) are moved onto the clock
+     * of the collectors (system clock) to share the same time line.
+     *
+     * The spans are formatted by the subscriber thread, a whole batch of
+     * events at a time, and written into a BufferedFileIO with one call,
+     * flushed in the background at the given interval. In
+     * Sink delivery the instrumented threads only stage their records (see
+     * MetricsSink), hence the whole export runs off their path.
+     */
+    class ChromeTraceLogger : public AbstractMetricsLogger
+    {
+    private:
+        ccl::sys::io::BufferedFileIO m_file;
+
+        int64_t     m_steadyOffset; // From steady to system clock, in ns
+        int         m_pid;
+        bool        m_first = true; // No comma before the first span
+        std::string m_line;         // Reused by consume and consumeBatch
+
+        std::atomic<uint64_t> m_spans = 0;
+
+        // Escaped names of the call sites
+        std::unordered_map<uint32_t, std::string> m_siteNames;
+
+        const std::string& siteName( uint32_t site );
+
+        // Append a complete event to m_line. Times are in ns, names escaped.
+        void appendSpan( std::string_view name, TID_t tid, int64_t start, int64_t duration,
+                         std::string_view parent, long cpu_time );
+
+        // Append the spans of the event to m_line, returns their number
+        size_t appendEvent( const event_ptr& event );
+
+    protected:
+        void consumeBatch( std::span<event_ptr> events ) override;
+
+    public:
+        /**
+         * @param path The trace file, truncated
+         * @param config The logger configuration
+         */
+        explicit ChromeTraceLogger( const std::string& path, const ChromeTraceLoggerConfig& config = {} );
+
+        /* Consumes the pending events and terminates the trace */
+        virtual ~ChromeTraceLogger();
+
+        void consume(event_ptr event) override;
+
+        /* Write the spans formatted so far into the file */
+        void flush();
+
+        /* Returns the number of spans written so far */
+        uint64_t getSpans() const;
     };
-};
\ No newline at end of file
+};
@@ -0,0 +1,319 @@
+#include "metrics_sink.hpp"
+#include <concurrent/thread.hpp>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+using namespace ccl::metrics;
+
+namespace ps = ccl::dp::pub_sub;
+
+/**
+ * Queue of a single thread. The thread is the only producer, the drainer
+ * (or whoever holds the mutex of the sink) the only consumer.
+ */
+template <typename Record>
+struct MetricsSink::Staging
+{
+    ds::buffers::SpscRingBuffer<Record> m_queue;
+
+    std::atomic<size_t> m_dropped  = 0;     // Records lost with a full queue
+    std::atomic<bool>   m_orphan   = false; // The owner thread has exited
+    std::atomic<bool>   m_detached = false; // The sink has been destroyed
+
+    explicit Staging( size_t capacity ) : m_queue( capacity ) {}
+};
+
+/**
+ * The queues of a thread, one for each sink it has used. The queues are
+ * shared with the sinks, so that neither the thread nor the sink has to
+ * outlive the other.
+ */
+template <typename Record>
+struct MetricsSink::LocalRegistry
+{
+    struct Entry
+    {
+        uint64_t                         m_sink;
+        std::shared_ptr<Staging<Record>> m_staging;
+    };
+
+    std::vector<Entry> m_entries;
+    uint64_t           m_lastSink    = 0; // Cache of the last lookup
+    Staging<Record>*   m_lastStaging = nullptr;
+
+    ~LocalRegistry()
+    {
+        // The drainer removes the queue once it is empty
+        for ( auto& entry: m_entries )
+        {
+            entry.m_staging->m_orphan.store( true, std::memory_order_release );
+        }
+    }
+};
+
+/**
+ * Background thread draining the queues. It sleeps for the drain interval
+ * once they are all empty, or until a blocked producer wakes it.
+ */
+class MetricsSink::Drainer : public ccl::sys::concurrent::Thread
+{
+private:
+    MetricsSink* m_owner;
+
+    void run() override
+    {
+        while ( !isCancelled() )
+        {
+            if ( m_owner->drain() > 0 ) continue;
+
+            // Checked under the lock, which the destructor holds to cancel
+            std::unique_lock<std::mutex> _l( m_owner->m_mutex );
+            if ( isCancelled() ) break;
+            m_owner->m_drainerCv.wait_for( _l, m_owner->m_config.drain_interval );
+        }
+    }
+
+public:
+    explicit Drainer( MetricsSink* owner )
+        : Thread( "MetricsSink-Drainer", false,
+                  ccl::sys::concurrent::CancellationPolicy::AT_CONDITION_CHECK ),
+          m_owner( owner )
+    {}
+};
+
+// The sink whose events the calling thread is delivering, if any
+static thread_local const MetricsSink* t_delivering = nullptr;
+
+static uint64_t next_sink_id()
+{
+    static std::atomic<uint64_t> counter = 0;
+    return counter.fetch_add( 1, std::memory_order_relaxed ) + 1;
+}
+
+MetricsSink::MetricsSink(ps::PubSubBroker &broker, const MetricsSinkConfig &config)
+    : m_id( next_sink_id() ), m_config( config ), m_broker( broker )
+{
+    if ( config.loss_policy == ds::LossPolicy::OVERWRITE_OLDEST )
+    {
+        throw std::invalid_argument( "OVERWRITE_OLDEST Loss policy is not available for MetricsSink" );
+    }
+
+    m_batch.resize( BATCH_SIZE );
+    m_scopeBatch.resize( BATCH_SIZE );
+}
+
+MetricsSink::~MetricsSink()
+{
+    if ( m_drainer != nullptr )
+    {
+        // Cancel with the lock held, so the drainer cannot miss the notification
+        {
+            std::lock_guard<std::mutex> _l( m_mutex );
+            m_drainer->cancel();
+        }
+
+        m_drainerCv.notify_all();
+        m_drainer->join();
+        m_drainer.reset();
+    }
+
+    drain();
+
+    std::lock_guard<std::mutex> _l( m_mutex );
+    for ( auto& staging: m_stagings )
+    {
+        staging->m_detached.store( true, std::memory_order_release );
+    }
+
+    for ( auto& staging: m_scopeStagings )
+    {
+        staging->m_detached.store( true, std::memory_order_release );
+    }
+}
+
+template <typename Record>
+MetricsSink::staging_list_t<Record> &MetricsSink::stagings()
+{
+    if constexpr ( std::is_same_v<Record, ScopeRecord> ) return m_scopeStagings;
+    else                                                 return m_stagings;
+}
+
+template <typename Record>
+MetricsSink::Staging<Record> &MetricsSink::staging()
+{
+    static thread_local LocalRegistry<Record> registry;
+
+    if ( registry.m_lastSink == m_id ) return *registry.m_lastStaging;
+
+    for ( auto& entry: registry.m_entries )
+    {
+        if ( entry.m_sink != m_id ) continue;
+
+        registry.m_lastSink = m_id;
+        registry.m_lastStaging = entry.m_staging.get();
+        return *registry.m_lastStaging;
+    }
+
+    // First record of this thread: drop the queues of destroyed sinks
+    std::erase_if( registry.m_entries, []( const typename LocalRegistry<Record>::Entry& entry ) {
+        return entry.m_staging->m_detached.load( std::memory_order_acquire );
+    });
+
+    auto queue = std::make_shared<Staging<Record>>( m_config.queue_capacity );
+
+    {
+        std::lock_guard<std::mutex> _l( m_mutex );
+        stagings<Record>().push_back( queue );
+
+        // The drainer is started only by the first instrumented thread
+        if ( m_drainer == nullptr )
+        {
+            m_drainer = std::make_unique<Drainer>( this );
+            m_drainer->start();
+        }
+    }
+
+    registry.m_entries.push_back( { m_id, queue } );
+    registry.m_lastSink = m_id;
+    registry.m_lastStaging = queue.get();
+    return *queue;
+}
+
+template <typename Record, typename U>
+bool MetricsSink::stage(U &&record)
+{
+    Staging<Record>& queue = staging<Record>();
+
+    if ( queue.m_queue.tryPush( std::forward<U>( record ) ) ) return true;
+
+    // The thread delivering the events is the only one that can empty its
+    // queue, and all the others wait for it: never block it.
+    if ( m_config.loss_policy == ds::LossPolicy::BLOCK && t_delivering != this )
+    {
+        m_drainerCv.notify_one();
+        queue.m_queue.push( std::forward<U>( record ) );
+        return true;
+    }
+
+    queue.m_dropped.fetch_add( 1, std::memory_order_relaxed );
+    return false;
+}
+
+bool MetricsSink::push(MetricsRecord &&record)
+{
+    return stage<MetricsRecord>( std::move( record ) );
+}
+
+bool MetricsSink::push(const ScopeRecord &record)
+{
+    return stage<ScopeRecord>( record );
+}
+
+template <typename Record, typename Deliver>
+size_t MetricsSink::drain(staging_list_t<Record> &queues, std::vector<Record> &batch, Deliver &&deliver)
+{
+    size_t total = 0;
+
+    for ( auto it = queues.begin(); it != queues.end(); )
+    {
+        Staging<Record>& queue = **it;
+
+        // Read the flag first: once set, no more pushes can happen
+        bool orphan = queue.m_orphan.load( std::memory_order_acquire );
+
+        // Bounded to the capacity, so a single thread cannot starve the others
+        size_t popped = 0, nelem = 0;
+        while ( popped < queue.m_queue.capacity() &&
+                ( nelem = queue.m_queue.tryPopN( batch.data(), BATCH_SIZE ) ) > 0 )
+        {
+            deliver( batch.data(), nelem );
+            popped += nelem;
+        }
+
+        total += popped;
+
+        if ( orphan && queue.m_queue.empty() )
+        {
+            m_dropped.fetch_add( queue.m_dropped.load( std::memory_order_relaxed ),
+                                 std::memory_order_relaxed );
+
+            it = queues.erase( it );
+            continue;
+        }
+
+        ++it;
+    }
+
+    return total;
+}
+
+size_t MetricsSink::drain()
+{
+    // Taken before the mutex, and held while publishing: the events of a
+    // thread are not overtaken by the ones popped by a concurrent drain.
+    std::lock_guard<std::recursive_mutex> _d( m_delivery );
+
+    std::vector<std::shared_ptr<const ps::PubSubEvent>> events;
+    size_t total = 0;
+
+    {
+        std::lock_guard<std::mutex> _l( m_mutex );
+
+        total = drain( m_stagings, m_batch, [&events]( MetricsRecord* records, size_t nelem ) {
+            for ( size_t idx = 0; idx < nelem; ++idx )
+            {
+                MetricsRecord& record = records[idx];
+
+                events.push_back( std::make_shared<const MetricEvent>(
+                    std::move( record.m_parent_func_name ), std::move( record.m_func_name ),
+                    record.m_metrics, record.m_thread_id ) );
+            }
+        });
+
+        total += drain( m_scopeStagings, m_scopeBatch, [&events]( ScopeRecord* records, size_t nelem ) {
+            events.push_back( std::make_shared<const ScopeBatchEvent>(
+                std::vector<ScopeRecord>( records, records + nelem ) ) );
+        });
+    }
+
+    // Restored even on exceptions, and by nested deliveries of other sinks
+    struct DeliveryGuard
+    {
+        const MetricsSink* m_previous;
+        explicit DeliveryGuard( const MetricsSink* sink ) : m_previous( t_delivering ) { t_delivering = sink; }
+        ~DeliveryGuard() { t_delivering = m_previous; }
+    } _guard( this );
+
+    for ( auto& event: events ) m_broker.notifySubscribers( std::move( event ) );
+    return total;
+}
+
+size_t MetricsSink::flush()
+{
+    // A single pass is enough: no queue holds more than its capacity
+    return drain();
+}
+
+size_t MetricsSink::getDropped() const
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+
+    size_t dropped = m_dropped.load( std::memory_order_relaxed );
+    for ( const auto& queue: m_stagings )
+    {
+        dropped += queue->m_dropped.load( std::memory_order_relaxed );
+    }
+
+    for ( const auto& queue: m_scopeStagings )
+    {
+        dropped += queue->m_dropped.load( std::memory_order_relaxed );
+    }
+
+    return dropped;
+}
+
+const MetricsSinkConfig &MetricsSink::getConfig() const
+{
+    return m_config;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <metrics/metrics_gather.hpp>
+#include <metrics/scope_timer.hpp>
+#include <data_structures/base/enum.hpp>
+#include <data_structures/buffers/spsc_ring_buffer.hpp>
+#include <patterns/pub_sub/broker.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ccl::metrics
+{
+    /**
+     * @brief Configuration of a MetricsSink
+     */
+    struct MetricsSinkConfig
+    {
+        // Number of records each thread can stage before the loss policy
+        // kicks in, for each kind of record. It is rounded up to the next
+        // power of two.
+        size_t queue_capacity = 1024;
+
+        // What to do when the queue of a thread is full: ERROR drops the
+        // record (counted by getDropped), BLOCK waits for the drainer.
+        // Records pushed by the subscribers while they are being notified
+        // by this sink are dropped rather than waiting for themselves.
+        // OVERWRITE_OLDEST is not supported.
+        ds::LossPolicy loss_policy = ds::LossPolicy::ERROR;
+
+        // How long the drainer sleeps when all the queues are empty. It is
+        // also the maximum delay before a record reaches the subscribers.
+        std::chrono::milliseconds drain_interval{ 10 };
+    };
+
+    /**
+     * @brief The metrics of a finished scope, as staged by a MetricsSink.
+     */
+    struct MetricsRecord
+    {
+        std::string m_parent_func_name;
+        std::string m_func_name;
+        Metrics     m_metrics;
+        TID_t       m_thread_id = 0;
+    };
+
+    /**
+     * @class MetricsSink
+     *
+     * @brief Deferred delivery of the metrics to the subscribers of a broker.
+     *
+     * Each thread pushes its records into a queue of its own: a lock-free
+     * single producer single consumer ring, so instrumented threads never
+     * contend with each other, nor take the lock of the broker. The names
+     * are moved into the record, hence pushing does not allocate.
+     *
+     * A background thread, started with the first record, drains all the
+     * queues in batches, turns the records into MetricEvents and delivers
+     * them through the broker. The ScopeRecords of the timers have queues
+     * of their own, and are delivered by batches of up to BATCH_SIZE in a
+     * single ScopeBatchEvent. Records of the same thread keep their order,
+     * while there is no ordering across threads nor across kinds.
+     *
+     * All the pending records are delivered on flush() and on destruction.
+     * The records are delivered without holding the lock of the queues, so
+     * subscribers may call flush() and getDropped(), or be instrumented.
+     */
+    class MetricsSink
+    {
+    public:
+        // Maximum number of records moved out of a queue at once
+        static constexpr size_t BATCH_SIZE = 64;
+
+    private:
+        class Drainer; // The background thread
+
+        template <typename Record>
+        struct Staging; // The queue of a single thread
+
+        template <typename Record>
+        struct LocalRegistry; // The queues of the calling thread
+
+        template <typename Record>
+        using staging_list_t = std::vector<std::shared_ptr<Staging<Record>>>;
+
+        const uint64_t    m_id;     // Identifies the sink in the thread-local registry
+        MetricsSinkConfig m_config;
+
+        ccl::dp::pub_sub::PubSubBroker& m_broker;
+
+        mutable std::mutex            m_mutex;         // Protects stagings and draining
+        std::recursive_mutex          m_delivery;      // Keeps the order of the deliveries, taken first
+        staging_list_t<MetricsRecord> m_stagings;      // One per instrumented thread
+        staging_list_t<ScopeRecord>   m_scopeStagings; // One per timed thread
+        std::vector<MetricsRecord>    m_batch;         // Reused by drain
+        std::vector<ScopeRecord>      m_scopeBatch;    // Reused by drain
+
+        std::atomic<size_t>      m_dropped = 0; // From stagings already removed
+        std::condition_variable  m_drainerCv;   // Wakes up the drainer
+        std::unique_ptr<Drainer> m_drainer;
+
+        template <typename Record>
+        Staging<Record>& staging(); // The queue of the calling thread
+
+        template <typename Record>
+        staging_list_t<Record>& stagings(); // All the queues of a kind
+
+        // Push into the queue of the calling thread, applying the loss policy
+        template <typename Record, typename U>
+        bool stage( U&& record );
+
+        // Pop the records of all the queues of a kind, handing each batch
+        // to deliver. Requires the mutex to be held.
+        template <typename Record, typename Deliver>
+        size_t drain( staging_list_t<Record>& queues, std::vector<Record>& batch, Deliver&& deliver );
+
+        // Pop the records of all the queues into events, under the mutex,
+        // then publish them once it is released. Returns the records delivered.
+        size_t drain();
+
+    public:
+        /**
+         * @param broker The broker delivering the events, must outlive the sink
+         * @param config The sink configuration
+         */
+        explicit MetricsSink( ccl::dp::pub_sub::PubSubBroker& broker,
+                              const MetricsSinkConfig& config = {} );
+
+        MetricsSink( const MetricsSink& ) = delete;
+        MetricsSink& operator=( const MetricsSink& ) = delete;
+
+        /* Stops the drainer and delivers all the pending records */
+        ~MetricsSink();
+
+        /**
+         * @brief Stage the record for delivery.
+         * @return False if it has been dropped because of a full queue
+         */
+        bool push( MetricsRecord&& record );
+
+        /**
+         * @brief Stage the record of a finished ScopeTimer for delivery.
+         * @return False if it has been dropped because of a full queue
+         */
+        bool push( const ScopeRecord& record );
+
+        /* Deliver all the pending records now, returns how many */
+        size_t flush();
+
+        /* Returns the number of records dropped because of a full queue */
+        size_t getDropped() const;
+
+        const MetricsSinkConfig& getConfig() const;
+    };
+}
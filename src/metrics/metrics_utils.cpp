@@ -1,7 +1,17 @@
 #include "metrics_utils.hpp"
 
+#ifndef _WIN32
+#include <malloc.h>
+#include <pthread.h>
+#include <time.h>
+#endif
+
 using namespace ccl::metrics;
 
+std::atomic<bool> ccl::metrics::heap_hooks::installed = false;
+thread_local long ccl::metrics::heap_hooks::live_bytes = 0;
+thread_local long ccl::metrics::heap_hooks::allocations = 0;
+
 long ccl::metrics::get_proc_value(const std::string &key)
 {
 #ifndef _WIN32
@@ -58,6 +68,38 @@ long ccl::metrics::get_cpu_time()
 #endif
 }
 
+long ccl::metrics::get_thread_cpu_time()
+{
+#ifndef _WIN32
+
+    struct timespec ts;
+    if ( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts ) == -1 ) return 0;
+
+    return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+
+#else
+
+    // Windows Implementation
+    return 0;
+
+#endif
+}
+
+int ccl::metrics::get_thread_id()
+{
+#ifndef _WIN32
+
+    static thread_local int tid = static_cast<int>( syscall( SYS_gettid ) );
+    return tid;
+
+#else
+
+    // Windows Implementation
+    return 0;
+
+#endif
+}
+
 long ccl::metrics::get_stack_usage( int tid )
 {
 #ifndef _WIN32
@@ -146,6 +188,57 @@ long ccl::metrics::get_heap_usage()
 #endif
 }
 
+long ccl::metrics::get_stack_usage_fast()
+{
+#ifndef _WIN32
+
+    static thread_local uintptr_t stack_high = 0;
+
+    if ( stack_high == 0 )
+    {
+        // For the main thread, glibc parses /proc/self/maps: done only once
+        pthread_attr_t attr;
+        if ( pthread_getattr_np( pthread_self(), &attr ) != 0 ) return 0;
+
+        void*  stack_addr = nullptr;
+        size_t stack_size = 0;
+        pthread_attr_getstack( &attr, &stack_addr, &stack_size );
+        pthread_attr_destroy( &attr );
+
+        stack_high = reinterpret_cast<uintptr_t>( stack_addr ) + stack_size;
+    }
+
+    // Get the current stack pointer's address using a local variable
+    char dummy_on_stack;
+    return static_cast<long>( stack_high - reinterpret_cast<uintptr_t>( &dummy_on_stack ) );
+
+#else
+
+    // Windows Implementation
+    return 0;
+
+#endif
+}
+
+long ccl::metrics::get_heap_bytes()
+{
+    if ( heap_hooks::installed.load( std::memory_order_relaxed ) )
+    {
+        return heap_hooks::live_bytes;
+    }
+
+#ifndef _WIN32
+
+    return static_cast<long>( mallinfo2().uordblks );
+
+#else
+
+    // Windows Implementation
+    return 0;
+
+#endif
+}
+
 std::string ccl::metrics::qualified_function_name(std::string_view f_name)
 {
 #ifndef _WIN32
@@ -7,6 +7,7 @@
 #include <unistd.h>
 #include <sys/syscall.h>
 #include <string_view>
+#include <atomic>
 
 namespace ccl::metrics
 {
@@ -25,6 +26,18 @@ namespace ccl::metrics
      */
     long get_cpu_time();
 
+    /**
+     * @brief Returns the CPU time consumed by the calling thread only, in
+     * microseconds, using the CLOCK_THREAD_CPUTIME_ID clock.
+     */
+    long get_thread_cpu_time();
+
+    /**
+     * @brief Returns the Thread ID of the caller. The system call is made
+     * only once per thread, then the value is cached.
+     */
+    int get_thread_id();
+
     /**
      * @brief Returns the current stack usage, using the special 'maps' file.
      * In particular, stack pointers for the current thread is given by the file
@@ -43,6 +56,34 @@ namespace ccl::metrics
      */
     long get_heap_usage();
 
+    /**
+     * @brief Returns the current stack usage of the calling thread in bytes.
+     * The top of the stack is read once per thread (pthread_getattr_np) and
+     * cached, hence it costs just a subtraction.
+     */
+    long get_stack_usage_fast();
+
+    /**
+     * @brief Returns the heap usage in bytes without reading any file.
+     *
+     * If the allocator hooks are linked (ccl_MetricsHooks target), it is the
+     * number of bytes allocated minus the ones freed by the calling thread,
+     * which costs a thread-local read. Otherwise, it is the number of bytes
+     * in use by the whole process from mallinfo2, whose cost grows with the
+     * number of free chunks (microseconds on fragmented heaps).
+     */
+    long get_heap_bytes();
+
+    /**
+     * @brief Counters updated by the allocator hooks, when linked.
+     */
+    namespace heap_hooks
+    {
+        extern std::atomic<bool>  installed;  // Set by the hooks at startup
+        extern thread_local long  live_bytes;  // Allocated - freed by this thread
+        extern thread_local long  allocations; // Allocations made by this thread
+    }
+
     /**
      * @brief Extract only the namespace/class name of the input fully
      * qualified function name (or function signature). Therefore, 
@@ -0,0 +1,493 @@
+#include "open_metrics.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+using namespace ccl::metrics;
+
+namespace buffers = ccl::ds::buffers;
+
+size_t ccl::metrics::metric_shard()
+{
+    static std::atomic<size_t> next = 0;
+    static thread_local size_t shard = next.fetch_add( 1, std::memory_order_relaxed ) % METRIC_SHARDS;
+    return shard;
+}
+
+static bool is_valid_name( const std::string& name, bool colons )
+{
+    if ( name.empty() ) return false;
+
+    for ( size_t idx = 0; idx < name.size(); ++idx )
+    {
+        char c = name[idx];
+        bool valid = std::isalpha( static_cast<unsigned char>( c ) ) || c == '_' || ( colons && c == ':' )
+                  || ( idx > 0 && std::isdigit( static_cast<unsigned char>( c ) ) );
+
+        if ( !valid ) return false;
+    }
+
+    return true;
+}
+
+static void check_name( const std::string& name, bool colons, const char* what )
+{
+    if ( is_valid_name( name, colons ) ) return;
+
+    std::stringstream ss;
+    ss << "[MetricsRegistry] Invalid " << what << " name '" << name << "'";
+    throw std::invalid_argument( ss.str() );
+}
+
+// Escape backslashes, new lines and, in label values, double quotes
+static void append_escaped( std::string& out, const std::string& text, bool quotes )
+{
+    for ( char c: text )
+    {
+        if ( c == '\\' )          { out += "\\\\"; continue; }
+        if ( c == '\n' )          { out += "\\n";  continue; }
+        if ( c == '"' && quotes ) { out += "\\\""; continue; }
+        out += c;
+    }
+}
+
+static void append_number( std::string& out, double value )
+{
+    if ( std::isnan( value ) ) { out += "NaN"; return; }
+    if ( std::isinf( value ) ) { out += value > 0 ? "+Inf" : "-Inf"; return; }
+
+    char buffer[32];
+    auto result = std::to_chars( buffer, buffer + sizeof( buffer ), value );
+    out.append( buffer, result.ptr );
+
+    // Canonical floats have a fraction or an exponent: le="1.0", not le="1"
+    if ( std::find_if( buffer, result.ptr, []( char c ) { return c == '.' || c == 'e'; } ) == result.ptr )
+    {
+        out += ".0";
+    }
+}
+
+static void append_number( std::string& out, uint64_t value )
+{
+    char buffer[24];
+    auto result = std::to_chars( buffer, buffer + sizeof( buffer ), value );
+    out.append( buffer, result.ptr );
+}
+
+static void add_double( std::atomic<double>& target, double value )
+{
+    double current = target.load( std::memory_order_relaxed );
+    while ( !target.compare_exchange_weak( current, current + value, std::memory_order_relaxed ) );
+}
+
+Metric::Metric(MetricLabels labels)
+    : m_labels( std::move( labels ) )
+{
+    for ( const auto& [ name, value ]: m_labels )
+    {
+        check_name( name, false, "label" );
+
+        if ( !m_labelsText.empty() ) m_labelsText += ',';
+        m_labelsText += name;
+        m_labelsText += "=\"";
+        append_escaped( m_labelsText, value, true );
+        m_labelsText += '"';
+    }
+}
+
+const MetricLabels &Metric::getLabels() const
+{
+    return m_labels;
+}
+
+const std::string &Metric::getLabelsText() const
+{
+    return m_labelsText;
+}
+
+void Counter::inc(uint64_t value)
+{
+    m_shards[ metric_shard() ].m_value.fetch_add( value, std::memory_order_relaxed );
+}
+
+uint64_t Counter::value() const
+{
+    uint64_t total = 0;
+    for ( const auto& shard: m_shards ) total += shard.m_value.load( std::memory_order_relaxed );
+    return total;
+}
+
+void Gauge::set(double value)
+{
+    m_value.store( value, std::memory_order_relaxed );
+}
+
+void Gauge::add(double value)
+{
+    add_double( m_value, value );
+}
+
+double Gauge::value() const
+{
+    return m_value.load( std::memory_order_relaxed );
+}
+
+Histogram::Histogram(MetricLabels labels, std::vector<double> bounds)
+    : Metric( std::move( labels ) ), m_bounds( std::move( bounds ) )
+{
+    if ( !std::is_sorted( m_bounds.begin(), m_bounds.end() ) ||
+         std::adjacent_find( m_bounds.begin(), m_bounds.end() ) != m_bounds.end() )
+    {
+        throw std::invalid_argument( "[Histogram] The bucket bounds must be strictly increasing" );
+    }
+
+    // +Inf is implicit
+    if ( !m_bounds.empty() && std::isinf( m_bounds.back() ) ) m_bounds.pop_back();
+
+    for ( auto& shard: m_shards )
+    {
+        shard.m_counts = std::make_unique<std::atomic<uint64_t>[]>( m_bounds.size() + 1 );
+    }
+}
+
+void Histogram::observe(double value)
+{
+    // First bucket whose upper bound is not below the value (le)
+    size_t bucket = std::lower_bound( m_bounds.begin(), m_bounds.end(), value ) - m_bounds.begin();
+
+    Shard& shard = m_shards[ metric_shard() ];
+    shard.m_counts[bucket].fetch_add( 1, std::memory_order_relaxed );
+    add_double( shard.m_sum, value );
+}
+
+void Histogram::snapshot(Snapshot &out) const
+{
+    out.m_buckets.assign( m_bounds.size() + 1, 0 );
+    out.m_sum = 0.0;
+
+    for ( const auto& shard: m_shards )
+    {
+        for ( size_t idx = 0; idx <= m_bounds.size(); ++idx )
+        {
+            out.m_buckets[idx] += shard.m_counts[idx].load( std::memory_order_relaxed );
+        }
+
+        out.m_sum += shard.m_sum.load( std::memory_order_relaxed );
+    }
+
+    for ( size_t idx = 1; idx < out.m_buckets.size(); ++idx ) out.m_buckets[idx] += out.m_buckets[idx - 1];
+    out.m_count = out.m_buckets.back();
+}
+
+const std::vector<double> &Histogram::getBounds() const
+{
+    return m_bounds;
+}
+
+std::vector<double> Histogram::exponentialBounds(double start, double factor, size_t count)
+{
+    if ( start <= 0.0 || factor <= 1.0 )
+    {
+        throw std::invalid_argument( "[Histogram] Exponential bounds need start > 0 and factor > 1" );
+    }
+
+    std::vector<double> bounds;
+    for ( double bound = start; bounds.size() < count; bound *= factor ) bounds.push_back( bound );
+    return bounds;
+}
+
+std::vector<double> Histogram::linearBounds(double start, double width, size_t count)
+{
+    if ( width <= 0.0 )
+    {
+        throw std::invalid_argument( "[Histogram] Linear bounds need width > 0" );
+    }
+
+    std::vector<double> bounds;
+    for ( size_t idx = 0; idx < count; ++idx ) bounds.push_back( start + width * static_cast<double>( idx ) );
+    return bounds;
+}
+
+MetricFamily &MetricsRegistry::family(const std::string &name, const std::string &help,
+                                      MetricType type, const std::vector<double> &bounds)
+{
+    for ( auto& family: m_families )
+    {
+        if ( family->m_name != name ) continue;
+
+        if ( family->m_type != type || family->m_bounds != bounds )
+        {
+            std::stringstream ss;
+            ss << "[MetricsRegistry] Metric '" << name << "' already registered with another type or buckets";
+            throw std::invalid_argument( ss.str() );
+        }
+
+        return *family;
+    }
+
+    check_name( name, true, "metric" );
+
+    m_families.push_back( std::make_unique<MetricFamily>( MetricFamily { name, help, type, bounds, {} } ) );
+    return *m_families.back();
+}
+
+Metric *MetricsRegistry::find(MetricFamily &family, const MetricLabels &labels)
+{
+    for ( auto& metric: family.m_metrics )
+    {
+        if ( metric->getLabels() == labels ) return metric.get();
+    }
+
+    return nullptr;
+}
+
+Counter &MetricsRegistry::counter(const std::string &name, const std::string &help, const MetricLabels &labels)
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+
+    MetricFamily& counters = family( name, help, MetricType::Counter, {} );
+    if ( Metric* metric = find( counters, labels ) ) return static_cast<Counter&>( *metric );
+
+    counters.m_metrics.push_back( std::make_unique<Counter>( labels ) );
+    return static_cast<Counter&>( *counters.m_metrics.back() );
+}
+
+Gauge &MetricsRegistry::gauge(const std::string &name, const std::string &help, const MetricLabels &labels)
+{
+    std::lock_guard<std::mutex> _l( m_mutex );
+
+    MetricFamily& gauges = family( name, help, MetricType::Gauge, {} );
+    if ( Metric* metric = find( gauges, labels ) ) return static_cast<Gauge&>( *metric );
+
+    gauges.m_metrics.push_back( std::make_unique<Gauge>( labels ) );
+    return static_cast<Gauge&>( *gauges.m_metrics.back() );
+}
+
+Histogram &MetricsRegistry::histogram(const std::string &name, const std::string &help,
+                                      const std::vector<double> &bounds, const MetricLabels &labels)
+{
+    // Validated before touching the registry
+    auto histogram = std::make_unique<Histogram>( labels, bounds );
+
+    std::lock_guard<std::mutex> _l( m_mutex );
+
+    MetricFamily& histograms = family( name, help, MetricType::Histogram, histogram->getBounds() );
+    if ( Metric* metric = find( histograms, labels ) ) return static_cast<Histogram&>( *metric );
+
+    histograms.m_metrics.push_back( std::move( histogram ) );
+    return static_cast<Histogram&>( *histograms.m_metrics.back() );
+}
+
+std::string MetricsRegistry::render() const
+{
+    OpenMetricsRenderer renderer( *this );
+    buffers::ByteBuffer buffer( 16 * 1024 );
+    std::string result;
+
+    renderer.begin();
+
+    bool done = false;
+    while ( !done )
+    {
+        buffer.reset();
+        done = renderer.render( buffer );
+        result.append( reinterpret_cast<const char*>( buffer.getBuffer() ), buffer.getBufferSize() );
+    }
+
+    return result;
+}
+
+OpenMetricsRenderer::OpenMetricsRenderer(const MetricsRegistry &registry)
+    : m_registry( registry )
+{}
+
+void OpenMetricsRenderer::begin()
+{
+    {
+        std::lock_guard<std::mutex> _l( m_registry.m_mutex );
+
+        m_families.clear();
+        for ( const auto& family: m_registry.m_families ) m_families.push_back( family.get() );
+    }
+
+    m_family  = 0;
+    m_metric  = 0;
+    m_line    = 0;
+    m_header  = true;
+    m_eof     = false;
+    m_current = nullptr;
+    m_pending = false;
+}
+
+bool OpenMetricsRenderer::nextLine()
+{
+    m_text.clear();
+
+    while ( m_family < m_families.size() )
+    {
+        const MetricFamily& family = *m_families[m_family];
+
+        if ( m_header )
+        {
+            if ( m_line == 0 )
+            {
+                static constexpr const char* TYPES[] = { "counter", "gauge", "histogram" };
+
+                m_line = 1;
+                m_text += "# TYPE ";
+                m_text += family.m_name;
+                m_text += ' ';
+                m_text += TYPES[ static_cast<int>( family.m_type ) ];
+                m_text += '\n';
+                return true;
+            }
+
+            m_header = false;
+            m_line = 0;
+
+            if ( !family.m_help.empty() )
+            {
+                m_text += "# HELP ";
+                m_text += family.m_name;
+                m_text += ' ';
+                append_escaped( m_text, family.m_help, false );
+                m_text += '\n';
+                return true;
+            }
+        }
+
+        if ( m_current == nullptr )
+        {
+            // Metrics can be added while rendering: read one at a time
+            std::lock_guard<std::mutex> _l( m_registry.m_mutex );
+            if ( m_metric < family.m_metrics.size() ) m_current = family.m_metrics[m_metric].get();
+        }
+
+        if ( m_current == nullptr )
+        {
+            ++m_family;
+            m_metric = 0;
+            m_line = 0;
+            m_header = true;
+            continue;
+        }
+
+        const std::string& labels = m_current->getLabelsText();
+        std::string_view suffix;
+        double bound = 0.0;
+        bool last = true, bucket = false;
+
+        if ( family.m_type == MetricType::Histogram )
+        {
+            if ( m_line == 0 ) static_cast<const Histogram*>( m_current )->snapshot( m_snapshot );
+
+            // Buckets (+Inf included), then count and sum
+            size_t buckets = m_snapshot.m_buckets.size();
+            bucket = m_line < buckets;
+            suffix = bucket ? "_bucket" : ( m_line == buckets ? "_count" : "_sum" );
+            last = m_line == buckets + 1;
+
+            if ( bucket )
+            {
+                const auto& bounds = family.m_bounds;
+                bound = m_line < bounds.size() ? bounds[m_line] : INFINITY;
+            }
+        }
+        else if ( family.m_type == MetricType::Counter )
+        {
+            suffix = "_total";
+        }
+
+        m_text += family.m_name;
+        m_text += suffix;
+
+        if ( !labels.empty() || bucket )
+        {
+            m_text += '{';
+            m_text += labels;
+
+            if ( bucket )
+            {
+                if ( !labels.empty() ) m_text += ',';
+                m_text += "le=\"";
+                append_number( m_text, bound );
+                m_text += '"';
+            }
+
+            m_text += '}';
+        }
+
+        m_text += ' ';
+
+        switch ( family.m_type )
+        {
+            case MetricType::Counter:
+                append_number( m_text, static_cast<const Counter*>( m_current )->value() );
+                break;
+
+            case MetricType::Gauge:
+                append_number( m_text, static_cast<const Gauge*>( m_current )->value() );
+                break;
+
+            case MetricType::Histogram:
+                if ( bucket )                                     append_number( m_text, m_snapshot.m_buckets[m_line] );
+                else if ( m_line == m_snapshot.m_buckets.size() ) append_number( m_text, m_snapshot.m_count );
+                else                                              append_number( m_text, m_snapshot.m_sum );
+                break;
+        }
+
+        m_text += '\n';
+
+        if ( last )
+        {
+            m_current = nullptr;
+            ++m_metric;
+            m_line = 0;
+        }
+        else
+        {
+            ++m_line;
+        }
+
+        return true;
+    }
+
+    if ( m_eof ) return false;
+
+    m_eof = true;
+    m_text += "# EOF\n";
+    return true;
+}
+
+bool OpenMetricsRenderer::render(buffers::ByteBuffer &out)
+{
+    while ( true )
+    {
+        if ( !m_pending )
+        {
+            if ( !nextLine() ) return true;
+            m_pending = true;
+        }
+
+        if ( m_text.size() > out.getBufferCapacity() - out.position() )
+        {
+            if ( out.position() == 0 )
+            {
+                std::stringstream ss;
+                ss << "[OpenMetricsRenderer] A line of " << m_text.size()
+                   << " bytes does not fit the buffer of " << out.getBufferCapacity();
+
+                throw std::overflow_error( ss.str() );
+            }
+
+            return false;
+        }
+
+        out.putBuffer( reinterpret_cast<const unsigned char*>( m_text.data() ), m_text.size() );
+        m_pending = false;
+    }
+}
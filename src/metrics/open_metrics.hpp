@@ -0,0 +1,247 @@
+#pragma once
+
+#include <data_structures/base/cache_line.hpp>
+#include <data_structures/buffers/byte_buffer.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ccl::metrics
+{
+    enum class MetricType
+    {
+        Counter,  // Monotonic total, exposed as <name>_total
+        Gauge,    // Value that can go up and down
+        Histogram // Cumulative buckets, with <name>_count and <name>_sum
+    };
+
+    using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+    // Number of shards of the counters and histograms. The threads are
+    // spread over them, so writers rarely share a cache line.
+    static constexpr size_t METRIC_SHARDS = 16;
+
+    /**
+     * @brief Returns the shard of the calling thread, assigned round robin
+     * at its first call.
+     */
+    size_t metric_shard();
+
+    /**
+     * @class Metric
+     *
+     * @brief Base class of a single time series of a MetricFamily, i.e.,
+     * the metric with a given set of labels.
+     */
+    class Metric
+    {
+    private:
+        MetricLabels m_labels;
+        std::string  m_labelsText; // Rendered once: k1="v1",k2="v2"
+
+    public:
+        explicit Metric( MetricLabels labels );
+        virtual ~Metric() = default;
+
+        const MetricLabels& getLabels() const;
+        const std::string&  getLabelsText() const;
+    };
+
+    /**
+     * @class Counter
+     *
+     * @brief Monotonic counter. Each thread increments its own shard with
+     * a relaxed atomic add, and the value is the sum of the shards.
+     */
+    class Counter : public Metric
+    {
+    private:
+        struct alignas( ds::base::CACHE_LINE_SIZE ) Shard
+        {
+            std::atomic<uint64_t> m_value = 0;
+        };
+
+        std::array<Shard, METRIC_SHARDS> m_shards;
+
+    public:
+        using Metric::Metric;
+
+        void inc( uint64_t value = 1 );
+        uint64_t value() const;
+    };
+
+    /**
+     * @class Gauge
+     *
+     * @brief Value that can be set, increased and decreased. A set cannot
+     * be split over shards, hence a gauge is a single atomic.
+     */
+    class Gauge : public Metric
+    {
+    private:
+        std::atomic<double> m_value = 0.0;
+
+    public:
+        using Metric::Metric;
+
+        void set( double value );
+        void add( double value );
+        double value() const;
+    };
+
+    /**
+     * @class Histogram
+     *
+     * @brief Distribution of observations in buckets with fixed upper bounds,
+     * plus an implicit +Inf one. Each thread counts in its own shard.
+     */
+    class Histogram : public Metric
+    {
+    public:
+        /**
+         * @brief Values of the histogram at some point: the cumulative counts
+         * of each bucket (+Inf last), the sum and the number of observations.
+         */
+        struct Snapshot
+        {
+            std::vector<uint64_t> m_buckets;
+            double                m_sum   = 0.0;
+            uint64_t              m_count = 0;
+        };
+
+    private:
+        struct alignas( ds::base::CACHE_LINE_SIZE ) Shard
+        {
+            std::unique_ptr<std::atomic<uint64_t>[]> m_counts; // Not cumulative
+            std::atomic<double>                      m_sum = 0.0;
+        };
+
+        std::vector<double>              m_bounds; // Sorted upper bounds, +Inf excluded
+        std::array<Shard, METRIC_SHARDS> m_shards;
+
+    public:
+        Histogram( MetricLabels labels, std::vector<double> bounds );
+
+        void observe( double value );
+        void snapshot( Snapshot& out ) const;
+
+        const std::vector<double>& getBounds() const;
+
+        /* Returns count bounds: start, start * factor, start * factor^2 ... */
+        static std::vector<double> exponentialBounds( double start, double factor, size_t count );
+
+        /* Returns count bounds: start, start + width, start + 2 * width ... */
+        static std::vector<double> linearBounds( double start, double width, size_t count );
+    };
+
+    /**
+     * @brief All the metrics with the same name, type and help text.
+     */
+    struct MetricFamily
+    {
+        std::string         m_name;
+        std::string         m_help;
+        MetricType          m_type;
+        std::vector<double> m_bounds; // Histograms only
+
+        // Never removed, so the references given away remain valid
+        std::vector<std::unique_ptr<Metric>> m_metrics;
+    };
+
+    /**
+     * @class MetricsRegistry
+     *
+     * @brief Owns the metric families and hands out references to their
+     * metrics. Getting a metric takes a lock, hence it is meant to be done
+     * once and the reference kept: updating a metric never locks.
+     *
+     * Names must match [a-zA-Z_:][a-zA-Z0-9_:]* and label names
+     * [a-zA-Z_][a-zA-Z0-9_]*, otherwise an invalid_argument is thrown, as
+     * when a name is reused with a different type or buckets.
+     */
+    class MetricsRegistry
+    {
+        friend class OpenMetricsRenderer;
+
+    private:
+        mutable std::mutex                         m_mutex;
+        std::vector<std::unique_ptr<MetricFamily>> m_families;
+
+        MetricFamily& family( const std::string& name, const std::string& help,
+                              MetricType type, const std::vector<double>& bounds );
+
+        Metric* find( MetricFamily& family, const MetricLabels& labels );
+
+    public:
+        MetricsRegistry() = default;
+
+        MetricsRegistry( const MetricsRegistry& ) = delete;
+        MetricsRegistry& operator=( const MetricsRegistry& ) = delete;
+
+        /* Returns the counter with the given name and labels, created if missing */
+        Counter& counter( const std::string& name, const std::string& help,
+                          const MetricLabels& labels = {} );
+
+        /* Returns the gauge with the given name and labels, created if missing */
+        Gauge& gauge( const std::string& name, const std::string& help,
+                      const MetricLabels& labels = {} );
+
+        /* Returns the histogram with the given name and labels, created if missing */
+        Histogram& histogram( const std::string& name, const std::string& help,
+                              const std::vector<double>& bounds, const MetricLabels& labels = {} );
+
+        /* Returns the whole exposition in the OpenMetrics text format */
+        std::string render() const;
+    };
+
+    /**
+     * @class OpenMetricsRenderer
+     *
+     * @brief Renders a registry in the OpenMetrics text format, a chunk at a
+     * time, into a ByteBuffer of fixed capacity.
+     *
+     * Each call to render appends as many whole lines as fit, so that the
+     * buffer can be sent and reset before the next one. The writers are
+     * never blocked: the values are read with relaxed loads, and the lines
+     * of a histogram come from a single snapshot of its shards. The list
+     * of metrics is read under the registry lock, one metric at a time.
+     */
+    class OpenMetricsRenderer
+    {
+    private:
+        const MetricsRegistry& m_registry;
+
+        std::vector<const MetricFamily*> m_families; // Taken by begin
+        size_t m_family = 0;     // Current family
+        size_t m_metric = 0;     // Current metric in the family
+        size_t m_line   = 0;     // Current line of the family or metric
+        bool   m_header = true;  // Rendering the TYPE and HELP lines
+        bool   m_eof    = false; // The # EOF line has been produced
+
+        const Metric*       m_current = nullptr; // Metric being rendered
+        Histogram::Snapshot m_snapshot;          // Of the current histogram
+
+        std::string m_text;            // The next line
+        bool        m_pending = false; // The line did not fit the last buffer
+
+        bool nextLine(); // Produce the next line into m_text
+
+    public:
+        explicit OpenMetricsRenderer( const MetricsRegistry& registry );
+
+        /* Start a new exposition, with the metrics registered so far */
+        void begin();
+
+        /**
+         * @brief Append the next lines to the buffer, from its position.
+         * @return True once the whole exposition has been written
+         * @throws std::overflow_error If a single line does not fit the buffer
+         */
+        bool render( ds::buffers::ByteBuffer& out );
+    };
+}
@@ -0,0 +1,281 @@
+#include "perf_counters.hpp"
+#include <atomic>
+#include <memory>
+
+#ifndef _WIN32
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace ccl::metrics;
+
+// Hardware events first: a software leader would move the group anyway
+static constexpr PerfEvent EVENTS[] = {
+    PerfEvent::Cycles, PerfEvent::Instructions, PerfEvent::CacheMisses,
+    PerfEvent::BranchMisses, PerfEvent::ContextSwitches
+};
+
+uint64_t &PerfCounters::get(PerfEvent event)
+{
+    switch ( event )
+    {
+        case PerfEvent::Cycles:       return m_cycles;
+        case PerfEvent::Instructions: return m_instructions;
+        case PerfEvent::CacheMisses:  return m_cache_misses;
+        case PerfEvent::BranchMisses: return m_branch_misses;
+        default:                      return m_context_switches;
+    }
+}
+
+uint64_t PerfCounters::get(PerfEvent event) const
+{
+    return const_cast<PerfCounters*>( this )->get( event );
+}
+
+PerfCounters PerfCounters::operator-(const PerfCounters &other) const
+{
+    PerfCounters result;
+    result.m_events = m_events & other.m_events;
+
+    for ( PerfEvent event: EVENTS )
+    {
+        if ( !has_events( result.m_events, event ) ) continue;
+        result.get( event ) = get( event ) - other.get( event );
+    }
+
+    return result;
+}
+
+#ifndef _WIN32
+
+static bool is_hardware( PerfEvent event )
+{
+    return event != PerfEvent::ContextSwitches;
+}
+
+static int open_event( PerfEvent event, int group_fd )
+{
+    struct perf_event_attr attr {};
+    attr.size        = sizeof( attr );
+    attr.type        = is_hardware( event ) ? PERF_TYPE_HARDWARE : PERF_TYPE_SOFTWARE;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID
+                     | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    attr.exclude_hv = 1;
+
+    // Switches are counted in the kernel, hardware events in user space only
+    attr.exclude_kernel = is_hardware( event ) ? 1 : 0;
+
+    switch ( event )
+    {
+        case PerfEvent::Cycles:       attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case PerfEvent::Instructions: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case PerfEvent::CacheMisses:  attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+        case PerfEvent::BranchMisses: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        default:                      attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES; break;
+    }
+
+    // The calling thread, on any CPU
+    return static_cast<int>( syscall( SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC ) );
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+static inline uint64_t rdpmc( uint32_t counter )
+{
+    uint32_t low, high;
+    asm volatile( "rdpmc" : "=a"( low ), "=d"( high ) : "c"( counter ) );
+    return static_cast<uint64_t>( high ) << 32 | low;
+}
+
+#endif
+
+#endif
+
+PerfCounterGroup::PerfCounterGroup(PerfEvent events)
+{
+#ifndef _WIN32
+
+    long page_size = sysconf( _SC_PAGESIZE );
+    m_rdpmc = true;
+
+    for ( PerfEvent event: EVENTS )
+    {
+        if ( !has_events( events, event ) ) continue;
+
+        int leader = m_counters.empty() ? -1 : m_counters.front().m_fd;
+        int fd = open_event( event, leader );
+        if ( fd < 0 ) continue;
+
+        Counter counter { event, fd, 0, nullptr };
+        ioctl( fd, PERF_EVENT_IOC_ID, &counter.m_id );
+
+        if ( is_hardware( event ) )
+        {
+            void* page = mmap( nullptr, page_size, PROT_READ, MAP_SHARED, fd, 0 );
+            if ( page != MAP_FAILED ) counter.m_page = page;
+        }
+
+        auto* mapped = static_cast<perf_event_mmap_page*>( counter.m_page );
+        m_rdpmc = m_rdpmc && mapped != nullptr && mapped->cap_user_rdpmc;
+
+        m_counters.push_back( counter );
+        m_events = m_events | event;
+    }
+
+#if !defined(__x86_64__) && !defined(__i386__)
+    m_rdpmc = false;
+#endif
+
+    m_rdpmc = m_rdpmc && !m_counters.empty();
+
+    // Number of events, enabled and running times, then (value, id) pairs
+    m_buffer.resize( 3 + 2 * m_counters.size() );
+
+#else
+
+    // Windows Implementation
+    (void)events;
+
+#endif
+}
+
+PerfCounterGroup::~PerfCounterGroup()
+{
+#ifndef _WIN32
+
+    long page_size = sysconf( _SC_PAGESIZE );
+
+    // Members first, then the leader
+    for ( auto it = m_counters.rbegin(); it != m_counters.rend(); ++it )
+    {
+        if ( it->m_page != nullptr ) munmap( it->m_page, page_size );
+        close( it->m_fd );
+    }
+
+#endif
+}
+
+bool PerfCounterGroup::readRdpmc(PerfCounters &out) const
+{
+#if !defined(_WIN32) && ( defined(__x86_64__) || defined(__i386__) )
+
+    for ( const auto& counter: m_counters )
+    {
+        auto* page = static_cast<volatile perf_event_mmap_page*>( counter.m_page );
+        uint32_t sequence;
+        int64_t value;
+
+        // The kernel updates the page under a sequence lock
+        do
+        {
+            sequence = page->lock;
+            std::atomic_signal_fence( std::memory_order_acq_rel );
+
+            // Not on the PMU right now, or multiplexed: scaling is needed
+            uint32_t index = page->index;
+            if ( index == 0 || page->time_enabled != page->time_running ) return false;
+
+            uint16_t width = page->pmc_width;
+            int64_t count = static_cast<int64_t>( rdpmc( index - 1 ) );
+            count = static_cast<int64_t>( static_cast<uint64_t>( count ) << ( 64 - width ) ) >> ( 64 - width );
+            value = page->offset + count;
+
+            std::atomic_signal_fence( std::memory_order_acq_rel );
+        }
+        while ( page->lock != sequence );
+
+        out.get( counter.m_event ) = static_cast<uint64_t>( value );
+    }
+
+    out.m_events = m_events;
+    return true;
+
+#else
+
+    (void)out;
+    return false;
+
+#endif
+}
+
+bool PerfCounterGroup::readGroup(PerfCounters &out)
+{
+#ifndef _WIN32
+
+    ssize_t size = static_cast<ssize_t>( m_buffer.size() * sizeof( uint64_t ) );
+    if ( ::read( m_counters.front().m_fd, m_buffer.data(), size ) != size ) return false;
+
+    uint64_t nevents = m_buffer[0], enabled = m_buffer[1], running = m_buffer[2];
+
+    for ( uint64_t idx = 0; idx < nevents && idx < m_counters.size(); ++idx )
+    {
+        uint64_t value = m_buffer[3 + 2 * idx];
+        uint64_t id = m_buffer[4 + 2 * idx];
+
+        // Multiplexed with other groups: extrapolate to the whole time
+        if ( running > 0 && running < enabled )
+        {
+            value = static_cast<uint64_t>( static_cast<double>( value ) * enabled / running );
+        }
+
+        for ( const auto& counter: m_counters )
+        {
+            if ( counter.m_id == id ) out.get( counter.m_event ) = value;
+        }
+    }
+
+    out.m_events = m_events;
+    return true;
+
+#else
+
+    (void)out;
+    return false;
+
+#endif
+}
+
+bool PerfCounterGroup::read(PerfCounters &out)
+{
+    if ( m_counters.empty() ) return false;
+    if ( m_rdpmc && readRdpmc( out ) ) return true;
+    return readGroup( out );
+}
+
+PerfEvent PerfCounterGroup::getEvents() const
+{
+    return m_events;
+}
+
+bool PerfCounterGroup::usesRdpmc() const
+{
+    return m_rdpmc;
+}
+
+PerfCounterGroup &PerfCounterGroup::forThread(PerfEvent events)
+{
+    struct Entry
+    {
+        PerfEvent                         m_requested;
+        std::unique_ptr<PerfCounterGroup> m_group;
+    };
+
+    static thread_local std::vector<Entry> groups;
+
+    for ( auto& entry: groups )
+    {
+        if ( entry.m_requested == events ) return *entry.m_group;
+    }
+
+    groups.push_back( { events, std::make_unique<PerfCounterGroup>( events ) } );
+    return *groups.back().m_group;
+}
+
+PerfEvent PerfCounterGroup::supported(PerfEvent events)
+{
+    return PerfCounterGroup( events ).getEvents();
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace ccl::metrics
+{
+    /**
+     * @brief Events counted by a PerfCounterGroup, as a bitmask.
+     */
+    enum class PerfEvent : unsigned
+    {
+        None            = 0,
+        Cycles          = 1 << 0, // CPU cycles (user space)
+        Instructions    = 1 << 1, // Retired instructions (user space)
+        CacheMisses     = 1 << 2, // Last level cache misses (user space)
+        BranchMisses    = 1 << 3, // Mispredicted branches (user space)
+        ContextSwitches = 1 << 4, // Context switches of the thread (software)
+        All             = ( 1 << 5 ) - 1
+    };
+
+    constexpr PerfEvent operator|( PerfEvent lhs, PerfEvent rhs )
+    {
+        return static_cast<PerfEvent>( static_cast<unsigned>( lhs ) | static_cast<unsigned>( rhs ) );
+    }
+
+    constexpr PerfEvent operator&( PerfEvent lhs, PerfEvent rhs )
+    {
+        return static_cast<PerfEvent>( static_cast<unsigned>( lhs ) & static_cast<unsigned>( rhs ) );
+    }
+
+    /* Returns true if all the events are in the set */
+    constexpr bool has_events( PerfEvent set, PerfEvent events )
+    {
+        return ( set & events ) == events;
+    }
+
+    /**
+     * @brief Values of the performance counters. Only the events in m_events
+     * have been counted, the other values are zero.
+     */
+    struct PerfCounters
+    {
+        PerfEvent m_events           = PerfEvent::None;
+        uint64_t  m_cycles           = 0;
+        uint64_t  m_instructions     = 0;
+        uint64_t  m_cache_misses     = 0;
+        uint64_t  m_branch_misses    = 0;
+        uint64_t  m_context_switches = 0;
+
+        uint64_t& get( PerfEvent event );
+        uint64_t  get( PerfEvent event ) const;
+
+        /* Counts from other to this, for the events counted by both */
+        PerfCounters operator-( const PerfCounters& other ) const;
+    };
+
+    /**
+     * @class PerfCounterGroup
+     *
+     * @brief Group of perf events (perf_event_open) counting the calling
+     * thread, read all at once.
+     *
+     * Hardware events exclude the kernel, so they are available with the
+     * default perf_event_paranoid level. Events that cannot be opened (e.g.,
+     * no PMU in virtual machines, or not permitted) are left out of the
+     * group, which is never an error: getEvents returns the counted ones.
+     *
+     * When the kernel allows it and all the events are hardware ones, the
+     * counters are read in user space with rdpmc through the mapped pages
+     * of the events. Otherwise, or when an event is not scheduled on the
+     * PMU, a single read of the group leader is made. Multiplexed values
+     * are scaled by the time the events were actually counted.
+     *
+     * The group counts the thread that constructed it, hence it must be
+     * read from the same thread (see forThread).
+     */
+    class PerfCounterGroup
+    {
+    private:
+        struct Counter
+        {
+            PerfEvent m_event;
+            int       m_fd;
+            uint64_t  m_id;   // Kernel id, to match the values of group reads
+            void*     m_page; // Mapped perf_event_mmap_page, for rdpmc
+        };
+
+        std::vector<Counter>  m_counters;
+        std::vector<uint64_t> m_buffer; // Group read buffer
+        PerfEvent             m_events = PerfEvent::None;
+        bool                  m_rdpmc  = false;
+
+        bool readRdpmc( PerfCounters& out ) const;
+        bool readGroup( PerfCounters& out );
+
+    public:
+        explicit PerfCounterGroup( PerfEvent events );
+
+        PerfCounterGroup( const PerfCounterGroup& ) = delete;
+        PerfCounterGroup& operator=( const PerfCounterGroup& ) = delete;
+
+        ~PerfCounterGroup();
+
+        /**
+         * @brief Read the current values of the counters.
+         * @return False if no event is counted or the read failed
+         */
+        bool read( PerfCounters& out );
+
+        PerfEvent getEvents() const; // Returns the events actually counted
+        bool      usesRdpmc() const; // Returns true if read in user space
+
+        /**
+         * @brief Returns the group of the calling thread for the given events,
+         * opened at the first call and kept until the thread exits.
+         */
+        static PerfCounterGroup& forThread( PerfEvent events );
+
+        /**
+         * @brief Returns which of the given events can be counted here.
+         */
+        static PerfEvent supported( PerfEvent events );
+    };
+}
@@ -0,0 +1,188 @@
+#include "sampling.hpp"
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace ccl::metrics;
+
+double Sampler::uniform()
+{
+    // xorshift64*, seeded differently by each thread
+    static thread_local uint64_t state =
+        std::hash<std::thread::id>{}( std::this_thread::get_id() ) | 1;
+
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+
+    uint64_t value = state * 0x2545F4914F6CDD1DULL;
+    return static_cast<double>( value >> 11 ) * 0x1.0p-53;
+}
+
+int64_t Sampler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+bool Sampler::shouldSample()
+{
+    uint64_t call = m_calls.fetch_add( 1, std::memory_order_relaxed ) + 1;
+    if ( !sample( call ) ) return false;
+
+    m_sampled.fetch_add( 1, std::memory_order_relaxed );
+    return true;
+}
+
+bool Sampler::needsCost() const
+{
+    return false;
+}
+
+void Sampler::record(uint64_t)
+{}
+
+uint64_t Sampler::getCalls() const
+{
+    return m_calls.load( std::memory_order_relaxed );
+}
+
+uint64_t Sampler::getSampled() const
+{
+    return m_sampled.load( std::memory_order_relaxed );
+}
+
+EveryNSampler::EveryNSampler(uint64_t period)
+    : m_period( period )
+{
+    if ( period == 0 )
+    {
+        throw std::invalid_argument( "[EveryNSampler] The period must be greater than zero" );
+    }
+}
+
+bool EveryNSampler::sample(uint64_t call)
+{
+    return ( call - 1 ) % m_period == 0;
+}
+
+WindowedSampler::WindowedSampler(std::chrono::nanoseconds window)
+    : m_window( window.count() ), m_windowEnd( now() + window.count() )
+{
+    if ( window.count() <= 0 )
+    {
+        throw std::invalid_argument( "[WindowedSampler] The window must be positive" );
+    }
+}
+
+void WindowedSampler::checkWindow(uint64_t call, bool force)
+{
+    if ( !force && call % CHECK_PERIOD != 0 ) return;
+
+    int64_t current = now();
+    int64_t end = m_windowEnd.load( std::memory_order_relaxed );
+    if ( current < end ) return;
+
+    // Only one thread closes the window
+    if ( !m_windowEnd.compare_exchange_strong( end, current + m_window, std::memory_order_relaxed ) )
+    {
+        return;
+    }
+
+    uint64_t first = m_windowFirstCall.exchange( call, std::memory_order_relaxed );
+    onWindow( call - first, current - ( end - m_window ) );
+}
+
+double WindowedSampler::getProbability() const
+{
+    return m_probability.load( std::memory_order_relaxed );
+}
+
+ReservoirSampler::ReservoirSampler(uint64_t size, std::chrono::nanoseconds window)
+    : WindowedSampler( window ), m_size( size )
+{
+    if ( size == 0 )
+    {
+        throw std::invalid_argument( "[ReservoirSampler] The size must be greater than zero" );
+    }
+}
+
+bool ReservoirSampler::sample(uint64_t call)
+{
+    checkWindow( call, false );
+
+    double probability = m_probability.load( std::memory_order_relaxed );
+    if ( probability < 1.0 && uniform() >= probability ) return false;
+
+    // Candidates are rare enough to afford a look at the clock
+    checkWindow( call, true );
+    return m_accepted.fetch_add( 1, std::memory_order_relaxed ) < m_size;
+}
+
+void ReservoirSampler::onWindow(uint64_t calls, int64_t)
+{
+    double probability = calls == 0 ? 1.0 : static_cast<double>( m_size ) / static_cast<double>( calls );
+
+    m_probability.store( std::min( probability, 1.0 ), std::memory_order_relaxed );
+    m_accepted.store( 0, std::memory_order_relaxed );
+}
+
+AdaptiveSampler::AdaptiveSampler(double budget, std::chrono::nanoseconds window, double min_probability)
+    : WindowedSampler( window ), m_budget( budget ), m_minProbability( min_probability )
+{
+    if ( budget <= 0.0 || budget > 1.0 || min_probability <= 0.0 || min_probability > 1.0 )
+    {
+        std::stringstream ss;
+        ss << "[AdaptiveSampler] Invalid budget " << budget
+           << " or minimum probability " << min_probability;
+
+        throw std::invalid_argument( ss.str() );
+    }
+}
+
+bool AdaptiveSampler::sample(uint64_t call)
+{
+    checkWindow( call, false );
+
+    double probability = m_probability.load( std::memory_order_relaxed );
+    return probability >= 1.0 || uniform() < probability;
+}
+
+void AdaptiveSampler::onWindow(uint64_t calls, int64_t elapsed)
+{
+    uint64_t cost  = m_cost.exchange( 0, std::memory_order_relaxed );
+    uint64_t count = m_costCount.exchange( 0, std::memory_order_relaxed );
+
+    // Keep the last known cost for the windows without samples
+    double average = m_averageCost.load( std::memory_order_relaxed );
+    if ( count > 0 )
+    {
+        average = static_cast<double>( cost ) / static_cast<double>( count );
+        m_averageCost.store( average, std::memory_order_relaxed );
+    }
+
+    if ( calls == 0 || average <= 0.0 ) return;
+
+    double probability = m_budget * static_cast<double>( elapsed )
+                       / ( static_cast<double>( calls ) * average );
+
+    m_probability.store( std::clamp( probability, m_minProbability, 1.0 ), std::memory_order_relaxed );
+}
+
+bool AdaptiveSampler::needsCost() const
+{
+    return true;
+}
+
+void AdaptiveSampler::record(uint64_t cost)
+{
+    m_cost.fetch_add( cost, std::memory_order_relaxed );
+    m_costCount.fetch_add( 1, std::memory_order_relaxed );
+}
+
+double AdaptiveSampler::getAverageCost() const
+{
+    return m_averageCost.load( std::memory_order_relaxed );
+}
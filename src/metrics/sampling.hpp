@@ -0,0 +1,186 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace ccl::metrics
+{
+    /**
+     * @class Sampler
+     *
+     * @brief Sampling policy of a single call site.
+     *
+     * A sampler is meant to be a static object next to the instrumentation
+     * (see MetricsCollector::create), deciding at each call whether the
+     * metrics of the scope are collected. It must outlive the collectors it
+     * has sampled. All the policies are thread-safe and lock-free.
+     */
+    class Sampler
+    {
+    private:
+        std::atomic<uint64_t> m_calls   = 0;
+        std::atomic<uint64_t> m_sampled = 0;
+
+    protected:
+        /**
+         * Decides whether the call is sampled.
+         * @param call The number of calls so far, this one included
+         */
+        virtual bool sample( uint64_t call ) = 0;
+
+        /* Returns a uniform random number in [0, 1), from a per-thread generator */
+        static double uniform();
+
+        /* Returns the steady clock in nanoseconds */
+        static int64_t now();
+
+    public:
+        virtual ~Sampler() = default;
+
+        /* Count the call and decide whether it is sampled */
+        bool shouldSample();
+
+        /**
+         * Returns true if the policy needs the cost of the sampled scopes,
+         * which are then measured by the collectors and given to record.
+         */
+        virtual bool needsCost() const;
+
+        /* Account the overhead of a sampled scope, in nanoseconds */
+        virtual void record( uint64_t cost );
+
+        uint64_t getCalls() const;   // Returns the number of calls
+        uint64_t getSampled() const; // Returns the number of sampled calls
+    };
+
+    /**
+     * @class EveryNSampler
+     *
+     * @brief Samples the first call and then one every N.
+     */
+    class EveryNSampler : public Sampler
+    {
+    private:
+        uint64_t m_period;
+
+    protected:
+        bool sample( uint64_t call ) override;
+
+    public:
+        explicit EveryNSampler( uint64_t period );
+    };
+
+    /**
+     * @class WindowedSampler
+     *
+     * @brief Base of the policies adapting themselves at each time window.
+     *
+     * The clock is read only every CHECK_PERIOD calls (or when the policy
+     * asks it), and the thread finding the window expired is the only one
+     * closing it, through onWindow.
+     */
+    class WindowedSampler : public Sampler
+    {
+    private:
+        const int64_t         m_window;              // Window length in nanoseconds
+        std::atomic<int64_t>  m_windowEnd;           // End of the current window
+        std::atomic<uint64_t> m_windowFirstCall = 0; // Calls before the window
+
+    protected:
+        static constexpr uint64_t CHECK_PERIOD = 64;
+
+        // Probability of the calls to be sampled in the current window
+        std::atomic<double> m_probability = 1.0;
+
+        /**
+         * Close the window if expired, checking the clock only every
+         * CHECK_PERIOD calls unless forced.
+         */
+        void checkWindow( uint64_t call, bool force );
+
+        /**
+         * Called once the window is closed.
+         * @param calls The number of calls in the window
+         * @param elapsed The length of the window in nanoseconds
+         */
+        virtual void onWindow( uint64_t calls, int64_t elapsed ) = 0;
+
+    public:
+        explicit WindowedSampler( std::chrono::nanoseconds window );
+
+        /* Returns the sampling probability of the current window */
+        double getProbability() const;
+    };
+
+    /**
+     * @class ReservoirSampler
+     *
+     * @brief Samples at most K calls per time window, spread over the window.
+     *
+     * A true reservoir would replace samples already taken, which is not
+     * possible once the metrics are out. Instead, the calls are sampled with
+     * probability K / (calls of the previous window), so that the K samples
+     * are uniformly spread over a window with a steady rate, and the bound
+     * is enforced by a counter. The first window samples the first K calls.
+     */
+    class ReservoirSampler : public WindowedSampler
+    {
+    private:
+        uint64_t              m_size;         // K, samples per window
+        std::atomic<uint64_t> m_accepted = 0; // Samples in the current window
+
+    protected:
+        bool sample( uint64_t call ) override;
+        void onWindow( uint64_t calls, int64_t elapsed ) override;
+
+    public:
+        ReservoirSampler( uint64_t size, std::chrono::nanoseconds window );
+    };
+
+    /**
+     * @class AdaptiveSampler
+     *
+     * @brief Samples as many calls as an overhead budget allows.
+     *
+     * The collectors sampled by this policy measure their own cost (the
+     * time spent in creation, collect and destruction). At the end of each
+     * window the probability is set so that, with the same call rate, the
+     * sampled scopes cost the given fraction of the window:
+     *
+     *    p = budget * window / ( calls * average cost )
+     *
+     * The budget is a fraction of the wall-clock time of a single thread,
+     * e.g., 0.01 keeps the overhead of the call site around 1%.
+     */
+    class AdaptiveSampler : public WindowedSampler
+    {
+    private:
+        double m_budget;
+        double m_minProbability;
+
+        std::atomic<uint64_t> m_cost        = 0;   // Total cost in the window
+        std::atomic<uint64_t> m_costCount   = 0;   // Sampled scopes in the window
+        std::atomic<double>   m_averageCost = 0.0; // Of the last window with samples
+
+    protected:
+        bool sample( uint64_t call ) override;
+        void onWindow( uint64_t calls, int64_t elapsed ) override;
+
+    public:
+        /**
+         * @param budget Fraction of the time the instrumentation may take
+         * @param window How often the probability is adjusted
+         * @param min_probability Lower bound, so the call site never goes dark
+         */
+        explicit AdaptiveSampler( double budget = 0.01,
+                                  std::chrono::nanoseconds window = std::chrono::milliseconds( 100 ),
+                                  double min_probability = 1e-6 );
+
+        bool needsCost() const override;
+        void record( uint64_t cost ) override;
+
+        double getAverageCost() const; // Average cost of a sampled scope in ns
+    };
+}
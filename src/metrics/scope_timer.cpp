@@ -0,0 +1,117 @@
+#include "scope_timer.hpp"
+#include <metrics/metrics_broker.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+using namespace ccl::metrics;
+
+// Call sites per chunk of the registry
+static constexpr uint32_t SITES_PER_CHUNK = 1024;
+
+/**
+ * Storage of the registry. Chunks are allocated on demand and published
+ * before the size, so a reader holding an id always finds its chunk.
+ */
+struct CallSiteStorage
+{
+    std::mutex            m_mutex;
+    std::atomic<uint32_t> m_size = 0;
+
+    std::array<std::atomic<CallSite*>, CallSiteRegistry::MAX_SITES / SITES_PER_CHUNK> m_chunks {};
+};
+
+static CallSiteStorage& storage()
+{
+    // Never destroyed, so the sites can be resolved until the very end
+    static CallSiteStorage* storage = new CallSiteStorage();
+    return *storage;
+}
+
+uint32_t CallSiteRegistry::intern(std::string name, const char *file, uint32_t line)
+{
+    CallSiteStorage& sites = storage();
+    std::lock_guard<std::mutex> _l( sites.m_mutex );
+
+    uint32_t index = sites.m_size.load( std::memory_order_relaxed );
+    if ( index >= MAX_SITES )
+    {
+        std::stringstream ss;
+        ss << "[CallSiteRegistry] Too many call sites, the maximum is " << MAX_SITES;
+        throw std::length_error( ss.str() );
+    }
+
+    auto& chunk = sites.m_chunks[ index / SITES_PER_CHUNK ];
+    if ( chunk.load( std::memory_order_relaxed ) == nullptr )
+    {
+        chunk.store( new CallSite[ SITES_PER_CHUNK ], std::memory_order_release );
+    }
+
+    uint32_t id = index + 1;
+    chunk.load( std::memory_order_relaxed )[ index % SITES_PER_CHUNK ] = { std::move( name ), file, line, id };
+
+    sites.m_size.store( id, std::memory_order_release );
+    return id;
+}
+
+const CallSite &CallSiteRegistry::get(uint32_t id)
+{
+    CallSiteStorage& sites = storage();
+
+    if ( id == 0 || id > sites.m_size.load( std::memory_order_acquire ) )
+    {
+        std::stringstream ss;
+        ss << "[CallSiteRegistry] Unknown call site id " << id;
+        throw std::out_of_range( ss.str() );
+    }
+
+    uint32_t index = id - 1;
+    return sites.m_chunks[ index / SITES_PER_CHUNK ].load( std::memory_order_acquire )[ index % SITES_PER_CHUNK ];
+}
+
+uint32_t CallSiteRegistry::size()
+{
+    return storage().m_size.load( std::memory_order_acquire );
+}
+
+// Call site of the innermost active timer of the thread
+static thread_local uint32_t t_current = 0;
+
+static int64_t steady_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+ScopeTimer::ScopeTimer(uint32_t site)
+    : m_site( 0 ), m_parent( 0 ), m_start( 0 )
+{
+    if ( !MetricsBroker::isEnabled() ) return;
+
+    m_site = site;
+    m_parent = t_current;
+    t_current = site;
+
+    // Last, so that the bookkeeping is not measured
+    m_start = steady_ns();
+}
+
+ScopeTimer::~ScopeTimer()
+{
+    if ( m_site == 0 ) return;
+
+    int64_t end = steady_ns();
+    t_current = m_parent;
+
+    MetricsBroker::instance().getSink().push(
+        ScopeRecord { m_site, m_parent, get_thread_id(), m_start, end } );
+}
+
+uint32_t ScopeTimer::current()
+{
+    return t_current;
+}
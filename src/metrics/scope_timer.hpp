@@ -0,0 +1,143 @@
+#pragma once
+
+#include <metrics/metrics_gather.hpp>
+#include <patterns/pub_sub/event.hpp>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ccl::metrics
+{
+    /**
+     * @brief Static description of an instrumented scope, registered once
+     * per call site by CCL_SCOPE_TIMER.
+     */
+    struct CallSite
+    {
+        std::string m_name; // Qualified function name, or the given one
+        const char* m_file; // Source file, as given by __FILE__
+        uint32_t    m_line; // Line of the timer
+        uint32_t    m_id;   // Interned id, never 0
+    };
+
+    /**
+     * @class CallSiteRegistry
+     *
+     * @brief Process-wide table of the call sites, mapping their interned
+     * ids back to their description.
+     *
+     * Registration takes a lock, and is meant to happen once per call site
+     * (the macros keep the id in a static variable). Looking up an id never
+     * locks: the sites are stored in chunks that are never moved nor freed,
+     * so the references returned by get remain valid until the process exits.
+     */
+    class CallSiteRegistry
+    {
+    public:
+        // Maximum number of call sites, ids go from 1 to MAX_SITES
+        static constexpr uint32_t MAX_SITES = 1u << 20;
+
+        /**
+         * @brief Register a new call site and returns its id.
+         * @throws std::length_error Once MAX_SITES sites are registered
+         */
+        static uint32_t intern( std::string name, const char* file, uint32_t line );
+
+        /**
+         * @brief Returns the call site with the given id.
+         * @throws std::out_of_range If the id has not been registered
+         */
+        static const CallSite& get( uint32_t id );
+
+        /* Returns the number of registered call sites */
+        static uint32_t size();
+    };
+
+    /**
+     * @brief A finished scope, as it travels through the metrics pipeline:
+     * the names are resolved by the consumers through the CallSiteRegistry.
+     * Timestamps are steady clock nanoseconds.
+     */
+    struct ScopeRecord
+    {
+        uint32_t m_site      = 0; // Call site of the scope
+        uint32_t m_parent    = 0; // Call site of the enclosing scope, 0 if none
+        TID_t    m_thread_id = 0; // Thread of the scope
+        int64_t  m_start     = 0; // Entry time
+        int64_t  m_end       = 0; // Exit time
+    };
+
+    static_assert( sizeof( ScopeRecord ) <= 32, "ScopeRecord must fit half a cache line" );
+
+    /**
+     * @class ScopeBatchEvent
+     *
+     * @brief Consecutive scopes of a single thread, in the order they have
+     * finished, delivered at once by the MetricsSink.
+     */
+    class ScopeBatchEvent : public ccl::dp::pub_sub::PubSubEvent
+    {
+    public:
+        std::vector<ScopeRecord> m_records;
+
+        explicit ScopeBatchEvent( std::vector<ScopeRecord> records )
+        : m_records( std::move( records ) )
+        {}
+
+        inline std::string name() const override
+        {
+            return "ScopeBatchEvent(" + std::to_string( m_records.size() ) + ")";
+        }
+    };
+
+    /**
+     * @class ScopeTimer
+     *
+     * @brief Lightweight alternative to the MetricsCollector, timing the
+     * scope it lives in. Use it through CCL_SCOPE_TIMER.
+     *
+     * The timer only reads the steady clock at construction and destruction,
+     * and stages a ScopeRecord in the MetricsSink of the MetricsBroker, which
+     * delivers them in ScopeBatchEvents: no name is parsed, copied nor
+     * allocated per call, whatever the MetricsDelivery. The parent of a
+     * timer is the closest enclosing timer of the same thread; timers and
+     * collectors do not see each other.
+     *
+     * Nothing is measured while the collection is disabled (see
+     * MetricsBroker::setEnabled).
+     */
+    class ScopeTimer
+    {
+    private:
+        uint32_t m_site;   // 0 when disabled
+        uint32_t m_parent;
+        int64_t  m_start;
+
+    public:
+        explicit ScopeTimer( uint32_t site );
+        ~ScopeTimer();
+
+        ScopeTimer( const ScopeTimer& ) = delete;
+        ScopeTimer& operator=( const ScopeTimer& ) = delete;
+
+        /* Returns the call site of the innermost active timer of the thread, 0 if none */
+        static uint32_t current();
+    };
+}
+
+#define CCL_SCOPE_TIMER_CONCAT_( a, b ) a##b
+#define CCL_SCOPE_TIMER_CONCAT( a, b ) CCL_SCOPE_TIMER_CONCAT_( a, b )
+
+/**
+ * Time the enclosing scope under the given name. The call site is
+ * registered the first time the line is executed.
+ */
+#define CCL_SCOPE_TIMER_NAMED( name )                                                        \
+    static const uint32_t CCL_SCOPE_TIMER_CONCAT( ccl_scope_site_, __LINE__ ) =              \
+        ccl::metrics::CallSiteRegistry::intern( name, __FILE__, __LINE__ );                 \
+    ccl::metrics::ScopeTimer CCL_SCOPE_TIMER_CONCAT( ccl_scope_timer_, __LINE__ )(           \
+        CCL_SCOPE_TIMER_CONCAT( ccl_scope_site_, __LINE__ ) )
+
+/* Time the enclosing scope under the qualified name of the function (see __FUNCNAME__) */
+#define CCL_SCOPE_TIMER() CCL_SCOPE_TIMER_NAMED( __FUNCNAME__() )
@@ -1,33 +1,145 @@
 #include "broker.hpp"
+#include <array>
 
-void ccl::dp::pub_sub::PubSubBroker::notifySubscribers(event_ptr event)
+using namespace ccl::dp::pub_sub;
+
+/**
+ * Snapshots of the shards of the last broker used by a thread, each valid
+ * as long as the version of its shard does not change. While notifying,
+ * the snapshots must not be replaced, so the nested publications load
+ * their own.
+ */
+struct PubSubBroker::SnapshotCache
+{
+    struct Entry
+    {
+        uint64_t     m_version = 0;
+        snapshot_ptr m_snapshot;
+    };
+
+    uint64_t                  m_broker = 0;
+    std::array<Entry, SHARDS> m_shards;
+    int                       m_depth  = 0; // Nesting of notifySubscribers
+};
+
+static uint64_t next_broker_id()
+{
+    static std::atomic<uint64_t> counter = 0;
+    return counter.fetch_add( 1, std::memory_order_relaxed ) + 1;
+}
+
+PubSubBroker::PubSubBroker()
+    : m_id( next_broker_id() )
+{}
+
+PubSubBroker::subscriber_map_t PubSubBroker::copySubscribers(const Shard &shard) const
+{
+    subscriber_map_t subscribers;
+
+    snapshot_ptr current = shard.m_subscribers.load( std::memory_order_acquire );
+    if ( current == nullptr ) return subscribers;
+
+    for ( const auto& [ key, collection ]: *current )
+    {
+        auto& copy = subscribers[key];
+        copy.reserve( collection.size() + 1 );
+
+        for ( const auto& tkn: collection )
+        {
+            if ( !tkn.expired() ) copy.push_back( tkn );
+        }
+
+        if ( copy.empty() ) subscribers.erase( key );
+    }
+
+    return subscribers;
+}
+
+void PubSubBroker::storeSubscribers(Shard &shard, subscriber_map_t &&subscribers)
+{
+    shard.m_subscribers.store( std::make_shared<const subscriber_map_t>( std::move( subscribers ) ),
+                               std::memory_order_release );
+
+    // After the store: a thread seeing the new version finds the new snapshot
+    shard.m_version.fetch_add( 1, std::memory_order_release );
+}
+
+void PubSubBroker::compact(Shard &shard)
 {
-    // First I need to lock for thread-safetiness
-    std::lock_guard<std::mutex> _l( m_mutex );
+    // Never wait: a change in progress compacts the subscribers anyway
+    std::unique_lock<std::mutex> _l( shard.m_mutex, std::try_to_lock );
+    if ( !_l.owns_lock() ) return;
+
+    storeSubscribers( shard, copySubscribers( shard ) );
+}
+
+void PubSubBroker::notifySubscribers(event_ptr event)
+{
+    static thread_local SnapshotCache cache;
 
     // In this case, the key of the subscriber map is directly taken
     // from the type of the input event
-    auto key = std::type_index( typeid(*event) );
+    const std::type_index type( typeid(*event) );
+    const size_t index = shardOf( type );
+    Shard& shard = m_shards[ index ];
 
-    if ( m_subscribers.find(key) != m_subscribers.end() )
+    // The snapshot is kept alive by the cache, or by the local reference
+    // when nested, even if replaced meanwhile: no lock is needed.
+    snapshot_ptr nested;
+    const subscriber_map_t* subscribers;
+
+    if ( cache.m_depth == 0 )
     {
-        auto& subscribers = m_subscribers[key];
-        
-        // Cycle for each subscriber and notify with the event, if the
-        // weak reference is not expired. In that case, the subscriber
-        // is removed.
-        auto vec_it = subscribers.begin();
-        while ( vec_it != subscribers.end() )
+        // Another broker: forget all the snapshots of the previous one. The
+        // version 0 of a shard has no snapshot, as the reset entries.
+        if ( cache.m_broker != m_id )
         {
-            if ( !vec_it->expired() )
-            {
-                auto sub_ptr = vec_it->lock();
-                sub_ptr->notify( event );
-                vec_it++;
-                continue;
-            }
-
-            vec_it = subscribers.erase(vec_it);
+            cache.m_shards = {};
+            cache.m_broker = m_id;
         }
+
+        auto& entry = cache.m_shards[ index ];
+        uint64_t version = shard.m_version.load( std::memory_order_acquire );
+        if ( entry.m_version != version )
+        {
+            entry.m_snapshot = shard.m_subscribers.load( std::memory_order_acquire );
+            entry.m_version = version;
+        }
+
+        subscribers = entry.m_snapshot.get();
     }
-}
\ No newline at end of file
+    else
+    {
+        nested = shard.m_subscribers.load( std::memory_order_acquire );
+        subscribers = nested.get();
+    }
+
+    if ( subscribers == nullptr ) return;
+
+    auto it = subscribers->find( type );
+    if ( it == subscribers->end() ) return;
+
+    // Keeps the cache untouched until the end of the loop, even on exceptions
+    struct DepthGuard
+    {
+        int& m_depth;
+        explicit DepthGuard( int& depth ) : m_depth( depth ) { ++m_depth; }
+        ~DepthGuard() { --m_depth; }
+    } _guard( cache.m_depth );
+
+    // Notify each subscriber whose weak reference is not expired. The
+    // expired ones are removed afterwards, from a new snapshot.
+    bool expired = false;
+    for ( const auto& tkn: it->second )
+    {
+        if ( auto sub_ptr = tkn.lock() )
+        {
+            sub_ptr->notify( event );
+            continue;
+        }
+
+        expired = true;
+    }
+
+    if ( expired ) compact( shard );
+}
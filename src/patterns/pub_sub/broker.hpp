@@ -1,12 +1,17 @@
 #pragma once
 
+#include <data_structures/base/cache_line.hpp>
 #include <patterns/pub_sub/subscriber.hpp>
 #include <patterns/pub_sub/publisher.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <mutex>
 #include <typeindex>
 #include <unordered_map>
 #include <type_traits>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace ccl::dp::pub_sub
@@ -26,28 +31,75 @@ namespace ccl::dp::pub_sub
      * - Automatically clean up expired subscribers (weak pointers that are no longer valid).
      *
      * Thread-safety:
-     * - All public operations (subscribe, unsubscribe, notifySubscribers) are protected by a mutex.
+     * - The event types are spread over SHARDS shards, by the hash of their
+     *   type. The subscriptions of a shard live in an immutable snapshot,
+     *   replaced as a whole (copy-on-write) by subscribe and unsubscribe,
+     *   which are serialized by the mutex of the shard.
+     * - notifySubscribers never locks, hence publishers on different threads
+     *   do not wait for each other nor for slow subscribers. Each thread
+     *   keeps the last snapshot it used of each shard, and only loads it
+     *   again once the version of the shard changes: publishers only see
+     *   the subscriptions to the event types of their own shard. A
+     *   Subscriber can therefore be notified concurrently, and may still
+     *   receive the events published while it is being unsubscribed.
+     * - Expired subscribers are compacted lazily, by the publisher finding
+     *   them if no subscription is in progress, or by the next subscription
+     *   in the same shard.
      *
      * Type-based dispatch:
      * - Events are delivered only to subscribers that registered for the runtime type of the event.
      */
     class PubSubBroker
     {
+    public:
+        static constexpr size_t SHARDS = 16; // Number of shards of the event types
+
     protected:
         using subscriber_ptr = std::shared_ptr<Subscriber>;
         using subscriber_life_tkn = std::weak_ptr<Subscriber>;
         using collection = std::vector<subscriber_life_tkn>;
         using subscriber_map_t = std::unordered_map<std::type_index, collection>;
+        using snapshot_ptr = std::shared_ptr<const subscriber_map_t>;
         using event_ptr = std::shared_ptr<const PubSubEvent>;
 
         /**
-         * This map contains all the subscribers of this broker, categorized
-         * based on event preferences.
+         * The subscribers of the event types of a shard. The map is never
+         * modified once published: every change stores a new copy. Shards
+         * are aligned so that publishers of different shards do not share
+         * a cache line.
+         */
+        struct alignas( ds::base::CACHE_LINE_SIZE ) Shard
+        {
+            std::atomic<snapshot_ptr> m_subscribers;
+            std::atomic<uint64_t>     m_version = 0; // Bumped after each new snapshot
+            std::mutex                m_mutex;       // Serializes the changes of the snapshot
+        };
+
+        std::array<Shard, SHARDS> m_shards;
+
+        /* Returns the index of the shard of the event type */
+        static size_t shardOf( const std::type_index& type );
+
+        /**
+         * @brief Returns a copy of the current subscriptions of the shard,
+         * without the expired subscribers, to be modified and published
+         * with store. Requires the mutex of the shard to be held.
          */
-        subscriber_map_t m_subscribers;
-        std::mutex       m_mutex; // To ensure thread-safetiness
+        subscriber_map_t copySubscribers( const Shard& shard ) const;
+
+        /* Publish the new subscriptions. Requires the mutex of the shard to be held. */
+        void storeSubscribers( Shard& shard, subscriber_map_t&& subscribers );
+
+        /* Drop the expired subscribers of the shard, unless a change is in progress */
+        void compact( Shard& shard );
+
+    private:
+        struct SnapshotCache; // The last snapshots used by the calling thread
+
+        const uint64_t m_id; // Identifies the broker in the thread-local caches
 
     public:
+        PubSubBroker();
         virtual ~PubSubBroker() = default;
 
         /**
@@ -73,40 +125,56 @@ namespace ccl::dp::pub_sub
         void notifySubscribers( event_ptr event );
     };
 
+    inline size_t PubSubBroker::shardOf(const std::type_index &type)
+    {
+        return type.hash_code() % SHARDS;
+    }
+
     template <typename... Events>
     inline void PubSubBroker::subscribe(const subscriber_ptr &subscriber)
     {
-        std::lock_guard<std::mutex> _l( m_mutex );
-        
-        // Fold expression to handle all event types
-        (m_subscribers[std::type_index(typeid(Events))].push_back(subscriber), ...);
+        // Fold expression to handle all event types, one shard at a time
+        (([this, &subscriber]()
+          {
+            const std::type_index type( typeid(Events) );
+            Shard& shard = m_shards[ shardOf( type ) ];
+
+            std::lock_guard<std::mutex> _l( shard.m_mutex );
+
+            subscriber_map_t subscribers = copySubscribers( shard );
+            subscribers[type].push_back( subscriber );
+            storeSubscribers( shard, std::move( subscribers ) );
+          }
+        )(), ...);
     }
 
     template <typename... Events>
     inline void PubSubBroker::unsubscribe(const subscriber_ptr &subscriber)
     {
-        std::lock_guard<std::mutex> _l( m_mutex );
-
-        // Fold expression to handle unsubscribes
+        // Fold expression to handle unsubscribes, one shard at a time
         (([this, &subscriber]()
           {
+            const std::type_index type( typeid(Events) );
+            Shard& shard = m_shards[ shardOf( type ) ];
+
+            std::lock_guard<std::mutex> _l( shard.m_mutex );
+
+            // The expired subscribers are already gone from the copy
+            subscriber_map_t subscribers = copySubscribers( shard );
+
             // If the key exists
-            auto key = std::type_index(typeid(Events));
-            if ( m_subscribers.find( key ) != m_subscribers.end() )
+            auto it = subscribers.find( type );
+            if ( it != subscribers.end() )
             {
-                collection& vec = m_subscribers[key];
-
-                // This will remove all expired subscribers and also
-                // the one given to the unsubscribe function.
-                vec.erase(std::remove_if(
-                    vec.begin(), vec.end(),
-                    [&subscriber]( const subscriber_life_tkn& tkn )
-                    {
-                        auto ptr = tkn.lock();
-                        return !ptr || ( ptr == subscriber );
-                    }
-                ));
+                std::erase_if( it->second, [&subscriber]( const subscriber_life_tkn& tkn )
+                {
+                    return tkn.lock() == subscriber;
+                });
+
+                if ( it->second.empty() ) subscribers.erase( it );
             }
+
+            storeSubscribers( shard, std::move( subscribers ) );
           }
         )(), ...);
     }
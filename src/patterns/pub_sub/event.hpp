@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <memory>
 
@@ -20,6 +21,12 @@ namespace ccl::dp::pub_sub
         /* Returns the name of the event */
         virtual std::string name() const = 0;
 
+        /* Returns the priority of the event, the lane of the AsyncSubscribers */
+        inline virtual size_t priority() const
+        {
+            return 0; // Bulk events
+        }
+
         /* Clone the current event to generate a mutable reference */
         inline virtual std::unique_ptr<PubSubEvent> clone() const
         {
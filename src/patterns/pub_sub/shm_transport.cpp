@@ -0,0 +1,564 @@
+#include "shm_transport.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace ccl::dp::pub_sub;
+
+/**
+ * The shared state of the ring. Every field is accessed by several
+ * processes, hence the atomics must be lock-free (address-free).
+ */
+struct ShmRing::Header
+{
+    uint32_t m_magic;
+    uint32_t m_version;
+    uint64_t m_capacity;
+
+    alignas( 64 ) std::atomic<uint64_t> m_tail;    // Reserved by the producers
+    alignas( 64 ) std::atomic<uint64_t> m_head;    // Consumed by the reader
+
+    alignas( 64 ) std::atomic<uint32_t> m_dataSeq; // Futex of the reader
+    std::atomic<uint32_t> m_readerWaiting;
+
+    alignas( 64 ) std::atomic<uint32_t> m_spaceSeq; // Futex of the producers
+    std::atomic<uint32_t> m_producersWaiting;
+    std::atomic<uint32_t> m_closed;
+};
+
+/**
+ * A record is committed once its size has the COMMITTED bit. Sizes are
+ * aligned to 8 bytes, as the records.
+ */
+struct ShmRing::RecordHeader
+{
+    static constexpr uint32_t COMMITTED = 1u << 31;
+
+    std::atomic<uint32_t> m_size; // Payload size | COMMITTED, 0 while free
+    uint32_t              m_type;
+};
+
+static_assert( std::atomic<uint64_t>::is_always_lock_free, "ShmRing needs lock-free 64 bit atomics" );
+static_assert( std::atomic<uint32_t>::is_always_lock_free, "ShmRing needs lock-free 32 bit atomics" );
+static_assert( sizeof( std::atomic<uint32_t> ) == sizeof( uint32_t ), "Futex words must be plain integers" );
+
+static constexpr size_t RECORD_ALIGN = 8;
+
+static size_t record_length( size_t size )
+{
+    size_t length = sizeof( uint64_t ) + size;
+    return ( length + RECORD_ALIGN - 1 ) & ~( RECORD_ALIGN - 1 );
+}
+
+// The data starts after the header, on a cache line of its own
+static constexpr size_t DATA_OFFSET = 512;
+
+#ifndef _WIN32
+
+static void throw_errno( const std::string& what )
+{
+    std::stringstream ss;
+    ss << "[ShmRing] " << what << ": " << std::strerror( errno );
+    throw std::runtime_error( ss.str() );
+}
+
+static void futex_wait( std::atomic<uint32_t>& word, uint32_t expected, std::chrono::milliseconds timeout )
+{
+    struct timespec ts;
+    struct timespec* tsp = nullptr;
+
+    if ( timeout != std::chrono::milliseconds::max() )
+    {
+        ts.tv_sec  = timeout.count() / 1000;
+        ts.tv_nsec = ( timeout.count() % 1000 ) * 1000000;
+        tsp = &ts;
+    }
+
+    // Shared futex: the waker may live in another process
+    syscall( SYS_futex, reinterpret_cast<uint32_t*>( &word ), FUTEX_WAIT, expected, tsp, nullptr, 0 );
+}
+
+static void futex_wake( std::atomic<uint32_t>& word, int count )
+{
+    syscall( SYS_futex, reinterpret_cast<uint32_t*>( &word ), FUTEX_WAKE, count, nullptr, nullptr, 0 );
+}
+
+#endif
+
+static size_t round_capacity( size_t capacity )
+{
+    size_t rounded = 64;
+    while ( rounded < capacity ) rounded <<= 1;
+    return rounded;
+}
+
+ShmRing::ShmRing(size_t capacity)
+{
+#ifndef _WIN32
+    m_fd = memfd_create( "ccl_shm_ring", MFD_CLOEXEC );
+    if ( m_fd < 0 ) throw_errno( "memfd_create" );
+
+    init( capacity );
+#else
+    // Windows Implementation
+#endif
+}
+
+ShmRing::ShmRing(const std::string &path, size_t capacity)
+{
+#ifndef _WIN32
+    m_fd = open( path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600 );
+    if ( m_fd < 0 ) throw_errno( "open " + path );
+
+    init( capacity );
+#else
+    // Windows Implementation
+#endif
+}
+
+ShmRing::ShmRing(const std::string &path)
+{
+#ifndef _WIN32
+    m_fd = open( path.c_str(), O_RDWR | O_CLOEXEC );
+    if ( m_fd < 0 ) throw_errno( "open " + path );
+
+    struct stat st;
+    if ( fstat( m_fd, &st ) < 0 )
+    {
+        ::close( m_fd );
+        throw_errno( "fstat " + path );
+    }
+
+    if ( static_cast<size_t>( st.st_size ) < DATA_OFFSET )
+    {
+        ::close( m_fd );
+        throw std::runtime_error( "[ShmRing] Not a ring: " + path );
+    }
+
+    map( static_cast<size_t>( st.st_size ) );
+
+    if ( m_header->m_magic != MAGIC || m_header->m_version != VERSION ||
+         DATA_OFFSET + m_header->m_capacity != m_length )
+    {
+        munmap( m_mapping, m_length );
+        ::close( m_fd );
+        throw std::runtime_error( "[ShmRing] Not a ring: " + path );
+    }
+
+    m_mask = m_header->m_capacity - 1;
+#else
+    // Windows Implementation
+#endif
+}
+
+ShmRing::~ShmRing()
+{
+#ifndef _WIN32
+    if ( m_mapping != nullptr ) munmap( m_mapping, m_length );
+    if ( m_fd >= 0 ) ::close( m_fd );
+#else
+    // Windows Implementation
+#endif
+}
+
+void ShmRing::map(size_t length)
+{
+#ifndef _WIN32
+    m_length  = length;
+    m_mapping = mmap( nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0 );
+    if ( m_mapping == MAP_FAILED )
+    {
+        m_mapping = nullptr;
+        ::close( m_fd );
+        throw_errno( "mmap" );
+    }
+
+    m_header = static_cast<Header*>( m_mapping );
+    m_data   = static_cast<unsigned char*>( m_mapping ) + DATA_OFFSET;
+#else
+    // Windows Implementation
+#endif
+}
+
+void ShmRing::init(size_t capacity)
+{
+    static_assert( sizeof( Header ) <= DATA_OFFSET, "The header of the ShmRing overlaps its data" );
+
+#ifndef _WIN32
+    capacity = round_capacity( capacity );
+
+    // The new pages are zeroed: every record is free
+    if ( ftruncate( m_fd, static_cast<off_t>( DATA_OFFSET + capacity ) ) < 0 )
+    {
+        ::close( m_fd );
+        throw_errno( "ftruncate" );
+    }
+
+    map( DATA_OFFSET + capacity );
+
+    new ( m_header ) Header {};
+    m_header->m_capacity = capacity;
+    m_header->m_version  = VERSION;
+    m_mask = capacity - 1;
+    m_header->m_magic = MAGIC;
+#else
+    // Windows Implementation
+#endif
+}
+
+size_t ShmRing::capacity() const
+{
+    return m_mask + 1;
+}
+
+size_t ShmRing::maxRecordSize() const
+{
+    // Leaves room for the padding in front of the record, and for the
+    // committed bit of the size
+    return std::min<size_t>( capacity() / 2, RecordHeader::COMMITTED ) - sizeof( uint64_t );
+}
+
+int ShmRing::getFd() const
+{
+    return m_fd;
+}
+
+ShmRing::RecordHeader *ShmRing::recordAt(uint64_t position) const
+{
+    return reinterpret_cast<RecordHeader*>( m_data + ( position & m_mask ) );
+}
+
+bool ShmRing::tryCommit(uint32_t type, const unsigned char *data, size_t size)
+{
+    const uint64_t cap    = capacity();
+    const uint64_t length = record_length( size );
+
+    uint64_t tail = m_header->m_tail.load( std::memory_order_relaxed );
+    uint64_t offset, total;
+
+    while ( true )
+    {
+        offset = tail & m_mask;
+
+        // Never across the end: the room left becomes a padding record
+        total = offset + length > cap ? ( cap - offset ) + length : length;
+
+        uint64_t head = m_header->m_head.load( std::memory_order_acquire );
+        if ( tail + total - head > cap ) return false;
+
+        if ( m_header->m_tail.compare_exchange_weak( tail, tail + total,
+                std::memory_order_acq_rel, std::memory_order_relaxed ) )
+        {
+            break;
+        }
+    }
+
+    if ( total != length )
+    {
+        RecordHeader* pad = recordAt( tail );
+        pad->m_type = PAD_TYPE;
+        pad->m_size.store( static_cast<uint32_t>( cap - offset - sizeof( uint64_t ) ) | RecordHeader::COMMITTED,
+                           std::memory_order_release );
+        tail += cap - offset;
+    }
+
+    RecordHeader* record = recordAt( tail );
+    std::memcpy( reinterpret_cast<unsigned char*>( record ) + sizeof( uint64_t ), data, size );
+    record->m_type = type;
+
+    // Sequentially consistent with the check of the waiting flag below
+    record->m_size.store( static_cast<uint32_t>( size ) | RecordHeader::COMMITTED, std::memory_order_seq_cst );
+
+#ifndef _WIN32
+    if ( m_header->m_readerWaiting.load( std::memory_order_seq_cst ) != 0 )
+    {
+        m_header->m_dataSeq.fetch_add( 1, std::memory_order_seq_cst );
+        futex_wake( m_header->m_dataSeq, 1 );
+    }
+#endif
+
+    return true;
+}
+
+bool ShmRing::tryWrite(uint32_t type, const unsigned char *data, size_t size)
+{
+    if ( size > maxRecordSize() || type == PAD_TYPE )
+    {
+        std::stringstream ss;
+        ss << "[ShmRing] Invalid record of type " << type << " and size " << size
+           << ", the maximum is " << maxRecordSize();
+        throw std::invalid_argument( ss.str() );
+    }
+
+    if ( isClosed() ) return false;
+    return tryCommit( type, data, size );
+}
+
+bool ShmRing::write(uint32_t type, const unsigned char *data, size_t size, std::chrono::milliseconds timeout)
+{
+    using clock = std::chrono::steady_clock;
+    const bool forever = timeout == std::chrono::milliseconds::max();
+    const auto deadline = forever ? clock::time_point::max() : clock::now() + timeout;
+
+    while ( true )
+    {
+        if ( tryWrite( type, data, size ) ) return true;
+        if ( isClosed() ) return false;
+
+#ifndef _WIN32
+        uint32_t seq = m_header->m_spaceSeq.load( std::memory_order_seq_cst );
+        m_header->m_producersWaiting.fetch_add( 1, std::memory_order_seq_cst );
+
+        // The reader may have freed the room meanwhile, without waking us
+        bool written = tryWrite( type, data, size );
+        if ( !written && !isClosed() )
+        {
+            auto left = forever ? std::chrono::milliseconds::max()
+                                : std::chrono::duration_cast<std::chrono::milliseconds>( deadline - clock::now() );
+
+            if ( left.count() > 0 ) futex_wait( m_header->m_spaceSeq, seq, left );
+        }
+
+        m_header->m_producersWaiting.fetch_sub( 1, std::memory_order_seq_cst );
+        if ( written ) return true;
+#else
+        // Windows Implementation
+#endif
+
+        if ( !forever && clock::now() >= deadline ) return tryWrite( type, data, size );
+    }
+}
+
+size_t ShmRing::read(const std::function<void( uint32_t, const unsigned char*, size_t )> &handler, size_t max)
+{
+    uint64_t head = m_header->m_head.load( std::memory_order_relaxed );
+    size_t count = 0;
+
+    while ( count < max )
+    {
+        RecordHeader* record = recordAt( head );
+        uint32_t size = record->m_size.load( std::memory_order_acquire );
+        if ( ( size & RecordHeader::COMMITTED ) == 0 ) break;
+
+        size &= ~RecordHeader::COMMITTED;
+        uint32_t type = record->m_type;
+        size_t length = record_length( size );
+
+        if ( type != PAD_TYPE )
+        {
+            handler( type, reinterpret_cast<unsigned char*>( record ) + sizeof( uint64_t ), size );
+            ++count;
+        }
+
+        // Free again for the producers, which only see it with the new head
+        std::memset( static_cast<void*>( record ), 0, length );
+        head += length;
+        m_header->m_head.store( head, std::memory_order_seq_cst );
+    }
+
+#ifndef _WIN32
+    if ( m_header->m_producersWaiting.load( std::memory_order_seq_cst ) != 0 )
+    {
+        m_header->m_spaceSeq.fetch_add( 1, std::memory_order_seq_cst );
+        futex_wake( m_header->m_spaceSeq, INT_MAX );
+    }
+#endif
+
+    return count;
+}
+
+bool ShmRing::wait(std::chrono::milliseconds timeout)
+{
+    auto readable = [this]
+    {
+        uint64_t head = m_header->m_head.load( std::memory_order_relaxed );
+        return ( recordAt( head )->m_size.load( std::memory_order_seq_cst ) & RecordHeader::COMMITTED ) != 0;
+    };
+
+#ifndef _WIN32
+    uint32_t seq = m_header->m_dataSeq.load( std::memory_order_seq_cst );
+    m_header->m_readerWaiting.store( 1, std::memory_order_seq_cst );
+
+    if ( !readable() && !isClosed() ) futex_wait( m_header->m_dataSeq, seq, timeout );
+
+    m_header->m_readerWaiting.store( 0, std::memory_order_relaxed );
+#else
+    // Windows Implementation
+#endif
+
+    return readable();
+}
+
+void ShmRing::wake()
+{
+#ifndef _WIN32
+    m_header->m_dataSeq.fetch_add( 1, std::memory_order_seq_cst );
+    futex_wake( m_header->m_dataSeq, INT_MAX );
+#else
+    // Windows Implementation
+#endif
+}
+
+void ShmRing::close()
+{
+    m_header->m_closed.store( 1, std::memory_order_seq_cst );
+
+#ifndef _WIN32
+    m_header->m_spaceSeq.fetch_add( 1, std::memory_order_seq_cst );
+    futex_wake( m_header->m_spaceSeq, INT_MAX );
+#endif
+
+    wake();
+}
+
+bool ShmRing::isClosed() const
+{
+    return m_header->m_closed.load( std::memory_order_acquire ) != 0;
+}
+
+bool ShmEventCodec::encode(const PubSubEvent &event, uint32_t &id, ds::buffers::ByteBuffer &buffer) const
+{
+    auto it = m_encoders.find( typeid(event) );
+    if ( it == m_encoders.end() ) return false;
+
+    id = it->second.first;
+    it->second.second( event, buffer );
+    return true;
+}
+
+ShmEventCodec::event_ptr ShmEventCodec::decode(uint32_t id, ds::buffers::ByteBuffer &buffer) const
+{
+    auto it = m_decoders.find( id );
+    if ( it == m_decoders.end() ) return nullptr;
+
+    return it->second( buffer );
+}
+
+ShmForwarder::ShmForwarder(const std::shared_ptr<ShmRing> &ring, const ShmEventCodec &codec,
+                           const ShmForwarderConfig &config)
+: m_ring( ring ), m_codec( codec ), m_config( config )
+{
+    if ( config.loss_policy == ds::LossPolicy::OVERWRITE_OLDEST )
+    {
+        throw std::invalid_argument( "OVERWRITE_OLDEST Loss policy is not available for ShmForwarder" );
+    }
+
+    m_config.max_event_size = std::min( config.max_event_size, ring->maxRecordSize() );
+}
+
+void ShmForwarder::notify(event_ptr &event)
+{
+    // Reused by all the forwarders of the thread, grown to the largest one
+    static thread_local ds::buffers::ByteBuffer buffer;
+    if ( buffer.getBufferCapacity() < m_config.max_event_size ) buffer.allocate( m_config.max_event_size );
+
+    buffer.reset();
+
+    uint32_t id;
+    bool encoded;
+
+    try
+    {
+        encoded = m_codec.encode( *event, id, buffer );
+    }
+    catch ( const std::overflow_error& )
+    {
+        encoded = false; // Larger than max_event_size
+    }
+
+    size_t size = buffer.position();
+    bool written = encoded && size <= m_config.max_event_size &&
+        ( m_config.loss_policy == ds::LossPolicy::BLOCK ? m_ring->write( id, buffer.getBuffer(), size )
+                                                         : m_ring->tryWrite( id, buffer.getBuffer(), size ) );
+
+    ( written ? m_forwarded : m_dropped ).fetch_add( 1, std::memory_order_relaxed );
+}
+
+uint64_t ShmForwarder::getForwarded() const
+{
+    return m_forwarded.load( std::memory_order_relaxed );
+}
+
+uint64_t ShmForwarder::getDropped() const
+{
+    return m_dropped.load( std::memory_order_relaxed );
+}
+
+ShmReceiver::ShmReceiver(const std::shared_ptr<ShmRing> &ring, const ShmEventCodec &codec,
+                         const std::shared_ptr<PubSubBroker> &broker)
+: Thread( "ShmReceiver", false, ccl::sys::concurrent::CancellationPolicy::AT_CONDITION_CHECK ),
+  m_ring( ring ), m_codec( codec ), m_publisher( broker )
+{}
+
+ShmReceiver::~ShmReceiver()
+{
+    stop();
+}
+
+void ShmReceiver::run()
+{
+    ds::buffers::ByteBuffer view;
+
+    auto handler = [this, &view]( uint32_t type, const unsigned char* data, size_t size )
+    {
+        // Read in place, the buffer does not own the record
+        view.setBuffer( const_cast<unsigned char*>( data ), size, false );
+        view.position( 0 );
+
+        std::shared_ptr<const PubSubEvent> event;
+        try
+        {
+            event = m_codec.decode( type, view );
+        }
+        catch ( const std::exception& )
+        {
+            event = nullptr; // Truncated or corrupted record
+        }
+
+        if ( event == nullptr )
+        {
+            m_unknown.fetch_add( 1, std::memory_order_relaxed );
+            return;
+        }
+
+        m_publisher.publish( event );
+        m_received.fetch_add( 1, std::memory_order_relaxed );
+    };
+
+    while ( !isCancelled() )
+    {
+        if ( m_ring->read( handler, 64 ) > 0 ) continue;
+        if ( m_ring->isClosed() && m_ring->read( handler ) == 0 ) break;
+
+        m_ring->wait( std::chrono::milliseconds( 100 ) );
+    }
+}
+
+void ShmReceiver::stop()
+{
+    cancel();
+    m_ring->wake();
+    join();
+}
+
+uint64_t ShmReceiver::getReceived() const
+{
+    return m_received.load( std::memory_order_relaxed );
+}
+
+uint64_t ShmReceiver::getUnknown() const
+{
+    return m_unknown.load( std::memory_order_relaxed );
+}
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <concurrent/thread.hpp>
+#include <data_structures/base/enum.hpp>
+#include <data_structures/buffers/byte_buffer.hpp>
+#include <patterns/pub_sub/broker.hpp>
+#include <patterns/pub_sub/event.hpp>
+#include <patterns/pub_sub/publisher.hpp>
+#include <patterns/pub_sub/subscriber.hpp>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+
+namespace ccl::dp::pub_sub
+{
+    /**
+     * @class ShmRing
+     *
+     * @brief Multi-producer single-consumer ring of records in a shared
+     * memory mapping, for events crossing process boundaries.
+     *
+     * The mapping holds a header followed by the data. Producers, in any
+     * process, reserve the room of a record by moving the tail with a CAS,
+     * copy it, and then commit it by setting its size. The consumer reads
+     * the committed records in order, zeroes them and moves the head. A
+     * record never wraps around the end of the data: the room left is
+     * skipped with a padding record. Producers and consumer only sleep on
+     * futexes (shared, not private, since the waiters may live in different
+     * processes), and are woken up only when the other side is sleeping.
+     *
+     * The ring lives in an anonymous memfd, shared with the forked children
+     * (or through getFd), or in a file, e.g., under /dev/shm, that other
+     * processes attach to by path. A producer dying between reserving and
+     * committing a record stops the consumer at that record.
+     */
+    class ShmRing
+    {
+    public:
+        static constexpr uint32_t MAGIC    = 0x43434c52; // "CCLR"
+        static constexpr uint32_t VERSION  = 1;
+        static constexpr uint32_t PAD_TYPE = 0xffffffff; // Type of the padding records
+
+    private:
+        struct Header;       // Shared state, at the start of the mapping
+        struct RecordHeader; // In front of each record
+
+        int            m_fd      = -1;
+        void*          m_mapping = nullptr;
+        size_t         m_length  = 0;       // Length of the mapping
+        Header*        m_header  = nullptr;
+        unsigned char* m_data    = nullptr; // Start of the ring
+        uint64_t       m_mask    = 0;
+
+        void map( size_t length );
+        void init( size_t capacity );
+
+        /* Reserve and fill a record, false if there is no room */
+        bool tryCommit( uint32_t type, const unsigned char* data, size_t size );
+
+        RecordHeader* recordAt( uint64_t position ) const;
+
+    public:
+        /**
+         * @brief Creates a ring in an anonymous memfd region
+         * @param capacity The size of the data in bytes, rounded up to a power of two
+         * @throws std::runtime_error If the region cannot be created
+         */
+        explicit ShmRing( size_t capacity );
+
+        /**
+         * @brief Creates a ring in the given file, truncated
+         * @param path The file, e.g., /dev/shm/name
+         * @param capacity The size of the data in bytes, rounded up to a power of two
+         * @throws std::runtime_error If the file cannot be created
+         */
+        ShmRing( const std::string& path, size_t capacity );
+
+        /**
+         * @brief Attach to the ring in the given file
+         * @throws std::runtime_error If the file does not contain a ring
+         */
+        explicit ShmRing( const std::string& path );
+
+        ShmRing( const ShmRing& ) = delete;
+        ShmRing& operator=( const ShmRing& ) = delete;
+
+        virtual ~ShmRing();
+
+        /* Returns the size of the data in bytes */
+        size_t capacity() const;
+
+        /* Returns the largest payload of a record */
+        size_t maxRecordSize() const;
+
+        /* Returns the file descriptor of the region */
+        int getFd() const;
+
+        /**
+         * @brief Append a record without waiting.
+         * @param type The type of the record, anything but PAD_TYPE
+         * @param data The payload
+         * @param size The size of the payload, up to maxRecordSize
+         * @return False if the ring is full or closed
+         * @throws std::invalid_argument If the record cannot fit the ring
+         */
+        bool tryWrite( uint32_t type, const unsigned char* data, size_t size );
+
+        /**
+         * @brief Append a record, sleeping while the ring is full.
+         * @return False if the ring is closed, or if the timeout expires
+         */
+        bool write( uint32_t type, const unsigned char* data, size_t size,
+                    std::chrono::milliseconds timeout = std::chrono::milliseconds::max() );
+
+        /**
+         * @brief Consume up to max committed records, in order. The payload
+         * is only valid during the call of the handler. Only one thread, of
+         * a single process, can read.
+         * @return The number of records consumed
+         */
+        size_t read( const std::function<void( uint32_t, const unsigned char*, size_t )>& handler,
+                     size_t max = SIZE_MAX );
+
+        /**
+         * @brief Sleep until a record is committed, the ring is closed, or
+         * wake is called. Only for the reading thread.
+         * @return True if a record can be read
+         */
+        bool wait( std::chrono::milliseconds timeout );
+
+        /* Wake up the reading thread, if sleeping */
+        void wake();
+
+        /* Refuse new records and wake up everybody. Records already written can be read. */
+        void close();
+
+        bool isClosed() const;
+    };
+
+    /**
+     * @brief An event that can cross processes: it writes itself into a
+     * ByteBuffer, and is rebuilt from it.
+     */
+    template <typename Event>
+    concept SerializableEvent = std::derived_from<Event, PubSubEvent>
+        && requires ( const Event& event, ds::buffers::ByteBuffer& buffer )
+    {
+        event.serialize( buffer );
+        { Event::deserialize( buffer ) } -> std::convertible_to<std::shared_ptr<const Event>>;
+    };
+
+    /**
+     * @class ShmEventCodec
+     *
+     * @brief Numbering and (de)serialization of the events crossing
+     * processes. Every process must register the same events with the same
+     * ids, before using the codec with ShmForwarders and ShmReceivers.
+     */
+    class ShmEventCodec
+    {
+    private:
+        using event_ptr = std::shared_ptr<const PubSubEvent>;
+        using encoder_t = std::function<void( const PubSubEvent&, ds::buffers::ByteBuffer& )>;
+        using decoder_t = std::function<event_ptr( ds::buffers::ByteBuffer& )>;
+
+        std::unordered_map<std::type_index, std::pair<uint32_t, encoder_t>> m_encoders;
+        std::unordered_map<uint32_t, decoder_t>                              m_decoders;
+
+    public:
+        /**
+         * @brief Register the event under the given id
+         * @throws std::invalid_argument If the id or the event is already registered
+         */
+        template <SerializableEvent Event>
+        void add( uint32_t id );
+
+        /**
+         * @brief Serialize the event into the buffer, and set its id
+         * @return False if the type of the event is not registered
+         */
+        bool encode( const PubSubEvent& event, uint32_t& id, ds::buffers::ByteBuffer& buffer ) const;
+
+        /* Rebuild the event with the given id, nullptr if not registered */
+        event_ptr decode( uint32_t id, ds::buffers::ByteBuffer& buffer ) const;
+    };
+
+    /**
+     * @brief Configuration of a ShmForwarder
+     */
+    struct ShmForwarderConfig
+    {
+        // Capacity of the buffer each publishing thread serializes into,
+        // larger events are dropped
+        size_t max_event_size = 64 * 1024;
+
+        // What to do when the ring is full: BLOCK waits for the reader,
+        // ERROR drops the event. OVERWRITE_OLDEST is not supported.
+        ds::LossPolicy loss_policy = ds::LossPolicy::BLOCK;
+    };
+
+    /**
+     * @class ShmForwarder
+     *
+     * @brief Subscriber writing the events it receives into a ShmRing, for
+     * a ShmReceiver in another process. Subscribe it to the events to
+     * forward: they are serialized on the thread of the publisher, into a
+     * thread-local ByteBuffer, and copied into the ring.
+     */
+    class ShmForwarder : public Subscriber
+    {
+    private:
+        std::shared_ptr<ShmRing> m_ring;
+        const ShmEventCodec&     m_codec;
+        ShmForwarderConfig       m_config;
+
+        std::atomic<uint64_t> m_forwarded = 0;
+        std::atomic<uint64_t> m_dropped   = 0;
+
+    protected:
+        void notify( event_ptr& event ) override;
+
+    public:
+        /**
+         * @throws std::invalid_argument With OVERWRITE_OLDEST
+         */
+        ShmForwarder( const std::shared_ptr<ShmRing>& ring, const ShmEventCodec& codec,
+                      const ShmForwarderConfig& config = {} );
+
+        /* Returns the number of events written into the ring */
+        uint64_t getForwarded() const;
+
+        /* Returns the number of events dropped: full ring, unknown or too large */
+        uint64_t getDropped() const;
+    };
+
+    /**
+     * @class ShmReceiver
+     *
+     * @brief Background thread reading the events of a ShmRing, written by
+     * ShmForwarders of other processes, and publishing them to a local
+     * broker, whose subscribers are notified on this thread.
+     */
+    class ShmReceiver : private ccl::sys::concurrent::Thread
+    {
+    private:
+        std::shared_ptr<ShmRing> m_ring;
+        const ShmEventCodec&     m_codec;
+        Publisher                m_publisher;
+
+        std::atomic<uint64_t> m_received = 0;
+        std::atomic<uint64_t> m_unknown  = 0; // Records of unregistered events
+
+        void run() override;
+
+    public:
+        ShmReceiver( const std::shared_ptr<ShmRing>& ring, const ShmEventCodec& codec,
+                     const std::shared_ptr<PubSubBroker>& broker );
+
+        /* Stops the thread */
+        virtual ~ShmReceiver();
+
+        using Thread::start;
+
+        /* Stop reading, the records left stay in the ring */
+        void stop();
+
+        /* Returns the number of events published to the broker */
+        uint64_t getReceived() const;
+
+        /* Returns the number of records of unknown events, skipped */
+        uint64_t getUnknown() const;
+    };
+
+    template <SerializableEvent Event>
+    inline void ShmEventCodec::add(uint32_t id)
+    {
+        if ( id == ShmRing::PAD_TYPE || m_decoders.count( id ) > 0 || m_encoders.count( typeid(Event) ) > 0 )
+        {
+            throw std::invalid_argument( "[ShmEventCodec] Event or id already registered: " + std::to_string( id ) );
+        }
+
+        m_encoders.emplace( typeid(Event), std::make_pair( id,
+            []( const PubSubEvent& event, ds::buffers::ByteBuffer& buffer )
+            {
+                static_cast<const Event&>( event ).serialize( buffer );
+            }));
+
+        m_decoders.emplace( id, []( ds::buffers::ByteBuffer& buffer ) -> event_ptr
+        {
+            return Event::deserialize( buffer );
+        });
+    }
+}
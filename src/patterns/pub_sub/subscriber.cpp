@@ -1,16 +1,211 @@
 #include "subscriber.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
 
 using namespace ccl::dp::pub_sub;
 
+/**
+ * The queue of an AsyncSubscriber: one FIFO per priority lane, sharing a
+ * single lock and a single capacity, with a single consumer. The consumer
+ * is only woken up when it waits for the events just pushed, and once the
+ * queue is closed it drains what is left.
+ */
+class AsyncSubscriber::EventQueue
+{
+private:
+    using event_ptr = std::shared_ptr<const PubSubEvent>;
+
+    const AsyncSubscriberConfig m_config;
+
+    mutable std::mutex                 m_mutex;
+    std::condition_variable            m_notEmpty;
+    std::condition_variable            m_notFull;
+    std::vector<std::deque<event_ptr>> m_lanes;
+
+    size_t m_wakeAt   = 0;     // Size waking up the consumer, 0 if it is not waiting
+    bool   m_urgent   = false; // An event above the lowest lane is waiting
+    bool   m_closed   = false;
+    size_t m_blocked  = 0;     // Number of producers waiting for room
+
+    std::atomic<size_t>   m_size    = 0;
+    std::atomic<uint64_t> m_dropped = 0;
+
+    void drop()
+    {
+        m_dropped.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    // Make room for an event of the given lane. Requires the lock.
+    bool makeRoom( std::unique_lock<std::mutex>& lock, size_t lane )
+    {
+        if ( m_config.capacity == 0 || m_size.load( std::memory_order_relaxed ) < m_config.capacity )
+        {
+            return true;
+        }
+
+        switch ( m_config.loss_policy )
+        {
+        case ccl::ds::LossPolicy::BLOCK:
+            ++m_blocked;
+            m_notFull.wait( lock, [this] {
+                return m_closed || m_size.load( std::memory_order_relaxed ) < m_config.capacity;
+            });
+            --m_blocked;
+            return !m_closed;
+
+        case ccl::ds::LossPolicy::OVERWRITE_OLDEST:
+            // Never drop a more urgent event than the new one
+            for ( size_t victim = 0; victim <= lane; ++victim )
+            {
+                if ( m_lanes[victim].empty() ) continue;
+
+                m_lanes[victim].pop_front();
+                m_size.fetch_sub( 1, std::memory_order_relaxed );
+                drop();
+                return true;
+            }
+            return false;
+
+        default:
+            return false;
+        }
+    }
+
+public:
+    explicit EventQueue( const AsyncSubscriberConfig& config )
+        : m_config( config ), m_lanes( config.lanes )
+    {}
+
+    void push( const event_ptr& event )
+    {
+        const size_t lane = std::min( event->priority(), m_lanes.size() - 1 );
+
+        std::unique_lock<std::mutex> lock( m_mutex );
+
+        if ( m_closed || !makeRoom( lock, lane ) )
+        {
+            drop();
+            return;
+        }
+
+        m_lanes[lane].push_back( event );
+        size_t size = m_size.fetch_add( 1, std::memory_order_relaxed ) + 1;
+        if ( lane > 0 ) m_urgent = true;
+
+        // A lingering consumer only wakes up with its batch, or an urgent event
+        bool wake = m_wakeAt != 0 && ( size >= m_wakeAt || lane > 0 );
+
+        lock.unlock();
+        if ( wake ) m_notEmpty.notify_one();
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_closed = true;
+        }
+
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+
+    /**
+     * Move up to nelem events into dst, the higher lanes first, waiting
+     * for at least one event, and then up to linger for nelem of them.
+     * Returns 0 once the queue is closed and empty.
+     */
+    size_t popN( event_ptr* dst, size_t nelem, std::chrono::microseconds linger )
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+
+        auto size = [this] { return m_size.load( std::memory_order_relaxed ); };
+
+        m_wakeAt = 1;
+        m_notEmpty.wait( lock, [this, &size] { return m_closed || size() > 0; } );
+
+        // A bounded queue never holds more than its capacity
+        size_t target = nelem;
+        if ( m_config.capacity != 0 ) target = std::min( target, m_config.capacity );
+
+        if ( linger.count() > 0 && !m_closed && !m_urgent && size() < target )
+        {
+            m_wakeAt = target;
+            m_notEmpty.wait_for( lock, linger, [this, &size, target] {
+                return m_closed || m_urgent || size() >= target;
+            });
+        }
+
+        m_wakeAt = 0;
+
+        size_t count = 0;
+        for ( size_t lane = m_lanes.size(); lane-- > 0 && count < nelem; )
+        {
+            auto& events = m_lanes[lane];
+            while ( !events.empty() && count < nelem )
+            {
+                dst[count++] = std::move( events.front() );
+                events.pop_front();
+            }
+        }
+
+        m_size.fetch_sub( count, std::memory_order_relaxed );
+        m_urgent = false;
+        for ( size_t lane = 1; lane < m_lanes.size() && !m_urgent; ++lane ) m_urgent = !m_lanes[lane].empty();
+
+        bool blocked = m_blocked > 0;
+
+        lock.unlock();
+        if ( blocked ) m_notFull.notify_all();
+        return count;
+    }
+
+    size_t depth() const
+    {
+        return m_size.load( std::memory_order_relaxed );
+    }
+
+    size_t depth( size_t lane ) const
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return lane < m_lanes.size() ? m_lanes[lane].size() : 0;
+    }
+
+    uint64_t dropped() const
+    {
+        return m_dropped.load( std::memory_order_relaxed );
+    }
+};
+
+AsyncSubscriber::AsyncSubscriber(const std::string &name, const AsyncSubscriberConfig &config)
+: Thread( name, false, ccl::sys::concurrent::CancellationPolicy::DEFERRED ),
+  m_config( config )
+{
+    if ( m_config.lanes == 0 )
+    {
+        throw std::invalid_argument( "AsyncSubscriber needs at least one lane" );
+    }
+
+    m_queue = std::make_unique<EventQueue>( m_config );
+}
+
+AsyncSubscriber::~AsyncSubscriber() = default;
+
 void AsyncSubscriber::notify(event_ptr &event)
 {
-    m_events.push( event );
+    m_queue->push( event );
 }
 
 void AsyncSubscriber::cancel()
 {
     Thread::cancel();
-    m_events.push( nullptr );
+
+    // The events left are consumed without lingering, the new ones dropped
+    m_queue->close();
 }
 
 void AsyncSubscriber::stop()
@@ -19,12 +214,40 @@ void AsyncSubscriber::stop()
     join();
 }
 
+void AsyncSubscriber::consumeBatch(std::span<event_ptr> events)
+{
+    for ( auto& event: events ) consume( event );
+}
+
 void AsyncSubscriber::run()
 {
+    std::vector<event_ptr> batch( std::max<size_t>( m_config.batch_size, 1 ) );
+
     while ( true )
     {
-        event_ptr event = m_events.pop();
-        if (!event) break;
-        consume( event );
+        size_t nelem = m_queue->popN( batch.data(), batch.size(), m_config.linger );
+
+        // Closed and empty
+        if ( nelem == 0 ) break;
+
+        consumeBatch( std::span<event_ptr>( batch.data(), nelem ) );
+
+        // Release the events now, not when the slots are reused
+        std::fill( batch.begin(), batch.begin() + nelem, nullptr );
     }
 }
+
+size_t AsyncSubscriber::getDepth() const
+{
+    return m_queue->depth();
+}
+
+size_t AsyncSubscriber::getDepth(size_t lane) const
+{
+    return m_queue->depth( lane );
+}
+
+uint64_t AsyncSubscriber::getDropped() const
+{
+    return m_queue->dropped();
+}
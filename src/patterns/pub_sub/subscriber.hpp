@@ -1,8 +1,11 @@
 #pragma once
 
 #include <concurrent/thread.hpp>
-#include <data_structures/queue/concurrent_queue.hpp>
+#include <data_structures/base/enum.hpp>
 #include <patterns/pub_sub/event.hpp>
+#include <chrono>
+#include <cstdint>
+#include <span>
 #include <string>
 #include <memory>
 
@@ -31,38 +34,87 @@ namespace ccl::dp::pub_sub
         virtual ~Subscriber() = default;
     };
 
+    /**
+     * @brief How an AsyncSubscriber queues the events, and takes them out
+     */
+    struct AsyncSubscriberConfig
+    {
+        // Maximum number of events taken from the queue with a single lock,
+        // and handed to consumeBatch at once
+        size_t batch_size = 64;
+
+        // Once an event is available, how long to wait for a full batch.
+        // Zero takes whatever is queued, without waiting.
+        std::chrono::microseconds linger{ 0 };
+
+        // Maximum number of queued events, over all the lanes. Zero for an
+        // unbounded queue.
+        size_t capacity = 0;
+
+        // What to do when the queue is full: BLOCK waits for room, ERROR
+        // drops the new event, OVERWRITE_OLDEST drops the oldest event of
+        // the lowest lane not above the one of the new event (or else the
+        // new event). Dropped events are counted by getDropped.
+        ccl::ds::LossPolicy loss_policy = ccl::ds::LossPolicy::BLOCK;
+
+        // Number of priority lanes. An event goes into the lane of its
+        // priority (see PubSubEvent::priority), clamped to the available
+        // ones, and the higher lanes are always consumed first.
+        size_t lanes = 1;
+    };
+
     /**
      * @class AsyncSubscriber
      * 
      * @brief Asynchronous Subscriber in which events are pushed into a
      * concurrent queue and then asynchronously consumed. On cancellation
-     * it injects a nullptr event to break the infinite running loop. Notice
+     * the queue is closed, which breaks the infinite running loop. Notice
      * that the subscriber will stop running once all elements left in the
      * queue are processed. That is why, the thread cancellation policy is
      * DEFERRED.
+     *
+     * The worker thread moves the events out of the queue in batches (see
+     * AsyncSubscriberConfig), one lock per batch, and hands them to
+     * consumeBatch. By default it calls consume on each of them, so that
+     * subscribers only override consumeBatch when they can do better with
+     * a whole batch, e.g., a single write.
+     *
+     * The queue can be bounded, to keep a slow subscriber from growing
+     * without limit, and split into priority lanes, so that urgent events
+     * overtake the bulk ones. An event in any lane but the lowest one also
+     * ends the linger of the worker. With the BLOCK policy, a full queue
+     * blocks the publishers notifying the subscriber.
      */
     class AsyncSubscriber : public Subscriber, private ccl::sys::concurrent::Thread
     {
+    private:
+        class EventQueue; // The lanes of events
+
+        std::unique_ptr<EventQueue> m_queue;
+
     protected:
-        ccl::ds::queue::ConcurrentQueue<event_ptr> m_events; // Concurrent queue of events
+        AsyncSubscriberConfig m_config;
 
         /* Push the event into the event queue */
         void notify( event_ptr& event ) override;
 
         /* Consume one single event from the event queue */
         virtual void consume( event_ptr event ) = 0;
+
+        /* Consume consecutive events of the queue, in order */
+        virtual void consumeBatch( std::span<event_ptr> events );
     
     public:
-        AsyncSubscriber(const std::string& name) 
-        : Thread( name, false, 
-            ccl::sys::concurrent::CancellationPolicy::DEFERRED )
-        {}
+        /**
+         * @throws std::invalid_argument If the configuration has no lanes
+         */
+        AsyncSubscriber(const std::string& name, const AsyncSubscriberConfig& config = {});
 
         AsyncSubscriber()
         : AsyncSubscriber( __FUNCTION__ )
         {}
 
-        virtual ~AsyncSubscriber() = default;
+        virtual ~AsyncSubscriber();
 
         // Imports some methods from the Thread class
         using Thread::join;
@@ -72,5 +124,14 @@ namespace ccl::dp::pub_sub
         void stop();   // Custom stop method for AsyncSubscriber
 
         void run() override;
+
+        /* Returns the number of events waiting to be consumed */
+        size_t getDepth() const;
+
+        /* Returns the number of events waiting in the given lane */
+        size_t getDepth( size_t lane ) const;
+
+        /* Returns the number of events dropped by the loss policy, or after cancel */
+        uint64_t getDropped() const;
     };
 }
\ No newline at end of file
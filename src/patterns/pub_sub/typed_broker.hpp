@@ -0,0 +1,312 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ccl::dp::pub_sub
+{
+    /**
+     * @brief A subscriber of the TypedBroker handling the events of type
+     * Event, through a non-virtual or virtual notify( const Event& ) member.
+     */
+    template <typename Subscriber, typename Event>
+    concept TypedSubscriber = requires ( Subscriber& subscriber, const Event& event )
+    {
+        subscriber.notify( event );
+    };
+
+    /**
+     * @class TypedBroker
+     *
+     * @brief Publish-subscribe broker for a closed set of event types,
+     * known at compile time.
+     *
+     * Unlike the PubSubBroker, events are plain types (they do not need to
+     * derive from PubSubEvent), published by reference, and routed to their
+     * subscribers at compile time: each event type has its own list of
+     * subscribers, selected by its position in Events. A publication then
+     * performs no heap allocation, no RTTI lookup and no virtual call: each
+     * subscriber is called through a function pointer to its own notify
+     * overload. The event only lives during publish, hence subscribers
+     * keeping it must copy it.
+     *
+     * Thread-safety follows the PubSubBroker: the subscribers of each event
+     * type live in an immutable snapshot, replaced as a whole by subscribe
+     * and unsubscribe, which are serialized by a mutex. Publishers never
+     * lock, and only load the snapshot again once it has been replaced.
+     * Subscribers are held through weak references, and the expired ones
+     * are skipped.
+     *
+     * @tparam Events The event types, each appearing once
+     */
+    template <typename... Events>
+    class TypedBroker
+    {
+    private:
+        template <typename Event>
+        struct Handler
+        {
+            std::weak_ptr<void> m_owner;                // Lifetime of the subscriber
+            void*               m_subscriber;           // The subscriber itself
+            void ( *m_notify )( void*, const Event& );  // Calls its notify overload
+        };
+
+        template <typename Event>
+        using snapshot_ptr = std::shared_ptr<const std::vector<Handler<Event>>>;
+
+        /* The subscribers of one event type */
+        template <typename Event>
+        struct Channel
+        {
+            std::atomic<snapshot_ptr<Event>> m_handlers;
+            std::atomic<uint64_t>            m_version = 0; // Bumped after each new snapshot
+        };
+
+        /* Snapshot last used by the calling thread, for one event type */
+        template <typename Event>
+        struct SnapshotCache
+        {
+            uint64_t            m_broker  = 0;
+            uint64_t            m_version = 0;
+            snapshot_ptr<Event> m_snapshot;
+            int                 m_depth   = 0; // Nesting of publish
+        };
+
+        template <typename Event>
+        static constexpr bool is_event_v = ( std::is_same_v<Event, Events> || ... );
+
+        template <typename Event>
+        static constexpr size_t count_v = ( size_t( std::is_same_v<Event, Events> ) + ... );
+
+        static_assert( sizeof...( Events ) > 0, "TypedBroker needs at least one event type" );
+        static_assert( ( ( count_v<Events> == 1 ) && ... ), "TypedBroker event types must be distinct" );
+
+        std::tuple<Channel<Events>...> m_channels;
+        std::mutex                     m_mutex; // Serializes the changes of the snapshots
+        const uint64_t                 m_id;    // Identifies the broker in the thread-local caches
+
+        static uint64_t nextId();
+
+        template <typename Event>
+        Channel<Event>& channel() { return std::get<Channel<Event>>( m_channels ); }
+
+        /**
+         * Store a copy of the subscribers of Event, without the expired ones,
+         * and those for which filter returns true. Requires the mutex.
+         */
+        template <typename Event, typename Filter>
+        void replace( Filter&& filter, const Handler<Event>* added );
+
+        /* Drop the expired subscribers of Event, unless a change is in progress */
+        template <typename Event>
+        void compact();
+
+    public:
+        TypedBroker()
+        : m_id( nextId() )
+        {}
+
+        TypedBroker( const TypedBroker& ) = delete;
+        TypedBroker& operator=( const TypedBroker& ) = delete;
+
+        /**
+         * @brief Subscribe the input subscriber to a list of one or more Events
+         * @param subscriber The input subscriber, handling each of the Events
+         * @tparam Subscribed A list of events, among the ones of the broker
+         */
+        template <typename... Subscribed, typename Subscriber>
+        void subscribe( const std::shared_ptr<Subscriber>& subscriber );
+
+        /**
+         * @brief Unsubscribe the input subscriber from a list of one or more Events
+         * @param subscriber The input subscriber
+         * @tparam Subscribed A list of events, among the ones of the broker
+         */
+        template <typename... Subscribed, typename Subscriber>
+        void unsubscribe( const std::shared_ptr<Subscriber>& subscriber );
+
+        /**
+         * @brief Notify the event to all the subscribers of its type. Events
+         * published by the subscribers are delivered before it returns.
+         */
+        template <typename Event>
+        void publish( const Event& event );
+
+        /* Build the event in place and publish it */
+        template <typename Event, typename... Args>
+        void emplace( Args&&... args );
+
+        /* Returns the number of subscribers of Event, expired ones included */
+        template <typename Event>
+        size_t subscribers();
+    };
+
+    template <typename... Events>
+    inline uint64_t TypedBroker<Events...>::nextId()
+    {
+        static std::atomic<uint64_t> counter = 0;
+        return counter.fetch_add( 1, std::memory_order_relaxed ) + 1;
+    }
+
+    template <typename... Events>
+    template <typename Event, typename Filter>
+    inline void TypedBroker<Events...>::replace(Filter &&filter, const Handler<Event> *added)
+    {
+        Channel<Event>& chan = channel<Event>();
+        snapshot_ptr<Event> current = chan.m_handlers.load( std::memory_order_acquire );
+
+        auto handlers = std::make_shared<std::vector<Handler<Event>>>();
+        handlers->reserve( ( current != nullptr ? current->size() : 0 ) + 1 );
+
+        if ( current != nullptr )
+        {
+            for ( const auto& handler: *current )
+            {
+                if ( !handler.m_owner.expired() && !filter( handler ) ) handlers->push_back( handler );
+            }
+        }
+
+        if ( added != nullptr ) handlers->push_back( *added );
+
+        chan.m_handlers.store( std::move( handlers ), std::memory_order_release );
+
+        // After the store: a thread seeing the new version finds the new snapshot
+        chan.m_version.fetch_add( 1, std::memory_order_release );
+    }
+
+    template <typename... Events>
+    template <typename Event>
+    inline void TypedBroker<Events...>::compact()
+    {
+        // Never wait: a change in progress compacts the subscribers anyway
+        std::unique_lock<std::mutex> _l( m_mutex, std::try_to_lock );
+        if ( !_l.owns_lock() ) return;
+
+        replace<Event>( []( const Handler<Event>& ) { return false; }, nullptr );
+    }
+
+    template <typename... Events>
+    template <typename... Subscribed, typename Subscriber>
+    inline void TypedBroker<Events...>::subscribe(const std::shared_ptr<Subscriber> &subscriber)
+    {
+        static_assert( ( is_event_v<Subscribed> && ... ), "The event is not handled by this TypedBroker" );
+        static_assert( ( TypedSubscriber<Subscriber, Subscribed> && ... ),
+                       "The subscriber has no notify overload for the event" );
+
+        std::lock_guard<std::mutex> _l( m_mutex );
+
+        // Fold expression to handle all event types
+        (([this, &subscriber]()
+          {
+            Handler<Subscribed> handler {
+                subscriber, subscriber.get(),
+                []( void* target, const Subscribed& event )
+                {
+                    static_cast<Subscriber*>( target )->notify( event );
+                }
+            };
+
+            replace<Subscribed>( []( const Handler<Subscribed>& ) { return false; }, &handler );
+          }
+        )(), ...);
+    }
+
+    template <typename... Events>
+    template <typename... Subscribed, typename Subscriber>
+    inline void TypedBroker<Events...>::unsubscribe(const std::shared_ptr<Subscriber> &subscriber)
+    {
+        static_assert( ( is_event_v<Subscribed> && ... ), "The event is not handled by this TypedBroker" );
+
+        std::lock_guard<std::mutex> _l( m_mutex );
+
+        void* target = subscriber.get();
+
+        // Fold expression to handle unsubscribes
+        ( replace<Subscribed>( [target]( const Handler<Subscribed>& handler )
+          {
+            return handler.m_subscriber == target;
+          }, nullptr ), ... );
+    }
+
+    template <typename... Events>
+    template <typename Event>
+    inline void TypedBroker<Events...>::publish(const Event &event)
+    {
+        static_assert( is_event_v<Event>, "The event is not handled by this TypedBroker" );
+
+        static thread_local SnapshotCache<Event> cache;
+
+        Channel<Event>& chan = channel<Event>();
+
+        // The snapshot is kept alive by the cache, or by the local reference
+        // when nested, even if replaced meanwhile: no lock is needed.
+        snapshot_ptr<Event> nested;
+        const std::vector<Handler<Event>>* handlers;
+
+        if ( cache.m_depth == 0 )
+        {
+            uint64_t version = chan.m_version.load( std::memory_order_acquire );
+            if ( cache.m_broker != m_id || cache.m_version != version )
+            {
+                cache.m_snapshot = chan.m_handlers.load( std::memory_order_acquire );
+                cache.m_broker = m_id;
+                cache.m_version = version;
+            }
+
+            handlers = cache.m_snapshot.get();
+        }
+        else
+        {
+            nested = chan.m_handlers.load( std::memory_order_acquire );
+            handlers = nested.get();
+        }
+
+        if ( handlers == nullptr ) return;
+
+        // Keeps the cache untouched until the end of the loop, even on exceptions
+        struct DepthGuard
+        {
+            int& m_depth;
+            explicit DepthGuard( int& depth ) : m_depth( depth ) { ++m_depth; }
+            ~DepthGuard() { --m_depth; }
+        } _guard( cache.m_depth );
+
+        bool expired = false;
+        for ( const Handler<Event>& handler: *handlers )
+        {
+            // Keeps the subscriber alive while notifying it
+            if ( auto owner = handler.m_owner.lock() )
+            {
+                handler.m_notify( handler.m_subscriber, event );
+                continue;
+            }
+
+            expired = true;
+        }
+
+        if ( expired ) compact<Event>();
+    }
+
+    template <typename... Events>
+    template <typename Event, typename... Args>
+    inline void TypedBroker<Events...>::emplace(Args &&...args)
+    {
+        publish( Event( std::forward<Args>( args )... ) );
+    }
+
+    template <typename... Events>
+    template <typename Event>
+    inline size_t TypedBroker<Events...>::subscribers()
+    {
+        static_assert( is_event_v<Event>, "The event is not handled by this TypedBroker" );
+
+        snapshot_ptr<Event> current = channel<Event>().m_handlers.load( std::memory_order_acquire );
+        return current != nullptr ? current->size() : 0;
+    }
+}
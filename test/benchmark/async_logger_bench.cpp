@@ -0,0 +1,90 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <io/file/buffered_io.hpp>
+#include <logging/async_logger.hpp>
+#include <logging/formatting.hpp>
+
+using namespace ccl::logging;
+using namespace ccl::sys::io;
+
+static constexpr const char* MESSAGE = "request served in 42 us from worker 7";
+
+// Baseline: format on the caller thread and write into a buffered file
+static void BM_SyncFormatAndWrite( benchmark::State& state )
+{
+    BufferedFileIO file( "/dev/null", iom::Write, 64 * 1024 );
+    DefaultStringFormatter formatter;
+
+    for ( auto _ : state )
+    {
+        std::string line = formatter.format( LoggingLevel::INFO, MESSAGE );
+        file.write( line.data(), line.size() );
+    }
+
+    state.SetItemsProcessed( state.iterations() );
+}
+
+static AsyncLogger& shared_logger()
+{
+    AsyncLoggerConfig config;
+    config.queue_capacity = 1 << 16;
+    config.loss_policy = ccl::ds::LossPolicy::BLOCK;
+
+    static AsyncLogger logger( "/dev/null", config );
+    return logger;
+}
+
+static void BM_AsyncLoggerCall( benchmark::State& state )
+{
+    AsyncLogger& logger = shared_logger();
+
+    for ( auto _ : state ) logger.info( MESSAGE );
+
+    state.SetItemsProcessed( state.iterations() );
+}
+
+static void BM_AsyncLoggerFiltered( benchmark::State& state )
+{
+    AsyncLogger& logger = shared_logger();
+    logger.setLevel( LoggingLevel::ERROR );
+
+    for ( auto _ : state ) logger.info( MESSAGE );
+
+    logger.setLevel( LoggingLevel::INFO );
+    state.SetItemsProcessed( state.iterations() );
+}
+
+// Latency distribution of the single call, reported as p50/p99 counters
+static void BM_AsyncLoggerLatency( benchmark::State& state )
+{
+    using clock = std::chrono::steady_clock;
+
+    AsyncLogger& logger = shared_logger();
+    std::vector<int64_t> samples;
+    samples.reserve( 1 << 20 );
+
+    for ( auto _ : state )
+    {
+        auto start = clock::now();
+        logger.info( MESSAGE );
+        auto stop = clock::now();
+
+        if ( samples.size() < samples.capacity() )
+        {
+            samples.push_back( std::chrono::duration_cast<std::chrono::nanoseconds>( stop - start ).count() );
+        }
+    }
+
+    if ( samples.empty() ) return;
+
+    std::sort( samples.begin(), samples.end() );
+    state.counters["p50_ns"] = static_cast<double>( samples[samples.size() / 2] );
+    state.counters["p99_ns"] = static_cast<double>( samples[samples.size() * 99 / 100] );
+}
+
+BENCHMARK( BM_SyncFormatAndWrite );
+BENCHMARK( BM_AsyncLoggerCall )->Threads(1)->Threads(4);
+BENCHMARK( BM_AsyncLoggerFiltered );
+BENCHMARK( BM_AsyncLoggerLatency );
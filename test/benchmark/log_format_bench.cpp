@@ -0,0 +1,150 @@
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <filesystem>
+#include <logging/binary_log.hpp>
+#include <logging/formatting.hpp>
+#include <metrics/metrics_utils.hpp>
+#include <unistd.h>
+
+using namespace ccl::logging;
+
+// Heap allocations of the calling thread, counted by the ccl_MetricsHooks
+static long allocations()
+{
+    return ccl::metrics::heap_hooks::allocations;
+}
+
+static void report_allocations( benchmark::State& state, long before )
+{
+    state.counters["allocs_per_msg"] = benchmark::Counter(
+        static_cast<double>( allocations() - before ),
+        benchmark::Counter::kAvgIterations );
+}
+
+// The implementation of DefaultStringFormatter::format before the allocation-free path
+static std::string legacy_format( LoggingLevel lvl, const std::string& msg )
+{
+    auto now = std::chrono::system_clock::now();
+    std::time_t now_c = std::chrono::system_clock::to_time_t( now );
+    std::tm tm {};
+    localtime_r( &now_c, &tm );
+
+    std::string logging_lvl;
+    switch (lvl)
+    {
+        case LoggingLevel::INFO: logging_lvl = "INFO"; break;
+        case LoggingLevel::WARNING: logging_lvl = "WARNING"; break;
+        case LoggingLevel::ERROR: logging_lvl = "ERROR"; break;
+        default: break;
+    }
+
+    std::ostringstream oss;
+    oss << "[" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "] "
+        << "[" << logging_lvl << "] " << msg
+        << std::endl;
+
+    return oss.str();
+}
+
+static void BM_LegacyStringStream( benchmark::State& state )
+{
+    long before = allocations();
+
+    for ( auto _ : state )
+    {
+        std::ostringstream oss;
+        oss << "request " << 1234 << " served in " << 42.5 << " us";
+        std::string line = legacy_format( LoggingLevel::INFO, oss.str() );
+        benchmark::DoNotOptimize( line.data() );
+    }
+
+    report_allocations( state, before );
+}
+
+static void BM_DefaultFormatterString( benchmark::State& state )
+{
+    DefaultStringFormatter formatter;
+    const std::string msg = "request 1234 served in 42.5 us";
+    long before = allocations();
+
+    for ( auto _ : state )
+    {
+        std::string line = formatter.format( LoggingLevel::INFO, msg );
+        benchmark::DoNotOptimize( line.data() );
+    }
+
+    report_allocations( state, before );
+}
+
+static void BM_DefaultFormatterFormatTo( benchmark::State& state )
+{
+    DefaultStringFormatter formatter;
+    StaticFormatBuffer<512> out;
+    long before = allocations();
+
+    for ( auto _ : state )
+    {
+        out.clear();
+        formatter.formatTo( out, LoggingLevel::INFO, "request {} served in {} us", 1234, 42.5 );
+        benchmark::DoNotOptimize( out.view().data() );
+    }
+
+    report_allocations( state, before );
+}
+
+static void BM_SysLogFormatterFormatTo( benchmark::State& state )
+{
+    SysLogFormatter formatter;
+    formatter.addElement( "origin" );
+    formatter.addParameter( "origin", "software", "ccl" );
+
+    StaticFormatBuffer<512> out;
+    long before = allocations();
+
+    for ( auto _ : state )
+    {
+        out.clear();
+        formatter.formatTo( out, SysLogFacility::USER_LEVEL, SysLogSeverity::NOTICE,
+                            "request 1234 served in 42.5 us" );
+        benchmark::DoNotOptimize( out.view().data() );
+    }
+
+    report_allocations( state, before );
+}
+
+static void BM_BinaryLoggerLog( benchmark::State& state )
+{
+    std::string path = ( std::filesystem::temp_directory_path() /
+        ( "ccl_log_format_bench_" + std::to_string( ::getpid() ) ) ).string();
+
+    long before = 0;
+    {
+        BinaryLogger logger( path );
+        before = allocations();
+
+        for ( auto _ : state )
+        {
+            logger.info( "request {} served in {} us", 1234, 42.5 );
+        }
+
+        report_allocations( state, before );
+    }
+
+    // Bytes on disk against the text line of DefaultFormatterFormatTo
+    auto files = BinaryLogReader::segments( path );
+    size_t bytes = 0;
+    for ( const auto& file: files ) bytes += std::filesystem::file_size( file );
+    state.counters["bytes_per_msg"] = benchmark::Counter(
+        static_cast<double>( bytes ), benchmark::Counter::kAvgIterations );
+
+    for ( const auto& file: files ) std::filesystem::remove( file );
+}
+
+BENCHMARK( BM_LegacyStringStream );
+BENCHMARK( BM_DefaultFormatterString );
+BENCHMARK( BM_DefaultFormatterFormatTo );
+BENCHMARK( BM_SysLogFormatterFormatTo );
+BENCHMARK( BM_BinaryLoggerLog );
@@ -0,0 +1,268 @@
+#include <benchmark/benchmark.h>
+#include <metrics/metrics_broker.hpp>
+#include <metrics/metrics_gather.hpp>
+#include <metrics/metrics_utils.hpp>
+#include <metrics/perf_counters.hpp>
+#include <metrics/hdr_histogram.hpp>
+#include <metrics/open_metrics.hpp>
+#include <metrics/scope_timer.hpp>
+#include <metrics/metrics_logger.hpp>
+#include <filesystem>
+#include <vector>
+
+using namespace ccl::metrics;
+
+// The probes taken at the beginning and at the end of a scope, /proc version
+static void BM_ProbesProc( benchmark::State& state )
+{
+    int tid = get_thread_id();
+
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize( get_cpu_time() );
+        benchmark::DoNotOptimize( get_stack_usage( tid ) );
+        benchmark::DoNotOptimize( get_heap_usage() );
+    }
+}
+
+static void BM_ProbesFast( benchmark::State& state )
+{
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize( get_thread_cpu_time() );
+        benchmark::DoNotOptimize( get_stack_usage_fast() );
+        benchmark::DoNotOptimize( get_heap_bytes() );
+    }
+}
+
+static void BM_ThreadCpuTime( benchmark::State& state )
+{
+    for ( auto _ : state ) benchmark::DoNotOptimize( get_thread_cpu_time() );
+}
+
+static void BM_StackAndHeapFast( benchmark::State& state )
+{
+    for ( auto _ : state )
+    {
+        benchmark::DoNotOptimize( get_stack_usage_fast() );
+        benchmark::DoNotOptimize( get_heap_bytes() );
+    }
+}
+
+// A read of the counters of the thread, with rdpmc if allowed
+static void BM_PerfCountersRead( benchmark::State& state )
+{
+    auto& group = PerfCounterGroup::forThread( PerfEvent::All );
+    if ( group.getEvents() == PerfEvent::None )
+    {
+        state.SkipWithError( "perf events not permitted" );
+        return;
+    }
+
+    PerfCounters counters;
+    for ( auto _ : state )
+    {
+        group.read( counters );
+        benchmark::DoNotOptimize( counters );
+    }
+
+    state.SetLabel( group.usesRdpmc() ? "rdpmc" : "read" );
+}
+
+// A whole instrumented scope: creation, collect and publication
+static void BM_CollectorScope( benchmark::State& state )
+{
+    auto mode = static_cast<CollectionMode>( state.range( 0 ) );
+    MetricsBroker::setCollectionMode( mode );
+
+    for ( auto _ : state )
+    {
+        auto collector = MetricsCollector::create( "scope" );
+        collector->collect();
+    }
+
+    MetricsBroker::setCollectionMode( CollectionMode::Proc );
+    state.SetLabel( mode == CollectionMode::Fast ? "Fast" : "Proc" );
+}
+
+// A whole instrumented scope from several threads, published directly
+// (broker lock and event allocation) or staged in the per-thread queues
+static void BM_CollectorDelivery( benchmark::State& state )
+{
+    auto delivery = static_cast<MetricsDelivery>( state.range( 0 ) );
+    if ( state.thread_index() == 0 )
+    {
+        MetricsBroker::setCollectionMode( CollectionMode::Fast );
+        MetricsBroker::setDelivery( delivery );
+    }
+
+    for ( auto _ : state )
+    {
+        auto collector = MetricsCollector::create( "scope" );
+        collector->collect();
+    }
+
+    if ( state.thread_index() == 0 )
+    {
+        MetricsBroker::getInstance()->getSink().flush();
+        MetricsBroker::setDelivery( MetricsDelivery::Direct );
+        MetricsBroker::setCollectionMode( CollectionMode::Proc );
+    }
+
+    state.SetLabel( delivery == MetricsDelivery::Sink ? "Sink" : "Direct" );
+}
+
+// A scope timed through its call site id, against a collector named at
+// each call by __FUNCNAME__, both staged in the per-thread queues
+static void BM_ScopeTimer( benchmark::State& state )
+{
+    for ( auto _ : state )
+    {
+        CCL_SCOPE_TIMER();
+    }
+
+    if ( state.thread_index() == 0 ) MetricsBroker::getInstance()->getSink().flush();
+}
+
+static void BM_CollectorFuncName( benchmark::State& state )
+{
+    if ( state.thread_index() == 0 )
+    {
+        MetricsBroker::setCollectionMode( CollectionMode::Fast );
+        MetricsBroker::setDelivery( MetricsDelivery::Sink );
+    }
+
+    for ( auto _ : state )
+    {
+        auto collector = MetricsCollector::create( __FUNCNAME__() );
+    }
+
+    if ( state.thread_index() == 0 )
+    {
+        MetricsBroker::getInstance()->getSink().flush();
+        MetricsBroker::setDelivery( MetricsDelivery::Direct );
+        MetricsBroker::setCollectionMode( CollectionMode::Proc );
+    }
+}
+
+// Formatting and writing the spans of a batch into a Chrome trace. At 100k
+// spans per second, 5% of a core is 500 ns per span.
+static void BM_ChromeTraceConsume( benchmark::State& state )
+{
+    std::string path = ( std::filesystem::temp_directory_path() / "ccl_bench_trace.json" ).string();
+
+    {
+        ChromeTraceLogger logger( path );
+
+        uint32_t parent = CallSiteRegistry::intern( "bench::parent", __FILE__, __LINE__ );
+        uint32_t site = CallSiteRegistry::intern( "bench::span", __FILE__, __LINE__ );
+
+        std::vector<ScopeRecord> records( MetricsSink::BATCH_SIZE );
+        for ( size_t idx = 0; idx < records.size(); ++idx )
+        {
+            records[idx] = { site, parent, 1234, int64_t( idx ) * 1000, int64_t( idx ) * 1000 + 731 };
+        }
+
+        auto batch = std::make_shared<const ScopeBatchEvent>( records );
+
+        for ( auto _ : state )
+        {
+            logger.consume( batch );
+        }
+
+        state.SetItemsProcessed( state.iterations() * records.size() );
+    }
+
+    std::filesystem::remove( path );
+}
+
+// Instrumentation left in a hot loop while the collection is disabled
+static void BM_CollectorDisabled( benchmark::State& state )
+{
+    static const std::string name = "scope";
+    MetricsBroker::setEnabled( false );
+
+    for ( auto _ : state )
+    {
+        auto collector = MetricsCollector::create( name );
+        collector->collect();
+    }
+
+    MetricsBroker::setEnabled( true );
+}
+
+// A call site sampling one call every N, for N in the argument
+static void BM_CollectorEveryN( benchmark::State& state )
+{
+    static const std::string name = "scope";
+    EveryNSampler sampler( state.range( 0 ) );
+    MetricsBroker::setCollectionMode( CollectionMode::Fast );
+
+    for ( auto _ : state )
+    {
+        auto collector = MetricsCollector::create( name, sampler );
+        collector->collect();
+    }
+
+    MetricsBroker::setCollectionMode( CollectionMode::Proc );
+}
+
+// Recording a duration into the histogram of a call tree node
+static void BM_HdrHistogramRecord( benchmark::State& state )
+{
+    HdrHistogram hist;
+    uint64_t value = 1;
+
+    for ( auto _ : state )
+    {
+        hist.record( value );
+        value = ( value * 2862933555777941757ULL + 3037000493ULL ) % 1'000'000;
+    }
+
+    benchmark::DoNotOptimize( hist.getValueAtPercentile( 99.0 ) );
+}
+
+// Updates of the exported metrics, each thread on its own shard
+static MetricsRegistry s_registry;
+
+static void BM_CounterInc( benchmark::State& state )
+{
+    Counter& counter = s_registry.counter( "bench_calls", "" );
+
+    for ( auto _ : state )
+    {
+        counter.inc();
+    }
+}
+
+static void BM_HistogramObserve( benchmark::State& state )
+{
+    Histogram& histogram = s_registry.histogram( "bench_seconds", "",
+                                                 Histogram::exponentialBounds( 1e-6, 4.0, 12 ) );
+    double value = 1e-6;
+
+    for ( auto _ : state )
+    {
+        histogram.observe( value );
+        value = value < 1.0 ? value * 1.7 : 1e-6;
+    }
+}
+
+BENCHMARK( BM_ProbesProc );
+BENCHMARK( BM_ProbesFast );
+BENCHMARK( BM_ThreadCpuTime );
+BENCHMARK( BM_StackAndHeapFast );
+BENCHMARK( BM_PerfCountersRead );
+BENCHMARK( BM_CollectorScope )->Arg( static_cast<int>( CollectionMode::Proc ) )
+                              ->Arg( static_cast<int>( CollectionMode::Fast ) );
+BENCHMARK( BM_HdrHistogramRecord );
+BENCHMARK( BM_CollectorDisabled );
+BENCHMARK( BM_CollectorEveryN )->Arg( 1 )->Arg( 100 )->Arg( 10000 );
+BENCHMARK( BM_CollectorDelivery )->Arg( static_cast<int>( MetricsDelivery::Direct ) )
+                                 ->Arg( static_cast<int>( MetricsDelivery::Sink ) )
+                                 ->Threads( 1 )->Threads( 4 );
+BENCHMARK( BM_CounterInc )->Threads( 1 )->Threads( 4 );
+BENCHMARK( BM_HistogramObserve )->Threads( 1 )->Threads( 4 );
+BENCHMARK( BM_ScopeTimer )->Threads( 1 )->Threads( 4 );
+BENCHMARK( BM_CollectorFuncName )->Threads( 1 )->Threads( 4 );
+BENCHMARK( BM_ChromeTraceConsume );
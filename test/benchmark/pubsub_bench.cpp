@@ -0,0 +1,380 @@
+#include <benchmark/benchmark.h>
+#include <patterns/pub_sub/broker.hpp>
+#include <patterns/pub_sub/event.hpp>
+#include <patterns/pub_sub/shm_transport.hpp>
+#include <patterns/pub_sub/subscriber.hpp>
+#include <patterns/pub_sub/typed_broker.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <span>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace ccl::dp::pub_sub;
+
+constexpr int SUBSCRIBERS = 4;
+
+using event_ptr = std::shared_ptr<const PubSubEvent>;
+
+class BenchEvent : public PubSubEvent
+{
+public:
+    std::string name() const override { return "BenchEvent"; }
+};
+
+// Subscriber doing a given amount of work per event, to emulate slow ones
+class WorkingSubscriber : public Subscriber
+{
+private:
+    std::atomic<uint64_t> m_received = 0;
+    int64_t               m_work;
+
+protected:
+    void notify( event_ptr& ) override
+    {
+        uint64_t value = 0;
+        for ( int64_t idx = 0; idx < m_work; ++idx ) benchmark::DoNotOptimize( value += idx );
+        m_received.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+public:
+    explicit WorkingSubscriber( int64_t work ) : m_work( work ) {}
+};
+
+static std::shared_ptr<PubSubBroker>                   s_broker;
+static std::vector<std::shared_ptr<WorkingSubscriber>> s_subscribers;
+
+// Publishers on several threads, sharing the broker and the subscribers.
+// The argument is the work done by each subscriber per event.
+static void BM_Publish( benchmark::State& state )
+{
+    if ( state.thread_index() == 0 )
+    {
+        s_broker = std::make_shared<PubSubBroker>();
+        s_subscribers.clear();
+
+        for ( int idx = 0; idx < SUBSCRIBERS; ++idx )
+        {
+            s_subscribers.push_back( std::make_shared<WorkingSubscriber>( state.range( 0 ) ) );
+            s_broker->subscribe<BenchEvent>( s_subscribers.back() );
+        }
+    }
+
+    auto event = std::make_shared<const BenchEvent>();
+
+    for ( auto _ : state )
+    {
+        s_broker->notifySubscribers( event );
+    }
+
+    state.SetItemsProcessed( state.iterations() );
+
+    if ( state.thread_index() == 0 )
+    {
+        s_subscribers.clear();
+        s_broker.reset();
+    }
+}
+
+BENCHMARK( BM_Publish )->Arg( 0 )->Arg( 200 )->ThreadRange( 1, 8 )->UseRealTime();
+
+constexpr int TOPICS = 32;
+
+template <int Topic>
+class TopicEvent : public PubSubEvent
+{
+public:
+    std::string name() const override { return "TopicEvent" + std::to_string( Topic ); }
+};
+
+class ChurnEvent : public PubSubEvent
+{
+public:
+    std::string name() const override { return "ChurnEvent"; }
+};
+
+template <int... Topics>
+static std::vector<event_ptr> make_topic_events( std::integer_sequence<int, Topics...> )
+{
+    return { std::make_shared<const TopicEvent<Topics>>()... };
+}
+
+template <int... Topics>
+static void subscribe_topics( PubSubBroker& broker, const std::shared_ptr<Subscriber>& subscriber,
+                              std::integer_sequence<int, Topics...> )
+{
+    broker.subscribe<TopicEvent<Topics>...>( subscriber );
+}
+
+static std::vector<event_ptr>  s_topicEvents;
+static std::atomic<bool>       s_churning = false;
+static std::thread             s_churn;
+
+// Each publisher thread has its own event type. With a non-zero argument,
+// another thread keeps subscribing and unsubscribing to an unrelated type.
+static void BM_PublishTopics( benchmark::State& state )
+{
+    if ( state.thread_index() == 0 )
+    {
+        s_broker = std::make_shared<PubSubBroker>();
+        s_subscribers.clear();
+        s_topicEvents = make_topic_events( std::make_integer_sequence<int, TOPICS>() );
+
+        for ( int idx = 0; idx < SUBSCRIBERS; ++idx )
+        {
+            s_subscribers.push_back( std::make_shared<WorkingSubscriber>( 0 ) );
+            subscribe_topics( *s_broker, s_subscribers.back(), std::make_integer_sequence<int, TOPICS>() );
+        }
+
+        if ( state.range( 0 ) != 0 )
+        {
+            s_churning = true;
+            s_churn = std::thread( [broker = s_broker]
+            {
+                auto temporary = std::make_shared<WorkingSubscriber>( 0 );
+                while ( s_churning.load( std::memory_order_relaxed ) )
+                {
+                    broker->subscribe<ChurnEvent>( temporary );
+                    broker->unsubscribe<ChurnEvent>( temporary );
+                }
+            });
+        }
+    }
+
+    event_ptr event;
+
+    for ( auto _ : state )
+    {
+        if ( event == nullptr ) event = s_topicEvents[ state.thread_index() % TOPICS ];
+        s_broker->notifySubscribers( event );
+    }
+
+    state.SetItemsProcessed( state.iterations() );
+
+    if ( state.thread_index() == 0 )
+    {
+        if ( s_churn.joinable() )
+        {
+            s_churning = false;
+            s_churn.join();
+        }
+
+        s_subscribers.clear();
+        s_broker.reset();
+    }
+}
+
+BENCHMARK( BM_PublishTopics )->Arg( 0 )->Arg( 1 )->ThreadRange( 1, 32 )->UseRealTime();
+
+// A new event per publication, as publishers usually do with the PubSubBroker
+static void BM_PublishAllocating( benchmark::State& state )
+{
+    auto broker = std::make_shared<PubSubBroker>();
+    std::vector<std::shared_ptr<WorkingSubscriber>> subscribers;
+
+    for ( int idx = 0; idx < SUBSCRIBERS; ++idx )
+    {
+        subscribers.push_back( std::make_shared<WorkingSubscriber>( 0 ) );
+        broker->subscribe<BenchEvent>( subscribers.back() );
+    }
+
+    for ( auto _ : state )
+    {
+        broker->notifySubscribers( std::make_shared<const BenchEvent>() );
+    }
+
+    state.SetItemsProcessed( state.iterations() );
+}
+
+BENCHMARK( BM_PublishAllocating );
+
+struct TypedEvent
+{
+    uint64_t m_sequence;
+};
+
+struct OtherEvent {};
+
+class TypedWorkingSubscriber
+{
+private:
+    std::atomic<uint64_t> m_received = 0;
+
+public:
+    void notify( const TypedEvent& event )
+    {
+        benchmark::DoNotOptimize( event.m_sequence );
+        m_received.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    void notify( const OtherEvent& ) {}
+};
+
+// Same subscribers as BM_PublishAllocating, with the events on the stack
+static void BM_TypedPublish( benchmark::State& state )
+{
+    TypedBroker<OtherEvent, TypedEvent> broker;
+    std::vector<std::shared_ptr<TypedWorkingSubscriber>> subscribers;
+
+    for ( int idx = 0; idx < SUBSCRIBERS; ++idx )
+    {
+        subscribers.push_back( std::make_shared<TypedWorkingSubscriber>() );
+        broker.subscribe<TypedEvent>( subscribers.back() );
+    }
+
+    uint64_t sequence = 0;
+    for ( auto _ : state )
+    {
+        broker.publish( TypedEvent { sequence++ } );
+    }
+
+    state.SetItemsProcessed( state.iterations() );
+}
+
+BENCHMARK( BM_TypedPublish );
+
+// Asynchronous subscriber writing each batch of events at once, as a file
+// logger would, the cost of a write being emulated by the given work
+class BatchWriter : public AsyncSubscriber
+{
+private:
+    int64_t m_work;
+
+protected:
+    void consume( event_ptr event ) override
+    {
+        consumeBatch( std::span<event_ptr>( &event, 1 ) );
+    }
+
+    void consumeBatch( std::span<event_ptr> events ) override
+    {
+        uint64_t value = 0;
+        for ( int64_t idx = 0; idx < m_work; ++idx ) benchmark::DoNotOptimize( value += idx );
+        m_consumed.fetch_add( events.size(), std::memory_order_release );
+    }
+
+public:
+    std::atomic<uint64_t> m_consumed = 0;
+
+    BatchWriter( const AsyncSubscriberConfig& config, int64_t work )
+    : AsyncSubscriber( "BatchWriter", config ), m_work( work )
+    {}
+};
+
+constexpr int ROUND = 1024;
+
+// Rounds of events published into an AsyncSubscriber and consumed.
+// Arguments are the batch size and the linger in microseconds.
+static void BM_AsyncConsume( benchmark::State& state )
+{
+    AsyncSubscriberConfig config;
+    config.batch_size = static_cast<size_t>( state.range( 0 ) );
+    config.linger = std::chrono::microseconds( state.range( 1 ) );
+
+    auto broker = std::make_shared<PubSubBroker>();
+    auto writer = std::make_shared<BatchWriter>( config, 1000 );
+    broker->subscribe<BenchEvent>( writer );
+    writer->start();
+
+    auto event = std::make_shared<const BenchEvent>();
+    uint64_t published = 0;
+
+    for ( auto _ : state )
+    {
+        for ( int idx = 0; idx < ROUND; ++idx ) broker->notifySubscribers( event );
+
+        published += ROUND;
+        while ( writer->m_consumed.load( std::memory_order_acquire ) < published ) std::this_thread::yield();
+    }
+
+    writer->stop();
+    state.SetItemsProcessed( state.iterations() * ROUND );
+}
+
+BENCHMARK( BM_AsyncConsume )->Args( { 1, 0 } )->Args( { 64, 0 } )->Args( { 64, 100 } )->UseRealTime();
+
+constexpr size_t MESSAGE = 64;
+
+// Round trips of a message with a forked process echoing it, through two
+// ShmRings, one per direction
+static void BM_ShmPingPong( benchmark::State& state )
+{
+    ShmRing request( 64 * 1024 ), reply( 64 * 1024 );
+
+    pid_t pid = fork();
+    if ( pid == 0 )
+    {
+        const auto echo = [&reply]( uint32_t type, const unsigned char* data, size_t size )
+        {
+            reply.write( type, data, size );
+        };
+
+        while ( !request.isClosed() )
+        {
+            if ( request.read( echo ) == 0 ) request.wait( std::chrono::milliseconds( 100 ) );
+        }
+
+        _exit( 0 );
+    }
+
+    unsigned char message[ MESSAGE ] = {};
+    const auto receive = []( uint32_t, const unsigned char* data, size_t ) { benchmark::DoNotOptimize( data ); };
+
+    for ( auto _ : state )
+    {
+        request.write( 1, message, MESSAGE );
+        while ( reply.read( receive ) == 0 ) reply.wait( std::chrono::milliseconds( 100 ) );
+    }
+
+    request.close();
+    waitpid( pid, nullptr, 0 );
+    state.SetItemsProcessed( state.iterations() );
+}
+
+BENCHMARK( BM_ShmPingPong )->UseRealTime();
+
+// Same round trips through a unix socket pair, for comparison
+static void BM_SocketPingPong( benchmark::State& state )
+{
+    int fds[ 2 ];
+    if ( socketpair( AF_UNIX, SOCK_STREAM, 0, fds ) != 0 )
+    {
+        state.SkipWithError( "socketpair failed" );
+        return;
+    }
+
+    pid_t pid = fork();
+    if ( pid == 0 )
+    {
+        ::close( fds[ 0 ] );
+
+        unsigned char buffer[ MESSAGE ];
+        while ( recv( fds[ 1 ], buffer, MESSAGE, MSG_WAITALL ) == static_cast<ssize_t>( MESSAGE ) )
+        {
+            send( fds[ 1 ], buffer, MESSAGE, 0 );
+        }
+
+        _exit( 0 );
+    }
+
+    ::close( fds[ 1 ] );
+
+    unsigned char message[ MESSAGE ] = {};
+    for ( auto _ : state )
+    {
+        send( fds[ 0 ], message, MESSAGE, 0 );
+        recv( fds[ 0 ], message, MESSAGE, MSG_WAITALL );
+    }
+
+    ::close( fds[ 0 ] );
+    waitpid( pid, nullptr, 0 );
+    state.SetItemsProcessed( state.iterations() );
+}
+
+BENCHMARK( BM_SocketPingPong )->UseRealTime();
@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+#include <thread>
+#include <vector>
+#include <data_structures/buffers/concurrent_ring_buffer.hpp>
+#include <data_structures/buffers/spsc_ring_buffer.hpp>
+
+using namespace ccl::ds::buffers;
+
+constexpr size_t CAPACITY = 1024;
+constexpr size_t BATCH    = 64;
+
+// Producer -> Consumer handoff of N integers through the mutex-based buffer.
+// ConcurrentRingBuffer overwrites when full, so the producer backs off on size.
+static void BM_ConcurrentRingBuffer_Handoff( benchmark::State& state )
+{
+    const int64_t items = state.range(0);
+
+    for ( auto _ : state )
+    {
+        ConcurrentRingBuffer<int64_t> buffer( CAPACITY );
+
+        std::thread producer( [&buffer, items]() {
+            for ( int64_t i = 0; i < items; ++i )
+            {
+                while ( buffer.size() >= CAPACITY ) std::this_thread::yield();
+                buffer.put( i );
+            }
+        });
+
+        int64_t sum = 0;
+        for ( int64_t i = 0; i < items; ++i ) sum += buffer.popFront();
+        benchmark::DoNotOptimize( sum );
+
+        producer.join();
+    }
+
+    state.SetItemsProcessed( state.iterations() * items );
+}
+
+static void BM_SpscRingBuffer_Handoff( benchmark::State& state )
+{
+    const int64_t items = state.range(0);
+
+    for ( auto _ : state )
+    {
+        SpscRingBuffer<int64_t> buffer( CAPACITY );
+
+        std::thread producer( [&buffer, items]() {
+            for ( int64_t i = 0; i < items; ++i ) buffer.push( i );
+        });
+
+        int64_t sum = 0;
+        for ( int64_t i = 0; i < items; ++i ) sum += buffer.pop();
+        benchmark::DoNotOptimize( sum );
+
+        producer.join();
+    }
+
+    state.SetItemsProcessed( state.iterations() * items );
+}
+
+static void BM_SpscRingBuffer_BulkHandoff( benchmark::State& state )
+{
+    const int64_t items = state.range(0);
+
+    for ( auto _ : state )
+    {
+        SpscRingBuffer<int64_t> buffer( CAPACITY );
+
+        std::thread producer( [&buffer, items]() {
+            std::vector<int64_t> chunk( BATCH );
+            int64_t next = 0;
+            while ( next < items )
+            {
+                int64_t count = std::min<int64_t>( BATCH, items - next );
+                for ( int64_t i = 0; i < count; ++i ) chunk[i] = next + i;
+                size_t pushed = buffer.tryPushN( chunk.data(), count );
+                if ( pushed == 0 ) std::this_thread::yield();
+                next += pushed;
+            }
+        });
+
+        std::vector<int64_t> chunk( BATCH );
+        int64_t received = 0, sum = 0;
+        while ( received < items )
+        {
+            size_t count = buffer.tryPopN( chunk.data(), chunk.size() );
+            if ( count == 0 ) std::this_thread::yield();
+            for ( size_t i = 0; i < count; ++i ) sum += chunk[i];
+            received += count;
+        }
+
+        benchmark::DoNotOptimize( sum );
+        producer.join();
+    }
+
+    state.SetItemsProcessed( state.iterations() * items );
+}
+
+BENCHMARK( BM_ConcurrentRingBuffer_Handoff )->Arg( 1 << 20 )->Unit( benchmark::kMillisecond )->UseRealTime();
+BENCHMARK( BM_SpscRingBuffer_Handoff )->Arg( 1 << 20 )->Unit( benchmark::kMillisecond )->UseRealTime();
+BENCHMARK( BM_SpscRingBuffer_BulkHandoff )->Arg( 1 << 20 )->Unit( benchmark::kMillisecond )->UseRealTime();
@@ -0,0 +1,76 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <vector>
+#include <concurrent/thread.hpp>
+#include <concurrent/thread_pool.hpp>
+
+using namespace ccl::sys::concurrent;
+
+// A short task, comparable with the cost of a single metrics update
+static void short_task( std::atomic<int64_t>& counter )
+{
+    counter.fetch_add( 1, std::memory_order_relaxed );
+}
+
+// Baseline: one Thread (hence one OS thread) spawned per task
+static void BM_ThreadPerTask( benchmark::State& state )
+{
+    const int64_t tasks = state.range(0);
+    std::atomic<int64_t> counter = 0;
+
+    for ( auto _ : state )
+    {
+        std::vector<Thread_ptr> threads;
+        threads.reserve( tasks );
+
+        for ( int64_t i = 0; i < tasks; ++i )
+        {
+            threads.push_back( Thread::start( short_task, false,
+                CancellationPolicy::DEFERRED, std::ref(counter) ) );
+        }
+
+        for ( auto& thread : threads ) thread->join();
+    }
+
+    state.SetItemsProcessed( state.iterations() * tasks );
+}
+
+static void BM_ThreadPoolSubmit( benchmark::State& state )
+{
+    const int64_t tasks = state.range(0);
+    std::atomic<int64_t> counter = 0;
+    ThreadPool pool( std::max( 2u, std::thread::hardware_concurrency() ) );
+
+    for ( auto _ : state )
+    {
+        std::vector<std::future<void>> futures;
+        futures.reserve( tasks );
+
+        for ( int64_t i = 0; i < tasks; ++i )
+        {
+            futures.push_back( pool.submit( short_task, std::ref(counter) ) );
+        }
+
+        for ( auto& future : futures ) future.get();
+    }
+
+    state.SetItemsProcessed( state.iterations() * tasks );
+}
+
+static void BM_ThreadPoolParallelFor( benchmark::State& state )
+{
+    const int64_t tasks = state.range(0);
+    std::atomic<int64_t> counter = 0;
+    ThreadPool pool( std::max( 2u, std::thread::hardware_concurrency() ) );
+
+    for ( auto _ : state )
+    {
+        pool.parallelFor( 0, tasks, [&counter]( size_t ){ short_task( counter ); }, 1 );
+    }
+
+    state.SetItemsProcessed( state.iterations() * tasks );
+}
+
+BENCHMARK( BM_ThreadPerTask )->Arg( 1000 )->Unit( benchmark::kMillisecond )->UseRealTime();
+BENCHMARK( BM_ThreadPoolSubmit )->Arg( 1000 )->Unit( benchmark::kMillisecond )->UseRealTime();
+BENCHMARK( BM_ThreadPoolParallelFor )->Arg( 1000 )->Unit( benchmark::kMillisecond )->UseRealTime();
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <io/file/async_file_io.hpp>
+#include <io/file/file_io.hpp>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace ccl::sys::io;
+
+// Each test runs on io_uring (when available) and on the fallback
+class AsyncFileIOTest : public ::testing::TestWithParam<bool> {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        auto name = "ccl_async_io_" + std::to_string(::getpid()) + "_" +
+            std::to_string(GetParam()) + ".txt";
+        path = (std::filesystem::temp_directory_path() / name).string();
+        std::filesystem::remove(path);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+
+    void create(const std::string& content) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << content;
+    }
+
+    std::string content() const {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+};
+
+TEST_P(AsyncFileIOTest, BackendSelection) {
+    AsyncFileIO aio(8, GetParam());
+    if (GetParam()) {
+        EXPECT_EQ(aio.getBackend(), AsyncFileIO::Backend::ThreadPool);
+    }
+}
+
+TEST_P(AsyncFileIOTest, BatchedReadsWithFutures) {
+    std::string data;
+    for (int i = 0; i < 64; ++i) data += static_cast<char>('A' + i % 26);
+    create(data);
+
+    FileIO file(path, iom::Read);
+    AsyncFileIO aio(8, GetParam());
+
+    // More reads than the queue depth, so that part of them is submitted implicitly
+    std::vector<std::array<char, 4>> chunks(16);
+    std::vector<std::future<ssize_t>> results;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        results.push_back(aio.read(file, chunks[i].data(), 4, static_cast<OFF_T>(i * 4)));
+    }
+
+    aio.submit();
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        ASSERT_EQ(results[i].get(), 4);
+        EXPECT_EQ(std::string(chunks[i].data(), 4), data.substr(i * 4, 4));
+    }
+}
+
+TEST_P(AsyncFileIOTest, WritesWithCallbacks) {
+    FileIO file(path, iom::Read | iom::Write | iom::Create | iom::Trunc);
+    AsyncFileIO aio(32, GetParam());
+
+    std::atomic<ssize_t> total{0};
+    std::vector<std::string> parts = { "alpha-", "beta--", "gamma-" };
+
+    for (size_t i = 0; i < parts.size(); ++i) {
+        aio.write(file, parts[i].c_str(), parts[i].size(), static_cast<OFF_T>(i * 6),
+            [&total](ssize_t r) { total += r; });
+    }
+
+    EXPECT_EQ(aio.submit(), 3u);
+    aio.wait();
+
+    EXPECT_EQ(aio.getInflight(), 0u);
+    EXPECT_EQ(total.load(), 18);
+    EXPECT_EQ(content(), "alpha-beta--gamma-");
+}
+
+TEST_P(AsyncFileIOTest, FixedFileAndRegisteredBuffers) {
+    create("0123456789");
+    FileIO file(path, iom::Read | iom::Write);
+    AsyncFileIO aio(8, GetParam());
+
+    std::vector<char> memory(16, 0);
+    std::vector<std::span<char>> buffers = { std::span<char>(memory) };
+    aio.registerBuffers(buffers);
+
+    PosixFileDescriptor handler(::dup(file.getNativeHandle()));
+    int slot = aio.registerFile(handler);
+    EXPECT_GE(slot, 0);
+
+    auto result = aio.read(AsyncTarget::fixed(slot), memory.data(), 10, 0, 0);
+    aio.submit();
+    EXPECT_EQ(result.get(), 10);
+    EXPECT_EQ(std::string(memory.data(), 10), "0123456789");
+
+    std::memcpy(memory.data(), "ab", 2);
+    auto written = aio.write(AsyncTarget::fixed(slot), memory.data(), 2, 8, 0);
+    aio.submit();
+    EXPECT_EQ(written.get(), 2);
+    EXPECT_EQ(content(), "01234567ab");
+
+    aio.unregisterFile(slot);
+    aio.unregisterBuffers();
+}
+
+TEST_P(AsyncFileIOTest, ErrorsAreNegativeErrno) {
+    create("data");
+    FileIO file(path, iom::Read);
+    AsyncFileIO aio(8, GetParam());
+
+    // The file is read only
+    auto result = aio.write(file, "x", 1, 0);
+    aio.submit();
+    EXPECT_EQ(result.get(), -EBADF);
+}
+
+TEST_P(AsyncFileIOTest, DestructorWaitsForQueuedOperations) {
+    std::atomic<int> completed{0};
+    {
+        FileIO file(path, iom::Read | iom::Write | iom::Create | iom::Trunc);
+        AsyncFileIO aio(8, GetParam());
+        for (int i = 0; i < 4; ++i) {
+            aio.write(file, "z", 1, i, [&completed](ssize_t) { completed++; });
+        }
+    }
+
+    EXPECT_EQ(completed.load(), 4);
+    EXPECT_EQ(content(), "zzzz");
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, AsyncFileIOTest, ::testing::Values(false, true),
+    [](const ::testing::TestParamInfo<bool>& info) {
+        return info.param ? std::string("Fallback") : std::string("Default");
+    });
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <logging/async_logger.hpp>
+#include <filesystem>
+#include <fstream>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace ccl::logging;
+
+class AsyncLoggerTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        auto name = "ccl_async_logger_" + std::to_string(::getpid()) + "_" +
+            ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".log";
+        path = (std::filesystem::temp_directory_path() / name).string();
+        std::filesystem::remove(path);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+
+    std::vector<std::string> lines() const {
+        std::ifstream in(path);
+        std::vector<std::string> result;
+        for (std::string line; std::getline(in, line);) result.push_back(line);
+        return result;
+    }
+};
+
+TEST_F(AsyncLoggerTest, WritesFormattedMessages) {
+    AsyncLogger logger(path);
+    logger.info("first");
+    logger.warning("second");
+    logger.error("third");
+    logger.flush();
+
+    auto result = lines();
+    ASSERT_EQ(result.size(), 3u);
+
+    std::regex pattern(R"(\[\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2}\] \[(\w+)\] (\w+))");
+    std::smatch match;
+    ASSERT_TRUE(std::regex_match(result[0], match, pattern));
+    EXPECT_EQ(match[1], "INFO");
+    EXPECT_EQ(match[2], "first");
+    ASSERT_TRUE(std::regex_match(result[1], match, pattern));
+    EXPECT_EQ(match[1], "WARNING");
+    ASSERT_TRUE(std::regex_match(result[2], match, pattern));
+    EXPECT_EQ(match[1], "ERROR");
+}
+
+TEST_F(AsyncLoggerTest, FiltersLevelsBeforeBuildingMessages) {
+    AsyncLoggerConfig config;
+    config.level = LoggingLevel::WARNING;
+    AsyncLogger logger(path, config);
+
+    int built = 0;
+    auto builder = [&built]() { ++built; return std::string("built"); };
+
+    EXPECT_FALSE(logger.isEnabled(LoggingLevel::INFO));
+    logger.log(LoggingLevel::INFO, builder);
+    logger.info("skipped");
+    EXPECT_EQ(built, 0);
+
+    logger.log(LoggingLevel::ERROR, builder);
+    EXPECT_EQ(built, 1);
+
+    logger.setLevel(LoggingLevel::INFO);
+    logger.info("now logged");
+    logger.flush();
+
+    auto result = lines();
+    ASSERT_EQ(result.size(), 2u);
+    EXPECT_NE(result[0].find("[ERROR] built"), std::string::npos);
+    EXPECT_NE(result[1].find("[INFO] now logged"), std::string::npos);
+}
+
+TEST_F(AsyncLoggerTest, LongMessagesAreNotTruncated) {
+    std::string msg(3 * AsyncLogger::INLINE_SIZE, 'x');
+
+    {
+        AsyncLogger logger(path);
+        logger.info(msg);
+        logger.info("short");
+    }
+
+    auto result = lines();
+    ASSERT_EQ(result.size(), 2u);
+    EXPECT_NE(result[0].find("[INFO] " + msg), std::string::npos);
+    EXPECT_NE(result[1].find("[INFO] short"), std::string::npos);
+}
+
+TEST_F(AsyncLoggerTest, BlockPolicyKeepsEveryMessage) {
+    constexpr int threads = 4;
+    constexpr int messages = 2000;
+
+    {
+        AsyncLoggerConfig config;
+        config.queue_capacity = 16;
+        config.loss_policy = ccl::ds::LossPolicy::BLOCK;
+        AsyncLogger logger(path, config);
+
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threads; ++t) {
+            producers.emplace_back([&logger, t]() {
+                for (int i = 0; i < messages; ++i) {
+                    logger.info(std::to_string(t) + " " + std::to_string(i));
+                }
+            });
+        }
+
+        for (auto& producer : producers) producer.join();
+        EXPECT_EQ(logger.getDropped(), 0u);
+    }
+
+    // Messages of the same thread keep their order
+    std::vector<int> next(threads, 0);
+    auto result = lines();
+    ASSERT_EQ(result.size(), static_cast<size_t>(threads * messages));
+
+    for (const auto& line : result) {
+        auto msg = line.substr(line.find("[INFO] ") + 7);
+        int t = std::stoi(msg.substr(0, msg.find(' ')));
+        int i = std::stoi(msg.substr(msg.find(' ') + 1));
+        EXPECT_EQ(i, next[t]++);
+    }
+}
+
+TEST_F(AsyncLoggerTest, DropPolicyCountsLostMessages) {
+    constexpr size_t messages = 1000;
+
+    AsyncLoggerConfig config;
+    config.queue_capacity = 4;
+    config.flush_interval = std::chrono::milliseconds(500);
+    AsyncLogger logger(path, config);
+
+    for (size_t i = 0; i < messages; ++i) logger.info("message");
+    logger.flush();
+
+    size_t dropped = logger.getDropped();
+    EXPECT_GT(dropped, 0u);
+    EXPECT_EQ(lines().size() + dropped, messages);
+}
+
+TEST_F(AsyncLoggerTest, OverwriteOldestIsRejected) {
+    AsyncLoggerConfig config;
+    config.loss_policy = ccl::ds::LossPolicy::OVERWRITE_OLDEST;
+    EXPECT_THROW(AsyncLogger(path, config), std::invalid_argument);
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <logging/binary_log.hpp>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace ccl::logging;
+
+class BinaryLogTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        auto name = "ccl_binary_log_" + std::to_string(::getpid()) + "_" +
+            ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        path = (std::filesystem::temp_directory_path() / name).string();
+        cleanup();
+    }
+
+    void TearDown() override {
+        cleanup();
+    }
+
+    void cleanup() {
+        for (const auto& file : BinaryLogReader::segments(path)) std::filesystem::remove(file);
+    }
+
+    std::vector<DecodedMessage> decode() const {
+        std::vector<DecodedMessage> result;
+        for (const auto& file : BinaryLogReader::segments(path)) {
+            BinaryLogReader reader(file);
+            for (DecodedMessage message; reader.next(message);) result.push_back(message);
+        }
+        return result;
+    }
+};
+
+TEST_F(BinaryLogTest, DecodesTheSameTextOfFormatTo) {
+    std::string name = "worker";
+    int value = 42;
+    {
+        BinaryLogger logger(path);
+        logger.info("{} {} took {} us, ok={} {} {}", name, -7, 42.5, true, 'c', std::string_view("sv"));
+        logger.warning("{{literal}} {}{} {}", 18446744073709551615ull, 0.1f, static_cast<const void*>(&value));
+        logger.error("plain text");
+        logger.log(LoggingLevel::INFO, "{}", static_cast<const char*>(nullptr));
+    }
+
+    StaticFormatBuffer<128> expected;
+    formatTo(expected, "{{literal}} {}{} {}", 18446744073709551615ull, 0.1f, static_cast<const void*>(&value));
+
+    auto messages = decode();
+    ASSERT_EQ(messages.size(), 4u);
+    EXPECT_EQ(messages[0].text, "worker -7 took 42.5 us, ok=true c sv");
+    EXPECT_EQ(messages[0].level, LoggingLevel::INFO);
+    EXPECT_EQ(messages[1].text, expected.view());
+    EXPECT_EQ(messages[1].level, LoggingLevel::WARNING);
+    EXPECT_EQ(messages[2].text, "plain text");
+    EXPECT_EQ(messages[2].level, LoggingLevel::ERROR);
+    EXPECT_EQ(messages[3].text, "(null)");
+
+    // Timestamps are delta encoded, the absolute values must come back
+    auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    for (size_t idx = 0; idx < messages.size(); ++idx) {
+        EXPECT_LE(messages[idx].timestamp, now);
+        EXPECT_GT(messages[idx].timestamp, now - 60'000'000'000LL);
+        if (idx > 0) {
+            EXPECT_GE(messages[idx].timestamp, messages[idx - 1].timestamp);
+        }
+    }
+}
+
+TEST_F(BinaryLogTest, KeepsTheTypeOfStructuredData) {
+    std::vector<SD_Element> elements;
+    elements.emplace_back("request@32473");
+    elements.back().addParameter("path", "/index.html");
+    elements.back().addParameter("status", int64_t(-1));
+    elements.back().addParameter("bytes", uint64_t(1) << 40);
+    elements.back().addParameter("ratio", 0.25);
+    elements.back().addParameter("cached", true);
+    {
+        BinaryLogger logger(path);
+        logger.log(LoggingLevel::WARNING, elements, "served {}", 200);
+        logger.log(LoggingLevel::INFO, std::span<const SD_Element>(), "no data");
+    }
+
+    auto messages = decode();
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_EQ(messages[0].text, "served 200");
+    ASSERT_EQ(messages[0].elements.size(), 1u);
+    EXPECT_TRUE(messages[1].elements.empty());
+
+    const SD_Element& element = messages[0].elements[0];
+    EXPECT_EQ(element.getId(), "request@32473");
+
+    SD_Element::SD_Value value;
+    ASSERT_EQ(element.getValue("path", value), 0);
+    EXPECT_EQ(std::get<std::string>(value), "/index.html");
+    ASSERT_EQ(element.getValue("status", value), 0);
+    EXPECT_EQ(std::get<int64_t>(value), -1);
+    ASSERT_EQ(element.getValue("bytes", value), 0);
+    EXPECT_EQ(std::get<uint64_t>(value), uint64_t(1) << 40);
+    ASSERT_EQ(element.getValue("ratio", value), 0);
+    EXPECT_EQ(std::get<double>(value), 0.25);
+    ASSERT_EQ(element.getValue("cached", value), 0);
+    EXPECT_TRUE(std::get<bool>(value));
+
+    std::string text;
+    ASSERT_EQ(element.getValue("bytes", text), 0);
+    EXPECT_EQ(text, "1099511627776");
+}
+
+TEST_F(BinaryLogTest, RotatesSegmentsThatDecodeOnTheirOwn) {
+    BinaryLogConfig config;
+    config.segment_size = 4096;
+    config.window_size = 4096;
+    {
+        BinaryLogger logger(path, config);
+        for (int idx = 0; idx < 1000; ++idx) logger.info("message {} of {}", idx, "rotation");
+    }
+
+    auto files = BinaryLogReader::segments(path);
+    ASSERT_GT(files.size(), 1u);
+
+    int expected = 0;
+    for (const auto& file : files) {
+        EXPECT_LE(std::filesystem::file_size(file), config.segment_size);
+
+        // Every segment carries its own format definitions
+        BinaryLogReader reader(file);
+        for (DecodedMessage message; reader.next(message); ++expected) {
+            EXPECT_EQ(message.text, "message " + std::to_string(expected) + " of rotation");
+        }
+    }
+    EXPECT_EQ(expected, 1000);
+
+    // A new logger never overwrites existing segments
+    {
+        BinaryLogger logger(path, config);
+        EXPECT_EQ(logger.getSegmentPath(), BinaryLogger::segmentPath(path, files.size()));
+        logger.info("restarted {}", 1);
+    }
+    EXPECT_EQ(decode().back().text, "restarted 1");
+}
+
+TEST_F(BinaryLogTest, FiltersLevelsAndRendersText) {
+    BinaryLogConfig config;
+    config.level = LoggingLevel::WARNING;
+    {
+        BinaryLogger logger(path, config);
+        logger.info("dropped {}", 1);
+        logger.warning("disk at {}%", 93);
+    }
+
+    auto files = BinaryLogReader::segments(path);
+    ASSERT_EQ(files.size(), 1u);
+
+    std::ostringstream out;
+    BinaryLogReader reader(files[0]);
+    EXPECT_EQ(reader.render(out), 1u);
+    EXPECT_NE(out.str().find("] [WARNING] disk at 93%\n"), std::string::npos);
+}
+
+TEST_F(BinaryLogTest, IsSmallerThanText) {
+    DefaultStringFormatter formatter;
+    StaticFormatBuffer<256> line;
+    size_t text_bytes = 0;
+    {
+        BinaryLogger logger(path);
+        for (int idx = 0; idx < 1000; ++idx) {
+            logger.info("request {} served in {} us", 1000 + idx, 42.5);
+
+            line.clear();
+            formatter.formatTo(line, LoggingLevel::INFO, "request {} served in {} us", 1000 + idx, 42.5);
+            text_bytes += line.size();
+        }
+    }
+
+    size_t binary_bytes = std::filesystem::file_size(BinaryLogReader::segments(path).at(0));
+    EXPECT_LT(2 * binary_bytes, text_bytes) << binary_bytes << " vs " << text_bytes;
+}
+
+TEST_F(BinaryLogTest, RejectsOtherFiles) {
+    std::string other = path + ".0";
+    {
+        std::FILE* file = std::fopen(other.c_str(), "w");
+        std::fputs("not a log", file);
+        std::fclose(file);
+    }
+
+    EXPECT_THROW(BinaryLogReader reader(other), std::runtime_error);
+}
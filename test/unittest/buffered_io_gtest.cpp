@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include <io/file/file_io.hpp>
+#include <io/file/buffered_io.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace ccl::sys::io;
+using ConstBuffer = FileIO::ConstBuffer;
+
+class BufferedFileIOTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        auto name = "ccl_buffered_io_" + std::to_string(::getpid()) + "_" +
+            ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".txt";
+        path = (std::filesystem::temp_directory_path() / name).string();
+        std::filesystem::remove(path);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+
+    std::string content() const {
+        std::ifstream in(path);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    static constexpr iom MODE = iom::Read | iom::Write | iom::Create | iom::Trunc;
+};
+
+TEST_F(BufferedFileIOTest, FileIOWritevGathersInOrder) {
+    FileIO file(path, MODE);
+    std::string a = "Hello", b = ", ", c = "World";
+    std::vector<ConstBuffer> buffers = { a, ConstBuffer(), b, c };
+
+    EXPECT_EQ(file.writev(buffers), 12);
+    EXPECT_EQ(file.tellp(), 12);
+    EXPECT_EQ(content(), "Hello, World");
+}
+
+TEST_F(BufferedFileIOTest, FileIOWritevMoreThanOneBatch) {
+    FileIO file(path, MODE);
+    std::vector<std::string> parts;
+    std::vector<ConstBuffer> buffers;
+    std::string expected;
+
+    for (size_t i = 0; i < FileIO::WRITEV_BATCH * 3 + 5; ++i) parts.push_back(std::to_string(i) + ";");
+    for (const auto& part : parts) {
+        buffers.emplace_back(part);
+        expected += part;
+    }
+
+    EXPECT_EQ(file.writev(buffers), static_cast<ssize_t>(expected.size()));
+    EXPECT_EQ(content(), expected);
+}
+
+TEST_F(BufferedFileIOTest, SmallWritesAreBufferedUntilFlush) {
+    BufferedFileIO file(path, MODE, 64);
+
+    EXPECT_EQ(file.write("abc", 3), 3);
+    EXPECT_EQ(file.write("def", 3), 3);
+    EXPECT_EQ(file.getBufferedBytes(), 6u);
+    EXPECT_EQ(content(), "");
+
+    EXPECT_EQ(file.flush(), 6);
+    EXPECT_EQ(file.getBufferedBytes(), 0u);
+    EXPECT_EQ(content(), "abcdef");
+}
+
+TEST_F(BufferedFileIOTest, LargeWriteBypassesTheBuffer) {
+    BufferedFileIO file(path, MODE, 16);
+    std::string large(100, 'x');
+
+    file.write("head", 4);
+    EXPECT_EQ(file.write(large.c_str(), large.size()), 100);
+
+    // Written along with the buffered content, nothing left behind
+    EXPECT_EQ(file.getBufferedBytes(), 0u);
+    EXPECT_EQ(content(), "head" + large);
+}
+
+TEST_F(BufferedFileIOTest, WritevCoalescesSmallBuffers) {
+    BufferedFileIO file(path, MODE, 64);
+    std::string a = "one ", b = "two ", c = "three";
+    std::vector<ConstBuffer> buffers = { a, b, c };
+
+    EXPECT_EQ(file.writev(buffers), 13);
+    EXPECT_EQ(file.getBufferedBytes(), 13u);
+    EXPECT_EQ(content(), "");
+
+    file.flush();
+    EXPECT_EQ(content(), "one two three");
+}
+
+TEST_F(BufferedFileIOTest, WritevLargerThanBufferGoesThrough) {
+    BufferedFileIO file(path, MODE, 8);
+    std::string a = "0123", b(20, 'b'), c = "end";
+    std::vector<ConstBuffer> buffers = { b, c };
+
+    file.write(a.c_str(), a.size());
+    EXPECT_EQ(file.writev(buffers), 23);
+    EXPECT_EQ(file.getBufferedBytes(), 0u);
+    EXPECT_EQ(content(), a + b + c);
+}
+
+TEST_F(BufferedFileIOTest, MaxBytesThresholdFlushes) {
+    FlushPolicy policy;
+    policy.max_bytes = 8;
+    BufferedFileIO file(path, MODE, 64, policy);
+
+    file.write("1234", 4);
+    EXPECT_EQ(content(), "");
+
+    file.write("5678", 4);
+    EXPECT_EQ(file.getBufferedBytes(), 0u);
+    EXPECT_EQ(content(), "12345678");
+}
+
+TEST_F(BufferedFileIOTest, MaxAgeFlushesInBackground) {
+    FlushPolicy policy;
+    policy.max_age = std::chrono::milliseconds(10);
+    BufferedFileIO file(path, MODE, 64, policy);
+
+    file.write("late", 4);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (file.getBufferedBytes() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    EXPECT_EQ(file.getBufferedBytes(), 0u);
+    EXPECT_EQ(content(), "late");
+}
+
+TEST_F(BufferedFileIOTest, DestructorFlushes) {
+    {
+        BufferedFileIO file(path, MODE, 64);
+        file.write("pending", 7);
+    }
+
+    EXPECT_EQ(content(), "pending");
+}
+
+TEST_F(BufferedFileIOTest, MoveKeepsBufferedContent) {
+    FlushPolicy policy;
+    policy.max_age = std::chrono::milliseconds(1000);
+
+    BufferedFileIO file(path, MODE, 64, policy);
+    file.write("moved", 5);
+
+    BufferedFileIO other(std::move(file));
+    EXPECT_EQ(other.getBufferedBytes(), 5u);
+    EXPECT_EQ(other.getFlushPolicy().max_age, policy.max_age);
+
+    other.flush();
+    EXPECT_EQ(content(), "moved");
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <metrics/metrics_broker.hpp>
+#include <metrics/metrics_gather.hpp>
+#include <metrics/metrics_logger.hpp>
+#include <metrics/scope_timer.hpp>
+#include <unistd.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ccl::metrics;
+
+static std::string read_file(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static size_t count_of(const std::string& text, const std::string& pattern) {
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+class ChromeTraceTest : public ::testing::Test {
+protected:
+    std::string m_path;
+
+    void SetUp() override {
+        m_path = (std::filesystem::temp_directory_path() /
+                  ("ccl_trace_" + std::to_string(getpid()) + ".json")).string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(m_path);
+    }
+};
+
+TEST_F(ChromeTraceTest, WritesCompleteEvents) {
+    const std::string pid = std::to_string(getpid());
+
+    {
+        ChromeTraceLogger logger(m_path);
+
+        Metrics metrics {};
+        metrics.m_start_time = Metrics::timep_t(std::chrono::microseconds(5'000'000));
+        metrics.m_duration = 250;
+        metrics.m_cpu_time = 120;
+        logger.consume(std::make_shared<const MetricEvent>("main", "say \"hi\"", metrics, 42));
+
+        uint32_t outer = CallSiteRegistry::intern("outer", __FILE__, __LINE__);
+        uint32_t inner = CallSiteRegistry::intern("inner", __FILE__, __LINE__);
+        std::vector<ScopeRecord> records = {
+            { inner, outer, 7, 1'000'500, 1'002'000 },
+            { outer, 0, 7, 1'000'000, 1'003'000 },
+        };
+        logger.consume(std::make_shared<const ScopeBatchEvent>(records));
+
+        EXPECT_EQ(logger.getSpans(), 3u);
+    }
+
+    std::string trace = read_file(m_path);
+    EXPECT_EQ(trace.rfind("[\n{", 0), 0u);
+    EXPECT_EQ(trace.substr(trace.size() - 3), "\n]\n");
+    EXPECT_EQ(count_of(trace, "\"ph\":\"X\""), 3u);
+    EXPECT_EQ(count_of(trace, "},\n{"), 2u);
+
+    EXPECT_NE(trace.find("{\"name\":\"say \\\"hi\\\"\",\"cat\":\"ccl\",\"ph\":\"X\",\"ts\":5000000,\"dur\":250,"
+                         "\"pid\":" + pid + ",\"tid\":42,\"args\":{\"parent\":\"main\",\"cpu_us\":120}}"),
+              std::string::npos);
+
+    // Durations keep the nanoseconds, the root has no arguments
+    EXPECT_NE(trace.find("\"dur\":1.500,\"pid\":" + pid + ",\"tid\":7,\"args\":{\"parent\":\"outer\"}}"),
+              std::string::npos);
+    EXPECT_NE(trace.find("\"dur\":3,\"pid\":" + pid + ",\"tid\":7}"), std::string::npos);
+}
+
+TEST_F(ChromeTraceTest, TimersShareTheClockOfTheCollectors) {
+    {
+        auto logger = std::make_shared<ChromeTraceLogger>(m_path);
+        logger->start();
+        MetricsBroker::getInstance()->subscribe<ScopeBatchEvent>(logger);
+
+        auto before = std::chrono::system_clock::now();
+        {
+            CCL_SCOPE_TIMER_NAMED("traced");
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+        MetricsBroker::getInstance()->getSink().flush();
+        MetricsBroker::getInstance()->unsubscribe<ScopeBatchEvent>(logger);
+        logger->stop();
+        logger->flush();
+
+        EXPECT_EQ(logger->getSpans(), 1u);
+
+        std::string trace = read_file(m_path);
+        size_t ts = trace.find("\"ts\":");
+        ASSERT_NE(ts, std::string::npos);
+
+        long long micros = std::stoll(trace.substr(ts + 5));
+        long long expected = std::chrono::duration_cast<std::chrono::microseconds>(
+            before.time_since_epoch()).count();
+        EXPECT_NEAR(static_cast<double>(micros), static_cast<double>(expected), 1e5);
+    }
+
+    EXPECT_NE(read_file(m_path).find("\"name\":\"traced\""), std::string::npos);
+}
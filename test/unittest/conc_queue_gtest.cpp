@@ -175,3 +175,47 @@ TEST_F(ConcurrentQueueTest, SetCapacity) {
     EXPECT_TRUE(q.full());
 }
 
+
+// Batched pop of the available elements
+TEST_F(ConcurrentQueueTest, PopNTakesAvailableElements) {
+    ConcurrentQueue<int> q(10);
+    for (int i = 0; i < 5; ++i) q.push(i);
+
+    int values[8] = {};
+    EXPECT_EQ(q.popN(values, 3), 3u);
+    EXPECT_EQ(values[0], 0);
+    EXPECT_EQ(values[2], 2);
+
+    // No more than available, without waiting
+    EXPECT_EQ(q.popN(values, 8), 2u);
+    EXPECT_EQ(values[0], 3);
+    EXPECT_EQ(values[1], 4);
+    EXPECT_TRUE(q.empty());
+
+    EXPECT_EQ(q.tryPopN(values, 8), 0u);
+    q.push(7);
+    EXPECT_EQ(q.tryPopN(values, 8), 1u);
+    EXPECT_EQ(values[0], 7);
+}
+
+// Batched pop waits for the first element, and frees the room
+TEST_F(ConcurrentQueueTest, PopNBlocksWhenEmpty) {
+    ConcurrentQueue<int> q(2);
+    q.push(1);
+    q.push(2);
+
+    std::thread producer([&q]() {
+        for (int i = 3; i <= 6; ++i) q.push(i);
+    });
+
+    std::vector<int> received;
+    int values[4];
+    while (received.size() < 6) {
+        size_t n = q.popN(values, 4);
+        EXPECT_GE(n, 1u);
+        received.insert(received.end(), values, values + n);
+    }
+
+    producer.join();
+    EXPECT_EQ(received, std::vector<int>({ 1, 2, 3, 4, 5, 6 }));
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <io/file/file_io.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
+
+using namespace ccl::sys::io;
+
+class FileIOTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        auto name = "ccl_file_io_" + std::to_string(::getpid()) + "_" +
+            ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".txt";
+        path = (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+
+    void create(const std::string& content) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << content;
+    }
+};
+
+TEST_F(FileIOTest, ReadLineKeepsTerminators) {
+    create("first\nsecond\nlast");
+    FileIO file(path, iom::Read);
+
+    std::string line;
+    EXPECT_EQ(file.readLine(line), 6);
+    EXPECT_EQ(line, "first\n");
+    EXPECT_EQ(file.readLine(line), 7);
+    EXPECT_EQ(line, "second\n");
+    EXPECT_EQ(file.readLine(line), 4);
+    EXPECT_EQ(line, "last");
+    EXPECT_EQ(file.readLine(line), 0);
+    EXPECT_EQ(line, "");
+    EXPECT_EQ(file.tellg(), 17);
+}
+
+TEST_F(FileIOTest, ReadLineViewWithoutCopies) {
+    create("a\n\nbc\n");
+    FileIO file(path, iom::Read);
+
+    std::string_view line;
+    EXPECT_EQ(file.readLine(line), 2);
+    EXPECT_EQ(line, "a\n");
+    EXPECT_EQ(file.readLine(line), 1);
+    EXPECT_EQ(line, "\n");
+    EXPECT_EQ(file.readLine(line), 3);
+    EXPECT_EQ(line, "bc\n");
+    EXPECT_EQ(file.readLine(line), 0);
+    EXPECT_TRUE(line.empty());
+}
+
+TEST_F(FileIOTest, LinesAcrossReadAheadChunks) {
+    // Lines longer than the read-ahead buffer and crossing chunk boundaries
+    std::string longLine(FileIOBase::READ_AHEAD_SIZE * 2 + 123, 'x');
+    std::string shortLine = "short";
+    std::string content;
+    for (int i = 0; i < 3; ++i) content += longLine + "\n" + shortLine + "\n";
+    create(content);
+
+    FileIO file(path, iom::Read);
+    std::string_view line;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(file.readLine(line), static_cast<ssize_t>(longLine.size() + 1));
+        EXPECT_EQ(line.substr(0, longLine.size()), longLine);
+        ASSERT_EQ(file.readLine(line), static_cast<ssize_t>(shortLine.size() + 1));
+        EXPECT_EQ(line, shortLine + "\n");
+    }
+
+    EXPECT_EQ(file.readLine(line), 0);
+}
+
+TEST_F(FileIOTest, GetNofLinesFromReadPointer) {
+    create("1\n2\n3\n4");
+    FileIO file(path, iom::Read);
+
+    EXPECT_EQ(file.getNofLines(), 4u);
+    EXPECT_EQ(file.tellg(), 0);
+
+    std::string line;
+    file.readLine(line);
+    EXPECT_EQ(file.getNofLines(), 3u);
+
+    // The read pointer is left untouched
+    file.readLine(line);
+    EXPECT_EQ(line, "2\n");
+}
+
+TEST_F(FileIOTest, GetNofLinesEmptyAndTerminated) {
+    create("");
+    {
+        FileIO file(path, iom::Read);
+        EXPECT_EQ(file.getNofLines(), 0u);
+    }
+
+    create("x\ny\n");
+    FileIO file(path, iom::Read);
+    EXPECT_EQ(file.getNofLines(), 2u);
+}
+
+TEST_F(FileIOTest, SeekDropsReadAhead) {
+    create("one\ntwo\nthree\n");
+    FileIO file(path, iom::Read);
+
+    std::string line;
+    file.readLine(line);
+    file.readLine(line);
+    EXPECT_EQ(line, "two\n");
+
+    file.seekg(0, iop::Beg);
+    file.readLine(line);
+    EXPECT_EQ(line, "one\n");
+
+    file.seekg(-6, iop::End);
+    file.readLine(line);
+    EXPECT_EQ(line, "three\n");
+}
+
+TEST_F(FileIOTest, WriteDropsReadAhead) {
+    create("aaaa\nbbbb\n");
+    FileIO file(path, iom::Read | iom::Write);
+
+    std::string line;
+    file.readLine(line);
+    EXPECT_EQ(line, "aaaa\n");
+
+    // Overwrite the second line, already cached by the read-ahead
+    file.seekp(5, iop::Beg);
+    file.write("cccc\n", 5);
+
+    file.readLine(line);
+    EXPECT_EQ(line, "cccc\n");
+}
+
+TEST_F(FileIOTest, IteratorVisitsEveryLine) {
+    create("l1\nl2\nl3");
+    FileIO file(path, iom::Read);
+
+    std::vector<std::string> lines;
+    for (auto& line : file) lines.push_back(line);
+
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[0], "l1\n");
+    EXPECT_EQ(lines[1], "l2\n");
+    EXPECT_EQ(lines[2], "l3");
+    EXPECT_TRUE(file.begin() == file.end());
+}
+
+TEST_F(FileIOTest, ReadWholeContent) {
+    create("alpha\nbeta\n");
+    FileIO file(path, iom::Read);
+
+    std::string content;
+    file >> content;
+    EXPECT_EQ(content, "alpha\nbeta\n");
+}
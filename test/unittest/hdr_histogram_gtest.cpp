@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <metrics/hdr_histogram.hpp>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+
+using namespace ccl::metrics;
+
+TEST(HdrHistogramTest, EmptyHistogram) {
+    HdrHistogram hist;
+    EXPECT_EQ(hist.getCount(), 0u);
+    EXPECT_EQ(hist.getMin(), 0u);
+    EXPECT_EQ(hist.getMax(), 0u);
+    EXPECT_EQ(hist.getValueAtPercentile(50.0), 0u);
+    EXPECT_DOUBLE_EQ(hist.getMean(), 0.0);
+}
+
+TEST(HdrHistogramTest, SmallValuesAreExact) {
+    HdrHistogram hist(1'000'000, 3);
+    for (uint64_t value = 1; value <= 100; ++value) hist.record(value);
+
+    EXPECT_EQ(hist.getCount(), 100u);
+    EXPECT_EQ(hist.getMin(), 1u);
+    EXPECT_EQ(hist.getMax(), 100u);
+    EXPECT_EQ(hist.getSum(), 5050u);
+    EXPECT_EQ(hist.getValueAtPercentile(50.0), 50u);
+    EXPECT_EQ(hist.getValueAtPercentile(99.0), 99u);
+    EXPECT_EQ(hist.getValueAtPercentile(100.0), 100u);
+    EXPECT_EQ(hist.getValueAtPercentile(0.0), 1u);
+}
+
+TEST(HdrHistogramTest, PercentilesWithinPrecision) {
+    HdrHistogram hist(HdrHistogram::DEFAULT_HIGHEST, 2);
+    std::mt19937_64 rng(42);
+    std::lognormal_distribution<double> dist(8.0, 2.0);
+
+    std::vector<uint64_t> values;
+    for (int idx = 0; idx < 100'000; ++idx) {
+        uint64_t value = static_cast<uint64_t>(dist(rng)) + 1;
+        values.push_back(value);
+        hist.record(value);
+    }
+
+    std::sort(values.begin(), values.end());
+    for (double percentile: { 50.0, 90.0, 99.0, 99.9 }) {
+        size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * values.size())) - 1;
+        double exact = static_cast<double>(values[rank]);
+        double estimate = static_cast<double>(hist.getValueAtPercentile(percentile));
+        EXPECT_NEAR(estimate, exact, exact * 0.01 + 1) << "p" << percentile;
+    }
+}
+
+TEST(HdrHistogramTest, ValuesAboveHighestAreClamped) {
+    HdrHistogram hist(1000, 2);
+    hist.record(10);
+    hist.record(1'000'000);
+
+    EXPECT_EQ(hist.getCount(), 2u);
+    EXPECT_EQ(hist.getMax(), 1'000'000u);
+    EXPECT_EQ(hist.getValueAtPercentile(100.0), 1'000'000u);
+    EXPECT_GE(hist.getValueAtPercentile(99.0), 1000u);
+}
+
+TEST(HdrHistogramTest, MergeAndReset) {
+    HdrHistogram lhs(10'000, 2), rhs(10'000, 2);
+    for (uint64_t value = 1; value <= 50; ++value) lhs.record(value);
+    rhs.record(1000, 50);
+
+    lhs.merge(rhs);
+    EXPECT_EQ(lhs.getCount(), 100u);
+    EXPECT_EQ(lhs.getMax(), 1000u);
+    EXPECT_EQ(lhs.getValueAtPercentile(50.0), 50u);
+    EXPECT_NEAR(static_cast<double>(lhs.getValueAtPercentile(75.0)), 1000.0, 10.0);
+
+    HdrHistogram other(10'000, 3);
+    EXPECT_THROW(lhs.merge(other), std::invalid_argument);
+
+    lhs.reset();
+    EXPECT_EQ(lhs.getCount(), 0u);
+    EXPECT_EQ(lhs.getSum(), 0u);
+}
+
+TEST(HdrHistogramTest, InvalidConfiguration) {
+    EXPECT_THROW(HdrHistogram(1000, 0), std::invalid_argument);
+    EXPECT_THROW(HdrHistogram(1000, 6), std::invalid_argument);
+    EXPECT_THROW(HdrHistogram(1, 2), std::invalid_argument);
+}
+
+TEST(HdrHistogramTest, MemoryIsBounded) {
+    // An hour in us with 2 digits fits in a few tens of KB
+    HdrHistogram hist;
+    EXPECT_LT(hist.getMemorySize(), 32u * 1024);
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <logging/formatting.hpp>
+#include <logging/format_string.hpp>
+#include <regex>
+#include <string>
+
+using namespace ccl::logging;
+
+struct Point { int x; int y; };
+
+// Custom types are formatted through an overload found by ADL
+void formatArg(FormatBuffer& out, const Point& p) {
+    formatTo(out, "({}, {})", p.x, p.y);
+}
+
+TEST(FormatStringTest, FormatsArguments) {
+    StaticFormatBuffer<128> out;
+    std::string name = "worker";
+    formatTo(out, "{} {} took {} us, ok={} {} {}", name, 7, 42.5, true, 'c', std::string_view("sv"));
+    EXPECT_EQ(out.view(), "worker 7 took 42.5 us, ok=true c sv");
+    EXPECT_FALSE(out.isTruncated());
+}
+
+TEST(FormatStringTest, HandlesEscapesAndEdges) {
+    StaticFormatBuffer<64> out;
+    formatTo(out, "{{literal}} {}{}", -1, 18446744073709551615ull);
+    EXPECT_EQ(out.view(), "{literal} -118446744073709551615");
+
+    out.clear();
+    formatTo(out, "no fields");
+    EXPECT_EQ(out.view(), "no fields");
+
+    out.clear();
+    formatTo(out, "{}", Point{1, 2});
+    EXPECT_EQ(out.view(), "(1, 2)");
+
+    out.clear();
+    const char* null = nullptr;
+    formatTo(out, "{} {}", null, static_cast<const void*>(nullptr));
+    EXPECT_EQ(out.view(), "(null) 0x0");
+}
+
+TEST(FormatStringTest, TruncatesWithoutOverflow) {
+    StaticFormatBuffer<8> out;
+    formatTo(out, "abc {} def", 123456);
+    EXPECT_EQ(out.view(), "abc ");
+    EXPECT_TRUE(out.isTruncated());
+
+    out.clear();
+    EXPECT_FALSE(out.isTruncated());
+    formatTo(out, "{}", std::string(20, 'x'));
+    EXPECT_EQ(out.view(), std::string(8, 'x'));
+    EXPECT_TRUE(out.isTruncated());
+}
+
+TEST(FormatStringTest, TimestampCacheRendersOncePerSecond) {
+    TimestampCache utc("%Y-%m-%dT%H:%M:%S", true);
+    EXPECT_EQ(utc.render(int64_t(0)), "1970-01-01T00:00:00");
+    EXPECT_EQ(utc.render(int64_t(86400 + 61)), "1970-01-02T00:01:01");
+
+    auto first = utc.render(int64_t(86400 + 61));
+    EXPECT_EQ(first.data(), utc.render(int64_t(86400 + 61)).data());
+}
+
+TEST(FormattersTest, DefaultFormatterKeepsItsLayout) {
+    DefaultStringFormatter formatter;
+    std::regex pattern(R"(\[\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2}\] \[WARNING\] disk at 93%\n)");
+
+    EXPECT_TRUE(std::regex_match(formatter.format(LoggingLevel::WARNING, "disk at 93%"), pattern));
+
+    StaticFormatBuffer<256> out;
+    formatter.formatTo(out, LoggingLevel::WARNING, "disk at {}%", 93);
+    EXPECT_TRUE(std::regex_match(std::string(out.view()), pattern));
+
+    // Longer than the thread buffer
+    std::string msg(2 * THREAD_BUFFER_SIZE, 'x');
+    std::string line = formatter.format(LoggingLevel::INFO, msg);
+    EXPECT_NE(line.find("[INFO] " + msg + "\n"), std::string::npos);
+}
+
+TEST(FormattersTest, SysLogFormatterFollowsRfc5424) {
+    SysLogFormatter formatter;
+    formatter.addElement("exampleSDID@32473");
+    formatter.addParameter("exampleSDID@32473", "eventSource", "App\"lication]");
+
+    std::string line = formatter.format(SysLogFacility::LOCAL_USE_4, SysLogSeverity::NOTICE, "started");
+
+    std::regex pattern(R"(<165>1 \d{4}-\d{2}-\d{2}T\d{2}:\d{2}:\d{2}\.\d{6}Z \S+ - \d+ - )"
+                       R"(\[exampleSDID@32473 eventSource="App\\"lication\\]"\] started)");
+    EXPECT_TRUE(std::regex_match(line, pattern)) << line;
+
+    SysLogFormatter empty;
+    std::string nil = empty.format(SysLogFacility::KERNEL, SysLogSeverity::EMERGENCY, "");
+    EXPECT_EQ(nil.substr(0, 5), "<0>1 ");
+    EXPECT_EQ(nil.substr(nil.size() - 2), " -");
+
+    // Message and structured data longer than the thread buffer
+    std::string msg(2 * THREAD_BUFFER_SIZE, 'x');
+    std::string long_line = formatter.format(SysLogFacility::LOCAL_USE_4, SysLogSeverity::NOTICE, msg);
+    EXPECT_EQ(long_line.substr(long_line.size() - msg.size() - 1), " " + msg);
+
+    std::string value(3 * THREAD_BUFFER_SIZE, 'v');
+    formatter.addParameter("exampleSDID@32473", "payload", value);
+    long_line = formatter.format(SysLogFacility::LOCAL_USE_4, SysLogSeverity::NOTICE, msg);
+    EXPECT_NE(long_line.find("payload=\"" + value + "\""), std::string::npos);
+    EXPECT_EQ(long_line.substr(long_line.size() - msg.size() - 1), " " + msg);
+}
@@ -0,0 +1,255 @@
+#include <gtest/gtest.h>
+#include <metrics/metrics_broker.hpp>
+#include <metrics/metrics_gather.hpp>
+#include <metrics/metrics_logger.hpp>
+#include <metrics/metrics_sink.hpp>
+#include <metrics/metrics_utils.hpp>
+#include <patterns/pub_sub/broker.hpp>
+#include <patterns/pub_sub/subscriber.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ccl::metrics;
+namespace ps = ccl::dp::pub_sub;
+
+class CountingSubscriber : public ps::Subscriber {
+public:
+    std::atomic<size_t> m_count = 0;
+    std::mutex m_mutex;
+    std::vector<std::string> m_names;
+
+protected:
+    void notify(event_ptr& event) override {
+        auto metric_ev = std::static_pointer_cast<const MetricEvent>(event);
+        std::lock_guard<std::mutex> _l(m_mutex);
+        m_names.push_back(metric_ev->m_func_name);
+        m_count.fetch_add(1);
+    }
+};
+
+static MetricsRecord make_record(const std::string& name) {
+    MetricsRecord record;
+    record.m_func_name = name;
+    record.m_metrics = {};
+    record.m_thread_id = get_thread_id();
+    return record;
+}
+
+TEST(MetricsSinkTest, DeliversThroughTheBroker) {
+    ps::PubSubBroker broker;
+    auto subscriber = std::make_shared<CountingSubscriber>();
+    broker.subscribe<MetricEvent>(subscriber);
+
+    {
+        MetricsSink sink(broker);
+        for (int idx = 0; idx < 10; ++idx) {
+            EXPECT_TRUE(sink.push(make_record(std::string("f").append(std::to_string(idx)))));
+        }
+
+        sink.flush();
+        EXPECT_EQ(subscriber->m_count.load(), 10u);
+
+        // Same thread: same order
+        for (int idx = 0; idx < 10; ++idx) {
+            EXPECT_EQ(subscriber->m_names[idx], std::string("f").append(std::to_string(idx)));
+        }
+
+        EXPECT_TRUE(sink.push(make_record("last")));
+    }
+
+    // Pending records are delivered on destruction
+    EXPECT_EQ(subscriber->m_count.load(), 11u);
+}
+
+TEST(MetricsSinkTest, ManyThreads) {
+    ps::PubSubBroker broker;
+    auto subscriber = std::make_shared<CountingSubscriber>();
+    broker.subscribe<MetricEvent>(subscriber);
+
+    MetricsSinkConfig config;
+    config.queue_capacity = 16;
+    config.loss_policy = ccl::ds::LossPolicy::BLOCK;
+    MetricsSink sink(broker, config);
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([&sink] {
+            for (int idx = 0; idx < 1000; ++idx) sink.push(make_record("work"));
+        });
+    }
+
+    for (auto& thread: threads) thread.join();
+
+    // The queues of the exited threads are still drained
+    sink.flush();
+    EXPECT_EQ(subscriber->m_count.load(), 4000u);
+    EXPECT_EQ(sink.getDropped(), 0u);
+}
+
+TEST(MetricsSinkTest, DropsWhenFull) {
+    ps::PubSubBroker broker;
+    auto subscriber = std::make_shared<CountingSubscriber>();
+    broker.subscribe<MetricEvent>(subscriber);
+
+    MetricsSinkConfig config;
+    config.queue_capacity = 4;
+    config.drain_interval = std::chrono::seconds(60);
+    MetricsSink sink(broker, config);
+
+    size_t pushed = 0;
+    for (int idx = 0; idx < 1000; ++idx) pushed += sink.push(make_record("work"));
+
+    sink.flush();
+    EXPECT_GT(sink.getDropped(), 0u);
+    EXPECT_EQ(pushed + sink.getDropped(), 1000u);
+    EXPECT_EQ(subscriber->m_count.load(), pushed);
+}
+
+// Uses the sink from its notify, on the drainer thread
+class ReentrantSubscriber : public ps::Subscriber {
+public:
+    MetricsSink* m_sink = nullptr;
+    std::atomic<size_t> m_count = 0;
+    std::atomic<size_t> m_dropped = 0;
+
+protected:
+    void notify(event_ptr& event) override {
+        auto metric_ev = std::static_pointer_cast<const MetricEvent>(event);
+
+        // The first record of this thread registers its queue in the sink
+        if (metric_ev->m_func_name == "first") m_sink->push(make_record("echo"));
+
+        m_sink->flush();
+        m_dropped = m_sink->getDropped();
+        m_count.fetch_add(1);
+    }
+};
+
+TEST(MetricsSinkTest, SubscribersCanUseTheSink) {
+    ps::PubSubBroker broker;
+    auto subscriber = std::make_shared<ReentrantSubscriber>();
+    broker.subscribe<MetricEvent>(subscriber);
+
+    MetricsSinkConfig config;
+    config.drain_interval = std::chrono::milliseconds(1);
+    MetricsSink sink(broker, config);
+    subscriber->m_sink = &sink;
+
+    EXPECT_TRUE(sink.push(make_record("first")));
+
+    auto start = std::chrono::steady_clock::now();
+    while (subscriber->m_count.load() < 2 && std::chrono::steady_clock::now() - start < std::chrono::seconds(10)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_EQ(subscriber->m_count.load(), 2u);
+    EXPECT_EQ(subscriber->m_dropped.load(), 0u);
+}
+
+// Instrumented subscriber: each event pushes a record back into the sink
+class EchoingSubscriber : public ps::Subscriber {
+public:
+    MetricsSink* m_sink = nullptr;
+    std::atomic<size_t> m_events = 0;
+    std::atomic<size_t> m_echoes = 0;
+
+protected:
+    void notify(event_ptr& event) override {
+        auto metric_ev = std::static_pointer_cast<const MetricEvent>(event);
+        if (metric_ev->m_func_name == "echo") {
+            m_echoes.fetch_add(1);
+            return;
+        }
+
+        m_sink->push(make_record("echo"));
+        m_events.fetch_add(1);
+    }
+};
+
+TEST(MetricsSinkTest, BlockingSubscribersCanUseTheSink) {
+    ps::PubSubBroker broker;
+    auto subscriber = std::make_shared<EchoingSubscriber>();
+    broker.subscribe<MetricEvent>(subscriber);
+
+    // A single pass delivers more records than a queue can hold
+    MetricsSinkConfig config;
+    config.queue_capacity = 8;
+    config.loss_policy = ccl::ds::LossPolicy::BLOCK;
+
+    size_t dropped = 0;
+    {
+        MetricsSink sink(broker, config);
+        subscriber->m_sink = &sink;
+
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < 2; ++thread) {
+            threads.emplace_back([&sink] {
+                for (int idx = 0; idx < 64; ++idx) EXPECT_TRUE(sink.push(make_record("work")));
+            });
+        }
+
+        for (auto& thread : threads) thread.join();
+        sink.flush();
+        dropped = sink.getDropped();
+    }
+
+    // The echoes the delivering thread could not queue are dropped
+    EXPECT_EQ(subscriber->m_events.load(), 128u);
+    EXPECT_EQ(subscriber->m_echoes.load() + dropped, 128u);
+}
+
+TEST(MetricsSinkTest, OverwriteOldestIsRejected) {
+    ps::PubSubBroker broker;
+    MetricsSinkConfig config;
+    config.loss_policy = ccl::ds::LossPolicy::OVERWRITE_OLDEST;
+    EXPECT_THROW(MetricsSink(broker, config), std::invalid_argument);
+}
+
+TEST(MetricsSinkTest, CollectorsDeliverThroughTheSink) {
+    auto logger = std::make_shared<TreeMetricsLogger>();
+    logger->start();
+
+    auto broker = MetricsBroker::getInstance();
+    broker->subscribe<MetricEvent>(logger);
+    MetricsBroker::setDelivery(MetricsDelivery::Sink);
+    MetricsBroker::setCollectionMode(CollectionMode::Fast);
+
+    auto scopes = [] {
+        for (int idx = 0; idx < 100; ++idx) {
+            auto outer = MetricsCollector::create("outer");
+            {
+                auto inner = MetricsCollector::create("inner");
+                inner->collect();
+            }
+            outer->collect();
+        }
+        return get_thread_id();
+    };
+
+    TID_t main_tid = scopes();
+    TID_t other_tid = 0;
+    std::thread other([&] { other_tid = scopes(); });
+    other.join();
+
+    MetricsBroker::setDelivery(MetricsDelivery::Direct);
+    MetricsBroker::setCollectionMode(CollectionMode::Proc);
+    broker->getSink().flush();
+    logger->stop();
+    broker->unsubscribe<MetricEvent>(logger);
+
+    for (TID_t tid: { main_tid, other_tid }) {
+        auto outer = logger->getNode(tid, "", "outer");
+        auto inner = logger->getNode(tid, "outer", "inner");
+        ASSERT_NE(outer, nullptr);
+        ASSERT_NE(inner, nullptr);
+        EXPECT_EQ(outer->m_duration.getCount(), 100u);
+        EXPECT_EQ(inner->m_duration.getCount(), 100u);
+    }
+
+    EXPECT_EQ(broker->getSink().getDropped(), 0u);
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <metrics/metrics_broker.hpp>
+#include <metrics/metrics_gather.hpp>
+#include <metrics/metrics_utils.hpp>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace ccl::metrics;
+
+static long busy_for(std::chrono::milliseconds cpu) {
+    long start = get_thread_cpu_time();
+    volatile unsigned long sink = 0;
+    while (get_thread_cpu_time() - start < cpu.count() * 1000) {
+        for (int idx = 0; idx < 10000; ++idx) sink = sink + idx;
+    }
+    return get_thread_cpu_time() - start;
+}
+
+static __attribute__((noinline)) long stack_at_depth(int depth) {
+    volatile char frame[1024];
+    frame[0] = static_cast<char>(depth);
+    if (depth == 0) return get_stack_usage_fast() + frame[0];
+    return stack_at_depth(depth - 1) + frame[0];
+}
+
+TEST(MetricsUtilsTest, ThreadCpuTimeCountsOnlyTheCaller) {
+    EXPECT_GE(busy_for(std::chrono::milliseconds(20)), 20'000);
+
+    // Sleeping does not consume CPU, neither do the other threads
+    long start = get_thread_cpu_time();
+    std::thread other([] { busy_for(std::chrono::milliseconds(50)); });
+    other.join();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_LT(get_thread_cpu_time() - start, 20'000);
+}
+
+TEST(MetricsUtilsTest, ThreadIdIsCachedPerThread) {
+    int main_tid = get_thread_id();
+    EXPECT_EQ(main_tid, static_cast<int>(syscall(SYS_gettid)));
+    EXPECT_EQ(main_tid, get_thread_id());
+
+    int other_tid = 0;
+    std::thread other([&] { other_tid = get_thread_id(); });
+    other.join();
+    EXPECT_NE(other_tid, main_tid);
+}
+
+TEST(MetricsUtilsTest, StackUsageGrowsWithDepth) {
+    long shallow = get_stack_usage_fast();
+    EXPECT_GT(shallow, 0);
+    EXPECT_GT(stack_at_depth(16), shallow + 16 * 1024);
+
+    // Each thread has its own cached bounds
+    long other = 0;
+    std::thread thread([&] { other = get_stack_usage_fast(); });
+    thread.join();
+    EXPECT_GT(other, 0);
+    EXPECT_LT(other, 64 * 1024);
+}
+
+TEST(MetricsUtilsTest, HeapHooksCountThreadAllocations) {
+    ASSERT_TRUE(heap_hooks::installed.load());
+
+    // Escapes through a volatile pointer, otherwise the compiler may drop
+    // the unused allocation. The counters are read before any assertion,
+    // whose failure messages allocate too.
+    static char* volatile block = nullptr;
+
+    long before = get_heap_bytes();
+    long allocations = heap_hooks::allocations;
+    block = new char[100'000];
+    block[0] = 1;
+    long allocated = get_heap_bytes() - before;
+    long counted = heap_hooks::allocations - allocations;
+    delete[] block;
+    long freed = get_heap_bytes() - before;
+
+    EXPECT_GE(allocated, 100'000);
+    EXPECT_EQ(counted, 1);
+    EXPECT_EQ(freed, 0);
+
+    // Allocations of the other threads are not accounted here, except for
+    // the state handed over by std::thread, freed by the new thread
+    std::thread other([] { std::vector<char> data(1'000'000); });
+    other.join();
+    EXPECT_LT(get_heap_bytes() - before, 1'000);
+}
+
+TEST(MetricsUtilsTest, CollectorUsesTheFastProbes) {
+    MetricsBroker::setCollectionMode(CollectionMode::Fast);
+
+    Metrics metrics;
+    {
+        auto collector = MetricsCollector::create("fast_scope");
+        std::vector<char> data(2 * 1024 * 1024, 1);
+        busy_for(std::chrono::milliseconds(5));
+        collector->collect();
+        metrics = collector->getCollectedMetrics();
+    }
+
+    MetricsBroker::setCollectionMode(CollectionMode::Proc);
+
+    EXPECT_GE(metrics.m_heap_usage, 2 * 1024);
+    EXPECT_GE(metrics.m_cpu_time, 5'000u);
+    EXPECT_LE(metrics.m_cpu_time, metrics.m_duration + 1'000u);
+    EXPECT_GE(metrics.m_stack_usage, 0);
+}
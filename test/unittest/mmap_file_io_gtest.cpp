@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <io/file/mmap_file_io.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using namespace ccl::sys::io;
+
+class MappedFileIOTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        auto name = "ccl_mmap_io_" + std::to_string(::getpid()) + "_" +
+            ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".txt";
+        path = (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+
+    void create(const std::string& content) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << content;
+    }
+
+    std::string content() const {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+};
+
+TEST_F(MappedFileIOTest, ReadOnlyReadsLines) {
+    create("first\nsecond\nlast");
+    MappedFileIO file(path);
+
+    std::string line;
+    EXPECT_EQ(file.readLine(line), 6);
+    EXPECT_EQ(line, "first\n");
+    EXPECT_EQ(file.readLine(line), 7);
+    EXPECT_EQ(line, "second\n");
+    EXPECT_EQ(file.readLine(line), 4);
+    EXPECT_EQ(line, "last");
+    EXPECT_EQ(file.readLine(line), 0);
+}
+
+TEST_F(MappedFileIOTest, ReadOnlyIgnoresWritesAndNeverGrows) {
+    create("0123456789");
+    MappedFileIO file(path, advf::Random);
+
+    file.seekp(0, iop::Beg);
+    EXPECT_EQ(file.write("abc", 3), 0);
+
+    // Seeking past the end stops at the end of the mapping
+    file.seekg(100, iop::Beg);
+    char buffer[4];
+    EXPECT_EQ(file.read(buffer, sizeof(buffer)), 0);
+
+    file.seekg(7, iop::Beg);
+    EXPECT_EQ(file.read(buffer, sizeof(buffer)), 3);
+    EXPECT_EQ(std::string(buffer, 3), "789");
+
+    EXPECT_EQ(std::filesystem::file_size(path), 10u);
+    EXPECT_EQ(content(), "0123456789");
+}
+
+TEST_F(MappedFileIOTest, AdviseAccessPatterns) {
+    create(std::string(1 << 16, 'x'));
+    MappedFileIO file(path, advf::Normal);
+
+    EXPECT_TRUE(file.advise(advf::Sequential));
+    EXPECT_TRUE(file.advise(advf::Random));
+    EXPECT_TRUE(file.advise(advf::Sequential | advf::WillNeed));
+    EXPECT_TRUE(file.advise(advf::Normal));
+    EXPECT_THROW(file.advise(advf::Sequential | advf::Random), std::runtime_error);
+}
+
+TEST_F(MappedFileIOTest, PrefetchAndEvictKeepContent) {
+    std::string data;
+    for (int i = 0; i < 10000; ++i) data += std::to_string(i) + "\n";
+    create(data);
+
+    MappedFileIO file(path, advf::Sequential);
+    file.prefetch(0, data.size());
+    file.evict(4096, 8192);
+    file.evict(1 << 30, 10); // Outside the mapping, nothing to do
+
+    std::string read(data.size(), '\0');
+    EXPECT_EQ(file.read(read.data(), read.size()), static_cast<ssize_t>(data.size()));
+    EXPECT_EQ(read, data);
+}
+
+TEST_F(MappedFileIOTest, RangeMsyncWritesBack) {
+    create(std::string(3 * 4096, '.'));
+
+    {
+        MappedFileIO file(path, iom::Read | iom::Write, protf::Read | protf::Write, mapf::Shared);
+        file.setSyncPolicy(MSyncPolicy::SYNC_ON_CLOSE);
+
+        file.seekp(5000, iop::Beg);
+        EXPECT_EQ(file.write("hello", 5), 5);
+        EXPECT_TRUE(file.msync(5000, 5));
+        EXPECT_TRUE(file.msync(0, 3 * 4096, true));
+
+        // The range is clamped to the mapping
+        EXPECT_TRUE(file.msync(4096, 1 << 20));
+        EXPECT_EQ(content().substr(5000, 5), "hello");
+
+        file.seekp(0, iop::Beg);
+        EXPECT_EQ(file.write("head", 4), 4);
+    }
+
+    // Synchronized on close
+    std::string result = content();
+    EXPECT_EQ(result.substr(0, 4), "head");
+    EXPECT_EQ(result.substr(5000, 5), "hello");
+}
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <data_structures/queue/mpmc_queue.hpp>
+
+using namespace ccl::ds::queue;
+
+class MpmcQueueTest : public ::testing::Test {
+protected:
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+// Basic push/pop
+TEST_F(MpmcQueueTest, PushPopSingleThread) {
+    MpmcQueue<int> q;
+    EXPECT_TRUE(q.empty());
+    EXPECT_EQ(q.size(), 0u);
+    EXPECT_EQ(q.capacity(), MpmcQueue<int>::DEFAULT_CAPACITY);
+
+    q.push(1);
+    q.push(2);
+    EXPECT_FALSE(q.empty());
+    EXPECT_EQ(q.size(), 2u);
+
+    int val = q.pop();
+    EXPECT_EQ(val, 1);
+    q.pop(val);
+    EXPECT_EQ(val, 2);
+    EXPECT_TRUE(q.empty());
+}
+
+// Capacity rounding and validation
+TEST_F(MpmcQueueTest, CapacityRoundedToPowerOfTwo) {
+    MpmcQueue<int> q(3);
+    EXPECT_EQ(q.capacity(), 4u);
+
+    MpmcQueue<int> q1(1);
+    EXPECT_EQ(q1.capacity(), 2u);
+    EXPECT_THROW(MpmcQueue<int>(0), std::invalid_argument);
+}
+
+// Try push/pop
+TEST_F(MpmcQueueTest, TryPushTryPop) {
+    MpmcQueue<int> q(2);
+    EXPECT_TRUE(q.tryPush(10));
+    EXPECT_TRUE(q.tryPush(20));
+    EXPECT_FALSE(q.tryPush(30)); // full
+    EXPECT_TRUE(q.full());
+
+    int val;
+    EXPECT_TRUE(q.tryPop(val));
+    EXPECT_EQ(val, 10);
+    EXPECT_TRUE(q.tryPop(val));
+    EXPECT_EQ(val, 20);
+    EXPECT_FALSE(q.tryPop(val));
+}
+
+// Wraparound over several laps
+TEST_F(MpmcQueueTest, WraparoundKeepsOrder) {
+    MpmcQueue<int> q(4);
+    int val;
+
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_TRUE(q.tryPush(i));
+        EXPECT_TRUE(q.tryPush(i + 1000));
+        EXPECT_TRUE(q.tryPop(val));
+        EXPECT_EQ(val, i);
+        EXPECT_TRUE(q.tryPop(val));
+        EXPECT_EQ(val, i + 1000);
+    }
+}
+
+// Peek
+TEST_F(MpmcQueueTest, PeekTest) {
+    MpmcQueue<int> q(4);
+    int val;
+    EXPECT_FALSE(q.peek(val));
+
+    q.push(42);
+    EXPECT_TRUE(q.peek(val));
+    EXPECT_EQ(val, 42);
+    EXPECT_EQ(q.size(), 1u); // peek should not remove
+}
+
+// Spin budget
+TEST_F(MpmcQueueTest, SpinBudget) {
+    MpmcQueue<int> q(4, 10);
+    EXPECT_EQ(q.getSpinBudget(), 10u);
+    q.setSpinBudget(0);
+    EXPECT_EQ(q.getSpinBudget(), 0u);
+}
+
+// Blocking push behavior
+TEST_F(MpmcQueueTest, BlockingPush) {
+    MpmcQueue<int> q(2);
+    q.push(1);
+    q.push(2);
+
+    std::thread t([&q]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        int val;
+        q.pop(val); // unblock push
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    q.push(3); // should block until pop occurs
+    auto end = std::chrono::steady_clock::now();
+
+    auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    EXPECT_GE(duration_ms, 90); // blocked ~100ms
+    t.join();
+
+    EXPECT_EQ(q.pop(), 2);
+    EXPECT_EQ(q.pop(), 3);
+}
+
+// Blocking pop behavior
+TEST_F(MpmcQueueTest, BlockingPop) {
+    MpmcQueue<int> q(2, 0);
+
+    std::thread t([&q]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        q.push(7);
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    int val = q.pop();
+    auto end = std::chrono::steady_clock::now();
+
+    auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    EXPECT_GE(duration_ms, 90);
+    EXPECT_EQ(val, 7);
+    t.join();
+}
+
+// Move semantics
+TEST_F(MpmcQueueTest, PushMoveTest) {
+    MpmcQueue<std::string> q(2);
+    std::string s = "hello";
+
+    q.push(std::move(s));
+    EXPECT_EQ(q.size(), 1u);
+
+    std::string val;
+    q.pop(val);
+    EXPECT_EQ(val, "hello");
+}
+
+// Usable through the generic interface
+TEST_F(MpmcQueueTest, QueueInterface) {
+    MpmcQueue<int> impl(8);
+    QueueInterface<int>& q = impl;
+
+    EXPECT_TRUE(q.tryPush(3));
+    q.push(4);
+    EXPECT_EQ(q.size(), 2u);
+    EXPECT_EQ(q.pop(), 3);
+    EXPECT_EQ(q.pop(), 4);
+}
+
+// Multi producers / multi consumers with blocking calls
+TEST_F(MpmcQueueTest, MultiProducerMultiConsumer) {
+    constexpr int PRODUCERS = 4;
+    constexpr int CONSUMERS = 4;
+    constexpr int N = 20000; // per producer
+
+    MpmcQueue<int> q(64, 16);
+    std::atomic<long long> sum{0};
+    std::atomic<int> count{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < PRODUCERS; ++p) {
+        threads.emplace_back([&q]() {
+            for (int i = 1; i <= N; ++i) q.push(i);
+        });
+    }
+
+    for (int c = 0; c < CONSUMERS; ++c) {
+        threads.emplace_back([&q, &sum, &count]() {
+            for (int i = 0; i < N; ++i) {
+                sum += q.pop();
+                ++count;
+            }
+        });
+    }
+
+    for (auto& t : threads) t.join();
+
+    EXPECT_EQ(count.load(), PRODUCERS * N);
+    EXPECT_EQ(sum.load(), static_cast<long long>(PRODUCERS) * N * (N + 1) / 2);
+    EXPECT_TRUE(q.empty());
+}
+
+// Per-producer order is preserved
+TEST_F(MpmcQueueTest, PerProducerFifo) {
+    constexpr int N = 20000;
+    MpmcQueue<std::pair<int, int>> q(32);
+
+    std::thread p0([&q]() { for (int i = 0; i < N; ++i) q.push({0, i}); });
+    std::thread p1([&q]() { for (int i = 0; i < N; ++i) q.push({1, i}); });
+
+    int last[2] = {-1, -1};
+    bool ordered = true;
+    for (int i = 0; i < 2 * N; ++i) {
+        auto [producer, value] = q.pop();
+        if (value <= last[producer]) ordered = false;
+        last[producer] = value;
+    }
+
+    p0.join();
+    p1.join();
+    EXPECT_TRUE(ordered);
+}
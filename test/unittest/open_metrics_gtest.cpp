@@ -0,0 +1,257 @@
+#include <gtest/gtest.h>
+#include <metrics/metrics_exporter.hpp>
+#include <metrics/metrics_gather.hpp>
+#include <metrics/metrics_logger.hpp>
+#include <metrics/open_metrics.hpp>
+#include <data_structures/buffers/byte_buffer.hpp>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ccl::metrics;
+
+// Send the request and read the whole response, up to the connection close
+static std::string http_exchange(int fd, const std::string& request) {
+    std::string response;
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) < 0) return response;
+
+    char chunk[4096];
+    ssize_t nbytes;
+    while ((nbytes = recv(fd, chunk, sizeof(chunk), 0)) > 0) {
+        response.append(chunk, static_cast<size_t>(nbytes));
+    }
+
+    close(fd);
+    return response;
+}
+
+static std::string scrape_tcp(uint16_t port, const std::string& method = "GET") {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    EXPECT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    return http_exchange(fd, method + " /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+}
+
+static std::string scrape_unix(const std::string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    EXPECT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    return http_exchange(fd, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+}
+
+static std::string body_of(const std::string& response) {
+    size_t end = response.find("\r\n\r\n");
+    return end == std::string::npos ? std::string() : response.substr(end + 4);
+}
+
+TEST(OpenMetricsTest, CounterSumsTheShardsOfAllThreads) {
+    MetricsRegistry registry;
+    Counter& counter = registry.counter("requests", "Handled requests");
+
+    std::vector<std::thread> threads;
+    for (int idx = 0; idx < 8; ++idx) {
+        threads.emplace_back([&counter] {
+            for (int jdx = 0; jdx < 10'000; ++jdx) counter.inc();
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_EQ(counter.value(), 80'000u);
+    EXPECT_EQ(&registry.counter("requests", "Handled requests"), &counter);
+    EXPECT_EQ(registry.render(),
+              "# TYPE requests counter\n"
+              "# HELP requests Handled requests\n"
+              "requests_total 80000\n"
+              "# EOF\n");
+}
+
+TEST(OpenMetricsTest, RendersGaugesAndHistograms) {
+    MetricsRegistry registry;
+    Gauge& gauge = registry.gauge("queue_depth", "", {{"queue", "main"}});
+    gauge.set(4.0);
+    gauge.add(-1.5);
+    EXPECT_DOUBLE_EQ(gauge.value(), 2.5);
+
+    Histogram& histogram = registry.histogram("latency_seconds", "Request latency", {0.1, 1.0});
+    histogram.observe(0.05);
+    histogram.observe(0.5);
+    histogram.observe(0.5);
+    histogram.observe(2.0);
+
+    Histogram::Snapshot snapshot;
+    histogram.snapshot(snapshot);
+    EXPECT_EQ(snapshot.m_buckets, (std::vector<uint64_t>{1, 3, 4}));
+    EXPECT_EQ(snapshot.m_count, 4u);
+    EXPECT_DOUBLE_EQ(snapshot.m_sum, 3.05);
+
+    EXPECT_EQ(registry.render(),
+              "# TYPE queue_depth gauge\n"
+              "queue_depth{queue=\"main\"} 2.5\n"
+              "# TYPE latency_seconds histogram\n"
+              "# HELP latency_seconds Request latency\n"
+              "latency_seconds_bucket{le=\"0.1\"} 1\n"
+              "latency_seconds_bucket{le=\"1.0\"} 3\n"
+              "latency_seconds_bucket{le=\"+Inf\"} 4\n"
+              "latency_seconds_count 4\n"
+              "latency_seconds_sum 3.05\n"
+              "# EOF\n");
+}
+
+TEST(OpenMetricsTest, EscapesLabelsAndHelp) {
+    MetricsRegistry registry;
+    registry.counter("escapes", "back\\slash\nnew line", {{"path", "a\"b\\c\nd"}}).inc(2);
+
+    EXPECT_EQ(registry.render(),
+              "# TYPE escapes counter\n"
+              "# HELP escapes back\\\\slash\\nnew line\n"
+              "escapes_total{path=\"a\\\"b\\\\c\\nd\"} 2\n"
+              "# EOF\n");
+}
+
+TEST(OpenMetricsTest, RejectsInvalidNamesAndMismatches) {
+    MetricsRegistry registry;
+    EXPECT_THROW(registry.counter("1bad", ""), std::invalid_argument);
+    EXPECT_THROW(registry.counter("bad-name", ""), std::invalid_argument);
+    EXPECT_THROW(registry.counter("good", "", {{"bad:label", "x"}}), std::invalid_argument);
+
+    registry.counter("taken", "");
+    EXPECT_THROW(registry.gauge("taken", ""), std::invalid_argument);
+
+    registry.histogram("buckets", "", {1.0, 2.0});
+    EXPECT_THROW(registry.histogram("buckets", "", {1.0, 3.0}), std::invalid_argument);
+    EXPECT_THROW(registry.histogram("unsorted", "", {2.0, 1.0}), std::invalid_argument);
+}
+
+TEST(OpenMetricsTest, IncrementalRenderingMatchesTheWholeExposition) {
+    MetricsRegistry registry;
+    for (int idx = 0; idx < 20; ++idx) {
+        registry.counter("calls", "Calls", {{"function", std::string("f").append(std::to_string(idx))}}).inc(idx);
+        registry.histogram("durations", "Durations", Histogram::exponentialBounds(1e-6, 4.0, 12),
+                           {{"function", std::string("f").append(std::to_string(idx))}}).observe(idx * 1e-3);
+    }
+
+    OpenMetricsRenderer renderer(registry);
+    ccl::ds::buffers::ByteBuffer buffer(128);
+    std::string result;
+    size_t chunks = 0;
+
+    renderer.begin();
+    bool done = false;
+    while (!done) {
+        buffer.reset();
+        done = renderer.render(buffer);
+        EXPECT_LE(buffer.getBufferSize(), 128u);
+        result.append(reinterpret_cast<const char*>(buffer.getBuffer()), buffer.getBufferSize());
+        ++chunks;
+    }
+
+    EXPECT_GT(chunks, 10u);
+    EXPECT_EQ(result, registry.render());
+}
+
+TEST(OpenMetricsTest, LineLargerThanTheBufferThrows) {
+    MetricsRegistry registry;
+    registry.counter("a_rather_long_metric_name", "").inc();
+
+    OpenMetricsRenderer renderer(registry);
+    ccl::ds::buffers::ByteBuffer buffer(16);
+    renderer.begin();
+    EXPECT_THROW(renderer.render(buffer), std::overflow_error);
+}
+
+TEST(OpenMetricsTest, ServesScrapesOverTcp) {
+    MetricsRegistry registry;
+    Counter& counter = registry.counter("scraped", "Scrape test");
+    counter.inc(3);
+
+    MetricsExporterConfig config;
+    config.buffer_size = 64;
+    MetricsExporter exporter(registry, config);
+    ASSERT_NE(exporter.getPort(), 0);
+
+    std::string response = scrape_tcp(exporter.getPort());
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(response.find("Content-Type: application/openmetrics-text; version=1.0.0"), std::string::npos);
+    EXPECT_EQ(body_of(response), registry.render());
+
+    counter.inc();
+    EXPECT_NE(body_of(scrape_tcp(exporter.getPort())).find("scraped_total 4\n"), std::string::npos);
+    EXPECT_EQ(exporter.getScrapes(), 2u);
+
+    EXPECT_EQ(scrape_tcp(exporter.getPort(), "POST").rfind("HTTP/1.1 405", 0), 0u);
+    EXPECT_EQ(exporter.getScrapes(), 2u);
+}
+
+TEST(OpenMetricsTest, ExporterGrowsTheBufferForLongLines) {
+    MetricsRegistry registry;
+    registry.counter("calls", "Calls", {{"function", std::string(200, 'f')}}).inc();
+    registry.counter("short", "Short").inc();
+
+    MetricsExporterConfig config;
+    config.buffer_size = 128;
+    MetricsExporter exporter(registry, config);
+
+    // The server survives, and the next scrapes keep the larger buffer
+    for (int scrape = 0; scrape < 2; ++scrape) {
+        std::string response = scrape_tcp(exporter.getPort());
+        EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+        EXPECT_EQ(body_of(response), registry.render());
+    }
+
+    EXPECT_EQ(exporter.getScrapes(), 2u);
+}
+
+TEST(OpenMetricsTest, ServesScrapesOverUnixSocket) {
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("ccl_metrics_" + std::to_string(getpid()) + ".sock")).string();
+
+    MetricsRegistry registry;
+    registry.gauge("temperature", "").set(21.5);
+
+    {
+        MetricsExporterConfig config;
+        config.unix_path = path;
+        MetricsExporter exporter(registry, config);
+        EXPECT_EQ(exporter.getPort(), 0);
+        EXPECT_TRUE(std::filesystem::exists(path));
+        EXPECT_EQ(body_of(scrape_unix(path)), "# TYPE temperature gauge\ntemperature 21.5\n# EOF\n");
+    }
+
+    EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+TEST(OpenMetricsTest, RegistryLoggerObservesFunctionMetrics) {
+    MetricsRegistry registry;
+    auto logger = std::make_shared<RegistryMetricsLogger>(registry);
+
+    Metrics metrics {};
+    metrics.m_duration = 1500; // us
+    metrics.m_cpu_time = 1000;
+    logger->consume(std::make_shared<const MetricEvent>("", "work", metrics, 1));
+    logger->consume(std::make_shared<const MetricEvent>("", "work", metrics, 2));
+
+    Histogram& duration = registry.histogram("ccl_function_duration_seconds", "",
+                                             Histogram::exponentialBounds(1e-6, 4.0, 12),
+                                             {{"function", "work"}});
+    Histogram::Snapshot snapshot;
+    duration.snapshot(snapshot);
+    EXPECT_EQ(snapshot.m_count, 2u);
+    EXPECT_DOUBLE_EQ(snapshot.m_sum, 3e-3);
+
+    std::string text = registry.render();
+    EXPECT_NE(text.find("ccl_function_cpu_seconds_count{function=\"work\"} 2\n"), std::string::npos);
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <metrics/metrics_gather.hpp>
+#include <metrics/perf_counters.hpp>
+#include <chrono>
+#include <thread>
+
+using namespace ccl::metrics;
+
+static constexpr PerfEvent HARDWARE = PerfEvent::Cycles | PerfEvent::Instructions
+                                    | PerfEvent::CacheMisses | PerfEvent::BranchMisses;
+
+static void sleep_a_few_times() {
+    for (int idx = 0; idx < 5; ++idx) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+static unsigned long spin(unsigned long iterations) {
+    volatile unsigned long sink = 0;
+    for (unsigned long idx = 0; idx < iterations; ++idx) sink = sink + idx;
+    return sink;
+}
+
+TEST(PerfCountersTest, LeavesOutTheUnsupportedEvents) {
+    PerfCounterGroup group(PerfEvent::All);
+    EXPECT_EQ(group.getEvents() & PerfEvent::All, group.getEvents());
+    EXPECT_EQ(group.getEvents(), PerfCounterGroup::supported(PerfEvent::All));
+
+    PerfCounters counters;
+    EXPECT_EQ(group.read(counters), group.getEvents() != PerfEvent::None);
+    EXPECT_EQ(counters.m_events, group.getEvents());
+
+    PerfCounterGroup none(PerfEvent::None);
+    EXPECT_FALSE(none.read(counters));
+}
+
+TEST(PerfCountersTest, CountsContextSwitches) {
+    if (!has_events(PerfCounterGroup::supported(PerfEvent::ContextSwitches), PerfEvent::ContextSwitches)) {
+        GTEST_SKIP() << "Software perf events are not permitted";
+    }
+
+    auto& group = PerfCounterGroup::forThread(PerfEvent::ContextSwitches);
+    EXPECT_EQ(&group, &PerfCounterGroup::forThread(PerfEvent::ContextSwitches));
+
+    PerfCounters before, after;
+    ASSERT_TRUE(group.read(before));
+    sleep_a_few_times();
+    ASSERT_TRUE(group.read(after));
+
+    EXPECT_GE((after - before).m_context_switches, 5u);
+}
+
+TEST(PerfCountersTest, CountsHardwareEvents) {
+    PerfEvent events = PerfCounterGroup::supported(HARDWARE);
+    if (!has_events(events, PerfEvent::Instructions)) {
+        GTEST_SKIP() << "Hardware perf events are not available";
+    }
+
+    auto& group = PerfCounterGroup::forThread(events);
+
+    PerfCounters before, middle, after;
+    ASSERT_TRUE(group.read(before));
+    spin(1'000);
+    ASSERT_TRUE(group.read(middle));
+    spin(1'000'000);
+    ASSERT_TRUE(group.read(after));
+
+    auto small = middle - before, large = after - middle;
+    EXPECT_GT(large.m_instructions, 1'000'000u);
+    EXPECT_GT(large.m_instructions, 10 * small.m_instructions);
+    if (has_events(events, PerfEvent::Cycles)) {
+        EXPECT_GT(large.m_cycles, small.m_cycles);
+    }
+}
+
+TEST(PerfCountersTest, CollectorReportsTheCounters) {
+    PerfEvent requested = PerfEvent::Instructions | PerfEvent::ContextSwitches;
+    PerfEvent events = PerfCounterGroup::supported(requested);
+    if (events == PerfEvent::None) {
+        GTEST_SKIP() << "Perf events are not permitted";
+    }
+
+    Metrics metrics;
+    {
+        auto collector = MetricsCollector::create("counted_scope", requested);
+        sleep_a_few_times();
+        spin(100'000);
+        collector->collect();
+        metrics = collector->getCollectedMetrics();
+    }
+
+    EXPECT_EQ(metrics.m_counters.m_events, events);
+    EXPECT_EQ(metrics.m_counters.m_cycles, 0u);
+
+    if (has_events(events, PerfEvent::ContextSwitches)) {
+        EXPECT_GE(metrics.m_counters.m_context_switches, 5u);
+    }
+    if (has_events(events, PerfEvent::Instructions)) {
+        EXPECT_GT(metrics.m_counters.m_instructions, 100'000u);
+    }
+
+    // Collectors without events do not touch the counters
+    auto plain = MetricsCollector::create("plain_scope");
+    plain->collect();
+    EXPECT_EQ(plain->getCollectedMetrics().m_counters.m_events, PerfEvent::None);
+}
@@ -6,6 +6,10 @@
 #include <thread>
 #include <vector>
 #include <chrono>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <span>
 
 using namespace ccl::dp::pub_sub;
 
@@ -34,8 +38,10 @@ private:
 class MockSubscriber : public Subscriber {
 public:
     std::vector<std::string> received_events;
+    std::mutex mutex; // Publishers notify concurrently
 
     void notify(event_ptr& event) override {
+        std::lock_guard<std::mutex> _l(mutex);
         received_events.push_back(event->name());
     }
 };
@@ -181,3 +187,332 @@ TEST_F(PubSubFixture, ConcurrentPublish) {
     std::this_thread::sleep_for(std::chrono::milliseconds(50));
     EXPECT_EQ(asyncSub->received_events.size(), 2);
 }
+
+TEST_F(PubSubFixture, ExpiredSubscribersAreSkipped) {
+    auto temporary = std::make_shared<MockSubscriber>();
+    broker->subscribe<TestEvent>(temporary);
+    temporary.reset();
+
+    publisher->publish(std::make_shared<const TestEvent>("Event1"));
+    publisher->publish(std::make_shared<const TestEvent>("Event2"));
+
+    EXPECT_EQ(sub1->received_events.size(), 2);
+    EXPECT_EQ(sub2->received_events.size(), 2);
+}
+
+TEST_F(PubSubFixture, UnsubscribeAmongExpiredSubscribers) {
+    auto first = std::make_shared<MockSubscriber>();
+    auto second = std::make_shared<MockSubscriber>();
+    broker->subscribe<TestEvent>(first);
+    broker->subscribe<TestEvent>(second);
+    first.reset();
+
+    broker->unsubscribe<TestEvent>(sub1);
+    broker->unsubscribe<TestEvent>(sub2);
+    publisher->publish(std::make_shared<const TestEvent>("Event1"));
+
+    EXPECT_EQ(sub1->received_events.size(), 0);
+    EXPECT_EQ(sub2->received_events.size(), 0);
+    EXPECT_EQ(second->received_events.size(), 1);
+}
+
+// A subscriber blocked in notify until released
+class BlockingSubscriber : public Subscriber {
+public:
+    std::promise<void> entered;
+    std::shared_future<void> release;
+
+    explicit BlockingSubscriber(std::shared_future<void> r) : release(std::move(r)) {}
+
+    void notify(event_ptr&) override {
+        entered.set_value();
+        release.wait();
+    }
+};
+
+TEST(PubSubBrokerTest, SlowSubscribersDoNotBlockOtherPublishers) {
+    auto broker = std::make_shared<PubSubBroker>();
+    std::promise<void> release;
+    auto blocking = std::make_shared<BlockingSubscriber>(release.get_future().share());
+    auto fast = std::make_shared<MockSubscriber>();
+
+    broker->subscribe<TestEvent>(blocking);
+    broker->subscribe<AnotherEvent>(fast);
+
+    std::thread slow([&broker] { broker->notifySubscribers(std::make_shared<const TestEvent>("Slow")); });
+    blocking->entered.get_future().wait();
+
+    // Neither publishing nor subscribing waits for the blocked notify
+    broker->notifySubscribers(std::make_shared<const AnotherEvent>("Fast"));
+    auto late = std::make_shared<MockSubscriber>();
+    broker->subscribe<AnotherEvent>(late);
+    broker->notifySubscribers(std::make_shared<const AnotherEvent>("Late"));
+
+    EXPECT_EQ(fast->received_events.size(), 2);
+    EXPECT_EQ(late->received_events.size(), 1);
+
+    release.set_value();
+    slow.join();
+}
+
+// A subscriber subscribing another one from notify
+class ChainingSubscriber : public Subscriber {
+public:
+    std::shared_ptr<PubSubBroker> broker;
+    std::shared_ptr<MockSubscriber> next = std::make_shared<MockSubscriber>();
+
+    void notify(event_ptr&) override {
+        broker->subscribe<AnotherEvent>(next);
+    }
+};
+
+TEST(PubSubBrokerTest, SubscribeFromNotify) {
+    auto broker = std::make_shared<PubSubBroker>();
+    auto chaining = std::make_shared<ChainingSubscriber>();
+    chaining->broker = broker;
+    broker->subscribe<TestEvent>(chaining);
+
+    broker->notifySubscribers(std::make_shared<const TestEvent>("Event1"));
+    broker->notifySubscribers(std::make_shared<const AnotherEvent>("Event2"));
+
+    ASSERT_EQ(chaining->next->received_events.size(), 1);
+    EXPECT_EQ(chaining->next->received_events[0], "Event2");
+    chaining->broker.reset();
+}
+
+TEST(PubSubBrokerTest, ConcurrentPublishersAndSubscriptions) {
+    auto broker = std::make_shared<PubSubBroker>();
+    auto counter = std::make_shared<MockSubscriber>();
+    broker->subscribe<TestEvent>(counter);
+
+    std::atomic<bool> done = false;
+    std::thread churn([&broker, &done] {
+        while (!done.load()) {
+            auto temporary = std::make_shared<MockSubscriber>();
+            broker->subscribe<TestEvent>(temporary);
+            broker->unsubscribe<TestEvent>(temporary);
+        }
+    });
+
+    std::vector<std::thread> publishers;
+    for (int idx = 0; idx < 4; ++idx) {
+        publishers.emplace_back([&broker] {
+            auto event = std::make_shared<const TestEvent>("Event");
+            for (int jdx = 0; jdx < 2000; ++jdx) broker->notifySubscribers(event);
+        });
+    }
+
+    for (auto& publisher : publishers) publisher.join();
+    done.store(true);
+    churn.join();
+
+    EXPECT_EQ(counter->received_events.size(), 8000u);
+}
+
+class BatchingSubscriber : public AsyncSubscriber {
+public:
+    std::vector<std::string> received_events;
+    std::vector<size_t> batches;
+
+    explicit BatchingSubscriber(const AsyncSubscriberConfig& config)
+    : AsyncSubscriber("BatchingSubscriber", config) {}
+
+    void consume(event_ptr event) override {
+        received_events.push_back(event->name());
+    }
+
+    void consumeBatch(std::span<event_ptr> events) override {
+        batches.push_back(events.size());
+        AsyncSubscriber::consumeBatch(events);
+    }
+};
+
+TEST(AsyncSubscriberTest, ConsumesInBatches) {
+    auto broker = std::make_shared<PubSubBroker>();
+    auto sub = std::make_shared<BatchingSubscriber>(AsyncSubscriberConfig { 4 });
+    broker->subscribe<TestEvent>(sub);
+
+    // Queued before the start, hence taken in full batches
+    for (int idx = 0; idx < 10; ++idx) {
+        broker->notifySubscribers(std::make_shared<const TestEvent>("Event" + std::to_string(idx)));
+    }
+
+    sub->start();
+    sub->stop();
+
+    EXPECT_EQ(sub->batches, std::vector<size_t>({ 4, 4, 2 }));
+    ASSERT_EQ(sub->received_events.size(), 10u);
+    EXPECT_EQ(sub->received_events.front(), "Event0");
+    EXPECT_EQ(sub->received_events.back(), "Event9");
+}
+
+TEST(AsyncSubscriberTest, LingerCoalescesEvents) {
+    auto broker = std::make_shared<PubSubBroker>();
+    auto sub = std::make_shared<BatchingSubscriber>(
+        AsyncSubscriberConfig { 4, std::chrono::seconds(5) });
+    broker->subscribe<TestEvent>(sub);
+    sub->start();
+
+    for (int idx = 0; idx < 4; ++idx) {
+        broker->notifySubscribers(std::make_shared<const TestEvent>("Event"));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    // A partial batch does not wait for the linger on stop
+    broker->notifySubscribers(std::make_shared<const TestEvent>("Last"));
+    sub->stop();
+
+    ASSERT_EQ(sub->received_events.size(), 5u);
+    EXPECT_EQ(sub->batches.front(), 4u);
+    EXPECT_EQ(sub->received_events.back(), "Last");
+}
+
+class UrgentEvent : public PubSubEvent {
+public:
+    UrgentEvent(std::string n) : m_name(std::move(n)) {}
+    std::string name() const override { return m_name; }
+    size_t priority() const override { return 1; }
+private:
+    std::string m_name;
+};
+
+static void publish_events(PubSubBroker& broker, const std::string& prefix, int count) {
+    for (int idx = 0; idx < count; ++idx) {
+        broker.notifySubscribers(std::make_shared<const TestEvent>(prefix + std::to_string(idx)));
+    }
+}
+
+TEST(AsyncSubscriberTest, DropNewWhenFull) {
+    auto broker = std::make_shared<PubSubBroker>();
+    AsyncSubscriberConfig config;
+    config.capacity = 3;
+    config.loss_policy = ccl::ds::LossPolicy::ERROR;
+    auto sub = std::make_shared<BatchingSubscriber>(config);
+    broker->subscribe<TestEvent>(sub);
+
+    publish_events(*broker, "Event", 5);
+    EXPECT_EQ(sub->getDepth(), 3u);
+    EXPECT_EQ(sub->getDropped(), 2u);
+
+    sub->start();
+    sub->stop();
+    EXPECT_EQ(sub->received_events, std::vector<std::string>({ "Event0", "Event1", "Event2" }));
+    EXPECT_EQ(sub->getDepth(), 0u);
+}
+
+TEST(AsyncSubscriberTest, DropOldestWhenFull) {
+    auto broker = std::make_shared<PubSubBroker>();
+    AsyncSubscriberConfig config;
+    config.capacity = 3;
+    config.loss_policy = ccl::ds::LossPolicy::OVERWRITE_OLDEST;
+    auto sub = std::make_shared<BatchingSubscriber>(config);
+    broker->subscribe<TestEvent>(sub);
+
+    publish_events(*broker, "Event", 5);
+    EXPECT_EQ(sub->getDropped(), 2u);
+
+    sub->start();
+    sub->stop();
+    EXPECT_EQ(sub->received_events, std::vector<std::string>({ "Event2", "Event3", "Event4" }));
+}
+
+TEST(AsyncSubscriberTest, BlockWhenFull) {
+    auto broker = std::make_shared<PubSubBroker>();
+    AsyncSubscriberConfig config;
+    config.capacity = 2;
+    auto sub = std::make_shared<BatchingSubscriber>(config);
+    broker->subscribe<TestEvent>(sub);
+
+    std::atomic<bool> published = false;
+    std::thread publisher([&broker, &published] {
+        publish_events(*broker, "Event", 10);
+        published = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(published.load());
+    EXPECT_EQ(sub->getDepth(), 2u);
+
+    sub->start();
+    publisher.join();
+    sub->stop();
+
+    EXPECT_EQ(sub->received_events.size(), 10u);
+    EXPECT_EQ(sub->received_events.back(), "Event9");
+    EXPECT_EQ(sub->getDropped(), 0u);
+}
+
+TEST(AsyncSubscriberTest, UrgentEventsOvertakeBulkOnes) {
+    auto broker = std::make_shared<PubSubBroker>();
+    AsyncSubscriberConfig config;
+    config.lanes = 2;
+    auto sub = std::make_shared<BatchingSubscriber>(config);
+    broker->subscribe<TestEvent, UrgentEvent>(sub);
+
+    publish_events(*broker, "Bulk", 3);
+    broker->notifySubscribers(std::make_shared<const UrgentEvent>("Urgent"));
+    EXPECT_EQ(sub->getDepth(0), 3u);
+    EXPECT_EQ(sub->getDepth(1), 1u);
+
+    sub->start();
+    sub->stop();
+    EXPECT_EQ(sub->received_events, std::vector<std::string>({ "Urgent", "Bulk0", "Bulk1", "Bulk2" }));
+}
+
+TEST(AsyncSubscriberTest, DropOldestKeepsUrgentEvents) {
+    auto broker = std::make_shared<PubSubBroker>();
+    AsyncSubscriberConfig config;
+    config.capacity = 2;
+    config.lanes = 2;
+    config.loss_policy = ccl::ds::LossPolicy::OVERWRITE_OLDEST;
+    auto sub = std::make_shared<BatchingSubscriber>(config);
+    broker->subscribe<TestEvent, UrgentEvent>(sub);
+
+    broker->notifySubscribers(std::make_shared<const UrgentEvent>("Urgent0"));
+    broker->notifySubscribers(std::make_shared<const UrgentEvent>("Urgent1"));
+    publish_events(*broker, "Bulk", 1);  // Dropped, nothing less urgent to drop
+    broker->notifySubscribers(std::make_shared<const UrgentEvent>("Urgent2"));
+
+    EXPECT_EQ(sub->getDropped(), 2u);
+    sub->start();
+    sub->stop();
+    EXPECT_EQ(sub->received_events, std::vector<std::string>({ "Urgent1", "Urgent2" }));
+}
+
+TEST(AsyncSubscriberTest, UrgentEventsEndTheLinger) {
+    auto broker = std::make_shared<PubSubBroker>();
+    AsyncSubscriberConfig config;
+    config.lanes = 2;
+    config.linger = std::chrono::seconds(5);
+    auto sub = std::make_shared<BatchingSubscriber>(config);
+    broker->subscribe<TestEvent, UrgentEvent>(sub);
+    sub->start();
+
+    auto start = std::chrono::steady_clock::now();
+    publish_events(*broker, "Bulk", 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    broker->notifySubscribers(std::make_shared<const UrgentEvent>("Urgent"));
+
+    // Taken out of the queue well before the end of the linger
+    while (sub->getDepth() > 0) {
+        ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    sub->stop();
+    EXPECT_EQ(sub->received_events, std::vector<std::string>({ "Urgent", "Bulk0" }));
+}
+
+TEST(AsyncSubscriberTest, EventsAfterCancelAreDropped) {
+    auto broker = std::make_shared<PubSubBroker>();
+    auto sub = std::make_shared<BatchingSubscriber>(AsyncSubscriberConfig {});
+    broker->subscribe<TestEvent>(sub);
+    sub->start();
+    sub->stop();
+
+    publish_events(*broker, "Late", 2);
+    EXPECT_EQ(sub->getDropped(), 2u);
+    EXPECT_TRUE(sub->received_events.empty());
+    EXPECT_THROW(BatchingSubscriber(AsyncSubscriberConfig { 1, {}, 0, ccl::ds::LossPolicy::BLOCK, 0 }),
+                 std::invalid_argument);
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <metrics/metrics_broker.hpp>
+#include <metrics/metrics_gather.hpp>
+#include <metrics/metrics_logger.hpp>
+#include <metrics/metrics_utils.hpp>
+#include <metrics/sampling.hpp>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace ccl::metrics;
+
+TEST(SamplingTest, EveryNSamplesFirstAndEveryPeriod) {
+    EveryNSampler sampler(10);
+    std::vector<int> sampled;
+    for (int idx = 0; idx < 1000; ++idx) {
+        if (sampler.shouldSample()) sampled.push_back(idx);
+    }
+
+    ASSERT_EQ(sampled.size(), 100u);
+    EXPECT_EQ(sampled[0], 0);
+    EXPECT_EQ(sampled[1], 10);
+    EXPECT_EQ(sampler.getCalls(), 1000u);
+    EXPECT_EQ(sampler.getSampled(), 100u);
+
+    EXPECT_THROW(EveryNSampler(0), std::invalid_argument);
+}
+
+TEST(SamplingTest, ReservoirBoundsSamplesPerWindow) {
+    ReservoirSampler sampler(10, std::chrono::milliseconds(50));
+
+    // First window: the first K calls
+    for (int idx = 0; idx < 1000; ++idx) {
+        EXPECT_EQ(sampler.shouldSample(), idx < 10) << idx;
+    }
+
+    // Next window: about K samples spread over the calls
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    size_t sampled = 0;
+    for (int idx = 0; idx < 1000; ++idx) sampled += sampler.shouldSample();
+
+    EXPECT_GE(sampled, 1u);
+    EXPECT_LE(sampled, 10u);
+    EXPECT_NEAR(sampler.getProbability(), 0.01, 0.001);
+
+    EXPECT_THROW(ReservoirSampler(0, std::chrono::milliseconds(1)), std::invalid_argument);
+}
+
+TEST(SamplingTest, AdaptiveMeetsTheBudget) {
+    // Pretend each sampled scope costs 1us, with a 1% budget
+    AdaptiveSampler sampler(0.01, std::chrono::milliseconds(10));
+
+    auto run_for = [&sampler](std::chrono::milliseconds duration) {
+        uint64_t sampled = 0;
+        auto end = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < end) {
+            for (int idx = 0; idx < 64; ++idx) {
+                if (!sampler.shouldSample()) continue;
+                sampler.record(1000);
+                ++sampled;
+            }
+        }
+        return sampled;
+    };
+
+    run_for(std::chrono::milliseconds(50)); // Warm up
+    EXPECT_LT(sampler.getProbability(), 1.0);
+    EXPECT_NEAR(sampler.getAverageCost(), 1000.0, 1.0);
+
+    // 1% of 200ms at 1us each: about 2000 samples, whatever the call rate
+    uint64_t sampled = run_for(std::chrono::milliseconds(200));
+    EXPECT_GT(sampled, 500u);
+    EXPECT_LT(sampled, 8000u);
+
+    EXPECT_THROW(AdaptiveSampler(0.0), std::invalid_argument);
+    EXPECT_THROW(AdaptiveSampler(0.01, std::chrono::milliseconds(0)), std::invalid_argument);
+}
+
+class CostSampler : public Sampler {
+public:
+    uint64_t m_records = 0;
+    uint64_t m_cost = 0;
+
+    bool needsCost() const override { return true; }
+    void record(uint64_t cost) override { ++m_records; m_cost += cost; }
+
+protected:
+    bool sample(uint64_t) override { return true; }
+};
+
+class SampledCollectorsTest : public ::testing::Test {
+protected:
+    std::shared_ptr<TreeMetricsLogger> m_logger;
+
+    void SetUp() override {
+        MetricsBroker::setCollectionMode(CollectionMode::Fast);
+        m_logger = std::make_shared<TreeMetricsLogger>();
+        m_logger->start();
+        MetricsBroker::getInstance()->subscribe<MetricEvent>(m_logger);
+    }
+
+    void TearDown() override {
+        MetricsBroker::setEnabled(true);
+        MetricsBroker::setCollectionMode(CollectionMode::Proc);
+        MetricsBroker::getInstance()->unsubscribe<MetricEvent>(m_logger);
+    }
+};
+
+TEST_F(SampledCollectorsTest, OnlySampledScopesArePublished) {
+    static EveryNSampler sampler(5);
+
+    for (int idx = 0; idx < 20; ++idx) {
+        auto collector = MetricsCollector::create("sampled", sampler);
+        ASSERT_NE(collector, nullptr);
+        EXPECT_EQ(collector->isSampled(), idx % 5 == 0);
+        collector->collect();
+    }
+
+    m_logger->stop();
+    auto node = m_logger->getNode(get_thread_id(), "", "sampled");
+    ASSERT_NE(node, nullptr);
+    EXPECT_EQ(node->m_duration.getCount(), 4u);
+}
+
+TEST_F(SampledCollectorsTest, DisabledCollectionIsInert) {
+    EveryNSampler sampler(1);
+    MetricsBroker::setEnabled(false);
+    EXPECT_FALSE(MetricsBroker::isEnabled());
+
+    {
+        auto collector = MetricsCollector::create("disabled");
+        EXPECT_FALSE(collector->isSampled());
+        EXPECT_EQ(collector.use_count(), 0);
+        collector->collect();
+
+        auto sampled = MetricsCollector::create("disabled", sampler);
+        EXPECT_FALSE(sampled->isSampled());
+    }
+
+    // The sampler is not even consulted
+    EXPECT_EQ(sampler.getCalls(), 0u);
+
+    MetricsBroker::setEnabled(true);
+    {
+        auto collector = MetricsCollector::create("enabled");
+        collector->collect();
+    }
+
+    m_logger->stop();
+    EXPECT_EQ(m_logger->getNode(get_thread_id(), "", "disabled"), nullptr);
+    EXPECT_NE(m_logger->getNode(get_thread_id(), "", "enabled"), nullptr);
+}
+
+TEST_F(SampledCollectorsTest, CollectorsReportTheirCost) {
+    CostSampler sampler;
+    for (int idx = 0; idx < 10; ++idx) {
+        auto collector = MetricsCollector::create("costly", sampler);
+        collector->collect();
+    }
+
+    m_logger->stop();
+    EXPECT_EQ(sampler.m_records, 10u);
+    EXPECT_GT(sampler.m_cost, 0u);
+}
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <metrics/metrics_broker.hpp>
+#include <metrics/metrics_logger.hpp>
+#include <metrics/metrics_sink.hpp>
+#include <metrics/open_metrics.hpp>
+#include <metrics/scope_timer.hpp>
+#include <patterns/pub_sub/subscriber.hpp>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ccl::metrics;
+namespace ps = ccl::dp::pub_sub;
+
+class ScopeCollector : public ps::Subscriber {
+public:
+    std::mutex m_mutex;
+    std::vector<ScopeRecord> m_records;
+
+protected:
+    void notify(event_ptr& event) override {
+        auto batch = std::static_pointer_cast<const ScopeBatchEvent>(event);
+        std::lock_guard<std::mutex> _l(m_mutex);
+        m_records.insert(m_records.end(), batch->m_records.begin(), batch->m_records.end());
+    }
+};
+
+namespace timed {
+    void inner() {
+        CCL_SCOPE_TIMER();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    void outer() {
+        CCL_SCOPE_TIMER();
+        inner();
+        inner();
+    }
+}
+
+class ScopeTimerTest : public ::testing::Test {
+protected:
+    std::shared_ptr<ScopeCollector> m_collector = std::make_shared<ScopeCollector>();
+
+    void SetUp() override {
+        MetricsBroker::getInstance()->subscribe<ScopeBatchEvent>(m_collector);
+    }
+
+    void TearDown() override {
+        MetricsBroker::setEnabled(true);
+        MetricsBroker::getInstance()->unsubscribe<ScopeBatchEvent>(m_collector);
+    }
+
+    std::vector<ScopeRecord> flush() {
+        MetricsBroker::getInstance()->getSink().flush();
+        std::lock_guard<std::mutex> _l(m_collector->m_mutex);
+        return m_collector->m_records;
+    }
+};
+
+TEST(CallSiteRegistryTest, InternsAndResolves) {
+    uint32_t first = CallSiteRegistry::intern("first", "file.cpp", 10);
+    uint32_t second = CallSiteRegistry::intern("second", "file.cpp", 20);
+
+    EXPECT_NE(first, 0u);
+    EXPECT_EQ(second, first + 1);
+    EXPECT_GE(CallSiteRegistry::size(), second);
+
+    const CallSite& site = CallSiteRegistry::get(second);
+    EXPECT_EQ(site.m_name, "second");
+    EXPECT_STREQ(site.m_file, "file.cpp");
+    EXPECT_EQ(site.m_line, 20u);
+    EXPECT_EQ(site.m_id, second);
+
+    EXPECT_THROW(CallSiteRegistry::get(0), std::out_of_range);
+    EXPECT_THROW(CallSiteRegistry::get(CallSiteRegistry::size() + 1), std::out_of_range);
+}
+
+TEST(CallSiteRegistryTest, ConcurrentRegistrationsGetDistinctIds) {
+    std::vector<std::vector<uint32_t>> ids(4);
+    std::vector<std::thread> threads;
+
+    for (size_t thread = 0; thread < ids.size(); ++thread) {
+        threads.emplace_back([&ids, thread] {
+            for (int idx = 0; idx < 1500; ++idx) {
+                ids[thread].push_back(CallSiteRegistry::intern("site" + std::to_string(idx), __FILE__, idx));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    std::map<uint32_t, int> seen;
+    for (const auto& list : ids) {
+        for (uint32_t id : list) {
+            ++seen[id];
+            EXPECT_EQ(CallSiteRegistry::get(id).m_id, id);
+        }
+    }
+    EXPECT_EQ(seen.size(), 6000u);
+}
+
+TEST_F(ScopeTimerTest, RecordsNestedScopes) {
+    timed::outer();
+    auto records = flush();
+    ASSERT_EQ(records.size(), 3u);
+
+    // Inner scopes finish first
+    const CallSite& inner = CallSiteRegistry::get(records[0].m_site);
+    const CallSite& outer = CallSiteRegistry::get(records[2].m_site);
+    EXPECT_EQ(inner.m_name, "timed::inner");
+    EXPECT_EQ(outer.m_name, "timed::outer");
+    EXPECT_NE(std::string(inner.m_file).find("scope_timer_gtest.cpp"), std::string::npos);
+
+    // The call site is registered once
+    EXPECT_EQ(records[1].m_site, records[0].m_site);
+
+    EXPECT_EQ(records[0].m_parent, records[2].m_site);
+    EXPECT_EQ(records[2].m_parent, 0u);
+    EXPECT_EQ(records[0].m_thread_id, get_thread_id());
+
+    EXPECT_GE(records[0].m_end - records[0].m_start, 1'000'000);
+    EXPECT_LE(records[2].m_start, records[0].m_start);
+    EXPECT_GE(records[2].m_end, records[1].m_end);
+    EXPECT_EQ(ScopeTimer::current(), 0u);
+}
+
+TEST_F(ScopeTimerTest, NamedTimers) {
+    {
+        CCL_SCOPE_TIMER_NAMED("custom.scope");
+        EXPECT_NE(ScopeTimer::current(), 0u);
+    }
+
+    auto records = flush();
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(CallSiteRegistry::get(records[0].m_site).m_name, "custom.scope");
+}
+
+TEST_F(ScopeTimerTest, DisabledTimersRecordNothing) {
+    MetricsBroker::setEnabled(false);
+    timed::outer();
+    EXPECT_EQ(ScopeTimer::current(), 0u);
+    EXPECT_TRUE(flush().empty());
+}
+
+TEST_F(ScopeTimerTest, ManyThreads) {
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([] {
+            for (int idx = 0; idx < 100; ++idx) {
+                CCL_SCOPE_TIMER_NAMED("worker");
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_EQ(flush().size(), 400u);
+    EXPECT_EQ(MetricsBroker::getInstance()->getSink().getDropped(), 0u);
+}
+
+TEST_F(ScopeTimerTest, RegistryLoggerResolvesCallSites) {
+    MetricsRegistry registry;
+    auto logger = std::make_shared<RegistryMetricsLogger>(registry);
+    logger->start();
+    MetricsBroker::getInstance()->subscribe<ScopeBatchEvent>(logger);
+
+    timed::outer();
+    flush();
+    MetricsBroker::getInstance()->unsubscribe<ScopeBatchEvent>(logger);
+    logger->stop();
+
+    std::string text = registry.render();
+    EXPECT_NE(text.find("ccl_function_duration_seconds_count{function=\"timed::inner\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("ccl_function_duration_seconds_count{function=\"timed::outer\"} 1\n"), std::string::npos);
+}
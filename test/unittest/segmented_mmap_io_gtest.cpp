@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <io/file/segmented_mmap_io.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using namespace ccl::sys::io;
+
+class SegmentedMappedFileIOTest : public ::testing::Test {
+protected:
+    std::string path;
+    size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+
+    void SetUp() override {
+        auto name = "ccl_segmented_io_" + std::to_string(::getpid()) + "_" +
+            ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".txt";
+        path = (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+
+    void create(const std::string& content) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << content;
+    }
+
+    std::string content() const {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    static std::string pattern(size_t size) {
+        std::string data(size, '\0');
+        for (size_t i = 0; i < size; ++i) data[i] = static_cast<char>('a' + i % 26);
+        return data;
+    }
+};
+
+TEST_F(SegmentedMappedFileIOTest, WindowSizeIsPageAligned) {
+    create("x");
+    SegmentedMappedFileIO file(path, iom::Read, 100, 2);
+    EXPECT_EQ(file.getWindowSize(), page);
+    EXPECT_EQ(file.getNofLiveWindows(), 0u);
+}
+
+TEST_F(SegmentedMappedFileIOTest, ReadsAcrossWindows) {
+    std::string data = pattern(5 * page + 123);
+    create(data);
+
+    SegmentedMappedFileIO file(path, iom::Read, page, 2);
+    EXPECT_EQ(file.getLength(), static_cast<OFF_T>(data.size()));
+
+    std::string read(data.size() + 10, '\0');
+    EXPECT_EQ(file.read(read.data(), read.size()), static_cast<ssize_t>(data.size()));
+    read.resize(data.size());
+    EXPECT_EQ(read, data);
+
+    // Only the most recent windows are kept alive
+    EXPECT_EQ(file.getNofLiveWindows(), 2u);
+
+    // Random access going back to an evicted window
+    file.seekg(page - 2, iop::Beg);
+    char buffer[4];
+    EXPECT_EQ(file.read(buffer, 4), 4);
+    EXPECT_EQ(std::string(buffer, 4), data.substr(page - 2, 4));
+    EXPECT_EQ(file.tellg(), static_cast<OFF_T>(page + 2));
+
+    file.seekg(-3, iop::End);
+    EXPECT_EQ(file.read(buffer, 4), 3);
+    EXPECT_EQ(std::string(buffer, 3), data.substr(data.size() - 3));
+
+    // Read-only files cannot be written
+    EXPECT_EQ(file.write("abc", 3), 0);
+}
+
+TEST_F(SegmentedMappedFileIOTest, AppendGrowsBySegments) {
+    create("");
+    std::string data = pattern(3 * page + 7);
+
+    {
+        SegmentedMappedFileIO file(path, iom::Read | iom::Write, page, 2);
+
+        // Many small appends crossing the window boundaries
+        for (size_t i = 0; i < data.size(); i += 100) {
+            size_t n = std::min<size_t>(100, data.size() - i);
+            EXPECT_EQ(file.write(data.data() + i, n), static_cast<ssize_t>(n));
+        }
+
+        EXPECT_EQ(file.getLength(), static_cast<OFF_T>(data.size()));
+        EXPECT_EQ(file.getSize(), static_cast<OFF_T>(4 * page));
+        EXPECT_TRUE(file.sync());
+
+        file.seekg(0, iop::Beg);
+        std::string read(data.size(), '\0');
+        EXPECT_EQ(file.read(read.data(), read.size()), static_cast<ssize_t>(data.size()));
+        EXPECT_EQ(read, data);
+    }
+
+    // The padding of the last segment is removed on close
+    EXPECT_EQ(content(), data);
+}
+
+TEST_F(SegmentedMappedFileIOTest, AppendModeAndOverwrite) {
+    create("head\n");
+
+    {
+        SegmentedMappedFileIO file(path, iom::Read | iom::Write | iom::App, page, 1);
+        EXPECT_EQ(file.tellp(), 5);
+        file << "tail\n";
+
+        file.seekp(0, iop::Beg);
+        EXPECT_EQ(file.write("HEAD", 4), 4);
+
+        std::string line;
+        EXPECT_EQ(file.readLine(line), 5);
+        EXPECT_EQ(line, "HEAD\n");
+        EXPECT_EQ(file.readLine(line), 5);
+        EXPECT_EQ(line, "tail\n");
+        EXPECT_EQ(file.readLine(line), 0);
+    }
+
+    EXPECT_EQ(content(), "HEAD\ntail\n");
+}
@@ -0,0 +1,305 @@
+#include <patterns/pub_sub/broker.hpp>
+#include <patterns/pub_sub/publisher.hpp>
+#include <patterns/pub_sub/shm_transport.hpp>
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ccl::dp::pub_sub;
+using ccl::ds::buffers::ByteBuffer;
+
+class PriceEvent : public PubSubEvent {
+public:
+    std::string symbol;
+    uint64_t sequence = 0;
+
+    PriceEvent(std::string s, uint64_t seq) : symbol(std::move(s)), sequence(seq) {}
+
+    std::string name() const override { return symbol; }
+
+    void serialize(ByteBuffer& buffer) const {
+        buffer.putUnsignedInt(static_cast<unsigned int>(symbol.size()));
+        buffer.putBuffer(reinterpret_cast<const unsigned char*>(symbol.data()), symbol.size());
+        buffer.putUnsignedLong(sequence);
+    }
+
+    static std::shared_ptr<const PriceEvent> deserialize(ByteBuffer& buffer) {
+        std::string symbol(buffer.getUnsignedInt(), '\0');
+        buffer.getBuffer(reinterpret_cast<unsigned char*>(symbol.data()), symbol.size());
+        return std::make_shared<const PriceEvent>(symbol, buffer.getUnsignedLong());
+    }
+};
+
+class LocalEvent : public PubSubEvent {
+public:
+    std::string name() const override { return "LocalEvent"; }
+};
+
+static_assert(SerializableEvent<PriceEvent>);
+static_assert(!SerializableEvent<LocalEvent>);
+
+class PriceCollector : public Subscriber {
+public:
+    std::mutex mutex;
+    std::vector<std::shared_ptr<const PriceEvent>> events;
+
+    size_t count() {
+        std::lock_guard<std::mutex> _l(mutex);
+        return events.size();
+    }
+
+protected:
+    void notify(event_ptr& event) override {
+        std::lock_guard<std::mutex> _l(mutex);
+        events.push_back(std::static_pointer_cast<const PriceEvent>(event));
+    }
+};
+
+struct Record {
+    uint32_t type;
+    std::string payload;
+};
+
+static std::vector<Record> read_all(ShmRing& ring) {
+    std::vector<Record> records;
+    ring.read([&records](uint32_t type, const unsigned char* data, size_t size) {
+        records.push_back({ type, std::string(reinterpret_cast<const char*>(data), size) });
+    });
+    return records;
+}
+
+static bool write_string(ShmRing& ring, uint32_t type, const std::string& text) {
+    return ring.tryWrite(type, reinterpret_cast<const unsigned char*>(text.data()), text.size());
+}
+
+// Wait for a forked child, true if it exited with 0
+static bool wait_child(pid_t pid) {
+    int status = 0;
+    return waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+TEST(ShmRingTest, WritesAndReadsInOrder) {
+    ShmRing ring(1000);
+    EXPECT_EQ(ring.capacity(), 1024u);
+    EXPECT_EQ(ring.maxRecordSize(), 504u);
+
+    EXPECT_TRUE(write_string(ring, 1, "first"));
+    EXPECT_TRUE(write_string(ring, 2, ""));
+    EXPECT_TRUE(write_string(ring, 3, "third record"));
+
+    auto records = read_all(ring);
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0].type, 1u);
+    EXPECT_EQ(records[0].payload, "first");
+    EXPECT_EQ(records[1].payload, "");
+    EXPECT_EQ(records[2].payload, "third record");
+    EXPECT_TRUE(read_all(ring).empty());
+
+    EXPECT_THROW(write_string(ring, 1, std::string(505, 'x')), std::invalid_argument);
+    EXPECT_THROW(write_string(ring, ShmRing::PAD_TYPE, "pad"), std::invalid_argument);
+}
+
+TEST(ShmRingTest, FullRingAndWrapAround) {
+    ShmRing ring(256);
+    const std::string payload(50, 'a');
+
+    // The payload of the record of the given type
+    auto expected = [&payload](uint32_t type) {
+        return type < 4 ? payload : std::string(type % 97, char('a' + type % 26));
+    };
+
+    // 56 bytes per record: the fifth one does not fit
+    for (int idx = 0; idx < 4; ++idx) EXPECT_TRUE(write_string(ring, idx, payload));
+    EXPECT_FALSE(write_string(ring, 4, payload));
+    EXPECT_FALSE(ring.write(4, reinterpret_cast<const unsigned char*>(payload.data()), payload.size(),
+                            std::chrono::milliseconds(10)));
+
+    // Records of many sizes, crossing the end of the ring many times
+    uint32_t written = 4, read = 0;
+    for (int round = 0; round < 500; ++round) {
+        for (const auto& record : read_all(ring)) {
+            EXPECT_EQ(record.type, read++);
+            EXPECT_EQ(record.payload, expected(record.type));
+        }
+
+        while (write_string(ring, written, expected(written))) ++written;
+    }
+
+    read += read_all(ring).size();
+    EXPECT_EQ(read, written);
+}
+
+TEST(ShmRingTest, AttachByPath) {
+    const std::string path = (std::filesystem::temp_directory_path() /
+                              ("ccl_ring_" + std::to_string(getpid()))).string();
+    {
+        ShmRing owner(path, 4096);
+        ShmRing attached(path);
+        EXPECT_EQ(attached.capacity(), 4096u);
+
+        EXPECT_TRUE(write_string(attached, 7, "hello"));
+        auto records = read_all(owner);
+        ASSERT_EQ(records.size(), 1u);
+        EXPECT_EQ(records[0].payload, "hello");
+
+        attached.close();
+        EXPECT_TRUE(owner.isClosed());
+        EXPECT_FALSE(write_string(owner, 7, "late"));
+    }
+
+    std::ofstream(path) << "not a ring";
+    EXPECT_THROW(ShmRing ring(path), std::runtime_error);
+    std::filesystem::remove(path);
+
+    EXPECT_THROW(ShmRing ring(path), std::runtime_error);
+}
+
+TEST(ShmRingTest, ProducersInChildProcesses) {
+    constexpr int CHILDREN = 4;
+    constexpr uint32_t RECORDS = 5000;
+
+    // Small on purpose: the producers have to wait for the reader
+    ShmRing ring(1024);
+
+    std::vector<pid_t> children;
+    for (int child = 0; child < CHILDREN; ++child) {
+        pid_t pid = fork();
+        ASSERT_GE(pid, 0);
+
+        if (pid == 0) {
+            for (uint32_t seq = 0; seq < RECORDS; ++seq) {
+                if (!ring.write(child, reinterpret_cast<const unsigned char*>(&seq), sizeof(seq))) _exit(1);
+            }
+            _exit(0);
+        }
+
+        children.push_back(pid);
+    }
+
+    std::vector<uint32_t> next(CHILDREN, 0);
+    bool ordered = true;
+    uint32_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    while (total < CHILDREN * RECORDS && std::chrono::steady_clock::now() - start < std::chrono::seconds(30)) {
+        total += ring.read([&next, &ordered](uint32_t child, const unsigned char* data, size_t size) {
+            uint32_t seq;
+            std::memcpy(&seq, data, size);
+            ordered = ordered && seq == next[child];
+            next[child] = seq + 1;
+        });
+
+        if (total < CHILDREN * RECORDS) ring.wait(std::chrono::milliseconds(100));
+    }
+
+    for (pid_t pid : children) EXPECT_TRUE(wait_child(pid));
+    EXPECT_EQ(total, CHILDREN * RECORDS);
+    EXPECT_TRUE(ordered);
+}
+
+TEST(ShmTransportTest, PublishAcrossProcesses) {
+    ShmEventCodec codec;
+    codec.add<PriceEvent>(1);
+    EXPECT_THROW(codec.add<PriceEvent>(2), std::invalid_argument);
+
+    auto ring = std::make_shared<ShmRing>(4096);
+
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+
+    if (pid == 0) {
+        auto broker = std::make_shared<PubSubBroker>();
+        auto forwarder = std::make_shared<ShmForwarder>(ring, codec);
+        broker->subscribe<PriceEvent, LocalEvent>(forwarder);
+
+        Publisher publisher(broker);
+        for (uint64_t seq = 0; seq < 1000; ++seq) {
+            publisher.publish(std::make_shared<const PriceEvent>("SYM" + std::to_string(seq % 3), seq));
+        }
+
+        // Not registered, hence never sent
+        publisher.publish(std::make_shared<const LocalEvent>());
+
+        _exit(forwarder->getForwarded() == 1000 && forwarder->getDropped() == 1 ? 0 : 1);
+    }
+
+    auto broker = std::make_shared<PubSubBroker>();
+    auto collector = std::make_shared<PriceCollector>();
+    broker->subscribe<PriceEvent>(collector);
+
+    ShmReceiver receiver(ring, codec, broker);
+    receiver.start();
+
+    auto start = std::chrono::steady_clock::now();
+    while (collector->count() < 1000 && std::chrono::steady_clock::now() - start < std::chrono::seconds(30)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    receiver.stop();
+    EXPECT_TRUE(wait_child(pid));
+
+    ASSERT_EQ(collector->events.size(), 1000u);
+    for (uint64_t seq = 0; seq < 1000; ++seq) {
+        EXPECT_EQ(collector->events[seq]->sequence, seq);
+        EXPECT_EQ(collector->events[seq]->symbol, "SYM" + std::to_string(seq % 3));
+    }
+    EXPECT_EQ(receiver.getReceived(), 1000u);
+    EXPECT_EQ(receiver.getUnknown(), 0u);
+}
+
+TEST(ShmTransportTest, ForwarderDropsWhenFull) {
+    ShmEventCodec codec;
+    codec.add<PriceEvent>(1);
+
+    auto ring = std::make_shared<ShmRing>(256);
+    ShmForwarderConfig config;
+    config.loss_policy = ccl::ds::LossPolicy::ERROR;
+    auto forwarder = std::make_shared<ShmForwarder>(ring, codec, config);
+
+    auto broker = std::make_shared<PubSubBroker>();
+    broker->subscribe<PriceEvent>(forwarder);
+
+    // 8 + 4 + 3 + 8 bytes, aligned to 24: 10 records fit
+    for (uint64_t seq = 0; seq < 12; ++seq) {
+        broker->notifySubscribers(std::make_shared<const PriceEvent>("SYM", seq));
+    }
+
+    EXPECT_EQ(forwarder->getForwarded(), 10u);
+    EXPECT_EQ(forwarder->getDropped(), 2u);
+
+    config.loss_policy = ccl::ds::LossPolicy::OVERWRITE_OLDEST;
+    EXPECT_THROW(ShmForwarder(ring, codec, config), std::invalid_argument);
+}
+
+TEST(ShmTransportTest, UnknownRecordsAreSkipped) {
+    ShmEventCodec codec;
+    codec.add<PriceEvent>(1);
+
+    auto ring = std::make_shared<ShmRing>(4096);
+    EXPECT_TRUE(write_string(*ring, 9, "unknown"));
+    EXPECT_TRUE(write_string(*ring, 1, "xx")); // Truncated PriceEvent
+
+    auto broker = std::make_shared<PubSubBroker>();
+    ShmReceiver receiver(ring, codec, broker);
+    receiver.start();
+
+    auto start = std::chrono::steady_clock::now();
+    while (receiver.getUnknown() < 2 && std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    receiver.stop();
+    EXPECT_EQ(receiver.getUnknown(), 2u);
+    EXPECT_EQ(receiver.getReceived(), 0u);
+}
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <future>
+#include <numeric>
+#include <data_structures/buffers/spsc_ring_buffer.hpp>
+
+using namespace ccl::ds::buffers;
+
+TEST(SpscRingBufferTest, CapacityIsRoundedToPowerOfTwo)
+{
+    SpscRingBuffer<int> buffer(5);
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(buffer.size(), 0);
+    EXPECT_EQ(buffer.capacity(), 8);
+
+    SpscRingBuffer<int> exact(16);
+    EXPECT_EQ(exact.capacity(), 16);
+}
+
+TEST(SpscRingBufferTest, ZeroCapacityThrows)
+{
+    EXPECT_THROW(SpscRingBuffer<int>(0), std::invalid_argument);
+}
+
+TEST(SpscRingBufferTest, TryPushTryPopFifo)
+{
+    SpscRingBuffer<int> buffer(4);
+    EXPECT_TRUE(buffer.tryPush(1));
+    EXPECT_TRUE(buffer.tryPush(2));
+    EXPECT_TRUE(buffer.tryPush(3));
+    EXPECT_EQ(buffer.size(), 3);
+
+    int out = 0;
+    EXPECT_TRUE(buffer.tryPop(out));
+    EXPECT_EQ(out, 1);
+    EXPECT_TRUE(buffer.tryPop(out));
+    EXPECT_EQ(out, 2);
+    EXPECT_TRUE(buffer.tryPop(out));
+    EXPECT_EQ(out, 3);
+    EXPECT_FALSE(buffer.tryPop(out));
+    EXPECT_TRUE(buffer.empty());
+}
+
+TEST(SpscRingBufferTest, TryPushFailsWhenFull)
+{
+    SpscRingBuffer<int> buffer(2);
+    EXPECT_TRUE(buffer.tryPush(1));
+    EXPECT_TRUE(buffer.tryPush(2));
+    EXPECT_TRUE(buffer.full());
+    EXPECT_FALSE(buffer.tryPush(3)); // Never overwrites the oldest
+
+    int out = 0;
+    EXPECT_TRUE(buffer.tryPop(out));
+    EXPECT_EQ(out, 1);
+    EXPECT_TRUE(buffer.tryPush(3));
+}
+
+TEST(SpscRingBufferTest, WraparoundKeepsOrder)
+{
+    SpscRingBuffer<int> buffer(4);
+    int out = 0;
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(buffer.tryPush(i));
+        EXPECT_TRUE(buffer.tryPop(out));
+        EXPECT_EQ(out, i);
+    }
+}
+
+TEST(SpscRingBufferTest, MoveOnlyAndStrings)
+{
+    SpscRingBuffer<std::string> buffer(2);
+    std::string value = "hello";
+    EXPECT_TRUE(buffer.tryPush(std::move(value)));
+    EXPECT_TRUE(buffer.tryPush("world"));
+
+    EXPECT_EQ(buffer.pop(), "hello");
+    EXPECT_EQ(buffer.pop(), "world");
+}
+
+TEST(SpscRingBufferTest, BulkPushAndPop)
+{
+    SpscRingBuffer<int> buffer(8);
+    std::vector<int> src(12);
+    std::iota(src.begin(), src.end(), 0);
+
+    // Only the free slots are filled
+    EXPECT_EQ(buffer.tryPushN(src.data(), src.size()), 8);
+    EXPECT_EQ(buffer.tryPushN(src.data(), src.size()), 0);
+
+    std::vector<int> dst(5);
+    EXPECT_EQ(buffer.tryPopN(dst.data(), dst.size()), 5);
+    EXPECT_EQ(dst, std::vector<int>({0, 1, 2, 3, 4}));
+
+    EXPECT_EQ(buffer.tryPushN(src.data() + 8, 4), 4);
+
+    std::vector<int> rest(10);
+    EXPECT_EQ(buffer.tryPopN(rest.data(), rest.size()), 7);
+    EXPECT_EQ(rest[0], 5);
+    EXPECT_EQ(rest[6], 11);
+    EXPECT_EQ(buffer.tryPopN(rest.data(), rest.size()), 0);
+}
+
+TEST(SpscRingBufferTest, PopBlocksUntilItemAvailable)
+{
+    SpscRingBuffer<int> buffer(1);
+
+    auto future = std::async(std::launch::async, [&buffer] {
+        return buffer.pop();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_NE(future.wait_for(std::chrono::milliseconds(0)), std::future_status::ready);
+
+    buffer.push(99);
+    EXPECT_EQ(future.get(), 99);
+}
+
+TEST(SpscRingBufferTest, PushBlocksUntilSlotAvailable)
+{
+    SpscRingBuffer<int> buffer(1);
+    buffer.push(1);
+
+    auto future = std::async(std::launch::async, [&buffer] {
+        buffer.push(2);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_NE(future.wait_for(std::chrono::milliseconds(0)), std::future_status::ready);
+
+    EXPECT_EQ(buffer.pop(), 1);
+    future.get();
+    EXPECT_EQ(buffer.pop(), 2);
+}
+
+TEST(SpscRingBufferTest, ConcurrentProducerConsumerKeepsOrder)
+{
+    constexpr int N = 200000;
+    SpscRingBuffer<int> buffer(64);
+
+    std::thread producer([&buffer]() {
+        for (int i = 0; i < N; ++i) buffer.push(i);
+    });
+
+    bool ordered = true;
+    std::thread consumer([&buffer, &ordered]() {
+        for (int i = 0; i < N; ++i) {
+            if (buffer.pop() != i) ordered = false;
+        }
+    });
+
+    producer.join();
+    consumer.join();
+
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(buffer.empty());
+}
+
+TEST(SpscRingBufferTest, ConcurrentBulkTransfer)
+{
+    constexpr int N = 100000;
+    SpscRingBuffer<int> buffer(128);
+
+    std::thread producer([&buffer]() {
+        std::vector<int> chunk(32);
+        int next = 0;
+        while (next < N) {
+            int count = std::min<int>(chunk.size(), N - next);
+            std::iota(chunk.begin(), chunk.begin() + count, next);
+            next += buffer.tryPushN(chunk.data(), count);
+        }
+    });
+
+    long long sum = 0;
+    int expected = 0;
+    bool ordered = true;
+    std::vector<int> chunk(32);
+    while (expected < N) {
+        size_t n = buffer.tryPopN(chunk.data(), chunk.size());
+        for (size_t i = 0; i < n; ++i) {
+            if (chunk[i] != expected++) ordered = false;
+            sum += chunk[i];
+        }
+    }
+
+    producer.join();
+    EXPECT_TRUE(ordered);
+    EXPECT_EQ(sum, static_cast<long long>(N) * (N - 1) / 2);
+}
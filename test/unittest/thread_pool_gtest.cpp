@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include <concurrent/thread_pool.hpp>
+#include <data_structures/queue/work_stealing_deque.hpp>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace ccl::sys::concurrent;
+using ccl::ds::queue::WorkStealingDeque;
+
+// --- WorkStealingDeque ---
+
+TEST(WorkStealingDequeTest, OwnerPopIsLifo) {
+    WorkStealingDeque<int> deque(4);
+    for (int i = 0; i < 3; ++i) deque.push(i);
+    EXPECT_EQ(deque.size(), 3u);
+
+    int value = -1;
+    EXPECT_TRUE(deque.pop(value));
+    EXPECT_EQ(value, 2);
+    EXPECT_TRUE(deque.pop(value));
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(deque.pop(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_FALSE(deque.pop(value));
+    EXPECT_TRUE(deque.empty());
+}
+
+TEST(WorkStealingDequeTest, StealIsFifo) {
+    WorkStealingDeque<int> deque(4);
+    for (int i = 0; i < 3; ++i) deque.push(i);
+
+    int value = -1;
+    EXPECT_TRUE(deque.steal(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(deque.pop(value));
+    EXPECT_EQ(value, 2);
+    EXPECT_TRUE(deque.steal(value));
+    EXPECT_EQ(value, 1);
+    EXPECT_FALSE(deque.steal(value));
+}
+
+TEST(WorkStealingDequeTest, GrowsWhenFull) {
+    WorkStealingDeque<int> deque(2);
+    for (int i = 0; i < 100; ++i) deque.push(i);
+    EXPECT_EQ(deque.size(), 100u);
+
+    int value = -1;
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(deque.steal(value));
+        EXPECT_EQ(value, i);
+    }
+}
+
+TEST(WorkStealingDequeTest, ConcurrentThievesTakeEachItemOnce) {
+    constexpr int N = 50000;
+    WorkStealingDeque<int> deque(64);
+    std::atomic<bool> done{false};
+    std::vector<std::vector<int>> stolen(3);
+
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; ++t) {
+        thieves.emplace_back([&deque, &done, &stolen, t]() {
+            int value;
+            while (!done.load() || !deque.empty()) {
+                if (deque.steal(value)) stolen[t].push_back(value);
+                else std::this_thread::yield();
+            }
+        });
+    }
+
+    std::vector<int> popped;
+    int value = -1;
+    for (int i = 0; i < N; ++i) {
+        deque.push(i);
+        if (i % 3 == 0 && deque.pop(value)) popped.push_back(value);
+    }
+    while (deque.pop(value)) popped.push_back(value);
+
+    done.store(true);
+    for (auto& t : thieves) t.join();
+
+    std::set<int> all(popped.begin(), popped.end());
+    size_t total = popped.size();
+    for (auto& v : stolen) {
+        all.insert(v.begin(), v.end());
+        total += v.size();
+    }
+
+    EXPECT_EQ(total, static_cast<size_t>(N));
+    EXPECT_EQ(all.size(), static_cast<size_t>(N));
+}
+
+// --- ThreadPool ---
+
+TEST(ThreadPoolTest, SubmitReturnsFuture) {
+    ThreadPool pool(2);
+    EXPECT_EQ(pool.size(), 2u);
+
+    auto future = pool.submit([](int a, int b) { return a + b; }, 2, 3);
+    EXPECT_EQ(future.get(), 5);
+}
+
+TEST(ThreadPoolTest, SubmitPropagatesExceptions) {
+    ThreadPool pool(2);
+    auto future = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+    EXPECT_THROW(future.get(), std::runtime_error);
+}
+
+TEST(ThreadPoolTest, ManyTasksAllExecuted) {
+    ThreadPool pool(4);
+    std::atomic<int> counter{0};
+    std::vector<std::future<void>> futures;
+
+    for (int i = 0; i < 10000; ++i) {
+        futures.push_back(pool.submit([&counter]() { counter.fetch_add(1); }));
+    }
+
+    for (auto& f : futures) f.get();
+    EXPECT_EQ(counter.load(), 10000);
+}
+
+TEST(ThreadPoolTest, NestedSubmitFromWorker) {
+    ThreadPool pool(2);
+
+    auto outer = pool.submit([&pool]() {
+        std::vector<std::future<int>> inner;
+        for (int i = 0; i < 100; ++i) inner.push_back(pool.submit([i]() { return i; }));
+
+        int sum = 0;
+        for (auto& f : inner) sum += f.get();
+        return sum;
+    });
+
+    EXPECT_EQ(outer.get(), 4950);
+}
+
+TEST(ThreadPoolTest, ParallelForCoversRange) {
+    ThreadPool pool(4);
+    std::vector<int> data(10007, 0);
+
+    pool.parallelFor(0, data.size(), [&data](size_t i) { data[i] = static_cast<int>(i); });
+
+    for (size_t i = 0; i < data.size(); ++i) EXPECT_EQ(data[i], static_cast<int>(i));
+}
+
+TEST(ThreadPoolTest, ParallelForWithGrainAndEmptyRange) {
+    ThreadPool pool(2);
+    std::atomic<long long> sum{0};
+
+    pool.parallelFor(10, 10, [&sum](size_t) { sum += 1; });
+    EXPECT_EQ(sum.load(), 0);
+
+    pool.parallelFor(0, 1000, [&sum](size_t i) { sum += i; }, 7);
+    EXPECT_EQ(sum.load(), 999LL * 1000 / 2);
+}
+
+TEST(ThreadPoolTest, ParallelForRethrows) {
+    ThreadPool pool(2);
+    EXPECT_THROW(
+        pool.parallelFor(0, 100, [](size_t i) {
+            if (i == 42) throw std::invalid_argument("bad index");
+        }),
+        std::invalid_argument);
+}
+
+TEST(ThreadPoolTest, NestedParallelForDoesNotDeadlock) {
+    ThreadPool pool(2);
+    std::atomic<int> counter{0};
+
+    pool.parallelFor(0, 8, [&pool, &counter](size_t) {
+        pool.parallelFor(0, 100, [&counter](size_t) { counter.fetch_add(1); });
+    });
+
+    EXPECT_EQ(counter.load(), 800);
+}
+
+TEST(ThreadPoolTest, DestructorDrainsPendingTasks) {
+    std::atomic<int> counter{0};
+    {
+        ThreadPool pool(1);
+        for (int i = 0; i < 100; ++i) {
+            pool.submit([&counter]() {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                counter.fetch_add(1);
+            });
+        }
+    }
+    EXPECT_EQ(counter.load(), 100);
+}
+
+TEST(ThreadPoolTest, PinnedWorkersRun) {
+    ThreadPool pool(2, true);
+    auto future = pool.submit([]() { return 7; });
+    EXPECT_EQ(future.get(), 7);
+}
+
+TEST(ThreadPoolTest, IdleWorkersWakeUp) {
+    ThreadPool pool(2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Let them sleep
+
+    auto future = pool.submit([]() { return 1; });
+    EXPECT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(future.get(), 1);
+}
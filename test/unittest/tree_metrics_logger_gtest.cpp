@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <metrics/metrics_broker.hpp>
+#include <metrics/metrics_gather.hpp>
+#include <metrics/metrics_logger.hpp>
+#include <metrics/metrics_utils.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace ccl::metrics;
+
+static std::shared_ptr<const ccl::dp::pub_sub::PubSubEvent>
+make_event(const std::string& parent, const std::string& name, unsigned duration,
+           unsigned long cpu_time, TID_t tid = 1) {
+    Metrics metrics {};
+    metrics.m_duration = duration;
+    metrics.m_cpu_time = cpu_time;
+    return std::make_shared<const MetricEvent>(parent, name, metrics, tid);
+}
+
+static std::string read_file(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+TEST(TreeMetricsLoggerTest, AggregatesCallsByParent) {
+    TreeMetricsLogger logger;
+    for (unsigned idx = 1; idx <= 100; ++idx) {
+        logger.consume(make_event("main", "work", idx, idx / 2));
+    }
+    logger.consume(make_event("", "main", 10'000, 5'000));
+    logger.consume(make_event("other", "work", 7, 7));
+
+    auto node = logger.getNode(1, "main", "work");
+    ASSERT_NE(node, nullptr);
+    EXPECT_EQ(node->m_duration.getCount(), 100u);
+    EXPECT_EQ(node->m_duration.getSum(), 5050u);
+    EXPECT_EQ(node->m_duration.getMin(), 1u);
+    EXPECT_EQ(node->m_duration.getMax(), 100u);
+    EXPECT_EQ(node->m_duration.getValueAtPercentile(99.0), 99u);
+    EXPECT_EQ(node->m_cpu_time.getMax(), 50u);
+
+    auto other = logger.getNode(1, "other", "work");
+    ASSERT_NE(other, nullptr);
+    EXPECT_EQ(other->m_duration.getCount(), 1u);
+
+    EXPECT_EQ(logger.getNode(2, "main", "work"), nullptr);
+    EXPECT_EQ(logger.getNode(1, "work", "main"), nullptr);
+}
+
+TEST(TreeMetricsLoggerTest, TreeReport) {
+    TreeMetricsLogger logger;
+    logger.consume(make_event("", "main", 1000, 900));
+    logger.consume(make_event("main", "parse", 300, 300));
+    logger.consume(make_event("main", "solve", 600, 500));
+    logger.consume(make_event("", "main", 1000, 900, 2));
+
+    std::stringstream ss;
+    logger.report(ss, TreeReportFormat::Tree);
+    std::string report = ss.str();
+
+    EXPECT_NE(report.find("Thread 1\n  main count=1 total=1000us"), std::string::npos) << report;
+    EXPECT_NE(report.find("\n    parse count=1 total=300us"), std::string::npos) << report;
+    EXPECT_NE(report.find("\n    solve count=1 total=600us"), std::string::npos) << report;
+    EXPECT_NE(report.find("p999="), std::string::npos);
+    EXPECT_NE(report.find("Thread 2\n"), std::string::npos);
+    EXPECT_LT(report.find("parse"), report.find("Thread 2"));
+}
+
+TEST(TreeMetricsLoggerTest, FoldedReportHasSelfTimes) {
+    TreeMetricsLogger logger;
+    logger.consume(make_event("", "main", 1000, 900));
+    logger.consume(make_event("main", "parse", 300, 300));
+    logger.consume(make_event("main", "solve", 600, 500));
+    logger.consume(make_event("solve", "solve", 200, 200)); // Recursive call
+
+    std::stringstream ss;
+    logger.report(ss, TreeReportFormat::Folded);
+
+    EXPECT_EQ(ss.str(), "1;main 100\n"
+                        "1;main;parse 300\n"
+                        "1;main;solve 400\n");
+}
+
+TEST(TreeMetricsLoggerTest, CollectorsAreLinkedToTheirCaller) {
+    auto logger = std::make_shared<TreeMetricsLogger>();
+    logger->start();
+    MetricsBroker::getInstance()->subscribe<MetricEvent>(logger);
+
+    {
+        auto outer = MetricsCollector::create("outer");
+        for (int idx = 0; idx < 3; ++idx) {
+            auto inner = MetricsCollector::create("inner");
+            inner->collect();
+        }
+        outer->collect();
+    }
+
+    // A sibling after the scope of outer is a root again
+    {
+        auto sibling = MetricsCollector::create("sibling");
+        sibling->collect();
+    }
+
+    logger->stop();
+    MetricsBroker::getInstance()->unsubscribe<MetricEvent>(logger);
+
+    TID_t tid = get_thread_id();
+    auto inner = logger->getNode(tid, "outer", "inner");
+    ASSERT_NE(inner, nullptr);
+    EXPECT_EQ(inner->m_duration.getCount(), 3u);
+    EXPECT_NE(logger->getNode(tid, "", "outer"), nullptr);
+    EXPECT_NE(logger->getNode(tid, "", "sibling"), nullptr);
+    EXPECT_EQ(logger->getNode(tid, "inner", "outer"), nullptr);
+}
+
+TEST(TreeMetricsLoggerTest, PeriodicExport) {
+    auto path = (std::filesystem::temp_directory_path() / "ccl_tree_metrics_report.txt").string();
+    std::filesystem::remove(path);
+
+    TreeMetricsLoggerConfig config;
+    config.path = path;
+    config.export_interval = std::chrono::milliseconds(20);
+    config.format = TreeReportFormat::Folded;
+
+    {
+        TreeMetricsLogger logger(config);
+        logger.consume(make_event("", "main", 1000, 900));
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!std::filesystem::exists(path) && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        EXPECT_EQ(read_file(path), "1;main 1000\n");
+        logger.consume(make_event("main", "child", 400, 400));
+    }
+
+    // The last export is made at destruction
+    EXPECT_EQ(read_file(path), "1;main 600\n1;main;child 400\n");
+    EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+    std::filesystem::remove(path);
+}
+
+TEST(TreeMetricsLoggerTest, ExportToUnwritablePath) {
+    TreeMetricsLogger logger;
+    logger.consume(make_event("", "main", 1000, 900));
+    EXPECT_FALSE(logger.exportTo("/nonexistent/dir/report.txt", TreeReportFormat::Tree));
+}
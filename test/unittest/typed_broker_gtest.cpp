@@ -0,0 +1,153 @@
+#include <patterns/pub_sub/typed_broker.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ccl::dp::pub_sub;
+
+struct Price {
+    std::string symbol;
+    double value;
+};
+
+struct Trade {
+    int quantity;
+};
+
+struct Unrelated {};
+
+using Broker = TypedBroker<Price, Trade>;
+
+class PriceSubscriber {
+public:
+    std::vector<std::string> symbols;
+
+    void notify(const Price& price) { symbols.push_back(price.symbol); }
+};
+
+class BothSubscriber {
+public:
+    std::atomic<int> prices = 0;
+    std::atomic<int> quantity = 0;
+
+    void notify(const Price&) { ++prices; }
+    void notify(const Trade& trade) { quantity += trade.quantity; }
+};
+
+static_assert(TypedSubscriber<BothSubscriber, Trade>);
+static_assert(!TypedSubscriber<PriceSubscriber, Trade>);
+
+TEST(TypedBrokerTest, DispatchesByType) {
+    Broker broker;
+    auto prices = std::make_shared<PriceSubscriber>();
+    auto both = std::make_shared<BothSubscriber>();
+
+    broker.subscribe<Price>(prices);
+    broker.subscribe<Price, Trade>(both);
+
+    broker.publish(Price { "ABC", 1.5 });
+    broker.publish(Trade { 10 });
+    broker.emplace<Trade>(5);
+
+    EXPECT_EQ(prices->symbols, std::vector<std::string>({ "ABC" }));
+    EXPECT_EQ(both->prices.load(), 1);
+    EXPECT_EQ(both->quantity.load(), 15);
+    EXPECT_EQ(broker.subscribers<Price>(), 2u);
+    EXPECT_EQ(broker.subscribers<Trade>(), 1u);
+}
+
+TEST(TypedBrokerTest, Unsubscribe) {
+    Broker broker;
+    auto both = std::make_shared<BothSubscriber>();
+    broker.subscribe<Price, Trade>(both);
+
+    broker.unsubscribe<Trade>(both);
+    broker.publish(Trade { 10 });
+    broker.publish(Price { "ABC", 1.0 });
+
+    EXPECT_EQ(both->quantity.load(), 0);
+    EXPECT_EQ(both->prices.load(), 1);
+    EXPECT_EQ(broker.subscribers<Trade>(), 0u);
+}
+
+TEST(TypedBrokerTest, ExpiredSubscribersAreSkipped) {
+    Broker broker;
+    auto kept = std::make_shared<PriceSubscriber>();
+    auto dropped = std::make_shared<PriceSubscriber>();
+    broker.subscribe<Price>(dropped);
+    broker.subscribe<Price>(kept);
+
+    dropped.reset();
+    broker.publish(Price { "ABC", 1.0 });
+
+    EXPECT_EQ(kept->symbols.size(), 1u);
+    EXPECT_EQ(broker.subscribers<Price>(), 1u);
+}
+
+// Publishing from notify, to the same and to another event type
+class ChainingSubscriber {
+public:
+    Broker& broker;
+    int trades = 0;
+
+    explicit ChainingSubscriber(Broker& b) : broker(b) {}
+
+    void notify(const Price& price) { broker.publish(Trade { static_cast<int>(price.value) }); }
+    void notify(const Trade&) { ++trades; }
+};
+
+TEST(TypedBrokerTest, PublishFromNotify) {
+    Broker broker;
+    auto chaining = std::make_shared<ChainingSubscriber>(broker);
+    broker.subscribe<Price, Trade>(chaining);
+
+    broker.publish(Price { "ABC", 3.0 });
+    EXPECT_EQ(chaining->trades, 1);
+}
+
+TEST(TypedBrokerTest, BrokersAreIndependent) {
+    Broker first, second;
+    auto a = std::make_shared<PriceSubscriber>();
+    auto b = std::make_shared<PriceSubscriber>();
+    first.subscribe<Price>(a);
+    second.subscribe<Price>(b);
+
+    // The thread-local snapshot must not leak from one broker to the other
+    first.publish(Price { "first", 0 });
+    second.publish(Price { "second", 0 });
+    first.publish(Price { "first", 0 });
+
+    EXPECT_EQ(a->symbols, std::vector<std::string>({ "first", "first" }));
+    EXPECT_EQ(b->symbols, std::vector<std::string>({ "second" }));
+}
+
+TEST(TypedBrokerTest, ConcurrentPublishersAndSubscriptions) {
+    Broker broker;
+    auto counter = std::make_shared<BothSubscriber>();
+    broker.subscribe<Trade>(counter);
+
+    std::atomic<bool> done = false;
+    std::thread churn([&broker, &done] {
+        while (!done.load()) {
+            auto temporary = std::make_shared<BothSubscriber>();
+            broker.subscribe<Trade>(temporary);
+            broker.unsubscribe<Trade>(temporary);
+        }
+    });
+
+    std::vector<std::thread> publishers;
+    for (int idx = 0; idx < 4; ++idx) {
+        publishers.emplace_back([&broker] {
+            for (int jdx = 0; jdx < 2000; ++jdx) broker.publish(Trade { 1 });
+        });
+    }
+
+    for (auto& publisher : publishers) publisher.join();
+    done.store(true);
+    churn.join();
+
+    EXPECT_EQ(counter->quantity.load(), 8000);
+}